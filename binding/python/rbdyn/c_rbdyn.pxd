@@ -226,8 +226,11 @@ cdef extern from "<RBDyn/FD.h>" namespace "rbd":
     void sForwardDynamics(const MultiBody&, MultiBodyConfig&) except +
     void sComputeH(const MultiBody&, const MultiBodyConfig&) except +
     void sComputeC(const MultiBody&, const MultiBodyConfig&) except +
+    void sComputeHC(const MultiBody&, const MultiBodyConfig&) except +
+    void sComputeHinv(const MultiBody&, const MultiBodyConfig&) except +
 
     MatrixXd H() const
+    MatrixXd Hinv() const
     VectorXd C() const
     vector[RBInertiad] inertiaSubTree() const
 
@@ -943,9 +943,18 @@ cdef class ForwardDynamics(object):
   def computeC(self, MultiBody mb, MultiBodyConfig mbc):
     self.impl.sComputeC(deref(mb.impl), deref(mbc.impl))
 
+  def computeHC(self, MultiBody mb, MultiBodyConfig mbc):
+    self.impl.sComputeHC(deref(mb.impl), deref(mbc.impl))
+
+  def computeHinv(self, MultiBody mb, MultiBodyConfig mbc):
+    self.impl.sComputeHinv(deref(mb.impl), deref(mbc.impl))
+
   def H(self):
     return eigen.MatrixXdFromC(self.impl.H())
 
+  def Hinv(self):
+    return eigen.MatrixXdFromC(self.impl.Hinv())
+
   def C(self):
     return eigen.VectorXdFromC(self.impl.C())
 
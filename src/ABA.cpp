@@ -0,0 +1,133 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/ABA.h"
+
+// includes
+// RBDyn
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace rbd
+{
+
+ArticulatedBodyAlgorithm::ArticulatedBodyAlgorithm(const MultiBody & mb)
+: IA_(mb.nrBodies()), pA_(mb.nrBodies()), c_(mb.nrBodies()), a_(mb.nrBodies()), U_(mb.nrJoints()),
+  UDinv_(mb.nrJoints()), Dinv_(mb.nrJoints()), u_(mb.nrJoints()), alphaD_(mb.nrJoints()), llt_(mb.nrJoints())
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    int dof = mb.joint(i).dof();
+    U_[i].resize(6, dof);
+    UDinv_[i].resize(6, dof);
+    Dinv_[i].resize(dof, dof);
+    u_[i].resize(dof);
+    alphaD_[i].resize(dof);
+    llt_[i] = Eigen::LLT<Eigen::MatrixXd>(dof);
+  }
+}
+
+void ArticulatedBodyAlgorithm::forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  const std::vector<Body> & bodies = mb.bodies();
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+
+  sva::MotionVecd a_0(Eigen::Vector3d::Zero(), mbc.gravity);
+
+  for(std::size_t i = 0; i < bodies.size(); ++i)
+  {
+    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+    const sva::RBInertiad & I_i = bodies[i].inertia();
+
+    IA_[i] = sva::ABInertiad(I_i.mass() * Eigen::Matrix3d::Identity(), sva::vector3ToCrossMatrix(I_i.momentum()),
+                             I_i.inertia());
+    pA_[i] = vb_i.crossDual(I_i * vb_i) - mbc.bodyPosW[i].dualMul(mbc.force[i]);
+    c_[i] = vb_i.cross(mbc.jointVelocity[i]);
+  }
+
+  for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
+  {
+    const Eigen::Matrix<double, 6, Eigen::Dynamic> & S = mbc.motionSubspace[i];
+    int dof = joints[i].dof();
+
+    if(dof != 0)
+    {
+      for(int d = 0; d < dof; ++d)
+      {
+        U_[i].col(d) = (IA_[i] * sva::MotionVecd(S.col(d))).vector();
+        u_[i](d) = mbc.jointTorque[i][d] - S.col(d).dot(pA_[i].vector());
+      }
+
+      Dinv_[i].noalias() = S.transpose() * U_[i];
+      llt_[i].compute(Dinv_[i]);
+      Dinv_[i].setIdentity();
+      llt_[i].solveInPlace(Dinv_[i]);
+      UDinv_[i].noalias() = U_[i] * Dinv_[i];
+    }
+
+    if(pred[i] != -1)
+    {
+      const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+
+      sva::ABInertiad Ia = IA_[i];
+      if(dof != 0)
+      {
+        Eigen::Matrix6d UDU;
+        UDU.noalias() = UDinv_[i] * U_[i].transpose();
+        Ia -= sva::ABInertiad(UDU.block<3, 3>(3, 3), UDU.block<3, 3>(0, 3), UDU.block<3, 3>(0, 0));
+      }
+
+      sva::ForceVecd pa = pA_[i] + Ia * c_[i];
+      if(dof != 0)
+      {
+        pa += sva::ForceVecd(UDinv_[i] * u_[i]);
+      }
+
+      IA_[pred[i]] += X_p_i.transMul(Ia);
+      pA_[pred[i]] += X_p_i.transMul(pa);
+    }
+  }
+
+  for(std::size_t i = 0; i < bodies.size(); ++i)
+  {
+    const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+    int dof = joints[i].dof();
+
+    if(pred[i] != -1)
+      a_[i] = X_p_i * a_[pred[i]] + c_[i];
+    else
+      a_[i] = X_p_i * a_0 + c_[i];
+
+    if(dof != 0)
+    {
+      u_[i].noalias() -= U_[i].transpose() * a_[i].vector();
+      alphaD_[i].noalias() = Dinv_[i] * u_[i];
+      a_[i] += sva::MotionVecd(mbc.motionSubspace[i] * alphaD_[i]);
+
+      for(int d = 0; d < dof; ++d)
+      {
+        mbc.alphaD[i][d] = alphaD_[i](d);
+      }
+    }
+  }
+}
+
+void ArticulatedBodyAlgorithm::sForwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchForce(mb, mbc);
+  checkMatchJointTorque(mb, mbc);
+
+  checkMatchAlphaD(mb, mbc);
+
+  forwardDynamics(mb, mbc);
+}
+
+} // namespace rbd
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/BatchDynamics.h"
+
+// includes
+// std
+#include <sstream>
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/FA.h"
+#include "RBDyn/FK.h"
+#include "RBDyn/FV.h"
+#include "RBDyn/MultiBody.h"
+
+namespace
+{
+
+void checkMatchSize(const Eigen::Ref<const Eigen::MatrixXd> & mat,
+                    Eigen::Index rows,
+                    Eigen::Index cols,
+                    const char * name)
+{
+  if(mat.rows() != rows || mat.cols() != cols)
+  {
+    std::ostringstream str;
+    str << name << " size mismatch: expected size " << rows << "x" << cols << " gived " << mat.rows() << "x"
+        << mat.cols();
+    throw std::domain_error(str.str());
+  }
+}
+
+} // namespace
+
+namespace rbd
+{
+
+BatchDynamics::BatchDynamics(const MultiBody & mb, int nrThreads)
+: id_(mb), fd_(mb), grain_(16), pool_(std::make_shared<ThreadPool>(nrThreads))
+{
+  workers_.resize(pool_->nrThreads());
+  for(Worker & w : workers_)
+  {
+    w.mbc = MultiBodyConfig(mb);
+    w.mbc.zero(mb);
+    w.q.resize(mb.nrParams());
+    w.alpha.resize(mb.nrDof());
+    w.alphaD.resize(mb.nrDof());
+    w.jointTorque.resize(mb.nrDof());
+    w.idWs = InverseDynamics::Workspace(mb);
+    w.fdWs = ForwardDynamics::Workspace(mb);
+    w.idim = IDIM(mb);
+  }
+  gravity_ = workers_.front().mbc.gravity;
+}
+
+void BatchDynamics::gravity(const Eigen::Vector3d & g)
+{
+  gravity_ = g;
+  for(Worker & w : workers_)
+  {
+    w.mbc.gravity = g;
+  }
+}
+
+void BatchDynamics::inverseDynamics(const MultiBody & mb,
+                                    const Eigen::Ref<const Eigen::MatrixXd> & q,
+                                    const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                                    const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                                    Eigen::Ref<Eigen::MatrixXd> jointTorque)
+{
+  pool_->parallelFor(static_cast<int>(q.rows()), grain_, [&](int worker, int begin, int end) {
+    Worker & w = workers_[worker];
+    for(int s = begin; s < end; ++s)
+    {
+      w.q = q.row(s).transpose();
+      w.alpha = alpha.row(s).transpose();
+      w.alphaD = alphaD.row(s).transpose();
+
+      forwardKinematics(mb, w.q, w.mbc);
+      forwardVelocity(mb, w.alpha, w.mbc);
+      id_.inverseDynamics(mb, w.alphaD, w.mbc, w.jointTorque, w.idWs);
+      jointTorque.row(s) = w.jointTorque.transpose();
+    }
+  });
+}
+
+void BatchDynamics::forwardDynamics(const MultiBody & mb,
+                                    const Eigen::Ref<const Eigen::MatrixXd> & q,
+                                    const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                                    const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+                                    Eigen::Ref<Eigen::MatrixXd> alphaD)
+{
+  pool_->parallelFor(static_cast<int>(q.rows()), grain_, [&](int worker, int begin, int end) {
+    Worker & w = workers_[worker];
+    for(int s = begin; s < end; ++s)
+    {
+      w.q = q.row(s).transpose();
+      w.alpha = alpha.row(s).transpose();
+      w.jointTorque = jointTorque.row(s).transpose();
+
+      forwardKinematics(mb, w.q, w.mbc);
+      forwardVelocity(mb, w.alpha, w.mbc);
+      fd_.forwardDynamics(mb, w.jointTorque, w.mbc, w.alphaD, w.fdWs);
+      alphaD.row(s) = w.alphaD.transpose();
+    }
+  });
+}
+
+void BatchDynamics::computeH(const MultiBody & mb,
+                             const Eigen::Ref<const Eigen::MatrixXd> & q,
+                             Eigen::Ref<Eigen::MatrixXd> H)
+{
+  int nrDof = mb.nrDof();
+  pool_->parallelFor(static_cast<int>(q.rows()), grain_, [&](int worker, int begin, int end) {
+    Worker & w = workers_[worker];
+    for(int s = begin; s < end; ++s)
+    {
+      w.q = q.row(s).transpose();
+
+      forwardKinematics(mb, w.q, w.mbc);
+      fd_.computeH(mb, w.mbc, w.fdWs);
+      H.middleRows(s * nrDof, nrDof) = w.fdWs.H;
+    }
+  });
+}
+
+void BatchDynamics::computeY(const MultiBody & mb,
+                             const Eigen::Ref<const Eigen::MatrixXd> & q,
+                             const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                             const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                             Eigen::Ref<Eigen::MatrixXd> Y)
+{
+  int nrDof = mb.nrDof();
+  // IDIM need the body accelerations computed with the gravity
+  sva::MotionVecd a_0(Eigen::Vector3d::Zero(), gravity_);
+  pool_->parallelFor(static_cast<int>(q.rows()), grain_, [&](int worker, int begin, int end) {
+    Worker & w = workers_[worker];
+    for(int s = begin; s < end; ++s)
+    {
+      w.q = q.row(s).transpose();
+      w.alpha = alpha.row(s).transpose();
+      w.alphaD = alphaD.row(s).transpose();
+
+      forwardKinematics(mb, w.q, w.mbc);
+      forwardVelocity(mb, w.alpha, w.mbc);
+      forwardAcceleration(mb, w.alphaD, w.mbc, a_0);
+      w.idim.computeY(mb, w.mbc);
+      Y.middleRows(s * nrDof, nrDof) = w.idim.Y();
+    }
+  });
+}
+
+void BatchDynamics::sInverseDynamics(const MultiBody & mb,
+                                     const Eigen::Ref<const Eigen::MatrixXd> & q,
+                                     const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                                     const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                                     Eigen::Ref<Eigen::MatrixXd> jointTorque)
+{
+  checkMatchMultiBody(mb);
+  checkMatchSize(q, q.rows(), mb.nrParams(), "q");
+  checkMatchSize(alpha, q.rows(), mb.nrDof(), "alpha");
+  checkMatchSize(alphaD, q.rows(), mb.nrDof(), "alphaD");
+  checkMatchSize(jointTorque, q.rows(), mb.nrDof(), "jointTorque");
+
+  inverseDynamics(mb, q, alpha, alphaD, jointTorque);
+}
+
+void BatchDynamics::sForwardDynamics(const MultiBody & mb,
+                                     const Eigen::Ref<const Eigen::MatrixXd> & q,
+                                     const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                                     const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+                                     Eigen::Ref<Eigen::MatrixXd> alphaD)
+{
+  checkMatchMultiBody(mb);
+  checkMatchSize(q, q.rows(), mb.nrParams(), "q");
+  checkMatchSize(alpha, q.rows(), mb.nrDof(), "alpha");
+  checkMatchSize(jointTorque, q.rows(), mb.nrDof(), "jointTorque");
+  checkMatchSize(alphaD, q.rows(), mb.nrDof(), "alphaD");
+
+  forwardDynamics(mb, q, alpha, jointTorque, alphaD);
+}
+
+void BatchDynamics::sComputeH(const MultiBody & mb,
+                              const Eigen::Ref<const Eigen::MatrixXd> & q,
+                              Eigen::Ref<Eigen::MatrixXd> H)
+{
+  checkMatchMultiBody(mb);
+  checkMatchSize(q, q.rows(), mb.nrParams(), "q");
+  checkMatchSize(H, q.rows() * mb.nrDof(), mb.nrDof(), "H");
+
+  computeH(mb, q, H);
+}
+
+void BatchDynamics::sComputeY(const MultiBody & mb,
+                              const Eigen::Ref<const Eigen::MatrixXd> & q,
+                              const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                              const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                              Eigen::Ref<Eigen::MatrixXd> Y)
+{
+  checkMatchMultiBody(mb);
+  checkMatchSize(q, q.rows(), mb.nrParams(), "q");
+  checkMatchSize(alpha, q.rows(), mb.nrDof(), "alpha");
+  checkMatchSize(alphaD, q.rows(), mb.nrDof(), "alphaD");
+  checkMatchSize(Y, q.rows() * mb.nrDof(), 10 * mb.nrBodies(), "Y");
+
+  computeY(mb, q, alpha, alphaD, Y);
+}
+
+void BatchDynamics::checkMatchMultiBody(const MultiBody & mb) const
+{
+  if(workers_.empty() || static_cast<int>(workers_.front().mbc.q.size()) != mb.nrJoints()
+     || workers_.front().q.size() != mb.nrParams() || workers_.front().alpha.size() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+}
+
+} // namespace rbd
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/BatchFK.h"
+
+// includes
+// std
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+
+namespace
+{
+
+/// Column of the rotation component (r, c) in a pose block.
+inline int rot(int r, int c)
+{
+  return 3 * r + c;
+}
+
+/// Column of the translation component r in a pose block.
+inline int trans(int r)
+{
+  return 9 + r;
+}
+
+/// Set the pose block starting at p to identity.
+void setIdentity(Eigen::Ref<Eigen::ArrayXXd> X, int p)
+{
+  for(int r = 0; r < 3; ++r)
+  {
+    for(int c = 0; c < 3; ++c)
+    {
+      X.col(p + rot(r, c)).setConstant(r == c ? 1. : 0.);
+    }
+    X.col(p + trans(r)).setZero();
+  }
+}
+
+/// Replace the pose block starting at p by its inverse (E^T, -E r).
+void invertInPlace(Eigen::Ref<Eigen::ArrayXXd> X, int p, Eigen::Ref<Eigen::ArrayXXd> tmp)
+{
+  for(int r = 0; r < 3; ++r)
+  {
+    tmp.col(r) = -(X.col(p + rot(r, 0)) * X.col(p + trans(0)) + X.col(p + rot(r, 1)) * X.col(p + trans(1))
+                   + X.col(p + rot(r, 2)) * X.col(p + trans(2)));
+  }
+  for(int r = 0; r < 3; ++r)
+  {
+    X.col(p + trans(r)) = tmp.col(r);
+    for(int c = r + 1; c < 3; ++c)
+    {
+      X.col(p + rot(r, c)).swap(X.col(p + rot(c, r)));
+    }
+  }
+}
+
+/**
+ * Rotation of angle -q around axis (same formula than Eigen::AngleAxis).
+ * cos(-q) and sin(-q) must be in tmp columns 0 and 1.
+ */
+void axisRotation(const Eigen::Vector3d & axis, Eigen::Ref<Eigen::ArrayXXd> tmp, Eigen::Ref<Eigen::ArrayXXd> X)
+{
+  auto c = tmp.col(0);
+  auto s = tmp.col(1);
+  tmp.col(2) = 1. - c;
+  auto c1 = tmp.col(2);
+
+  X.col(rot(0, 1)) = c1 * (axis.x() * axis.y()) - s * axis.z();
+  X.col(rot(1, 0)) = c1 * (axis.x() * axis.y()) + s * axis.z();
+  X.col(rot(0, 2)) = c1 * (axis.x() * axis.z()) + s * axis.y();
+  X.col(rot(2, 0)) = c1 * (axis.x() * axis.z()) - s * axis.y();
+  X.col(rot(1, 2)) = c1 * (axis.y() * axis.z()) - s * axis.x();
+  X.col(rot(2, 1)) = c1 * (axis.y() * axis.z()) + s * axis.x();
+  for(int i = 0; i < 3; ++i)
+  {
+    X.col(rot(i, i)) = c1 * (axis(i) * axis(i)) + c;
+  }
+}
+
+/**
+ * Rotation matrix of the quaternion (w, x, y, z) stored in tmp columns 0 to 3
+ * (same formula than Eigen::Quaternion::toRotationMatrix).
+ */
+void quaternionRotation(Eigen::Ref<Eigen::ArrayXXd> tmp, Eigen::Ref<Eigen::ArrayXXd> X)
+{
+  auto w = tmp.col(0);
+  auto x = tmp.col(1);
+  auto y = tmp.col(2);
+  auto z = tmp.col(3);
+
+  X.col(rot(0, 0)) = 1. - 2. * (y * y + z * z);
+  X.col(rot(0, 1)) = 2. * (x * y - w * z);
+  X.col(rot(0, 2)) = 2. * (x * z + w * y);
+  X.col(rot(1, 0)) = 2. * (x * y + w * z);
+  X.col(rot(1, 1)) = 1. - 2. * (x * x + z * z);
+  X.col(rot(1, 2)) = 2. * (y * z - w * x);
+  X.col(rot(2, 0)) = 2. * (x * z - w * y);
+  X.col(rot(2, 1)) = 2. * (y * z + w * x);
+  X.col(rot(2, 2)) = 1. - 2. * (x * x + y * y);
+}
+
+/// Compute the joint transformation of every configuration in the pose block 0 of X.
+void jointPose(const rbd::Joint & joint,
+               const Eigen::Ref<const Eigen::MatrixXd> & Q,
+               int pos,
+               Eigen::Ref<Eigen::ArrayXXd> tmp,
+               Eigen::Ref<Eigen::ArrayXXd> X)
+{
+  using namespace Eigen;
+
+  const Matrix<double, 6, Dynamic> & S = joint.motionSubspace();
+  auto q = [&Q, pos](int i) { return Q.col(pos + i).array(); };
+
+  switch(joint.type())
+  {
+    case rbd::Joint::Rev:
+      tmp.col(0) = q(0).cos();
+      tmp.col(1) = -q(0).sin();
+      axisRotation(S.block<3, 1>(0, 0), tmp, X);
+      for(int r = 0; r < 3; ++r)
+      {
+        X.col(trans(r)).setZero();
+      }
+      break;
+    case rbd::Joint::Prism:
+      for(int r = 0; r < 3; ++r)
+      {
+        for(int c = 0; c < 3; ++c)
+        {
+          X.col(rot(r, c)).setConstant(r == c ? 1. : 0.);
+        }
+        X.col(trans(r)) = q(0) * S(3 + r, 0);
+      }
+      break;
+    case rbd::Joint::Spherical:
+      // inverse of the quaternion (w, dir*x, dir*y, dir*z)
+      tmp.col(4) = (q(0) * q(0) + q(1) * q(1) + q(2) * q(2) + q(3) * q(3)).inverse();
+      tmp.col(0) = q(0) * tmp.col(4);
+      for(int i = 1; i < 4; ++i)
+      {
+        tmp.col(i) = q(i) * tmp.col(4) * -joint.direction();
+      }
+      quaternionRotation(tmp, X);
+      for(int r = 0; r < 3; ++r)
+      {
+        X.col(trans(r)).setZero();
+      }
+      break;
+    case rbd::Joint::Planar:
+      tmp.col(0) = q(0).cos();
+      tmp.col(1) = q(0).sin();
+      X.col(rot(0, 0)) = tmp.col(0);
+      X.col(rot(0, 1)) = tmp.col(1);
+      X.col(rot(0, 2)).setZero();
+      X.col(rot(1, 0)) = -tmp.col(1);
+      X.col(rot(1, 1)) = tmp.col(0);
+      X.col(rot(1, 2)).setZero();
+      X.col(rot(2, 0)).setZero();
+      X.col(rot(2, 1)).setZero();
+      X.col(rot(2, 2)).setOnes();
+      X.col(trans(0)) = tmp.col(0) * q(1) - tmp.col(1) * q(2);
+      X.col(trans(1)) = tmp.col(1) * q(1) + tmp.col(0) * q(2);
+      X.col(trans(2)).setZero();
+      if(joint.direction() != 1.)
+      {
+        invertInPlace(X, 0, tmp);
+      }
+      break;
+    case rbd::Joint::Cylindrical:
+      tmp.col(0) = q(0).cos();
+      tmp.col(1) = -q(0).sin();
+      axisRotation(S.col(0).head<3>(), tmp, X);
+      for(int r = 0; r < 3; ++r)
+      {
+        X.col(trans(r)) = q(1) * S(3 + r, 1);
+      }
+      break;
+    case rbd::Joint::Free:
+      // QuatToE
+      X.col(rot(0, 0)) = 2. * (q(0) * q(0) + q(1) * q(1) - 0.5);
+      X.col(rot(0, 1)) = 2. * (q(1) * q(2) + q(0) * q(3));
+      X.col(rot(0, 2)) = 2. * (q(1) * q(3) - q(0) * q(2));
+      X.col(rot(1, 0)) = 2. * (q(1) * q(2) - q(0) * q(3));
+      X.col(rot(1, 1)) = 2. * (q(0) * q(0) + q(2) * q(2) - 0.5);
+      X.col(rot(1, 2)) = 2. * (q(2) * q(3) + q(0) * q(1));
+      X.col(rot(2, 0)) = 2. * (q(1) * q(3) + q(0) * q(2));
+      X.col(rot(2, 1)) = 2. * (q(2) * q(3) - q(0) * q(1));
+      X.col(rot(2, 2)) = 2. * (q(0) * q(0) + q(3) * q(3) - 0.5);
+      for(int r = 0; r < 3; ++r)
+      {
+        X.col(trans(r)) = q(4 + r);
+      }
+      if(joint.direction() != 1.)
+      {
+        invertInPlace(X, 0, tmp);
+      }
+      break;
+    case rbd::Joint::Fixed:
+    default:
+      setIdentity(X, 0);
+      break;
+  }
+}
+
+/// R = X * Xt, Xt being the same for every configuration.
+void mulConstant(const Eigen::Ref<const Eigen::ArrayXXd> & X, const sva::PTransformd & Xt, Eigen::Ref<Eigen::ArrayXXd> R)
+{
+  const Eigen::Matrix3d & E = Xt.rotation();
+  const Eigen::Vector3d & t = Xt.translation();
+  for(int r = 0; r < 3; ++r)
+  {
+    for(int c = 0; c < 3; ++c)
+    {
+      R.col(rot(r, c)) = X.col(rot(r, 0)) * E(0, c) + X.col(rot(r, 1)) * E(1, c) + X.col(rot(r, 2)) * E(2, c);
+    }
+    R.col(trans(r)) = t(r) + X.col(trans(0)) * E(0, r) + X.col(trans(1)) * E(1, r) + X.col(trans(2)) * E(2, r);
+  }
+}
+
+/// Number of configurations processed at once (keep the temporaries in cache).
+int chunkRows(int batchSize)
+{
+  return batchSize < 128 ? batchSize : 128;
+}
+
+/// Pose block res of R = X * (pose block y of R).
+void mul(const Eigen::Ref<const Eigen::ArrayXXd> & X, Eigen::Ref<Eigen::ArrayXXd> R, int y, int res)
+{
+  for(int r = 0; r < 3; ++r)
+  {
+    for(int c = 0; c < 3; ++c)
+    {
+      R.col(res + rot(r, c)) = X.col(rot(r, 0)) * R.col(y + rot(0, c)) + X.col(rot(r, 1)) * R.col(y + rot(1, c))
+                               + X.col(rot(r, 2)) * R.col(y + rot(2, c));
+    }
+    R.col(res + trans(r)) = R.col(y + trans(r)) + R.col(y + rot(0, r)) * X.col(trans(0))
+                            + R.col(y + rot(1, r)) * X.col(trans(1)) + R.col(y + rot(2, r)) * X.col(trans(2));
+  }
+}
+
+} // namespace
+
+namespace rbd
+{
+
+BatchForwardKinematics::BatchForwardKinematics(const MultiBody & mb, int batchSize)
+: bodyPosW_(batchSize, 12 * mb.nrBodies()), jointConfig_(chunkRows(batchSize), 12),
+  parentToSon_(chunkRows(batchSize), 12), tmp_(chunkRows(batchSize), 5)
+{
+}
+
+void BatchForwardKinematics::forwardKinematics(const MultiBody & mb, const Eigen::Ref<const Eigen::MatrixXd> & q)
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+  const std::vector<int> & succ = mb.successors();
+  const std::vector<sva::PTransformd> & Xt = mb.transforms();
+
+  // the batch is processed by chunks to keep the temporaries in cache
+  for(Eigen::Index start = 0; start < bodyPosW_.rows(); start += jointConfig_.rows())
+  {
+    Eigen::Index size = std::min(jointConfig_.rows(), bodyPosW_.rows() - start);
+    auto qc = q.middleRows(start, size);
+    auto bodyPosW = bodyPosW_.middleRows(start, size);
+    auto jointConfig = jointConfig_.topRows(size);
+    auto parentToSon = parentToSon_.topRows(size);
+    auto tmp = tmp_.topRows(size);
+
+    for(std::size_t i = 0; i < joints.size(); ++i)
+    {
+      jointPose(joints[i], qc, mb.jointPosInParam(static_cast<int>(i)), tmp, jointConfig);
+      mulConstant(jointConfig, Xt[i], parentToSon);
+
+      if(pred[i] != -1)
+        mul(parentToSon, bodyPosW, 12 * pred[i], 12 * succ[i]);
+      else
+        bodyPosW.middleCols(12 * succ[i], 12) = parentToSon;
+    }
+  }
+}
+
+sva::PTransformd BatchForwardKinematics::bodyPosW(int body, int sample) const
+{
+  Eigen::Matrix3d E;
+  Eigen::Vector3d r;
+  for(int i = 0; i < 3; ++i)
+  {
+    for(int j = 0; j < 3; ++j)
+    {
+      E(i, j) = bodyPosW_(sample, 12 * body + rot(i, j));
+    }
+    r(i) = bodyPosW_(sample, 12 * body + trans(i));
+  }
+  return sva::PTransformd(E, r);
+}
+
+void BatchForwardKinematics::sForwardKinematics(const MultiBody & mb, const Eigen::Ref<const Eigen::MatrixXd> & q)
+{
+  if(bodyPosW_.cols() != 12 * mb.nrBodies())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  if(q.rows() != bodyPosW_.rows() || q.cols() != mb.nrParams())
+  {
+    std::ostringstream str;
+    str << "q size mismatch: expected size " << bodyPosW_.rows() << "x" << mb.nrParams() << " gived " << q.rows()
+        << "x" << q.cols();
+    throw std::domain_error(str.str());
+  }
+
+  forwardKinematics(mb, q);
+}
+
+} // namespace rbd
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/BatchIK.h"
+
+// includes
+// std
+#include <sstream>
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+
+namespace
+{
+
+void checkMatchSize(const Eigen::Ref<const Eigen::MatrixXd> & mat,
+                    Eigen::Index rows,
+                    Eigen::Index cols,
+                    const char * name)
+{
+  if(mat.rows() != rows || mat.cols() != cols)
+  {
+    std::ostringstream str;
+    str << name << " size mismatch: expected size " << rows << "x" << cols << " gived " << mat.rows() << "x"
+        << mat.cols();
+    throw std::domain_error(str.str());
+  }
+}
+
+} // namespace
+
+namespace rbd
+{
+
+BatchInverseKinematics::BatchInverseKinematics(const MultiBody & mb, const std::vector<int> & effectors, int nrThreads)
+: effectors_(effectors), ikIndex_(static_cast<std::size_t>(mb.nrBodies()), -1), grain_(1),
+  pool_(std::make_shared<ThreadPool>(nrThreads))
+{
+  for(std::size_t e = 0; e < effectors_.size(); ++e)
+  {
+    ikIndex_.at(static_cast<std::size_t>(effectors_[e])) = static_cast<int>(e);
+  }
+
+  workers_.resize(pool_->nrThreads());
+  for(Worker & w : workers_)
+  {
+    w.mbc = MultiBodyConfig(mb);
+    w.mbc.zero(mb);
+    w.q.resize(mb.nrParams());
+    for(int ef : effectors_)
+    {
+      w.iks.emplace_back(mb, ef);
+    }
+  }
+}
+
+const std::vector<BatchInverseKinematics::Result> & BatchInverseKinematics::inverseKinematics(
+    const MultiBody & mb,
+    const std::vector<Problem> & problems,
+    const Eigen::Ref<const Eigen::MatrixXd> & seeds,
+    Eigen::Ref<Eigen::MatrixXd> q)
+{
+  int nrProblems = static_cast<int>(problems.size());
+  int nrTasks = nrProblems * static_cast<int>(seeds.rows());
+
+  if(solved_.size() != problems.size())
+  {
+    solved_ = std::vector<std::atomic<bool>>(problems.size());
+  }
+  for(std::atomic<bool> & s : solved_)
+  {
+    s.store(false);
+  }
+  results_.resize(problems.size());
+  taskQ_.resize(nrTasks, mb.nrParams());
+  taskResults_.resize(static_cast<std::size_t>(nrTasks));
+  taskRun_.assign(static_cast<std::size_t>(nrTasks), 0);
+
+  // task t solve the problem t % nrProblems from the seed t / nrProblems
+  pool_->parallelFor(nrTasks, grain_, [&](int worker, int begin, int end) {
+    Worker & w = workers_[worker];
+    for(int t = begin; t < end; ++t)
+    {
+      int p = t % nrProblems;
+      if(solved_[p].load(std::memory_order_relaxed))
+      {
+        continue;
+      }
+
+      DampedInverseKinematics & ik = w.iks[ikIndex_[problems[p].effector]];
+      w.q = seeds.row(t / nrProblems).transpose();
+      vectorToParam(w.q, w.mbc.q);
+      bool converged = ik.inverseKinematics(mb, w.mbc, problems[p].target, solved_[p]);
+      if(converged)
+      {
+        solved_[p].store(true, std::memory_order_relaxed);
+      }
+
+      paramToVector(w.mbc.q, w.q);
+      taskQ_.row(t) = w.q.transpose();
+      taskResults_[t] = {converged, t / nrProblems, ik.error().norm(), ik.iterations()};
+      taskRun_[t] = 1;
+    }
+  });
+
+  // keep the first converged seed, or the smallest error
+  for(int p = 0; p < nrProblems; ++p)
+  {
+    int best = -1;
+    for(int t = p; t < nrTasks; t += nrProblems)
+    {
+      if(!taskRun_[t])
+      {
+        continue;
+      }
+
+      const Result & r = taskResults_[t];
+      if(best == -1 || (!taskResults_[best].converged && (r.converged || r.error < taskResults_[best].error)))
+      {
+        best = t;
+      }
+    }
+
+    if(best == -1)
+    {
+      // no seed
+      results_[p] = {false, -1, 0., 0};
+    }
+    else
+    {
+      results_[p] = taskResults_[best];
+      q.row(p) = taskQ_.row(best);
+    }
+  }
+
+  return results_;
+}
+
+void BatchInverseKinematics::maxIterations(int maxIter)
+{
+  for(Worker & w : workers_)
+  {
+    for(DampedInverseKinematics & ik : w.iks)
+    {
+      ik.max_iterations_ = maxIter;
+    }
+  }
+}
+
+void BatchInverseKinematics::threshold(double threshold)
+{
+  for(Worker & w : workers_)
+  {
+    for(DampedInverseKinematics & ik : w.iks)
+    {
+      ik.threshold_ = threshold;
+    }
+  }
+}
+
+void BatchInverseKinematics::jointLimits(const Eigen::VectorXd & qMin, const Eigen::VectorXd & qMax)
+{
+  for(Worker & w : workers_)
+  {
+    for(DampedInverseKinematics & ik : w.iks)
+    {
+      ik.jointLimits(qMin, qMax);
+    }
+  }
+}
+
+const std::vector<BatchInverseKinematics::Result> & BatchInverseKinematics::sInverseKinematics(
+    const MultiBody & mb,
+    const std::vector<Problem> & problems,
+    const Eigen::Ref<const Eigen::MatrixXd> & seeds,
+    Eigen::Ref<Eigen::MatrixXd> q)
+{
+  checkMatchMultiBody(mb);
+  checkMatchSize(seeds, seeds.rows(), mb.nrParams(), "seeds");
+  checkMatchSize(q, static_cast<Eigen::Index>(problems.size()), mb.nrParams(), "q");
+
+  for(const Problem & p : problems)
+  {
+    if(p.effector < 0 || p.effector >= static_cast<int>(ikIndex_.size()) || ikIndex_[p.effector] == -1)
+    {
+      std::ostringstream str;
+      str << "Body " << p.effector << " is not a registered effector";
+      throw std::domain_error(str.str());
+    }
+  }
+
+  return inverseKinematics(mb, problems, seeds, q);
+}
+
+void BatchInverseKinematics::sJointLimits(const MultiBody & mb,
+                                          const Eigen::VectorXd & qMin,
+                                          const Eigen::VectorXd & qMax)
+{
+  checkMatchMultiBody(mb);
+  checkMatchParamVector(mb, qMin, "qMin");
+  checkMatchParamVector(mb, qMax, "qMax");
+
+  jointLimits(qMin, qMax);
+}
+
+void BatchInverseKinematics::checkMatchMultiBody(const MultiBody & mb) const
+{
+  if(workers_.empty() || static_cast<int>(workers_.front().mbc.q.size()) != mb.nrJoints()
+     || workers_.front().q.size() != mb.nrParams() || static_cast<int>(ikIndex_.size()) != mb.nrBodies())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+}
+
+} // namespace rbd
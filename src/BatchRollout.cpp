@@ -0,0 +1,136 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/BatchRollout.h"
+
+// includes
+// std
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+
+namespace
+{
+
+void checkMatchSize(const Eigen::Ref<const Eigen::MatrixXd> & mat,
+                    Eigen::Index rows,
+                    Eigen::Index cols,
+                    const char * name)
+{
+  if(mat.rows() != rows || mat.cols() != cols)
+  {
+    std::ostringstream str;
+    str << name << " size mismatch: expected size " << rows << "x" << cols << " gived " << mat.rows() << "x"
+        << mat.cols();
+    throw std::domain_error(str.str());
+  }
+}
+
+} // namespace
+
+namespace rbd
+{
+
+BatchRollout::BatchRollout(const MultiBody & mb, DynamicsIntegrator::Method method, int nrThreads)
+: method_(method), grain_(1), rolloutsPerSecond_(0.), nrParams_(mb.nrParams()), nrDof_(mb.nrDof()),
+  pool_(std::make_shared<ThreadPool>(nrThreads))
+{
+  workers_.resize(pool_->nrThreads());
+  for(Worker & w : workers_)
+  {
+    w.mbc = MultiBodyConfig(mb);
+    w.mbc.zero(mb);
+    w.integrator = DynamicsIntegrator(mb, method);
+  }
+  gravity_ = workers_.front().mbc.gravity;
+}
+
+void BatchRollout::rollout(const MultiBody & mb,
+                           const Eigen::Ref<const Eigen::MatrixXd> & q0,
+                           const Eigen::Ref<const Eigen::MatrixXd> & alpha0,
+                           const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+                           double step,
+                           Eigen::Ref<Eigen::MatrixXd> q,
+                           Eigen::Ref<Eigen::MatrixXd> alpha)
+{
+  int nrRollouts = static_cast<int>(q0.cols());
+  int horizon = nrRollouts == 0 ? 0 : static_cast<int>(jointTorque.cols()) / nrRollouts;
+
+  auto start = std::chrono::steady_clock::now();
+  pool_->parallelFor(nrRollouts, grain_, [&](int worker, int begin, int end) {
+    Worker & w = workers_[worker];
+    for(int r = begin; r < end; ++r)
+    {
+      int col = r * (horizon + 1);
+      q.col(col) = q0.col(r);
+      alpha.col(col) = alpha0.col(r);
+      vectorToParam(q0.col(r), w.mbc.q);
+      vectorToParam(alpha0.col(r), w.mbc.alpha);
+
+      for(int k = 0; k < horizon; ++k)
+      {
+        vectorToParam(jointTorque.col(r * horizon + k), w.mbc.jointTorque);
+        w.integrator.integrate(mb, w.mbc, step);
+
+        paramToVector(w.mbc.q, q.col(col + k + 1));
+        paramToVector(w.mbc.alpha, alpha.col(col + k + 1));
+      }
+    }
+  });
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+  rolloutsPerSecond_ = duration.count() > 0. ? nrRollouts / duration.count() : 0.;
+}
+
+void BatchRollout::method(DynamicsIntegrator::Method m)
+{
+  method_ = m;
+  for(Worker & w : workers_)
+  {
+    w.integrator.method(m);
+  }
+}
+
+void BatchRollout::gravity(const Eigen::Vector3d & g)
+{
+  gravity_ = g;
+  for(Worker & w : workers_)
+  {
+    w.mbc.gravity = g;
+  }
+}
+
+void BatchRollout::sRollout(const MultiBody & mb,
+                            const Eigen::Ref<const Eigen::MatrixXd> & q0,
+                            const Eigen::Ref<const Eigen::MatrixXd> & alpha0,
+                            const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+                            double step,
+                            Eigen::Ref<Eigen::MatrixXd> q,
+                            Eigen::Ref<Eigen::MatrixXd> alpha)
+{
+  checkMatchMultiBody(mb);
+  checkMatchSize(q0, mb.nrParams(), q0.cols(), "q0");
+  checkMatchSize(alpha0, mb.nrDof(), q0.cols(), "alpha0");
+
+  Eigen::Index horizon = q0.cols() == 0 ? 0 : jointTorque.cols() / q0.cols();
+  checkMatchSize(jointTorque, mb.nrDof(), q0.cols() * horizon, "jointTorque");
+  checkMatchSize(q, mb.nrParams(), q0.cols() * (horizon + 1), "q");
+  checkMatchSize(alpha, mb.nrDof(), q0.cols() * (horizon + 1), "alpha");
+
+  rollout(mb, q0, alpha0, jointTorque, step, q, alpha);
+}
+
+void BatchRollout::checkMatchMultiBody(const MultiBody & mb) const
+{
+  if(workers_.empty() || static_cast<int>(workers_.front().mbc.q.size()) != mb.nrJoints()
+     || nrParams_ != mb.nrParams() || nrDof_ != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+}
+
+} // namespace rbd
@@ -219,20 +219,24 @@ void CoMJacobianDummy::init(const rbd::MultiBody & mb)
  *														CoMJacobian
  */
 
+CoMJacobian::Workspace::Workspace(const MultiBody & mb)
+: jac(3, mb.nrDof()), jacDot(3, mb.nrDof()), bodiesCoMWorld(mb.nrBodies()), bodiesCoMVelB(mb.nrBodies()),
+  normalAcc(mb.nrBodies())
+{
+}
+
 CoMJacobian::CoMJacobian() {}
 
 CoMJacobian::CoMJacobian(const MultiBody & mb)
-: jac_(3, mb.nrDof()), jacDot_(3, mb.nrDof()), bodiesCoeff_(mb.nrBodies()), bodiesCoM_(mb.nrBodies()),
-  jointsSubBodies_(mb.nrJoints()), bodiesCoMWorld_(mb.nrBodies()), bodiesCoMVelB_(mb.nrBodies()),
-  normalAcc_(mb.nrJoints()), weight_(mb.nrBodies(), 1.)
+: bodiesCoeff_(mb.nrBodies()), bodiesCoM_(mb.nrBodies()), jointsSubBodies_(mb.nrJoints()),
+  weight_(mb.nrBodies(), 1.), ws_(mb)
 {
   init(mb);
 }
 
 CoMJacobian::CoMJacobian(const MultiBody & mb, std::vector<double> weight)
-: jac_(3, mb.nrDof()), jacDot_(3, mb.nrDof()), bodiesCoeff_(mb.nrBodies()), bodiesCoM_(mb.nrBodies()),
-  jointsSubBodies_(mb.nrJoints()), bodiesCoMWorld_(mb.nrBodies()), bodiesCoMVelB_(mb.nrBodies()),
-  normalAcc_(mb.nrJoints()), weight_(std::move(weight))
+: bodiesCoeff_(mb.nrBodies()), bodiesCoM_(mb.nrBodies()), jointsSubBodies_(mb.nrJoints()),
+  weight_(std::move(weight)), ws_(mb)
 {
   if(int(weight_.size()) != mb.nrBodies())
   {
@@ -276,66 +280,78 @@ void CoMJacobian::weight(const MultiBody & mb, std::vector<double> w)
 }
 
 const Eigen::MatrixXd & CoMJacobian::jacobian(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return jacobian(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & CoMJacobian::jacobian(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
 {
   const std::vector<Joint> & joints = mb.joints();
 
-  jac_.setZero();
+  ws.jac.setZero();
 
   // we pre compute the CoM position of each bodie in world frame
   for(int i = 0; i < mb.nrBodies(); ++i)
   {
     // the transformation must be read {}^0E_p {}^pT_N {}^NX_0
     sva::PTransformd X_0_com_w = bodiesCoM_[i] * mbc.bodyPosW[i];
-    bodiesCoMWorld_[i] = sva::PTransformd(X_0_com_w.translation());
+    ws.bodiesCoMWorld[i] = sva::PTransformd(X_0_com_w.translation());
   }
 
   int curJ = 0;
   for(int i = 0; i < mb.nrJoints(); ++i)
   {
-    std::vector<int> & subBodies = jointsSubBodies_[i];
+    const std::vector<int> & subBodies = jointsSubBodies_[i];
     sva::PTransformd X_i_0 = mbc.bodyPosW[i].inv();
     for(int b : subBodies)
     {
-      sva::PTransformd X_i_com = bodiesCoMWorld_[b] * X_i_0;
+      sva::PTransformd X_i_com = ws.bodiesCoMWorld[b] * X_i_0;
       for(int dof = 0; dof < joints[i].dof(); ++dof)
       {
-        jac_.col(curJ + dof).noalias() +=
+        ws.jac.col(curJ + dof).noalias() +=
             (X_i_com.linearMul(sva::MotionVecd(mbc.motionSubspace[i].col(dof)))) * bodiesCoeff_[b];
       }
     }
     curJ += joints[i].dof();
   }
 
-  return jac_;
+  return ws.jac;
 }
 
 const Eigen::MatrixXd & CoMJacobian::jacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return jacobianDot(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & CoMJacobian::jacobianDot(const MultiBody & mb,
+                                                 const MultiBodyConfig & mbc,
+                                                 Workspace & ws) const
 {
   const std::vector<Joint> & joints = mb.joints();
 
-  jacDot_.setZero();
+  ws.jacDot.setZero();
 
   // we pre compute the CoM position/velocity of each bodie
   for(int i = 0; i < mb.nrBodies(); ++i)
   {
-    bodiesCoMWorld_[i] = bodiesCoM_[i] * mbc.bodyPosW[i];
-    bodiesCoMVelB_[i] = bodiesCoM_[i] * mbc.bodyVelB[i];
+    ws.bodiesCoMWorld[i] = bodiesCoM_[i] * mbc.bodyPosW[i];
+    ws.bodiesCoMVelB[i] = bodiesCoM_[i] * mbc.bodyVelB[i];
   }
 
   int curJ = 0;
   for(int i = 0; i < mb.nrJoints(); ++i)
   {
-    std::vector<int> & subBodies = jointsSubBodies_[i];
+    const std::vector<int> & subBodies = jointsSubBodies_[i];
     sva::PTransformd X_i_0 = mbc.bodyPosW[i].inv();
 
     for(int b : subBodies)
     {
-      sva::PTransformd X_i_com = bodiesCoMWorld_[b] * X_i_0;
+      sva::PTransformd X_i_com = ws.bodiesCoMWorld[b] * X_i_0;
       sva::PTransformd E_b_0(Eigen::Matrix3d(mbc.bodyPosW[b].rotation().transpose()));
 
       // angular velocity of rotation N to O
       sva::MotionVecd E_Vb(mbc.bodyVelW[b].angular(), Eigen::Vector3d::Zero());
-      sva::MotionVecd X_Vcom_i_com = X_i_com * mbc.bodyVelB[i] - bodiesCoMVelB_[b];
+      sva::MotionVecd X_Vcom_i_com = X_i_com * mbc.bodyVelB[i] - ws.bodiesCoMVelB[b];
 
       for(int dof = 0; dof < joints[i].dof(); ++dof)
       {
@@ -344,7 +360,7 @@ const Eigen::MatrixXd & CoMJacobian::jacobianDot(const MultiBody & mb, const Mul
         // JD_i = (E_com_0_d*X_i_com*S_i + E_com_0*X_i_com_d*S_i)*(mass/totalMass)
         // E_com_0_d = (ANG_Vcom)_0 x E_com_0
         // X_i_com_d = (Vi - Vcom)_com x X_i_com
-        jacDot_.col(curJ + dof).noalias() +=
+        ws.jacDot.col(curJ + dof).noalias() +=
             ((E_Vb.cross(E_b_0 * X_i_com * S_ij)).linear() + (E_b_0 * X_Vcom_i_com.cross(X_i_com * S_ij)).linear())
             * bodiesCoeff_[b];
       }
@@ -352,7 +368,7 @@ const Eigen::MatrixXd & CoMJacobian::jacobianDot(const MultiBody & mb, const Mul
     curJ += joints[i].dof();
   }
 
-  return jacDot_;
+  return ws.jacDot;
 }
 
 Eigen::Vector3d CoMJacobian::velocity(const MultiBody & mb, const MultiBodyConfig & mbc) const
@@ -372,6 +388,13 @@ Eigen::Vector3d CoMJacobian::velocity(const MultiBody & mb, const MultiBodyConfi
 }
 
 Eigen::Vector3d CoMJacobian::normalAcceleration(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return normalAcceleration(mb, mbc, ws_);
+}
+
+Eigen::Vector3d CoMJacobian::normalAcceleration(const MultiBody & mb,
+                                                const MultiBodyConfig & mbc,
+                                                Workspace & ws) const
 {
   const std::vector<int> & pred = mb.predecessors();
   const std::vector<int> & succ = mb.successors();
@@ -383,12 +406,12 @@ Eigen::Vector3d CoMJacobian::normalAcceleration(const MultiBody & mb, const Mult
     const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
 
     if(pred[i] != -1)
-      normalAcc_[succ[i]] = X_p_i * normalAcc_[pred[i]] + vb_i.cross(vj_i);
+      ws.normalAcc[succ[i]] = X_p_i * ws.normalAcc[pred[i]] + vb_i.cross(vj_i);
     else
-      normalAcc_[succ[i]] = vb_i.cross(vj_i);
+      ws.normalAcc[succ[i]] = vb_i.cross(vj_i);
   }
 
-  return normalAcceleration(mb, mbc, normalAcc_);
+  return normalAcceleration(mb, mbc, ws.normalAcc);
 }
 
 Eigen::Vector3d CoMJacobian::normalAcceleration(const MultiBody & mb,
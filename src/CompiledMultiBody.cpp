@@ -0,0 +1,544 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/CompiledMultiBody.h"
+
+// includes
+// std
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/Joint.h"
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace rbd
+{
+
+namespace
+{
+
+typedef CompiledMultiBody::CompiledJoint CompiledJoint;
+
+template<int Axis>
+Eigen::Matrix3d axisRotation(double q);
+
+template<>
+Eigen::Matrix3d axisRotation<0>(double q)
+{
+  return sva::RotX(q);
+}
+
+template<>
+Eigen::Matrix3d axisRotation<1>(double q)
+{
+  return sva::RotY(q);
+}
+
+template<>
+Eigen::Matrix3d axisRotation<2>(double q)
+{
+  return sva::RotZ(q);
+}
+
+/// Revolute joint about the X (0), Y (1) or Z (2) axis.
+template<int Axis>
+struct RevAxis
+{
+  static sva::PTransformd pose(const CompiledJoint & j, const double * q)
+  {
+    // AngleAxis(-q, sign*axis) is the sva rotation of angle sign*q
+    return sva::PTransformd(axisRotation<Axis>(j.sign * q[0]));
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    Eigen::Vector3d w = Eigen::Vector3d::Zero();
+    w(Axis) = j.sign * alpha[0];
+    return sva::MotionVecd(w, Eigen::Vector3d::Zero());
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    tau[0] = j.sign * f.couple()(Axis);
+  }
+};
+
+/// Revolute joint about any axis.
+struct Rev
+{
+  static sva::PTransformd pose(const CompiledJoint & j, const double * q)
+  {
+    return sva::PTransformd(Eigen::AngleAxisd(-q[0], j.axis).matrix());
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    return sva::MotionVecd(j.axis * alpha[0], Eigen::Vector3d::Zero());
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    tau[0] = j.axis.dot(f.couple());
+  }
+};
+
+/// Prismatic joint along the X (0), Y (1) or Z (2) axis.
+template<int Axis>
+struct PrismAxis
+{
+  static sva::PTransformd pose(const CompiledJoint & j, const double * q)
+  {
+    Eigen::Vector3d r = Eigen::Vector3d::Zero();
+    r(Axis) = j.sign * q[0];
+    return sva::PTransformd(r);
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    Eigen::Vector3d v = Eigen::Vector3d::Zero();
+    v(Axis) = j.sign * alpha[0];
+    return sva::MotionVecd(Eigen::Vector3d::Zero(), v);
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    tau[0] = j.sign * f.force()(Axis);
+  }
+};
+
+/// Prismatic joint along any axis.
+struct Prism
+{
+  static sva::PTransformd pose(const CompiledJoint & j, const double * q)
+  {
+    return sva::PTransformd(Eigen::Vector3d(j.axis * q[0]));
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    return sva::MotionVecd(Eigen::Vector3d::Zero(), j.axis * alpha[0]);
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    tau[0] = j.axis.dot(f.force());
+  }
+};
+
+struct Spherical
+{
+  static sva::PTransformd pose(const CompiledJoint & j, const double * q)
+  {
+    return sva::PTransformd(Eigen::Quaterniond(q[0], j.dir * q[1], j.dir * q[2], j.dir * q[3]).inverse());
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    return sva::MotionVecd(j.sign * Eigen::Vector3d(alpha[0], alpha[1], alpha[2]), Eigen::Vector3d::Zero());
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    Eigen::Map<Eigen::Vector3d> t(tau);
+    t = j.sign * f.couple();
+  }
+};
+
+template<bool Forward>
+struct Planar
+{
+  static sva::PTransformd pose(const CompiledJoint &, const double * q)
+  {
+    Eigen::Matrix3d rot = sva::RotZ(q[0]);
+    sva::PTransformd X(rot, rot.transpose() * Eigen::Vector3d(q[1], q[2], 0.));
+    return Forward ? X : X.inv();
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    return sva::MotionVecd(Eigen::Vector3d(0., 0., j.sign * alpha[0]),
+                           Eigen::Vector3d(j.sign * alpha[1], j.sign * alpha[2], 0.));
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    tau[0] = j.sign * f.couple().z();
+    tau[1] = j.sign * f.force().x();
+    tau[2] = j.sign * f.force().y();
+  }
+};
+
+struct Cylindrical
+{
+  static sva::PTransformd pose(const CompiledJoint & j, const double * q)
+  {
+    return sva::PTransformd(Eigen::AngleAxisd(-q[0], j.axis).matrix(), j.axis * q[1]);
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    return sva::MotionVecd(j.axis * alpha[0], j.axis * alpha[1]);
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    tau[0] = j.axis.dot(f.couple());
+    tau[1] = j.axis.dot(f.force());
+  }
+};
+
+template<bool Forward>
+struct Free
+{
+  static sva::PTransformd pose(const CompiledJoint &, const double * q)
+  {
+    sva::PTransformd X(QuatToE(Eigen::Map<const Eigen::Vector4d>(q)), Eigen::Vector3d(q[4], q[5], q[6]));
+    return Forward ? X : X.inv();
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint & j, const double * alpha)
+  {
+    return sva::MotionVecd(j.sign * Eigen::Map<const Eigen::Vector6d>(alpha));
+  }
+
+  static void torque(const CompiledJoint & j, const sva::ForceVecd & f, double * tau)
+  {
+    Eigen::Map<Eigen::Vector6d> t(tau);
+    t = j.sign * f.vector();
+  }
+};
+
+struct Fixed
+{
+  static sva::PTransformd pose(const CompiledJoint &, const double *)
+  {
+    return sva::PTransformd::Identity();
+  }
+
+  static sva::MotionVecd motion(const CompiledJoint &, const double *)
+  {
+    return sva::MotionVecd(Eigen::Vector6d::Zero());
+  }
+
+  static void torque(const CompiledJoint &, const sva::ForceVecd &, double *) {}
+};
+
+template<typename Kernel>
+void bind(CompiledJoint & j)
+{
+  j.pose = &Kernel::pose;
+  j.motion = &Kernel::motion;
+  j.torque = &Kernel::torque;
+}
+
+/// @return Index of the unit axis equal to a (-1 if none).
+int unitAxis(const Eigen::Vector3d & a)
+{
+  for(int i = 0; i < 3; ++i)
+  {
+    if(a == Eigen::Vector3d::Unit(i))
+      return i;
+  }
+  return -1;
+}
+
+void bindKernels(const Joint & joint, CompiledJoint & j)
+{
+  bool forward = joint.direction() == 1.;
+  switch(joint.type())
+  {
+    case Joint::Rev:
+      switch(unitAxis(joint.motionSubspace().col(0).head<3>().cwiseAbs()))
+      {
+        case 0:
+          bind<RevAxis<0>>(j);
+          break;
+        case 1:
+          bind<RevAxis<1>>(j);
+          break;
+        case 2:
+          bind<RevAxis<2>>(j);
+          break;
+        default:
+          bind<Rev>(j);
+          break;
+      }
+      break;
+    case Joint::Prism:
+      switch(unitAxis(joint.motionSubspace().col(0).tail<3>().cwiseAbs()))
+      {
+        case 0:
+          bind<PrismAxis<0>>(j);
+          break;
+        case 1:
+          bind<PrismAxis<1>>(j);
+          break;
+        case 2:
+          bind<PrismAxis<2>>(j);
+          break;
+        default:
+          bind<Prism>(j);
+          break;
+      }
+      break;
+    case Joint::Spherical:
+      bind<Spherical>(j);
+      break;
+    case Joint::Planar:
+      if(forward)
+        bind<Planar<true>>(j);
+      else
+        bind<Planar<false>>(j);
+      break;
+    case Joint::Cylindrical:
+      bind<Cylindrical>(j);
+      break;
+    case Joint::Free:
+      if(forward)
+        bind<Free<true>>(j);
+      else
+        bind<Free<false>>(j);
+      break;
+    case Joint::Fixed:
+    default:
+      bind<Fixed>(j);
+      break;
+  }
+}
+
+} // namespace
+
+CompiledMultiBody::CompiledMultiBody(const MultiBody & mb) : joints_(mb.nrJoints()), f_(mb.nrBodies())
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    const Joint & joint = mb.joint(i);
+    CompiledJoint & j = joints_[i];
+
+    bindKernels(joint, j);
+
+    // the motion subspace holds the direction, the kernels read it from axis and sign
+    const Eigen::Matrix<double, 6, Eigen::Dynamic> & S = joint.motionSubspace();
+    j.S = S;
+    j.axis.setZero();
+    j.sign = 1.;
+    switch(joint.type())
+    {
+      case Joint::Rev:
+      case Joint::Cylindrical:
+        j.axis = S.col(0).head<3>();
+        j.sign = j.axis.sum();
+        break;
+      case Joint::Prism:
+        j.axis = S.col(0).tail<3>();
+        j.sign = j.axis.sum();
+        break;
+      case Joint::Spherical:
+      case Joint::Free:
+        j.sign = S(0, 0);
+        break;
+      case Joint::Planar:
+        j.sign = S(2, 0);
+        break;
+      default:
+        break;
+    }
+    j.dir = joint.direction();
+
+    j.pred = mb.predecessor(i);
+    j.paramPos = mb.jointPosInParam(i);
+    j.dofPos = mb.jointPosInDof(i);
+
+    j.Xt = mb.transform(i);
+    j.inertia = mb.body(mb.successor(i)).inertia();
+  }
+}
+
+void CompiledMultiBody::forwardKinematics(const Eigen::Ref<const Eigen::VectorXd> & q, MultiBodyConfig & mbc) const
+{
+  for(std::size_t i = 0; i < joints_.size(); ++i)
+  {
+    const CompiledJoint & j = joints_[i];
+
+    mbc.jointConfig[i] = j.pose(j, q.data() + j.paramPos);
+    mbc.parentToSon[i] = mbc.jointConfig[i] * j.Xt;
+    mbc.motionSubspace[i] = j.S;
+
+    if(j.pred != -1)
+      mbc.bodyPosW[i] = mbc.parentToSon[i] * mbc.bodyPosW[j.pred];
+    else
+      mbc.bodyPosW[i] = mbc.parentToSon[i];
+  }
+}
+
+void CompiledMultiBody::forwardVelocity(const Eigen::Ref<const Eigen::VectorXd> & alpha, MultiBodyConfig & mbc) const
+{
+  for(std::size_t i = 0; i < joints_.size(); ++i)
+  {
+    const CompiledJoint & j = joints_[i];
+
+    mbc.jointVelocity[i] = j.motion(j, alpha.data() + j.dofPos);
+
+    if(j.pred != -1)
+      mbc.bodyVelB[i] = mbc.parentToSon[i] * mbc.bodyVelB[j.pred] + mbc.jointVelocity[i];
+    else
+      mbc.bodyVelB[i] = mbc.jointVelocity[i];
+
+    sva::PTransformd E_0_i(mbc.bodyPosW[i].rotation());
+    mbc.bodyVelW[i] = E_0_i.invMul(mbc.bodyVelB[i]);
+  }
+}
+
+void CompiledMultiBody::forwardAcceleration(const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                            MultiBodyConfig & mbc,
+                                            const sva::MotionVecd & A_0) const
+{
+  for(std::size_t i = 0; i < joints_.size(); ++i)
+  {
+    const CompiledJoint & j = joints_[i];
+
+    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+    sva::MotionVecd ai_tan = j.motion(j, alphaD.data() + j.dofPos);
+
+    if(j.pred != -1)
+      mbc.bodyAccB[i] = mbc.parentToSon[i] * mbc.bodyAccB[j.pred] + ai_tan + vb_i.cross(mbc.jointVelocity[i]);
+    else
+      mbc.bodyAccB[i] = mbc.parentToSon[i] * A_0 + ai_tan + vb_i.cross(mbc.jointVelocity[i]);
+  }
+}
+
+void CompiledMultiBody::inverseDynamics(const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                        MultiBodyConfig & mbc,
+                                        Eigen::Ref<Eigen::VectorXd> jointTorque)
+{
+  inverseDynamics(alphaD, mbc, jointTorque, f_);
+}
+
+void CompiledMultiBody::inverseDynamics(const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                        MultiBodyConfig & mbc,
+                                        Eigen::Ref<Eigen::VectorXd> jointTorque,
+                                        std::vector<sva::ForceVecd> & f) const
+{
+  sva::MotionVecd a_0(Eigen::Vector3d::Zero(), mbc.gravity);
+  forwardAcceleration(alphaD, mbc, a_0);
+
+  for(std::size_t i = 0; i < joints_.size(); ++i)
+  {
+    const sva::RBInertiad & I = joints_[i].inertia;
+    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+
+    f[i] = I * mbc.bodyAccB[i] + vb_i.crossDual(I * vb_i) - mbc.bodyPosW[i].dualMul(mbc.force[i]);
+  }
+
+  for(int i = static_cast<int>(joints_.size()) - 1; i >= 0; --i)
+  {
+    const CompiledJoint & j = joints_[i];
+
+    j.torque(j, f[i], jointTorque.data() + j.dofPos);
+
+    if(j.pred != -1)
+      f[j.pred] = f[j.pred] + mbc.parentToSon[i].transMul(f[i]);
+  }
+}
+
+void CompiledMultiBody::checkMatchMultiBody(const MultiBody & mb) const
+{
+  if(static_cast<int>(joints_.size()) != mb.nrJoints())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+}
+
+void CompiledMultiBody::sForwardKinematics(const MultiBody & mb,
+                                           const Eigen::Ref<const Eigen::VectorXd> & q,
+                                           MultiBodyConfig & mbc) const
+{
+  checkMatchMultiBody(mb);
+  checkMatchParamVector(mb, q, "Generalized position variable vector");
+
+  checkMatchBodyPos(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  forwardKinematics(q, mbc);
+}
+
+void CompiledMultiBody::sForwardVelocity(const MultiBody & mb,
+                                         const Eigen::Ref<const Eigen::VectorXd> & alpha,
+                                         MultiBodyConfig & mbc) const
+{
+  checkMatchMultiBody(mb);
+  checkMatchDofVector(mb, alpha, "Generalized velocity variable vector");
+  checkMatchBodyPos(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+
+  checkMatchBodyVel(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+
+  forwardVelocity(alpha, mbc);
+}
+
+void CompiledMultiBody::sForwardAcceleration(const MultiBody & mb,
+                                             const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                             MultiBodyConfig & mbc,
+                                             const sva::MotionVecd & A_0) const
+{
+  checkMatchMultiBody(mb);
+  checkMatchDofVector(mb, alphaD, "Generalized acceleration variable vector");
+  checkMatchParentToSon(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+
+  checkMatchBodyAcc(mb, mbc);
+
+  forwardAcceleration(alphaD, mbc, A_0);
+}
+
+void CompiledMultiBody::sInverseDynamics(const MultiBody & mb,
+                                         const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                         MultiBodyConfig & mbc,
+                                         Eigen::Ref<Eigen::VectorXd> jointTorque)
+{
+  checkMatchMultiBody(mb);
+  checkMatchDofVector(mb, alphaD, "Generalized acceleration variable vector");
+  checkMatchForce(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+
+  checkMatchBodyAcc(mb, mbc);
+  checkMatchDofVector(mb, jointTorque, "Joint torque vector");
+
+  inverseDynamics(alphaD, mbc, jointTorque);
+}
+
+void CompiledMultiBody::sInverseDynamics(const MultiBody & mb,
+                                         const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                         MultiBodyConfig & mbc,
+                                         Eigen::Ref<Eigen::VectorXd> jointTorque,
+                                         std::vector<sva::ForceVecd> & f) const
+{
+  checkMatchMultiBody(mb);
+  checkMatchDofVector(mb, alphaD, "Generalized acceleration variable vector");
+  checkMatchForce(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+
+  checkMatchBodyAcc(mb, mbc);
+  checkMatchDofVector(mb, jointTorque, "Joint torque vector");
+  if(static_cast<int>(f.size()) != mb.nrBodies())
+  {
+    throw std::domain_error("Internal forces vector size mismatch");
+  }
+
+  inverseDynamics(alphaD, mbc, jointTorque, f);
+}
+
+} // namespace rbd
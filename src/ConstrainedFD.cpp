@@ -0,0 +1,283 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/ConstrainedFD.h"
+
+// includes
+// std
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace
+{
+
+std::vector<int> pathDofs(const rbd::MultiBody & mb, const rbd::Jacobian & jac)
+{
+  std::vector<int> dofs;
+  for(int j : jac.jointsPath())
+  {
+    for(int dof = 0; dof < mb.joint(j).dof(); ++dof)
+    {
+      dofs.push_back(mb.jointPosInDof(j) + dof);
+    }
+  }
+  return dofs;
+}
+
+void checkMatchSize(const Eigen::Ref<const Eigen::VectorXd> & vec, Eigen::Index rows, const char * name)
+{
+  if(vec.rows() != rows)
+  {
+    std::ostringstream str;
+    str << name << " size mismatch: expected size " << rows << " gived " << vec.rows();
+    throw std::domain_error(str.str());
+  }
+}
+
+} // namespace
+
+namespace rbd
+{
+
+ConstrainedForwardDynamics::ConstrainedForwardDynamics(const MultiBody & mb,
+                                                       const std::vector<Constraint> & constraints)
+: nrRows_(0), kp_(0.), kd_(0.), fd_(mb), ltdl_(mb)
+{
+  constraints_.reserve(constraints.size());
+  for(const Constraint & c : constraints)
+  {
+    ConstraintData data;
+    data.X_b1_f1 = c.X_b1_f1;
+    data.X_b2_f2 = c.X_b2_f2;
+    data.body1 = mb.sBodyIndexByName(c.body1);
+    data.jac1 = Jacobian(mb, c.body1, c.X_b1_f1.translation());
+    data.dofs1 = pathDofs(mb, data.jac1);
+    if(c.body2.empty())
+    {
+      data.body2 = -1;
+    }
+    else
+    {
+      data.body2 = mb.sBodyIndexByName(c.body2);
+      data.jac2 = Jacobian(mb, c.body2, c.X_b2_f2.translation());
+      data.dofs2 = pathDofs(mb, data.jac2);
+    }
+    std::set_union(data.dofs1.begin(), data.dofs1.end(), data.dofs2.begin(), data.dofs2.end(),
+                   std::back_inserter(data.dofs));
+    data.rows = c.linear ? 3 : 6;
+    data.rowOffset = nrRows_;
+    data.W.resize(data.dofs.size(), data.rows);
+    nrRows_ += data.rows;
+    constraints_.push_back(std::move(data));
+  }
+
+  J_.resize(nrRows_, mb.nrDof());
+  G_.resize(nrRows_, nrRows_);
+  ldlt_ = Eigen::LDLT<Eigen::MatrixXd>(nrRows_);
+  error_.resize(nrRows_);
+  velocity_.resize(nrRows_);
+  gamma_.resize(nrRows_);
+  lambda_.resize(nrRows_);
+  dInvSqrt_.resize(mb.nrDof());
+  alpha_.resize(mb.nrDof());
+  s_.resize(mb.nrDof());
+  tmpAlpha_.resize(mb.nrDof());
+}
+
+void ConstrainedForwardDynamics::forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  paramToVector(mbc.jointTorque, tmpAlpha_);
+  forwardDynamics(mb, tmpAlpha_, mbc, tmpAlpha_);
+  vectorToParam(tmpAlpha_, mbc.alphaD);
+}
+
+void ConstrainedForwardDynamics::forwardDynamics(const MultiBody & mb,
+                                                 const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                                 const MultiBodyConfig & mbc,
+                                                 Eigen::Ref<Eigen::VectorXd> alphaD)
+{
+  factorize(mb, mbc);
+  solve(jointTorque, gamma_, alphaD);
+}
+
+void ConstrainedForwardDynamics::factorize(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  fd_.computeHC(mb, mbc);
+  ltdl_.compute(fd_.H());
+  paramToVector(mbc.alpha, alpha_);
+  dInvSqrt_ = ltdl_.matrix().diagonal().cwiseSqrt().cwiseInverse();
+
+  J_.setZero();
+  for(ConstraintData & c : constraints_)
+  {
+    // linear constraints only use the linear part of the jacobians
+    int top = 6 - c.rows;
+    auto gamma = gamma_.segment(c.rowOffset, c.rows);
+
+    const Eigen::MatrixXd & jac1 = c.jac1.jacobian(mb, mbc);
+    const Eigen::MatrixXd & jacDot1 = c.jac1.jacobianDot(mb, mbc);
+    gamma.setZero();
+    for(std::size_t k = 0; k < c.dofs1.size(); ++k)
+    {
+      J_.col(c.dofs1[k]).segment(c.rowOffset, c.rows) += jac1.col(k).tail(c.rows);
+      gamma -= jacDot1.col(k).tail(c.rows) * alpha_(c.dofs1[k]);
+    }
+    sva::PTransformd X_0_f1 = c.X_b1_f1 * mbc.bodyPosW[c.body1];
+
+    sva::PTransformd X_0_f2 = c.X_b2_f2;
+    if(c.body2 != -1)
+    {
+      const Eigen::MatrixXd & jac2 = c.jac2.jacobian(mb, mbc);
+      const Eigen::MatrixXd & jacDot2 = c.jac2.jacobianDot(mb, mbc);
+      for(std::size_t k = 0; k < c.dofs2.size(); ++k)
+      {
+        J_.col(c.dofs2[k]).segment(c.rowOffset, c.rows) -= jac2.col(k).tail(c.rows);
+        gamma += jacDot2.col(k).tail(c.rows) * alpha_(c.dofs2[k]);
+      }
+      X_0_f2 = c.X_b2_f2 * mbc.bodyPosW[c.body2];
+    }
+
+    if(top == 0)
+    {
+      error_.segment<3>(c.rowOffset) = sva::rotationError(X_0_f2.rotation(), X_0_f1.rotation());
+    }
+    error_.segment<3>(c.rowOffset + 3 - top) = X_0_f1.translation() - X_0_f2.translation();
+  }
+
+  velocity_.noalias() = J_ * alpha_;
+  gamma_ -= kd_ * velocity_ + kp_ * error_;
+
+  // W = D^-1/2 L^-T J^T, the ancestors of a constraint dofs are also
+  // constraint dofs so L^-T J^T stay in the constraint dofs
+  for(ConstraintData & c : constraints_)
+  {
+    for(std::size_t k = 0; k < c.dofs.size(); ++k)
+    {
+      c.W.row(k) = J_.col(c.dofs[k]).segment(c.rowOffset, c.rows).transpose();
+    }
+    ltdl_.halfSolveInPlace(c.dofs, c.W);
+  }
+
+  // G = W^T W
+  for(std::size_t i = 0; i < constraints_.size(); ++i)
+  {
+    const ConstraintData & ci = constraints_[i];
+    G_.block(ci.rowOffset, ci.rowOffset, ci.rows, ci.rows).noalias() = ci.W.transpose() * ci.W;
+    for(std::size_t j = 0; j < i; ++j)
+    {
+      const ConstraintData & cj = constraints_[j];
+      LTDLFactorization::sharedDofsProduct(ci.dofs, ci.W, cj.dofs, cj.W,
+                                           G_.block(ci.rowOffset, cj.rowOffset, ci.rows, cj.rows));
+      G_.block(cj.rowOffset, ci.rowOffset, cj.rows, ci.rows) =
+          G_.block(ci.rowOffset, cj.rowOffset, ci.rows, cj.rows).transpose();
+    }
+  }
+  ldlt_.compute(G_);
+}
+
+void ConstrainedForwardDynamics::solve(const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                       Eigen::Ref<Eigen::VectorXd> alphaD)
+{
+  solve(jointTorque, gamma_, alphaD);
+}
+
+void ConstrainedForwardDynamics::solve(const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                       const Eigen::Ref<const Eigen::VectorXd> & gamma,
+                                       Eigen::Ref<Eigen::VectorXd> alphaD)
+{
+  // s = D^-1/2 L^-T (tau - C), so the unconstrained acceleration is
+  // L^-1 D^-1/2 s and its constraint acceleration is W^T s
+  s_ = jointTorque - fd_.C();
+  ltdl_.solveLTransposeInPlace(s_);
+  s_.array() *= dInvSqrt_.array();
+
+  // G lambda = gamma - J H^-1 (tau - C)
+  lambda_ = gamma;
+  for(const ConstraintData & c : constraints_)
+  {
+    for(std::size_t k = 0; k < c.dofs.size(); ++k)
+    {
+      lambda_.segment(c.rowOffset, c.rows) -= c.W.row(k).transpose() * s_(c.dofs[k]);
+    }
+  }
+  ldlt_.solveInPlace(lambda_);
+
+  // alphaD = H^-1 (tau - C + J^T lambda)
+  alphaD = s_;
+  for(const ConstraintData & c : constraints_)
+  {
+    for(std::size_t k = 0; k < c.dofs.size(); ++k)
+    {
+      alphaD(c.dofs[k]) += c.W.row(k).dot(lambda_.segment(c.rowOffset, c.rows));
+    }
+  }
+  alphaD.array() *= dInvSqrt_.array();
+  ltdl_.solveLInPlace(alphaD);
+}
+
+void ConstrainedForwardDynamics::sForwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchForce(mb, mbc);
+  checkMatchAlpha(mb, mbc);
+  checkMatchJointTorque(mb, mbc);
+
+  checkMatchAlphaD(mb, mbc);
+  checkMatchMultiBody(mb);
+
+  forwardDynamics(mb, mbc);
+}
+
+void ConstrainedForwardDynamics::sForwardDynamics(const MultiBody & mb,
+                                                  const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                                  const MultiBodyConfig & mbc,
+                                                  Eigen::Ref<Eigen::VectorXd> alphaD)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchForce(mb, mbc);
+  checkMatchAlpha(mb, mbc);
+  checkMatchDofVector(mb, jointTorque, "Joint torque vector");
+
+  checkMatchDofVector(mb, alphaD, "Generalized acceleration variable vector");
+  checkMatchMultiBody(mb);
+
+  forwardDynamics(mb, jointTorque, mbc, alphaD);
+}
+
+void ConstrainedForwardDynamics::sSolve(const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                        const Eigen::Ref<const Eigen::VectorXd> & gamma,
+                                        Eigen::Ref<Eigen::VectorXd> alphaD)
+{
+  checkMatchSize(jointTorque, alpha_.size(), "jointTorque");
+  checkMatchSize(gamma, nrRows_, "gamma");
+  checkMatchSize(alphaD, alpha_.size(), "alphaD");
+
+  solve(jointTorque, gamma, alphaD);
+}
+
+void ConstrainedForwardDynamics::checkMatchMultiBody(const MultiBody & mb) const
+{
+  if(alpha_.size() != mb.nrDof() || J_.cols() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+}
+
+} // namespace rbd
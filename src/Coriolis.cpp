@@ -7,71 +7,119 @@
 namespace rbd
 {
 
-Coriolis::Coriolis(const rbd::MultiBody & mb) : coriolis_(mb.nrDof(), mb.nrDof()), res_(0, 0)
+Coriolis::Workspace::Workspace(const rbd::MultiBody & mb)
+: coriolis(mb.nrDof(), mb.nrDof()), S(6, mb.nrDof()), SD(6, mb.nrDof()), F(6, mb.nrDof()), IS(6, mb.nrDof()),
+  BS(3, mb.nrDof()), I(static_cast<std::size_t>(mb.nrBodies())), Bw(static_cast<std::size_t>(mb.nrBodies())),
+  P(static_cast<std::size_t>(mb.nrBodies()))
 {
-  Eigen::Vector3d com;
-  double mass;
-  for(int i = 0; i < mb.nrBodies(); ++i)
-  {
-    mass = mb.body(i).inertia().mass();
-    if(mass > 0)
-    {
-      com = mb.body(i).inertia().momentum() / mass;
-    }
-    else
-    {
-      com.setZero();
-    }
-    jacs_.push_back(rbd::Jacobian(mb, mb.body(i).name(), com));
-    compactPaths_.push_back(jacs_.back().compactPath(mb));
-    if(jacs_.back().dof() > res_.rows())
-    {
-      res_.resize(jacs_.back().dof(), jacs_.back().dof());
-    }
-  }
 }
 
+Coriolis::Coriolis(const rbd::MultiBody & mb) : ws_(mb) {}
+
 const Eigen::MatrixXd & Coriolis::coriolis(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc)
 {
-  Eigen::Matrix3d rot;
-  Eigen::Matrix3d rDot;
-
-  Eigen::Matrix3d inertia;
+  return coriolis(mb, mbc, ws_);
+}
 
-  coriolis_.setZero();
+const Eigen::MatrixXd & Coriolis::coriolis(const rbd::MultiBody & mb,
+                                           const rbd::MultiBodyConfig & mbc,
+                                           Workspace & ws) const
+{
+  const std::vector<int> & parents = mb.parents();
 
+  /* In world frame, with p the body CoM, the Bjerkend and Pettersen
+   * factorization is C = \sum J_i^T (I_i \dot{J}_i + B_i J_i) with
+   * B_i = [[[w]x R I_c R^T - m [p]x [\dot{p}]x, 0], [-m [\dot{p}]x, 0]]. */
   for(int i = 0; i < mb.nrBodies(); ++i)
   {
-    const auto & jac = jacs_[i].jacobian(mb, mbc);
-    const auto & jacDot = jacs_[i].jacobianDot(mb, mbc);
-
-    rot = mbc.bodyPosW[i].rotation().transpose();
-    rDot.noalias() = sva::vector3ToCrossMatrix(mbc.bodyVelW[i].angular()) * rot;
+    const sva::PTransformd & X_0_i = mbc.bodyPosW[i];
+    sva::MotionVecd v = X_0_i.invMul(mbc.bodyVelB[i]);
 
-    auto jvi = jac.bottomRows<3>();
-    auto jDvi = jacDot.bottomRows<3>();
-
-    auto jwi = jac.topRows<3>();
-    auto jDwi = jacDot.topRows<3>();
+    int pos = mb.jointPosInDof(i);
+    for(int dof = 0; dof < mb.joint(i).dof(); ++dof)
+    {
+      sva::MotionVecd S = X_0_i.invMul(sva::MotionVecd(mbc.motionSubspace[i].col(dof)));
+      ws.S.col(pos + dof) = S.vector();
+      // the motion subspace is constant in body frame
+      ws.SD.col(pos + dof) = v.cross(S).vector();
+    }
 
-    double mass = mb.body(i).inertia().mass();
-    inertia = mb.body(i).inertia().inertia()
-              - sva::vector3ToCrossMatrix<double>(mass * jacs_[i].point())
-                    * sva::vector3ToCrossMatrix(jacs_[i].point()).transpose();
+    ws.I[i] = X_0_i.transMul(mb.body(i).inertia());
+    double mass = ws.I[i].mass();
+    const Eigen::Vector3d & h = ws.I[i].momentum();
+    if(mass > 0.)
+    {
+      // m*\dot{p} and rotational inertia at the CoM
+      ws.P[i] = mass * v.linear() + v.angular().cross(h);
+      Eigen::Matrix3d hCross = sva::vector3ToCrossMatrix(h);
+      ws.Bw[i].noalias() = sva::vector3ToCrossMatrix(v.angular()) * (ws.I[i].inertia() + hCross * hCross / mass);
+      ws.Bw[i].noalias() -= hCross * sva::vector3ToCrossMatrix(ws.P[i]) / mass;
+    }
+    else
+    {
+      ws.P[i].setZero();
+      ws.Bw[i].noalias() = sva::vector3ToCrossMatrix(v.angular()) * ws.I[i].inertia();
+    }
+  }
 
-    Eigen::Matrix3d ir = inertia * rot.transpose();
+  // composite quantities
+  for(int i = mb.nrBodies() - 1; i >= 0; --i)
+  {
+    if(parents[i] != -1)
+    {
+      ws.I[parents[i]] += ws.I[i];
+      ws.Bw[parents[i]] += ws.Bw[i];
+      ws.P[parents[i]] += ws.P[i];
+    }
+  }
 
-    /* C = \sum m_i J_{v_i}^T \dot{J}_{v_i}
-     *        + J_{w_i}^T R_i I_i R_i^T \dot{J}_{w_i}
-     *        + J_{w_i}^T \dot{R}_i I_i R_i^T J_{w_i} */
+  for(int j = 0; j < mb.nrJoints(); ++j)
+  {
+    int pos = mb.jointPosInDof(j);
+    for(int dof = 0; dof < mb.joint(j).dof(); ++dof)
+    {
+      sva::MotionVecd S(ws.S.col(pos + dof));
+      // B*S and B^T*S
+      Eigen::Vector3d BSa = ws.Bw[j] * S.angular();
+      Eigen::Vector3d BSl = S.angular().cross(ws.P[j]);
+      ws.F.col(pos + dof) = (ws.I[j] * sva::MotionVecd(ws.SD.col(pos + dof))).vector();
+      ws.F.col(pos + dof).head<3>() += BSa;
+      ws.F.col(pos + dof).tail<3>() += BSl;
+      ws.IS.col(pos + dof) = (ws.I[j] * S).vector();
+      ws.BS.col(pos + dof).noalias() = ws.Bw[j].transpose() * S.angular();
+      ws.BS.col(pos + dof) += ws.P[j].cross(S.linear());
+    }
+  }
 
-    res_.topLeftCorner(jacs_[i].dof(), jacs_[i].dof()).noalias() =
-        mass * jvi.transpose() * jDvi + jwi.transpose() * (rot * ir * jDwi + rDot * ir * jwi);
+  ws.coriolis.setZero();
+  for(int j = 0; j < mb.nrJoints(); ++j)
+  {
+    int dofJ = mb.joint(j).dof();
+    if(dofJ == 0)
+    {
+      continue;
+    }
+    int posJ = mb.jointPosInDof(j);
 
-    jacs_[i].expandAdd(compactPaths_[i], res_.topLeftCorner(jacs_[i].dof(), jacs_[i].dof()), coriolis_);
+    // C(a, j) = S_a^T (I_j \dot{S}_j + B_j S_j) for a ancestor of j (j included)
+    // C(j, a) = S_j^T (I_j \dot{S}_a + B_j S_a) for a strict ancestor of j
+    for(int a = j; a != -1; a = parents[a])
+    {
+      int dofA = mb.joint(a).dof();
+      int posA = mb.jointPosInDof(a);
+      ws.coriolis.block(posA, posJ, dofA, dofJ).noalias() =
+          ws.S.middleCols(posA, dofA).transpose() * ws.F.middleCols(posJ, dofJ);
+      if(a != j)
+      {
+        ws.coriolis.block(posJ, posA, dofJ, dofA).noalias() =
+            ws.IS.middleCols(posJ, dofJ).transpose() * ws.SD.middleCols(posA, dofA);
+        ws.coriolis.block(posJ, posA, dofJ, dofA).noalias() +=
+            ws.BS.middleCols(posJ, dofJ).transpose() * ws.S.middleCols(posA, dofA).topRows<3>();
+      }
+    }
   }
 
-  return coriolis_;
+  return ws.coriolis;
 }
 
 } // namespace rbd
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/Delassus.h"
+
+// includes
+// std
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace rbd
+{
+
+Delassus::Delassus(const MultiBody & mb, const std::vector<Frame> & frames, bool linear)
+: frameRows_(linear ? 3 : 6), nrRows_(frameRows_ * static_cast<int>(frames.size())), rowOffset_(frames.size()),
+  dofs_(frames.size()), W_(frames.size()), fd_(mb), ltdl_(mb),
+  delassus_(nrRows_, nrRows_), lambda_(nrRows_, nrRows_), llt_(nrRows_)
+{
+  jacs_.reserve(frames.size());
+  for(std::size_t f = 0; f < frames.size(); ++f)
+  {
+    jacs_.emplace_back(mb, frames[f].bodyName, frames[f].point);
+    rowOffset_[f] = frameRows_ * static_cast<int>(f);
+
+    for(int j : jacs_[f].jointsPath())
+    {
+      for(int dof = 0; dof < mb.joint(j).dof(); ++dof)
+      {
+        dofs_[f].push_back(mb.jointPosInDof(j) + dof);
+      }
+    }
+    W_[f].resize(dofs_[f].size(), frameRows_);
+  }
+}
+
+const Eigen::MatrixXd & Delassus::delassus(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  fd_.computeH(mb, mbc);
+  ltdl_.compute(fd_.H());
+  return delassus(mb, mbc, ltdl_);
+}
+
+const Eigen::MatrixXd & Delassus::delassus(const MultiBody & mb,
+                                           const MultiBodyConfig & mbc,
+                                           const LTDLFactorization & ltdl)
+{
+  for(std::size_t f = 0; f < jacs_.size(); ++f)
+  {
+    const Eigen::MatrixXd & jac = jacs_[f].jacobian(mb, mbc);
+    W_[f] = jac.bottomRows(frameRows_).transpose();
+    ltdl.halfSolveInPlace(dofs_[f], W_[f]);
+  }
+
+  for(std::size_t f = 0; f < jacs_.size(); ++f)
+  {
+    delassus_.block(rowOffset_[f], rowOffset_[f], frameRows_, frameRows_).noalias() = W_[f].transpose() * W_[f];
+    for(std::size_t g = 0; g < f; ++g)
+    {
+      LTDLFactorization::sharedDofsProduct(dofs_[f], W_[f], dofs_[g], W_[g],
+                                           delassus_.block(rowOffset_[f], rowOffset_[g], frameRows_, frameRows_));
+      delassus_.block(rowOffset_[g], rowOffset_[f], frameRows_, frameRows_) =
+          delassus_.block(rowOffset_[f], rowOffset_[g], frameRows_, frameRows_).transpose();
+    }
+  }
+
+  return delassus_;
+}
+
+const Eigen::MatrixXd & Delassus::operationalSpaceInertia()
+{
+  llt_.compute(delassus_);
+  lambda_.setIdentity();
+  llt_.solveInPlace(lambda_);
+  return lambda_;
+}
+
+const Eigen::MatrixXd & Delassus::sDelassus(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchMultiBody(mb);
+
+  return delassus(mb, mbc);
+}
+
+const Eigen::MatrixXd & Delassus::sDelassus(const MultiBody & mb,
+                                            const MultiBodyConfig & mbc,
+                                            const LTDLFactorization & ltdl)
+{
+  checkMatchBodyPos(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchMultiBody(mb);
+  if(ltdl.matrix().rows() != mb.nrDof())
+  {
+    throw std::domain_error("LTDLFactorization mismatch");
+  }
+
+  return delassus(mb, mbc, ltdl);
+}
+
+const Eigen::MatrixXd & Delassus::sOperationalSpaceInertia()
+{
+  operationalSpaceInertia();
+  if(llt_.info() != Eigen::Success)
+  {
+    throw std::domain_error("Delassus operator is not positive definite");
+  }
+
+  return lambda_;
+}
+
+void Delassus::checkMatchMultiBody(const MultiBody & mb) const
+{
+  if(ltdl_.matrix().rows() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+  for(const std::vector<int> & dofs : dofs_)
+  {
+    if(!dofs.empty() && dofs.back() >= mb.nrDof())
+    {
+      throw std::domain_error("MultiBody mismatch");
+    }
+  }
+}
+
+} // namespace rbd
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/DynamicsIntegration.h"
+
+// includes
+// std
+#include <cmath>
+#include <stdexcept>
+
+// Eigen
+#include <Eigen/Geometry>
+
+// RBDyn
+#include "RBDyn/EulerIntegration.h"
+#include "RBDyn/FK.h"
+#include "RBDyn/FV.h"
+#include "RBDyn/MultiBody.h"
+
+namespace
+{
+
+/** Derivative of the exponential coordinates O of q0^-1*q from the body
+ * angular velocity w (inverse of the right jacobian of SO(3)).
+ * The series is truncated after the second order term, enough for a
+ * fourth order scheme.
+ */
+Eigen::Vector3d dexpInv(const Eigen::Vector3d & O, const Eigen::Vector3d & w)
+{
+  Eigen::Vector3d Ow = O.cross(w);
+  return w + Ow / 2. + O.cross(Ow) / 12.;
+}
+
+/// q = q0*exp(O) with q and q0 as (w, x, y, z) quaternions.
+template<typename ConstVector, typename Vector>
+void quaternionRetract(const ConstVector & q0, const Eigen::Vector3d & O, Vector && q)
+{
+  Eigen::Quaterniond qi(q0[0], q0[1], q0[2], q0[3]);
+  // exp(O) is the quaternion (cos(|O|/2), sin(|O|/2)*O/|O|)
+  Eigen::Vector3d Oh = O / 2.;
+  double n = Oh.norm();
+  double s = sva::sinc(n);
+  qi *= Eigen::Quaterniond(std::cos(n), s * Oh.x(), s * Oh.y(), s * Oh.z());
+  qi.normalize();
+
+  q[0] = qi.w();
+  q[1] = qi.x();
+  q[2] = qi.y();
+  q[3] = qi.z();
+}
+
+} // namespace
+
+namespace rbd
+{
+
+DynamicsIntegrator::DynamicsIntegrator(const MultiBody & mb, Method method)
+: fd_(mb), method_(method), mbc_(mb), jointTorque_(mb.nrDof()), q0_(mb.nrParams()), alpha0_(mb.nrDof()),
+  q_(mb.nrParams()), alpha_(mb.nrDof()), a1_(mb.nrDof()), a2_(mb.nrDof()), a3_(mb.nrDof()), a4_(mb.nrDof()),
+  eta_(mb.nrDof()), etaD1_(mb.nrDof()), etaD2_(mb.nrDof()), etaD3_(mb.nrDof()), etaD4_(mb.nrDof())
+{
+  mbc_.zero(mb);
+}
+
+void DynamicsIntegrator::integrate(const MultiBody & mb, MultiBodyConfig & mbc, double step)
+{
+  paramToVector(mbc.q, q0_);
+  paramToVector(mbc.alpha, alpha0_);
+  paramToVector(mbc.jointTorque, jointTorque_);
+  mbc_.force = mbc.force;
+  mbc_.gravity = mbc.gravity;
+
+  eta_.setZero();
+  acceleration(mb, q0_, alpha0_, a1_);
+  switch(method_)
+  {
+    case Euler:
+      q_ = q0_;
+      alpha_ = alpha0_;
+      eulerIntegration(mb, q_, alpha_, a1_, step);
+      break;
+
+    case SemiImplicitEuler:
+      // the new velocity is used to integrate the configuration
+      alpha_ = alpha0_ + step * a1_;
+      localVelocity(mb, q0_, eta_, alpha_, etaD1_);
+      eta_ = step * etaD1_;
+      retract(mb, eta_, q_);
+      break;
+
+    case StormerVerlet:
+      // the configuration is integrated with the mid-step velocity (midpoint rule)
+      alpha_ = alpha0_ + (step / 2.) * a1_;
+      localVelocity(mb, q0_, eta_, alpha_, etaD1_);
+      eta_ = (step / 2.) * etaD1_;
+      retract(mb, eta_, q_);
+      localVelocity(mb, q_, eta_, alpha_, etaD2_);
+      eta_ = step * etaD2_;
+      retract(mb, eta_, q_);
+
+      // a4_ store the predicted final velocity
+      a4_ = alpha0_ + step * a1_;
+      acceleration(mb, q_, a4_, a2_);
+      alpha_ += (step / 2.) * a2_;
+      break;
+
+    case RK4:
+    default:
+      localVelocity(mb, q0_, eta_, alpha0_, etaD1_);
+
+      eta_ = (step / 2.) * etaD1_;
+      alpha_ = alpha0_ + (step / 2.) * a1_;
+      retract(mb, eta_, q_);
+      localVelocity(mb, q_, eta_, alpha_, etaD2_);
+      acceleration(mb, q_, alpha_, a2_);
+
+      eta_ = (step / 2.) * etaD2_;
+      alpha_ = alpha0_ + (step / 2.) * a2_;
+      retract(mb, eta_, q_);
+      localVelocity(mb, q_, eta_, alpha_, etaD3_);
+      acceleration(mb, q_, alpha_, a3_);
+
+      eta_ = step * etaD3_;
+      alpha_ = alpha0_ + step * a3_;
+      retract(mb, eta_, q_);
+      localVelocity(mb, q_, eta_, alpha_, etaD4_);
+      acceleration(mb, q_, alpha_, a4_);
+
+      eta_ = (step / 6.) * (etaD1_ + 2. * etaD2_ + 2. * etaD3_ + etaD4_);
+      alpha_ = alpha0_ + (step / 6.) * (a1_ + 2. * a2_ + 2. * a3_ + a4_);
+      retract(mb, eta_, q_);
+      break;
+  }
+
+  vectorToParam(q_, mbc.q);
+  vectorToParam(alpha_, mbc.alpha);
+  vectorToParam(a1_, mbc.alphaD);
+}
+
+void DynamicsIntegrator::sIntegrate(const MultiBody & mb, MultiBodyConfig & mbc, double step)
+{
+  checkMatchQ(mb, mbc);
+  checkMatchAlpha(mb, mbc);
+  checkMatchAlphaD(mb, mbc);
+  checkMatchForce(mb, mbc);
+  checkMatchJointTorque(mb, mbc);
+
+  if(q0_.size() != mb.nrParams() || alpha0_.size() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  integrate(mb, mbc, step);
+}
+
+void DynamicsIntegrator::acceleration(const MultiBody & mb,
+                                      const Eigen::VectorXd & q,
+                                      const Eigen::VectorXd & alpha,
+                                      Eigen::VectorXd & a)
+{
+  forwardKinematics(mb, q, mbc_);
+  forwardVelocity(mb, alpha, mbc_);
+  fd_.forwardDynamics(mb, jointTorque_, mbc_, a);
+}
+
+void DynamicsIntegrator::localVelocity(const MultiBody & mb,
+                                       const Eigen::VectorXd & q,
+                                       const Eigen::VectorXd & eta,
+                                       const Eigen::VectorXd & alpha,
+                                       Eigen::VectorXd & etaD) const
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    const Joint & joint = mb.joint(i);
+    int dofPos = mb.jointPosInDof(i);
+    int paramPos = mb.jointPosInParam(i);
+
+    // The Rev, Prism and Cylindrical reverse joints pose use the reversed
+    // axis, so alpha is already the derivative of q. The pose of the other
+    // reverse joints is the inverse of the forward joint pose X(q) and their
+    // motion subspace is S = -S_fwd, alpha is then mapped to the forward
+    // joint velocity -S^T X(q) S alpha.
+    Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, 6, 1> alphaJ = alpha.segment(dofPos, joint.dof());
+    if(!joint.forward()
+       && (joint.type() == Joint::Spherical || joint.type() == Joint::Planar || joint.type() == Joint::Free))
+    {
+      const Eigen::Matrix<double, 6, Eigen::Dynamic> & S = joint.motionSubspace();
+      sva::PTransformd X_rev = joint.pose(q.segment(paramPos, joint.params()));
+      alphaJ = -S.transpose() * X_rev.invMul(sva::MotionVecd(S * alphaJ)).vector();
+    }
+
+    switch(joint.type())
+    {
+      case Joint::Spherical:
+        etaD.segment<3>(dofPos) = dexpInv(eta.segment<3>(dofPos), alphaJ.head<3>());
+        break;
+
+      case Joint::Free:
+        etaD.segment<3>(dofPos) = dexpInv(eta.segment<3>(dofPos), alphaJ.head<3>());
+        // linear velocity in FP coordinate
+        etaD.segment<3>(dofPos + 3).noalias() = QuatToE(q.segment<4>(paramPos)).transpose() * alphaJ.tail<3>();
+        break;
+
+      case Joint::Planar:
+        etaD(dofPos) = alphaJ(0);
+        // linear velocity in FP coordinate
+        etaD.segment<2>(dofPos + 1) = Eigen::Rotation2Dd(q(paramPos)) * alphaJ.tail<2>();
+        break;
+
+      case Joint::Fixed:
+        break;
+
+      default:
+        etaD.segment(dofPos, joint.dof()) = alphaJ;
+    }
+  }
+}
+
+void DynamicsIntegrator::retract(const MultiBody & mb, const Eigen::VectorXd & eta, Eigen::VectorXd & q) const
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    int dofPos = mb.jointPosInDof(i);
+    int paramPos = mb.jointPosInParam(i);
+    switch(mb.joint(i).type())
+    {
+      case Joint::Spherical:
+        quaternionRetract(q0_.segment<4>(paramPos), eta.segment<3>(dofPos), q.segment<4>(paramPos));
+        break;
+
+      case Joint::Free:
+        quaternionRetract(q0_.segment<4>(paramPos), eta.segment<3>(dofPos), q.segment<4>(paramPos));
+        q.segment<3>(paramPos + 4) = q0_.segment<3>(paramPos + 4) + eta.segment<3>(dofPos + 3);
+        break;
+
+      case Joint::Planar:
+      {
+        // (q[1], q[2]) is the joint position in FS coordinate
+        double theta = q0_(paramPos) + eta(dofPos);
+        Eigen::Vector2d p = Eigen::Rotation2Dd(q0_(paramPos)) * q0_.segment<2>(paramPos + 1);
+        p += eta.segment<2>(dofPos + 1);
+        q(paramPos) = theta;
+        q.segment<2>(paramPos + 1) = Eigen::Rotation2Dd(-theta) * p;
+        break;
+      }
+
+      case Joint::Fixed:
+        break;
+
+      default:
+        q.segment(paramPos, mb.joint(i).params()) =
+            q0_.segment(paramPos, mb.joint(i).params()) + eta.segment(dofPos, mb.joint(i).dof());
+    }
+  }
+}
+
+} // namespace rbd
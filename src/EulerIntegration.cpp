@@ -29,42 +29,46 @@ Eigen::Vector3d magnusExpansion(const Eigen::Vector3d & w, const Eigen::Vector3d
   return O1 + O2 + O3;
 }
 
-} // namespace
-
-namespace rbd
-{
-
-void eulerJointIntegration(Joint::Type type,
-                           const std::vector<double> & alpha,
-                           const std::vector<double> & alphaD,
-                           double step,
-                           std::vector<double> & q)
+template<typename ConstVector, typename Vector>
+void jointIntegration(rbd::Joint::Type type,
+                      const ConstVector & alpha,
+                      const ConstVector & alphaD,
+                      double step,
+                      Vector & q)
 {
   double step2 = step * step;
   switch(type)
   {
-    case Joint::Rev:
-    case Joint::Prism:
+    case rbd::Joint::Rev:
+    case rbd::Joint::Prism:
     {
       q[0] += alpha[0] * step + alphaD[0] * step2 / 2;
       break;
     }
 
     /// @todo manage reverse joint
-    case Joint::Planar:
+    case rbd::Joint::Planar:
     {
-      // This is the old implementation akin to x' = x + v*step
-      // (i.e. we don't take the acceleration into account)
-      /// @todo us the acceleration
-      double q1Step = q[2] * alpha[0] + alpha[1];
-      double q2Step = -q[1] * alpha[0] + alpha[2];
-      q[0] += alpha[0] * step;
-      q[1] += q1Step * step;
-      q[2] += q2Step * step;
+      // (q[1], q[2]) is the joint position in FS coordinate, in FP coordinate
+      // p = R(theta)*(q[1], q[2]) and dp/dt = R(theta)*v.
+      // theta is integrated exactly and p with the Simpson rule
+      // (exact without rotation, fourth order otherwise).
+      Eigen::Vector2d v(alpha[1], alpha[2]);
+      Eigen::Vector2d vD(alphaD[1], alphaD[2]);
+      double theta1 = q[0] + alpha[0] * step + alphaD[0] * step2 / 2;
+      double thetaMid = q[0] + alpha[0] * step / 2 + alphaD[0] * step2 / 8;
+      Eigen::Vector2d p = Eigen::Rotation2Dd(q[0]) * Eigen::Vector2d(q[1], q[2]);
+      p += (step / 6)
+           * (Eigen::Rotation2Dd(q[0]) * v + 4 * (Eigen::Rotation2Dd(thetaMid) * (v + vD * step / 2))
+              + Eigen::Rotation2Dd(theta1) * (v + vD * step));
+      p = Eigen::Rotation2Dd(-theta1) * p;
+      q[0] = theta1;
+      q[1] = p.x();
+      q[2] = p.y();
       break;
     }
 
-    case Joint::Cylindrical:
+    case rbd::Joint::Cylindrical:
     {
       q[0] += alpha[0] * step + alphaD[0] * step2 / 2;
       q[1] += alpha[1] * step + alphaD[1] * step2 / 2;
@@ -72,15 +76,15 @@ void eulerJointIntegration(Joint::Type type,
     }
 
     /// @todo manage reverse joint
-    case Joint::Free:
+    case rbd::Joint::Free:
     {
       Eigen::Vector3d v;
       Eigen::Vector3d a;
       v << alpha[3], alpha[4], alpha[5];
       a << alphaD[3], alphaD[4], alphaD[5];
       // v and a are in FS coordinate. We have to put it back in FP coordinate.
-      v = QuatToE(q).transpose() * v;
-      a = QuatToE(q).transpose() * a;
+      v = rbd::QuatToE(q).transpose() * v;
+      a = rbd::QuatToE(q).transpose() * a;
 
       q[4] += v[0] * step + a[0] * step2 / 2;
       q[5] += v[1] * step + a[1] * step2 / 2;
@@ -89,7 +93,7 @@ void eulerJointIntegration(Joint::Type type,
       // don't break, we go in spherical
     }
     /// @todo manage reverse joint
-    case Joint::Spherical:
+    case rbd::Joint::Spherical:
     {
       Eigen::Quaterniond qi(q[0], q[1], q[2], q[3]);
       Eigen::Vector3d w(alpha[0], alpha[1], alpha[2]);
@@ -112,11 +116,34 @@ void eulerJointIntegration(Joint::Type type,
       break;
     }
 
-    case Joint::Fixed:
+    case rbd::Joint::Fixed:
     default:;
   }
 }
 
+} // namespace
+
+namespace rbd
+{
+
+void eulerJointIntegration(Joint::Type type,
+                           const std::vector<double> & alpha,
+                           const std::vector<double> & alphaD,
+                           double step,
+                           std::vector<double> & q)
+{
+  jointIntegration(type, alpha, alphaD, step, q);
+}
+
+void eulerJointIntegration(Joint::Type type,
+                           const Eigen::Ref<const Eigen::VectorXd> & alpha,
+                           const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                           double step,
+                           Eigen::Ref<Eigen::VectorXd> q)
+{
+  jointIntegration(type, alpha, alphaD, step, q);
+}
+
 void eulerIntegration(const MultiBody & mb, MultiBodyConfig & mbc, double step)
 {
   const std::vector<Joint> & joints = mb.joints();
@@ -132,6 +159,27 @@ void eulerIntegration(const MultiBody & mb, MultiBodyConfig & mbc, double step)
   }
 }
 
+void eulerIntegration(const MultiBody & mb,
+                      Eigen::Ref<Eigen::VectorXd> q,
+                      Eigen::Ref<Eigen::VectorXd> alpha,
+                      const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                      double step)
+{
+  const std::vector<Joint> & joints = mb.joints();
+
+  // integrate
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    int dofPos = mb.jointPosInDof(static_cast<int>(i));
+    int dof = joints[i].dof();
+    Eigen::Ref<const Eigen::VectorXd> alphai = alpha.segment(dofPos, dof);
+    Eigen::Ref<const Eigen::VectorXd> alphaDi = alphaD.segment(dofPos, dof);
+    Eigen::Ref<Eigen::VectorXd> qi = q.segment(mb.jointPosInParam(static_cast<int>(i)), joints[i].params());
+    jointIntegration(joints[i].type(), alphai, alphaDi, step, qi);
+  }
+  alpha += alphaD * step;
+}
+
 void sEulerIntegration(const MultiBody & mb, MultiBodyConfig & mbc, double step)
 {
   checkMatchQ(mb, mbc);
@@ -36,6 +36,32 @@ void forwardAcceleration(const MultiBody & mb, MultiBodyConfig & mbc, const sva:
   }
 }
 
+void forwardAcceleration(const MultiBody & mb,
+                         const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                         MultiBodyConfig & mbc,
+                         const sva::MotionVecd & A_0)
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+  const std::vector<int> & succ = mb.successors();
+
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+
+    const sva::MotionVecd & vj_i = mbc.jointVelocity[i];
+    sva::MotionVecd ai_tan =
+        joints[i].tanAccel(alphaD.segment(mb.jointPosInDof(static_cast<int>(i)), joints[i].dof()));
+
+    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+
+    if(pred[i] != -1)
+      mbc.bodyAccB[succ[i]] = X_p_i * mbc.bodyAccB[pred[i]] + ai_tan + vb_i.cross(vj_i);
+    else
+      mbc.bodyAccB[succ[i]] = X_p_i * A_0 + ai_tan + vb_i.cross(vj_i);
+  }
+}
+
 void sForwardAcceleration(const MultiBody & mb, MultiBodyConfig & mbc, const sva::MotionVecd & A_0)
 {
   checkMatchAlphaD(mb, mbc);
@@ -48,4 +74,19 @@ void sForwardAcceleration(const MultiBody & mb, MultiBodyConfig & mbc, const sva
   forwardAcceleration(mb, mbc, A_0);
 }
 
+void sForwardAcceleration(const MultiBody & mb,
+                          const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                          MultiBodyConfig & mbc,
+                          const sva::MotionVecd & A_0)
+{
+  checkMatchDofVector(mb, alphaD, "Generalized acceleration variable vector");
+  checkMatchParentToSon(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+
+  checkMatchBodyAcc(mb, mbc);
+
+  forwardAcceleration(mb, alphaD, mbc, A_0);
+}
+
 } // namespace rbd
@@ -6,6 +6,12 @@
 #include "RBDyn/FD.h"
 
 // includes
+// std
+#include <algorithm>
+
+// Eigen
+#include <Eigen/Cholesky>
+
 // RBDyn
 #include "RBDyn/MultiBody.h"
 #include "RBDyn/MultiBodyConfig.h"
@@ -13,14 +19,53 @@
 namespace rbd
 {
 
-ForwardDynamics::ForwardDynamics(const MultiBody & mb)
-: H_(mb.nrDof(), mb.nrDof()), C_(mb.nrDof()), I_st_(mb.nrBodies()), F_(mb.nrJoints()), acc_(mb.nrBodies()),
-  f_(mb.nrBodies()), tmpFd_(mb.nrDof()), dofPos_(mb.nrJoints()), ldlt_(mb.nrDof())
+ForwardDynamics::Workspace::Workspace(const MultiBody & mb)
+: H(mb.nrDof(), mb.nrDof()), C(mb.nrDof()), ltdl(mb), I_st(mb.nrBodies()), F(mb.nrJoints()), acc(mb.nrBodies()),
+  f(mb.nrBodies()), SW(6, mb.nrDof()), FW(6, mb.nrDof()), tmpFd(mb.nrDof())
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    F[i].resize(6, mb.joint(i).dof());
+  }
+}
+
+void ForwardDynamics::Workspace::resizeHinv(const MultiBody & mb)
+{
+  Hinv.resize(mb.nrDof(), mb.nrDof());
+  IA.resize(mb.nrBodies());
+  U.resize(mb.nrJoints());
+  UDinv.resize(mb.nrJoints());
+  pA.resize(mb.nrBodies());
+  aA.resize(mb.nrBodies());
+
+  // the dofs of the subtree of body i are in [jointPosInDof(i), subtreeEnd[i])
+  std::vector<int> subtreeEnd(mb.nrJoints());
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    subtreeEnd[i] = mb.jointPosInDof(i) + mb.joint(i).dof();
+  }
+  for(int i = mb.nrJoints() - 1; i >= 0; --i)
+  {
+    if(mb.predecessor(i) != -1)
+    {
+      subtreeEnd[mb.predecessor(i)] = std::max(subtreeEnd[mb.predecessor(i)], subtreeEnd[i]);
+    }
+  }
+
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    U[i].resize(6, mb.joint(i).dof());
+    UDinv[i].resize(6, mb.joint(i).dof());
+    pA[i].resize(6, subtreeEnd[i] - mb.jointPosInDof(i));
+    aA[i].resize(6, mb.nrDof() - mb.jointPosInDof(i));
+  }
+}
+
+ForwardDynamics::ForwardDynamics(const MultiBody & mb) : dofPos_(mb.nrJoints()), ws_(mb)
 {
   int dofP = 0;
   for(int i = 0; i < mb.nrJoints(); ++i)
   {
-    F_[i].resize(6, mb.joint(i).dof());
     dofPos_[i] = dofP;
     dofP += mb.joint(i).dof();
   }
@@ -28,26 +73,67 @@ ForwardDynamics::ForwardDynamics(const MultiBody & mb)
 
 void ForwardDynamics::forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
 {
-  computeH(mb, mbc);
-  computeC(mb, mbc);
-
-  paramToVector(mbc.jointTorque, tmpFd_);
-  ldlt_.compute(H_);
-  tmpFd_ = ldlt_.solve(tmpFd_ - C_);
+  forwardDynamics(mb, mbc, ws_);
+}
 
-  vectorToParam(tmpFd_, mbc.alphaD);
+void ForwardDynamics::forwardDynamics(const MultiBody & mb,
+                                      const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                      const MultiBodyConfig & mbc,
+                                      Eigen::Ref<Eigen::VectorXd> alphaD)
+{
+  forwardDynamics(mb, jointTorque, mbc, alphaD, ws_);
 }
 
 void ForwardDynamics::computeH(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  computeH(mb, mbc, ws_);
+}
+
+void ForwardDynamics::computeC(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  computeC(mb, mbc, ws_);
+}
+
+void ForwardDynamics::computeHC(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  computeHC(mb, mbc, ws_);
+}
+
+void ForwardDynamics::computeHinv(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  computeHinv(mb, mbc, ws_);
+}
+
+void ForwardDynamics::forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const
+{
+  paramToVector(mbc.jointTorque, ws.tmpFd);
+  forwardDynamics(mb, ws.tmpFd, mbc, ws.tmpFd, ws);
+  vectorToParam(ws.tmpFd, mbc.alphaD);
+}
+
+void ForwardDynamics::forwardDynamics(const MultiBody & mb,
+                                      const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                      const MultiBodyConfig & mbc,
+                                      Eigen::Ref<Eigen::VectorXd> alphaD,
+                                      Workspace & ws) const
+{
+  computeHC(mb, mbc, ws);
+
+  alphaD = jointTorque - ws.C;
+  ws.ltdl.compute(ws.H);
+  ws.ltdl.solveInPlace(alphaD);
+}
+
+void ForwardDynamics::computeH(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
 {
   const std::vector<Body> & bodies = mb.bodies();
   const std::vector<Joint> & joints = mb.joints();
   const std::vector<int> & pred = mb.predecessors();
 
-  H_.setZero();
+  ws.H.setZero();
   for(std::size_t i = 0; i < bodies.size(); ++i)
   {
-    I_st_[i] = bodies[i].inertia();
+    ws.I_st[i] = bodies[i].inertia();
   }
 
   for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
@@ -55,16 +141,16 @@ void ForwardDynamics::computeH(const MultiBody & mb, const MultiBodyConfig & mbc
     if(pred[i] != -1)
     {
       const sva::PTransformd & X_p_i = mbc.parentToSon[i];
-      I_st_[pred[i]] += X_p_i.transMul(I_st_[i]);
+      ws.I_st[pred[i]] += X_p_i.transMul(ws.I_st[i]);
     }
 
     for(int dof = 0; dof < joints[i].dof(); ++dof)
     {
-      F_[i].col(dof).noalias() = (I_st_[i] * sva::MotionVecd(mbc.motionSubspace[i].col(dof))).vector();
+      ws.F[i].col(dof).noalias() = (ws.I_st[i] * sva::MotionVecd(mbc.motionSubspace[i].col(dof))).vector();
     }
 
-    H_.block(dofPos_[i], dofPos_[i], joints[i].dof(), joints[i].dof()).noalias() =
-        mbc.motionSubspace[i].transpose() * F_[i];
+    ws.H.block(dofPos_[i], dofPos_[i], joints[i].dof(), joints[i].dof()).noalias() =
+        mbc.motionSubspace[i].transpose() * ws.F[i];
 
     int j = i;
     while(pred[j] != -1)
@@ -72,23 +158,23 @@ void ForwardDynamics::computeH(const MultiBody & mb, const MultiBodyConfig & mbc
       const sva::PTransformd & X_p_j = mbc.parentToSon[j];
       for(int dof = 0; dof < joints[i].dof(); ++dof)
       {
-        F_[i].col(dof) = X_p_j.transMul(sva::ForceVecd(F_[i].col(dof))).vector();
+        ws.F[i].col(dof) = X_p_j.transMul(sva::ForceVecd(ws.F[i].col(dof))).vector();
       }
       j = pred[j];
 
       if(joints[j].dof() != 0)
       {
-        H_.block(dofPos_[i], dofPos_[j], joints[i].dof(), joints[j].dof()).noalias() =
-            F_[i].transpose() * mbc.motionSubspace[j];
+        ws.H.block(dofPos_[i], dofPos_[j], joints[i].dof(), joints[j].dof()).noalias() =
+            ws.F[i].transpose() * mbc.motionSubspace[j];
 
-        H_.block(dofPos_[j], dofPos_[i], joints[j].dof(), joints[i].dof()).noalias() =
-            H_.block(dofPos_[i], dofPos_[j], joints[i].dof(), joints[j].dof()).transpose();
+        ws.H.block(dofPos_[j], dofPos_[i], joints[j].dof(), joints[i].dof()).noalias() =
+            ws.H.block(dofPos_[i], dofPos_[j], joints[i].dof(), joints[j].dof()).transpose();
       }
     }
   }
 }
 
-void ForwardDynamics::computeC(const MultiBody & mb, const MultiBodyConfig & mbc)
+void ForwardDynamics::computeC(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
 {
   const std::vector<Body> & bodies = mb.bodies();
   const std::vector<Joint> & joints = mb.joints();
@@ -105,26 +191,216 @@ void ForwardDynamics::computeC(const MultiBody & mb, const MultiBodyConfig & mbc
     const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
 
     if(pred[i] != -1)
-      acc_[i] = X_p_i * acc_[pred[i]] + vb_i.cross(vj_i);
+      ws.acc[i] = X_p_i * ws.acc[pred[i]] + vb_i.cross(vj_i);
     else
-      acc_[i] = X_p_i * a_0 + vb_i.cross(vj_i);
+      ws.acc[i] = X_p_i * a_0 + vb_i.cross(vj_i);
 
-    f_[i] = bodies[i].inertia() * acc_[i] + vb_i.crossDual(bodies[i].inertia() * vb_i)
-            - mbc.bodyPosW[i].dualMul(mbc.force[i]);
+    ws.f[i] = bodies[i].inertia() * ws.acc[i] + vb_i.crossDual(bodies[i].inertia() * vb_i)
+              - mbc.bodyPosW[i].dualMul(mbc.force[i]);
   }
 
   for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
   {
-    C_.segment(dofPos_[i], joints[i].dof()).noalias() = mbc.motionSubspace[i].transpose() * f_[i].vector();
+    ws.C.segment(dofPos_[i], joints[i].dof()).noalias() = mbc.motionSubspace[i].transpose() * ws.f[i].vector();
 
     if(pred[i] != -1)
     {
       const sva::PTransformd & X_p_i = mbc.parentToSon[i];
-      f_[pred[i]] += X_p_i.transMul(f_[i]);
+      ws.f[pred[i]] += X_p_i.transMul(ws.f[i]);
     }
   }
 }
 
+void ForwardDynamics::computeHC(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
+{
+  const std::vector<Body> & bodies = mb.bodies();
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+
+  sva::MotionVecd a_0(Eigen::Vector3d::Zero(), mbc.gravity);
+
+  // like computeH, the blocks of joints that are not in the same branch are zero
+  ws.H.setZero();
+  for(std::size_t i = 0; i < bodies.size(); ++i)
+  {
+    const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+    const sva::MotionVecd & vj_i = mbc.jointVelocity[i];
+    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+    const sva::RBInertiad & I_i = bodies[i].inertia();
+    const sva::PTransformd & X_0_i = mbc.bodyPosW[i];
+
+    if(pred[i] != -1)
+      ws.acc[i] = X_p_i * ws.acc[pred[i]] + vb_i.cross(vj_i);
+    else
+      ws.acc[i] = X_p_i * a_0 + vb_i.cross(vj_i);
+
+    ws.f[i] = I_i * ws.acc[i] + vb_i.crossDual(I_i * vb_i) - X_0_i.dualMul(mbc.force[i]);
+    ws.I_st[i] = I_i;
+
+    // the H blocks are computed in world frame to avoid transforming
+    // I_st*S to each ancestor frame
+    for(int dof = 0; dof < joints[i].dof(); ++dof)
+    {
+      ws.SW.col(dofPos_[i] + dof) = X_0_i.invMul(sva::MotionVecd(mbc.motionSubspace[i].col(dof))).vector();
+    }
+  }
+
+  // the subtree inertia and force of body i are complete once its
+  // successors have been visited
+  for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
+  {
+    const Eigen::Matrix<double, 6, Eigen::Dynamic> & S_i = mbc.motionSubspace[i];
+    const sva::PTransformd & X_0_i = mbc.bodyPosW[i];
+    int dofI = joints[i].dof();
+
+    ws.C.segment(dofPos_[i], dofI).noalias() = S_i.transpose() * ws.f[i].vector();
+
+    if(dofI != 0)
+    {
+      for(int dof = 0; dof < dofI; ++dof)
+      {
+        ws.FW.col(dofPos_[i] + dof) = X_0_i.transMul(ws.I_st[i] * sva::MotionVecd(S_i.col(dof))).vector();
+      }
+
+      // H(j, i) = S_j^T I_st_i S_i with j ancestor of i (i included)
+      for(int j = i; j != -1; j = pred[j])
+      {
+        int dofJ = joints[j].dof();
+        // most joints have one dof, avoid the dynamic product overhead
+        if(dofI == 1 && dofJ == 1)
+        {
+          ws.H(dofPos_[j], dofPos_[i]) = ws.SW.col(dofPos_[j]).dot(ws.FW.col(dofPos_[i]));
+        }
+        else
+        {
+          ws.H.block(dofPos_[j], dofPos_[i], dofJ, dofI).noalias() =
+              ws.SW.middleCols(dofPos_[j], dofJ).transpose().lazyProduct(ws.FW.middleCols(dofPos_[i], dofI));
+        }
+        if(j != i)
+        {
+          ws.H.block(dofPos_[i], dofPos_[j], dofI, dofJ) = ws.H.block(dofPos_[j], dofPos_[i], dofJ, dofI).transpose();
+        }
+      }
+    }
+
+    if(pred[i] != -1)
+    {
+      const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+      ws.I_st[pred[i]] += X_p_i.transMul(ws.I_st[i]);
+      ws.f[pred[i]] += X_p_i.transMul(ws.f[i]);
+    }
+  }
+}
+
+void ForwardDynamics::computeHinv(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
+{
+  using DofMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, 6, 6>;
+
+  const std::vector<Body> & bodies = mb.bodies();
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+  int nrDof = mb.nrDof();
+
+  if(ws.pA.size() != bodies.size())
+  {
+    ws.resizeHinv(mb);
+  }
+
+  /* Articulated body algorithm with null velocity and gravity applied to the
+   * nrDof unit joint torques: the joint accelerations are the columns of H^-1.
+   * A unit torque only produce articulated forces on the bodies that support
+   * its joint, so pA[i] is restricted to the dofs of the subtree of i. The
+   * row of dof k is only propagated on the columns after k, which give the
+   * upper triangular part of H^-1.
+   * Everything is in world frame, so the 6 x nrDof forces and accelerations
+   * are never transformed from a body to its parent. */
+  for(std::size_t i = 0; i < bodies.size(); ++i)
+  {
+    const sva::PTransformd & X_0_i = mbc.bodyPosW[i];
+    sva::RBInertiad I_i = X_0_i.transMul(bodies[i].inertia());
+    ws.IA[i] = sva::ABInertiad(I_i.mass() * Eigen::Matrix3d::Identity(), sva::vector3ToCrossMatrix(I_i.momentum()),
+                               I_i.inertia());
+    ws.pA[i].setZero();
+
+    for(int dof = 0; dof < joints[i].dof(); ++dof)
+    {
+      ws.SW.col(dofPos_[i] + dof) = X_0_i.invMul(sva::MotionVecd(mbc.motionSubspace[i].col(dof))).vector();
+    }
+  }
+
+  for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
+  {
+    int dof = joints[i].dof();
+    int pos = dofPos_[i];
+    int subtreeDof = static_cast<int>(ws.pA[i].cols());
+    auto S = ws.SW.middleCols(pos, dof);
+
+    if(dof != 0)
+    {
+      for(int d = 0; d < dof; ++d)
+      {
+        ws.U[i].col(d) = (ws.IA[i] * sva::MotionVecd(S.col(d))).vector();
+      }
+      DofMatrix D = S.transpose() * ws.U[i];
+      Eigen::LLT<DofMatrix> llt(D);
+      // D is at most 6x6, its inverse stay on the stack and the coefficient
+      // based product don't need any temporary
+      DofMatrix Dinv = DofMatrix::Identity(dof, dof);
+      llt.solveInPlace(Dinv);
+      ws.UDinv[i].noalias() = ws.U[i].lazyProduct(Dinv);
+
+      // D^-1 (tau - S^T pA), the parent acceleration term is removed by the forward pass
+      Eigen::Block<Eigen::MatrixXd> Hi = ws.Hinv.block(pos, pos, dof, subtreeDof);
+      Hi.noalias() = -S.transpose() * ws.pA[i];
+      Hi.leftCols(dof).diagonal().array() += 1.;
+      llt.solveInPlace(Hi);
+      ws.Hinv.block(pos, pos + subtreeDof, dof, nrDof - pos - subtreeDof).setZero();
+    }
+
+    if(pred[i] != -1)
+    {
+      if(dof != 0)
+      {
+        Eigen::Matrix6d UDU;
+        UDU.noalias() = ws.UDinv[i] * ws.U[i].transpose();
+        ws.IA[i] -= sva::ABInertiad(UDU.block<3, 3>(3, 3), UDU.block<3, 3>(0, 3), UDU.block<3, 3>(0, 0));
+        ws.pA[i].noalias() += ws.U[i] * ws.Hinv.block(pos, pos, dof, subtreeDof);
+      }
+
+      ws.IA[pred[i]] += ws.IA[i];
+      ws.pA[pred[i]].middleCols(pos - dofPos_[pred[i]], subtreeDof) += ws.pA[i];
+    }
+  }
+
+  for(std::size_t i = 0; i < bodies.size(); ++i)
+  {
+    int dof = joints[i].dof();
+    int pos = dofPos_[i];
+    int cols = nrDof - pos;
+
+    if(pred[i] != -1)
+    {
+      ws.aA[i] = ws.aA[pred[i]].rightCols(cols);
+    }
+    else
+    {
+      ws.aA[i].setZero();
+    }
+
+    if(dof != 0)
+    {
+      Eigen::Block<Eigen::MatrixXd> Hi = ws.Hinv.block(pos, pos, dof, cols);
+      Hi.noalias() -= ws.UDinv[i].transpose() * ws.aA[i];
+      ws.aA[i].noalias() += ws.SW.middleCols(pos, dof) * Hi;
+    }
+  }
+
+  for(int i = 0; i < nrDof; ++i)
+  {
+    ws.Hinv.col(i).tail(nrDof - i - 1) = ws.Hinv.row(i).tail(nrDof - i - 1).transpose();
+  }
+}
+
 void ForwardDynamics::sForwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
 {
   checkMatchParentToSon(mb, mbc);
@@ -140,6 +416,24 @@ void ForwardDynamics::sForwardDynamics(const MultiBody & mb, MultiBodyConfig & m
   forwardDynamics(mb, mbc);
 }
 
+void ForwardDynamics::sForwardDynamics(const MultiBody & mb,
+                                       const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                                       const MultiBodyConfig & mbc,
+                                       Eigen::Ref<Eigen::VectorXd> alphaD)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchForce(mb, mbc);
+  checkMatchDofVector(mb, jointTorque, "Joint torque vector");
+
+  checkMatchDofVector(mb, alphaD, "Generalized acceleration variable vector");
+
+  forwardDynamics(mb, jointTorque, mbc, alphaD);
+}
+
 void ForwardDynamics::sComputeH(const MultiBody & mb, const MultiBodyConfig & mbc)
 {
   checkMatchParentToSon(mb, mbc);
@@ -160,4 +454,24 @@ void ForwardDynamics::sComputeC(const MultiBody & mb, const MultiBodyConfig & mb
   computeC(mb, mbc);
 }
 
+void ForwardDynamics::sComputeHC(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchForce(mb, mbc);
+
+  computeHC(mb, mbc);
+}
+
+void ForwardDynamics::sComputeHinv(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  checkMatchBodyPos(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  computeHinv(mb, mbc);
+}
+
 } // namespace rbd
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/FDDerivatives.h"
+
+// includes
+// std
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace rbd
+{
+
+ForwardDynamicsDerivatives::ForwardDynamicsDerivatives(const MultiBody & mb)
+: idd_(mb), dalphaD_dq_(mb.nrDof(), mb.nrDof()), dalphaD_dalpha_(mb.nrDof(), mb.nrDof()),
+  dalphaD_dtau_(mb.nrDof(), mb.nrDof())
+{
+}
+
+void ForwardDynamicsDerivatives::computeDerivatives(const MultiBody & mb,
+                                                    MultiBodyConfig & mbc,
+                                                    const LTDLFactorization & ltdl)
+{
+  idd_.computeDerivatives(mb, mbc);
+
+  dalphaD_dq_ = -idd_.dtau_dq();
+  ltdl.solveInPlace(dalphaD_dq_);
+
+  dalphaD_dalpha_ = -idd_.dtau_dalpha();
+  ltdl.solveInPlace(dalphaD_dalpha_);
+
+  dalphaD_dtau_.setIdentity();
+  ltdl.solveInPlace(dalphaD_dtau_);
+}
+
+void ForwardDynamicsDerivatives::sComputeDerivatives(const MultiBody & mb,
+                                                     MultiBodyConfig & mbc,
+                                                     const LTDLFactorization & ltdl)
+{
+  checkMatchAlphaD(mb, mbc);
+  checkMatchForce(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  checkMatchBodyAcc(mb, mbc);
+  checkMatchJointTorque(mb, mbc);
+
+  if(ltdl.matrix().rows() != mb.nrDof() || dalphaD_dtau_.rows() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  computeDerivatives(mb, mbc, ltdl);
+}
+
+} // namespace rbd
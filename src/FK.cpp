@@ -34,6 +34,26 @@ void forwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc)
   }
 }
 
+void forwardKinematics(const MultiBody & mb, const Eigen::Ref<const Eigen::VectorXd> & q, MultiBodyConfig & mbc)
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+  const std::vector<int> & succ = mb.successors();
+  const std::vector<sva::PTransformd> & Xt = mb.transforms();
+
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    mbc.jointConfig[i] = joints[i].pose(q.segment(mb.jointPosInParam(static_cast<int>(i)), joints[i].params()));
+    mbc.parentToSon[i] = mbc.jointConfig[i] * Xt[i];
+    mbc.motionSubspace[i] = joints[i].motionSubspace();
+
+    if(pred[i] != -1)
+      mbc.bodyPosW[succ[i]] = mbc.parentToSon[i] * mbc.bodyPosW[pred[i]];
+    else
+      mbc.bodyPosW[succ[i]] = mbc.parentToSon[i];
+  }
+}
+
 void sForwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc)
 {
   checkMatchQ(mb, mbc);
@@ -45,4 +65,16 @@ void sForwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc)
   forwardKinematics(mb, mbc);
 }
 
+void sForwardKinematics(const MultiBody & mb, const Eigen::Ref<const Eigen::VectorXd> & q, MultiBodyConfig & mbc)
+{
+  checkMatchParamVector(mb, q, "Generalized position variable vector");
+
+  checkMatchBodyPos(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  forwardKinematics(mb, q, mbc);
+}
+
 } // namespace rbd
@@ -36,6 +36,28 @@ void forwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc)
   }
 }
 
+void forwardVelocity(const MultiBody & mb, const Eigen::Ref<const Eigen::VectorXd> & alpha, MultiBodyConfig & mbc)
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+  const std::vector<int> & succ = mb.successors();
+
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+
+    mbc.jointVelocity[i] = joints[i].motion(alpha.segment(mb.jointPosInDof(static_cast<int>(i)), joints[i].dof()));
+
+    if(pred[i] != -1)
+      mbc.bodyVelB[succ[i]] = X_p_i * mbc.bodyVelB[pred[i]] + mbc.jointVelocity[i];
+    else
+      mbc.bodyVelB[succ[i]] = mbc.jointVelocity[i];
+
+    sva::PTransformd E_0_i(mbc.bodyPosW[succ[i]].rotation());
+    mbc.bodyVelW[succ[i]] = E_0_i.invMul(mbc.bodyVelB[succ[i]]);
+  }
+}
+
 void sForwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc)
 {
   checkMatchAlpha(mb, mbc);
@@ -50,4 +72,17 @@ void sForwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc)
   forwardVelocity(mb, mbc);
 }
 
+void sForwardVelocity(const MultiBody & mb, const Eigen::Ref<const Eigen::VectorXd> & alpha, MultiBodyConfig & mbc)
+{
+  checkMatchDofVector(mb, alpha, "Generalized velocity variable vector");
+  checkMatchBodyPos(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+
+  checkMatchBodyVel(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+
+  forwardVelocity(mb, alpha, mbc);
+}
+
 } // namespace rbd
@@ -13,45 +13,70 @@
 namespace rbd
 {
 
-InverseDynamics::InverseDynamics(const MultiBody & mb) : f_(mb.nrBodies()) {}
+InverseDynamics::Workspace::Workspace(const MultiBody & mb) : f(mb.nrBodies()) {}
+
+InverseDynamics::InverseDynamics(const MultiBody & mb) : ws_(mb) {}
 
 void InverseDynamics::inverseDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  inverseDynamics(mb, mbc, ws_);
+}
+
+void InverseDynamics::inverseDynamics(const MultiBody & mb,
+                                      const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                      MultiBodyConfig & mbc,
+                                      Eigen::Ref<Eigen::VectorXd> jointTorque)
+{
+  inverseDynamics(mb, alphaD, mbc, jointTorque, ws_);
+}
+
+void InverseDynamics::inverseDynamicsNoInertia(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  inverseDynamicsNoInertia(mb, mbc, ws_);
+}
+
+void InverseDynamics::inverseDynamics(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const
 {
   const std::vector<Body> & bodies = mb.bodies();
   const std::vector<Joint> & joints = mb.joints();
-  const std::vector<int> & pred = mb.predecessors();
 
   sva::MotionVecd a_0(Eigen::Vector3d::Zero(), mbc.gravity);
 
-  for(std::size_t i = 0; i < bodies.size(); ++i)
+  for(int i = 0; i < static_cast<int>(bodies.size()); ++i)
   {
-    const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+    computeBodyForce(mb, mbc, i, a_0, joints[i].tanAccel(mbc.alphaD[i]), ws);
+  }
 
-    const sva::MotionVecd & vj_i = mbc.jointVelocity[i];
-    sva::MotionVecd ai_tan = joints[i].tanAccel(mbc.alphaD[i]);
+  computeJointTorques(mb, mbc, ws);
+}
 
-    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+void InverseDynamics::inverseDynamics(const MultiBody & mb,
+                                      const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                      MultiBodyConfig & mbc,
+                                      Eigen::Ref<Eigen::VectorXd> jointTorque,
+                                      Workspace & ws) const
+{
+  const std::vector<Body> & bodies = mb.bodies();
+  const std::vector<Joint> & joints = mb.joints();
 
-    if(pred[i] != -1)
-      mbc.bodyAccB[i] = X_p_i * mbc.bodyAccB[pred[i]] + ai_tan + vb_i.cross(vj_i);
-    else
-      mbc.bodyAccB[i] = X_p_i * a_0 + ai_tan + vb_i.cross(vj_i);
+  sva::MotionVecd a_0(Eigen::Vector3d::Zero(), mbc.gravity);
 
-    f_[i] = bodies[i].inertia() * mbc.bodyAccB[i] + vb_i.crossDual(bodies[i].inertia() * vb_i)
-            - mbc.bodyPosW[i].dualMul(mbc.force[i]);
+  for(int i = 0; i < static_cast<int>(bodies.size()); ++i)
+  {
+    computeBodyForce(mb, mbc, i, a_0, joints[i].tanAccel(alphaD.segment(mb.jointPosInDof(i), joints[i].dof())), ws);
   }
 
-  computeJointTorques(mb, mbc);
+  computeJointTorques(mb, mbc, jointTorque, ws);
 }
 
-void InverseDynamics::inverseDynamicsNoInertia(const MultiBody & mb, MultiBodyConfig & mbc)
+void InverseDynamics::inverseDynamicsNoInertia(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const
 {
   for(int i = 0; i < mb.nrBodies(); ++i)
   {
-    f_[i] = mbc.bodyPosW[i].dualMul(mbc.force[i]);
+    ws.f[i] = mbc.bodyPosW[i].dualMul(mbc.force[i]);
   }
 
-  computeJointTorques(mb, mbc);
+  computeJointTorques(mb, mbc, ws);
 }
 
 void InverseDynamics::sInverseDynamics(const MultiBody & mb, MultiBodyConfig & mbc)
@@ -71,6 +96,26 @@ void InverseDynamics::sInverseDynamics(const MultiBody & mb, MultiBodyConfig & m
   inverseDynamics(mb, mbc);
 }
 
+void InverseDynamics::sInverseDynamics(const MultiBody & mb,
+                                       const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                       MultiBodyConfig & mbc,
+                                       Eigen::Ref<Eigen::VectorXd> jointTorque)
+{
+  checkMatchDofVector(mb, alphaD, "Generalized acceleration variable vector");
+  checkMatchForce(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  checkMatchBodyAcc(mb, mbc);
+  checkMatchDofVector(mb, jointTorque, "Joint torque vector");
+
+  inverseDynamics(mb, alphaD, mbc, jointTorque);
+}
+
 void InverseDynamics::sInverseDynamicsNoInertia(const MultiBody & mb, MultiBodyConfig & mbc)
 {
   checkMatchAlphaD(mb, mbc);
@@ -90,14 +135,39 @@ void InverseDynamics::sInverseDynamicsNoInertia(const MultiBody & mb, MultiBodyC
 
 const std::vector<sva::ForceVecd> & InverseDynamics::f() const
 {
-  return f_;
+  return ws_.f;
 }
 
 /*
  * Private functions
  */
 
-void InverseDynamics::computeJointTorques(const MultiBody & mb, MultiBodyConfig & mbc)
+void InverseDynamics::computeBodyForce(const MultiBody & mb,
+                                       MultiBodyConfig & mbc,
+                                       int i,
+                                       const sva::MotionVecd & a_0,
+                                       const sva::MotionVecd & ai_tan,
+                                       Workspace & ws) const
+{
+  const Body & body = mb.body(i);
+  int pred = mb.predecessor(i);
+
+  const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+
+  const sva::MotionVecd & vj_i = mbc.jointVelocity[i];
+
+  const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+
+  if(pred != -1)
+    mbc.bodyAccB[i] = X_p_i * mbc.bodyAccB[pred] + ai_tan + vb_i.cross(vj_i);
+  else
+    mbc.bodyAccB[i] = X_p_i * a_0 + ai_tan + vb_i.cross(vj_i);
+
+  ws.f[i] = body.inertia() * mbc.bodyAccB[i] + vb_i.crossDual(body.inertia() * vb_i)
+            - mbc.bodyPosW[i].dualMul(mbc.force[i]);
+}
+
+void InverseDynamics::computeJointTorques(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const
 {
   const std::vector<Body> & bodies = mb.bodies();
   const std::vector<Joint> & joints = mb.joints();
@@ -107,13 +177,34 @@ void InverseDynamics::computeJointTorques(const MultiBody & mb, MultiBodyConfig
   {
     for(int j = 0; j < joints[i].dof(); ++j)
     {
-      mbc.jointTorque[i][j] = mbc.motionSubspace[i].col(j).transpose() * f_[i].vector();
+      mbc.jointTorque[i][j] = mbc.motionSubspace[i].col(j).transpose() * ws.f[i].vector();
     }
 
     if(pred[i] != -1)
     {
       const sva::PTransformd & X_p_i = mbc.parentToSon[i];
-      f_[pred[i]] = f_[pred[i]] + X_p_i.transMul(f_[i]);
+      ws.f[pred[i]] = ws.f[pred[i]] + X_p_i.transMul(ws.f[i]);
+    }
+  }
+}
+
+void InverseDynamics::computeJointTorques(const MultiBody & mb,
+                                          const MultiBodyConfig & mbc,
+                                          Eigen::Ref<Eigen::VectorXd> jointTorque,
+                                          Workspace & ws) const
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+
+  for(int i = static_cast<int>(joints.size()) - 1; i >= 0; --i)
+  {
+    jointTorque.segment(mb.jointPosInDof(i), joints[i].dof()).noalias() =
+        mbc.motionSubspace[i].transpose() * ws.f[i].vector();
+
+    if(pred[i] != -1)
+    {
+      const sva::PTransformd & X_p_i = mbc.parentToSon[i];
+      ws.f[pred[i]] = ws.f[pred[i]] + X_p_i.transMul(ws.f[i]);
     }
   }
 }
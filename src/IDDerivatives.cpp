@@ -0,0 +1,243 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/IDDerivatives.h"
+
+// includes
+// std
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace
+{
+
+/// @return Matrix M such that M*m = m.crossDual(f).
+Eigen::Matrix6d forceCrossMatrix(const sva::ForceVecd & f)
+{
+  Eigen::Matrix6d M;
+  Eigen::Matrix3d nCross = sva::vector3ToCrossMatrix(f.couple());
+  Eigen::Matrix3d fCross = sva::vector3ToCrossMatrix(f.force());
+  M << -nCross, -fCross, -fCross, Eigen::Matrix3d::Zero();
+  return M;
+}
+
+/// Append the dof columns of joint to ranges, merging contiguous ranges.
+void addDofRange(const rbd::MultiBody & mb, int joint, std::vector<std::pair<int, int>> & ranges)
+{
+  int pos = mb.jointPosInDof(joint);
+  int dof = mb.joint(joint).dof();
+  if(dof == 0)
+  {
+    return;
+  }
+
+  if(!ranges.empty() && ranges.back().first + ranges.back().second == pos)
+  {
+    ranges.back().second += dof;
+  }
+  else
+  {
+    ranges.emplace_back(pos, dof);
+  }
+}
+
+} // namespace
+
+namespace rbd
+{
+
+InverseDynamicsDerivatives::InverseDynamicsDerivatives(const MultiBody & mb)
+: f_(mb.nrBodies()), ancestorCols_(mb.nrBodies()), subtreeCols_(mb.nrBodies()),
+  dv_dq_(mb.nrBodies(), Eigen::MatrixXd::Zero(6, mb.nrDof())),
+  dv_dalpha_(mb.nrBodies(), Eigen::MatrixXd::Zero(6, mb.nrDof())),
+  da_dq_(mb.nrBodies(), Eigen::MatrixXd::Zero(6, mb.nrDof())),
+  da_dalpha_(mb.nrBodies(), Eigen::MatrixXd::Zero(6, mb.nrDof())),
+  df_dq_(mb.nrBodies(), Eigen::MatrixXd::Zero(6, mb.nrDof())),
+  df_dalpha_(mb.nrBodies(), Eigen::MatrixXd::Zero(6, mb.nrDof())),
+  df_dalphaD_(mb.nrBodies(), Eigen::MatrixXd::Zero(6, mb.nrDof())),
+  dtau_dq_(Eigen::MatrixXd::Zero(mb.nrDof(), mb.nrDof())),
+  dtau_dalpha_(Eigen::MatrixXd::Zero(mb.nrDof(), mb.nrDof())),
+  dtau_dalphaD_(Eigen::MatrixXd::Zero(mb.nrDof(), mb.nrDof()))
+{
+  const std::vector<int> & pred = mb.predecessors();
+  for(int i = 0; i < mb.nrBodies(); ++i)
+  {
+    if(pred[i] != -1)
+    {
+      ancestorCols_[i] = ancestorCols_[pred[i]];
+      addDofRange(mb, pred[i], ancestorCols_[i]);
+    }
+
+    for(int j = pred[i]; j != -1; j = pred[j])
+    {
+      addDofRange(mb, i, subtreeCols_[j]);
+    }
+  }
+}
+
+void InverseDynamicsDerivatives::computeDerivatives(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  using namespace Eigen;
+
+  const std::vector<Body> & bodies = mb.bodies();
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+
+  sva::MotionVecd a_0(Vector3d::Zero(), mbc.gravity);
+
+  // forward pass: body accelerations, forces and their derivatives
+  // with respect to the joints supporting each body
+  for(int i = 0; i < static_cast<int>(bodies.size()); ++i)
+  {
+    const sva::RBInertiad & I = bodies[i].inertia();
+    const Matrix<double, 6, Dynamic> & S = mbc.motionSubspace[i];
+    const sva::MotionVecd & vj_i = mbc.jointVelocity[i];
+    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+    int posI = mb.jointPosInDof(i);
+    int dofI = joints[i].dof();
+    int p = pred[i];
+
+    Matrix6d X = mbc.parentToSon[i].matrix();
+    sva::MotionVecd vp_i = vb_i - vj_i;
+    sva::MotionVecd ap_i = p != -1 ? mbc.parentToSon[i] * mbc.bodyAccB[p] : mbc.parentToSon[i] * a_0;
+    sva::ForceVecd fext_i = mbc.bodyPosW[i].dualMul(mbc.force[i]);
+
+    mbc.bodyAccB[i] = ap_i + joints[i].tanAccel(mbc.alphaD[i]) + vb_i.cross(vj_i);
+    f_[i] = I * mbc.bodyAccB[i] + vb_i.crossDual(I * vb_i) - fext_i;
+
+    Matrix6d IM = I.matrix();
+    Matrix6d crossVj = sva::vector6ToCrossMatrix(vj_i.vector());
+    // derivative of I*a + v x* I*v - fext with respect to v and to the body displacement
+    Matrix6d dfdv = forceCrossMatrix(I * vb_i) + sva::vector6ToCrossDualMatrix(vb_i.vector()) * IM;
+    Matrix6d dfdx = forceCrossMatrix(fext_i);
+
+    for(const std::pair<int, int> & c : ancestorCols_[i])
+    {
+      dv_dq_[i].middleCols(c.first, c.second).noalias() = X * dv_dq_[p].middleCols(c.first, c.second);
+      dv_dalpha_[i].middleCols(c.first, c.second).noalias() = X * dv_dalpha_[p].middleCols(c.first, c.second);
+      da_dq_[i].middleCols(c.first, c.second).noalias() = X * da_dq_[p].middleCols(c.first, c.second);
+      da_dq_[i].middleCols(c.first, c.second).noalias() -= crossVj * dv_dq_[i].middleCols(c.first, c.second);
+      da_dalpha_[i].middleCols(c.first, c.second).noalias() = X * da_dalpha_[p].middleCols(c.first, c.second);
+      da_dalpha_[i].middleCols(c.first, c.second).noalias() -=
+          crossVj * dv_dalpha_[i].middleCols(c.first, c.second);
+      computeBodyForceDerivatives(i, c.first, c.second, IM, dfdv, dfdx);
+    }
+
+    // moving joint i rotates the parent velocity and acceleration
+    dv_dq_[i].middleCols(posI, dofI).noalias() = sva::vector6ToCrossMatrix(vp_i.vector()) * S;
+    dv_dalpha_[i].middleCols(posI, dofI) = S;
+    da_dq_[i].middleCols(posI, dofI).noalias() = sva::vector6ToCrossMatrix(ap_i.vector()) * S;
+    da_dq_[i].middleCols(posI, dofI).noalias() -= crossVj * dv_dq_[i].middleCols(posI, dofI);
+    da_dalpha_[i].middleCols(posI, dofI).noalias() = (sva::vector6ToCrossMatrix(vb_i.vector()) - crossVj) * S;
+    computeBodyForceDerivatives(i, posI, dofI, IM, dfdv, dfdx);
+
+    // filled by the children in the backward pass
+    for(const std::pair<int, int> & c : subtreeCols_[i])
+    {
+      df_dq_[i].middleCols(c.first, c.second).setZero();
+      df_dalpha_[i].middleCols(c.first, c.second).setZero();
+      df_dalphaD_[i].middleCols(c.first, c.second).setZero();
+    }
+  }
+
+  // backward pass: joint torques and their derivatives
+  for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
+  {
+    const Matrix<double, 6, Dynamic> & S = mbc.motionSubspace[i];
+    int posI = mb.jointPosInDof(i);
+    int dofI = joints[i].dof();
+    int p = pred[i];
+
+    Matrix6d Xt = mbc.parentToSon[i].matrix().transpose();
+    for(const std::pair<int, int> & c : ancestorCols_[i])
+    {
+      computeJointTorqueDerivatives(mb, mbc, i, Xt, c.first, c.second);
+    }
+    computeJointTorqueDerivatives(mb, mbc, i, Xt, posI, dofI);
+    for(const std::pair<int, int> & c : subtreeCols_[i])
+    {
+      computeJointTorqueDerivatives(mb, mbc, i, Xt, c.first, c.second);
+    }
+
+    VectorXd::Map(mbc.jointTorque[i].data(), dofI).noalias() = S.transpose() * f_[i].vector();
+
+    if(p != -1)
+    {
+      // moving joint i rotates the force transmitted to the parent
+      df_dq_[p].middleCols(posI, dofI).noalias() += Xt * (forceCrossMatrix(f_[i]) * S);
+      f_[p] = f_[p] + mbc.parentToSon[i].transMul(f_[i]);
+    }
+  }
+}
+
+void InverseDynamicsDerivatives::sComputeDerivatives(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  checkMatchAlphaD(mb, mbc);
+  checkMatchForce(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  checkMatchBodyAcc(mb, mbc);
+  checkMatchJointTorque(mb, mbc);
+
+  if(static_cast<int>(f_.size()) != mb.nrBodies() || dtau_dq_.rows() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  computeDerivatives(mb, mbc);
+}
+
+/*
+ * Private functions
+ */
+
+void InverseDynamicsDerivatives::computeBodyForceDerivatives(int i,
+                                                             int pos,
+                                                             int size,
+                                                             const Eigen::Matrix6d & I,
+                                                             const Eigen::Matrix6d & dfdv,
+                                                             const Eigen::Matrix6d & dfdx)
+{
+  df_dq_[i].middleCols(pos, size).noalias() = I * da_dq_[i].middleCols(pos, size);
+  df_dq_[i].middleCols(pos, size).noalias() += dfdv * dv_dq_[i].middleCols(pos, size);
+  df_dq_[i].middleCols(pos, size).noalias() += dfdx * dv_dalpha_[i].middleCols(pos, size);
+  df_dalpha_[i].middleCols(pos, size).noalias() = I * da_dalpha_[i].middleCols(pos, size);
+  df_dalpha_[i].middleCols(pos, size).noalias() += dfdv * dv_dalpha_[i].middleCols(pos, size);
+  df_dalphaD_[i].middleCols(pos, size).noalias() = I * dv_dalpha_[i].middleCols(pos, size);
+}
+
+void InverseDynamicsDerivatives::computeJointTorqueDerivatives(const MultiBody & mb,
+                                                               const MultiBodyConfig & mbc,
+                                                               int i,
+                                                               const Eigen::Matrix6d & Xt,
+                                                               int pos,
+                                                               int size)
+{
+  const Eigen::Matrix<double, 6, Eigen::Dynamic> & S = mbc.motionSubspace[i];
+  int posI = mb.jointPosInDof(i);
+  int dofI = mb.joint(i).dof();
+  int p = mb.predecessor(i);
+
+  dtau_dq_.block(posI, pos, dofI, size).noalias() = S.transpose() * df_dq_[i].middleCols(pos, size);
+  dtau_dalpha_.block(posI, pos, dofI, size).noalias() = S.transpose() * df_dalpha_[i].middleCols(pos, size);
+  dtau_dalphaD_.block(posI, pos, dofI, size).noalias() = S.transpose() * df_dalphaD_[i].middleCols(pos, size);
+
+  if(p != -1)
+  {
+    df_dq_[p].middleCols(pos, size).noalias() += Xt * df_dq_[i].middleCols(pos, size);
+    df_dalpha_[p].middleCols(pos, size).noalias() += Xt * df_dalpha_[i].middleCols(pos, size);
+    df_dalphaD_[p].middleCols(pos, size).noalias() += Xt * df_dalphaD_[i].middleCols(pos, size);
+  }
+}
+
+} // namespace rbd
@@ -6,10 +6,87 @@
 #include "RBDyn/IDIM.h"
 
 // includes
+// std
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+// Eigen
+#include <Eigen/QR>
+
 // RBDyn
+#include "RBDyn/FA.h"
+#include "RBDyn/FK.h"
+#include "RBDyn/FV.h"
 #include "RBDyn/MultiBody.h"
 #include "RBDyn/MultiBodyConfig.h"
 
+namespace
+{
+
+/// Under this scale the accumulated sums are rescaled to avoid overflows.
+const double minScale = 1e-100;
+
+/// Compute the body i force regressor: I*a + v x* I*v = bodyFPhi*phi_i.
+void computeBodyFPhi(const rbd::MultiBodyConfig & mbc, int i, Eigen::Matrix<double, 6, 10> & bodyFPhi)
+{
+  const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
+  Eigen::Matrix<double, 6, 10> vb_i_Phi(rbd::IMPhi(vb_i));
+
+  bodyFPhi.noalias() = rbd::IMPhi(mbc.bodyAccB[i]);
+  // bodyFPhi += vb_i x* IMPhi(vb_i)
+  // is faster to convert each col in a ForceVecd
+  // than using sva::vector6ToCrossDualMatrix
+  for(int c = 0; c < 10; ++c)
+  {
+    bodyFPhi.col(c).noalias() += (vb_i.crossDual(sva::ForceVecd(vb_i_Phi.col(c)))).vector();
+  }
+}
+
+/// Transform the force regressor in the predecessor frame.
+void transformFPhi(const sva::PTransformd & X_p_j, Eigen::Matrix<double, 6, 10> & bodyFPhi)
+{
+  // bodyFPhi = X_p_j^T bodyFPhi
+  // is faster to convert each col in a ForceVecd
+  // than using X_p_j.inv().dualMatrix()
+  for(int c = 0; c < 10; ++c)
+  {
+    bodyFPhi.col(c) = X_p_j.transMul(sva::ForceVecd(bodyFPhi.col(c))).vector();
+  }
+}
+
+/// Set a random configuration, velocity and acceleration in mbc.
+void randomState(const rbd::MultiBody & mb, rbd::MultiBodyConfig & mbc)
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    const rbd::Joint & j = mb.joint(i);
+    Eigen::VectorXd q(Eigen::VectorXd::Random(j.params()) * 3.);
+    if(j.type() == rbd::Joint::Spherical || j.type() == rbd::Joint::Free)
+    {
+      q.head<4>().normalize();
+    }
+    Eigen::VectorXd alpha(Eigen::VectorXd::Random(j.dof()));
+    Eigen::VectorXd alphaD(Eigen::VectorXd::Random(j.dof()));
+    mbc.q[i].assign(q.data(), q.data() + q.size());
+    mbc.alpha[i].assign(alpha.data(), alpha.data() + alpha.size());
+    mbc.alphaD[i].assign(alphaD.data(), alphaD.data() + alphaD.size());
+  }
+}
+
+void checkMatchVector(const Eigen::Ref<const Eigen::VectorXd> & vec, Eigen::Index size, const char * name)
+{
+  if(vec.size() != size)
+  {
+    std::ostringstream str;
+    str << name << " size mismatch: expected size " << size << " gived " << vec.size();
+    throw std::domain_error(str.str());
+  }
+}
+
+} // namespace
+
 namespace rbd
 {
 
@@ -64,7 +141,38 @@ Eigen::VectorXd multiBodyToInertialVector(const rbd::MultiBody & mb)
   return vec;
 }
 
-IDIM::IDIM(const rbd::MultiBody & mb) : Y_(Eigen::MatrixXd::Zero(mb.nrDof(), mb.nrBodies() * 10)) {}
+IDIM::IDIM(const rbd::MultiBody & mb)
+: Y_(Eigen::MatrixXd::Zero(mb.nrDof(), mb.nrBodies() * 10)), compactY_(mb.nrBodies()),
+  compactPaths_(mb.nrBodies()), pathDofPos_(mb.nrJoints())
+{
+  const std::vector<int> & pred = mb.predecessors();
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    int p = pred[i];
+    int dof = mb.joint(i).dof();
+    pathDofPos_[i] = p != -1 ? pathDofPos_[p] + mb.joint(p).dof() : 0;
+
+    Blocks & path = compactPaths_[i];
+    if(p != -1)
+    {
+      path = compactPaths_[p];
+    }
+    if(dof != 0)
+    {
+      int dofPos = mb.jointPosInDof(i);
+      if(!path.empty() && path.back().startDof + path.back().length == dofPos)
+      {
+        path.back().length += dof;
+      }
+      else
+      {
+        path.emplace_back(dofPos, pathDofPos_[i], dof);
+      }
+    }
+
+    compactY_[i] = Eigen::MatrixXd::Zero(pathDofPos_[i] + dof, 10);
+  }
+}
 
 void IDIM::computeY(const MultiBody & mb, const MultiBodyConfig & mbc)
 {
@@ -75,17 +183,7 @@ void IDIM::computeY(const MultiBody & mb, const MultiBodyConfig & mbc)
   Eigen::Matrix<double, 6, 10> bodyFPhi;
   for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
   {
-    const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
-    Eigen::Matrix<double, 6, 10> vb_i_Phi(IMPhi(vb_i));
-
-    bodyFPhi.noalias() = IMPhi(mbc.bodyAccB[i]);
-    // bodyFPhi += vb_i x* IMPhi(vb_i)
-    // is faster to convert each col in a ForceVecd
-    // than using sva::vector6ToCrossDualMatrix
-    for(int c = 0; c < 10; ++c)
-    {
-      bodyFPhi.col(c).noalias() += (vb_i.crossDual(sva::ForceVecd(vb_i_Phi.col(c)))).vector();
-    }
+    computeBodyFPhi(mbc, i, bodyFPhi);
 
     int iDofPos = mb.jointPosInDof(i);
 
@@ -94,14 +192,7 @@ void IDIM::computeY(const MultiBody & mb, const MultiBodyConfig & mbc)
     int j = i;
     while(pred[j] != -1)
     {
-      const sva::PTransformd & X_p_j = mbc.parentToSon[j];
-      // bodyFPhi = X_p_j^T bodyFPhi
-      // is faster to convert each col in a ForceVecd
-      // than using X_p_j.inv().dualMatrix()
-      for(int c = 0; c < 10; ++c)
-      {
-        bodyFPhi.col(c) = X_p_j.transMul(sva::ForceVecd(bodyFPhi.col(c))).vector();
-      }
+      transformFPhi(mbc.parentToSon[j], bodyFPhi);
       j = pred[j];
 
       int jDofPos = mb.jointPosInDof(j);
@@ -113,6 +204,61 @@ void IDIM::computeY(const MultiBody & mb, const MultiBodyConfig & mbc)
   }
 }
 
+void IDIM::computeCompactY(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  const std::vector<Body> & bodies = mb.bodies();
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+
+  Eigen::Matrix<double, 6, 10> bodyFPhi;
+  for(int i = static_cast<int>(bodies.size()) - 1; i >= 0; --i)
+  {
+    Eigen::MatrixXd & Yi = compactY_[i];
+    computeBodyFPhi(mbc, i, bodyFPhi);
+
+    Yi.middleRows(pathDofPos_[i], joints[i].dof()).noalias() = mbc.motionSubspace[i].transpose() * bodyFPhi;
+
+    int j = i;
+    while(pred[j] != -1)
+    {
+      transformFPhi(mbc.parentToSon[j], bodyFPhi);
+      j = pred[j];
+
+      if(joints[j].dof() != 0)
+      {
+        Yi.middleRows(pathDofPos_[j], joints[j].dof()).noalias() = mbc.motionSubspace[j].transpose() * bodyFPhi;
+      }
+    }
+  }
+}
+
+void IDIM::YTimes(const Eigen::Ref<const Eigen::VectorXd> & phi, Eigen::Ref<Eigen::VectorXd> tau) const
+{
+  tau.setZero();
+  for(std::size_t i = 0; i < compactY_.size(); ++i)
+  {
+    const Eigen::MatrixXd & Yi = compactY_[i];
+    for(const Block & b : compactPaths_[i])
+    {
+      tau.segment(b.startDof, b.length).noalias() += Yi.middleRows(b.startJac, b.length) * phi.segment<10>(10 * i);
+    }
+  }
+}
+
+void IDIM::YTransposeTimes(const Eigen::Ref<const Eigen::VectorXd> & r, Eigen::Ref<Eigen::VectorXd> res) const
+{
+  for(std::size_t i = 0; i < compactY_.size(); ++i)
+  {
+    const Eigen::MatrixXd & Yi = compactY_[i];
+    res.segment<10>(10 * i).setZero();
+    for(const Block & b : compactPaths_[i])
+    {
+      res.segment<10>(10 * i).noalias() +=
+          Yi.middleRows(b.startJac, b.length).transpose() * r.segment(b.startDof, b.length);
+    }
+  }
+}
+
 void IDIM::sComputeY(const MultiBody & mb, const MultiBodyConfig & mbc)
 {
   checkMatchParentToSon(mb, mbc);
@@ -123,4 +269,304 @@ void IDIM::sComputeY(const MultiBody & mb, const MultiBodyConfig & mbc)
   computeY(mb, mbc);
 }
 
+void IDIM::sComputeCompactY(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchBodyAcc(mb, mbc);
+
+  if(static_cast<int>(compactY_.size()) != mb.nrBodies() || Y_.rows() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  computeCompactY(mb, mbc);
+}
+
+void IDIM::sYTimes(const Eigen::Ref<const Eigen::VectorXd> & phi, Eigen::Ref<Eigen::VectorXd> tau) const
+{
+  checkMatchVector(phi, Y_.cols(), "phi");
+  checkMatchVector(tau, Y_.rows(), "tau");
+
+  YTimes(phi, tau);
+}
+
+void IDIM::sYTransposeTimes(const Eigen::Ref<const Eigen::VectorXd> & r, Eigen::Ref<Eigen::VectorXd> res) const
+{
+  checkMatchVector(r, Y_.rows(), "r");
+  checkMatchVector(res, Y_.cols(), "res");
+
+  YTransposeTimes(r, res);
+}
+
+IDIMAccumulator::IDIMAccumulator(const rbd::MultiBody & mb)
+: idim_(mb), tau_(mb.nrDof()), subtreeCols_(mb.nrJoints()),
+  YTY_(Eigen::MatrixXd::Zero(10 * mb.nrBodies(), 10 * mb.nrBodies())),
+  YTtau_(Eigen::VectorXd::Zero(10 * mb.nrBodies())), tauTtau_(0.), scale_(1.), lambda_(1.), nrSamples_(0)
+{
+  const std::vector<int> & pred = mb.predecessors();
+  for(int i = 0; i < mb.nrBodies(); ++i)
+  {
+    // body i parameters appear in the rows of joint i and of its ancestors
+    for(int j = i; j != -1; j = pred[j])
+    {
+      std::vector<std::pair<int, int>> & cols = subtreeCols_[j];
+      if(!cols.empty() && cols.back().first + cols.back().second == 10 * i)
+      {
+        cols.back().second += 10;
+      }
+      else
+      {
+        cols.emplace_back(10 * i, 10);
+      }
+    }
+  }
+}
+
+void IDIMAccumulator::addSample(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc, double weight)
+{
+  idim_.computeY(mb, mbc);
+  paramToVector(mbc.jointTorque, tau_);
+  addSample(mb, idim_.Y(), tau_, weight);
+}
+
+void IDIMAccumulator::addSample(const rbd::MultiBody & mb,
+                                const Eigen::Ref<const Eigen::MatrixXd> & Y,
+                                const Eigen::Ref<const Eigen::VectorXd> & tau,
+                                double weight)
+{
+  const std::vector<Joint> & joints = mb.joints();
+
+  scale_ *= lambda_;
+  if(scale_ < minScale)
+  {
+    YTY_ *= scale_;
+    YTtau_ *= scale_;
+    tauTtau_ *= scale_;
+    scale_ = 1.;
+  }
+
+  double w = weight / scale_;
+  for(int j = 0; j < mb.nrJoints(); ++j)
+  {
+    int pos = mb.jointPosInDof(j);
+    int dof = joints[j].dof();
+    if(dof == 0)
+    {
+      continue;
+    }
+
+    const std::vector<std::pair<int, int>> & cols = subtreeCols_[j];
+    for(std::size_t a = 0; a < cols.size(); ++a)
+    {
+      auto Ya = Y.block(pos, cols[a].first, dof, cols[a].second);
+      YTY_.block(cols[a].first, cols[a].first, cols[a].second, cols[a].second)
+          .selfadjointView<Eigen::Upper>()
+          .rankUpdate(Ya.transpose(), w);
+      // column ranges are sorted, so (a, b) blocks are in the upper triangle
+      for(std::size_t b = a + 1; b < cols.size(); ++b)
+      {
+        YTY_.block(cols[a].first, cols[b].first, cols[a].second, cols[b].second).noalias() +=
+            w * Ya.transpose() * Y.block(pos, cols[b].first, dof, cols[b].second);
+      }
+      YTtau_.segment(cols[a].first, cols[a].second).noalias() += w * Ya.transpose() * tau.segment(pos, dof);
+    }
+  }
+  tauTtau_ += w * tau.squaredNorm();
+  ++nrSamples_;
+}
+
+void IDIMAccumulator::merge(const IDIMAccumulator & other)
+{
+  double ratio = other.scale_ / scale_;
+  YTY_.triangularView<Eigen::Upper>() += ratio * other.YTY_;
+  YTtau_ += ratio * other.YTtau_;
+  tauTtau_ += ratio * other.tauTtau_;
+  nrSamples_ += other.nrSamples_;
+}
+
+void IDIMAccumulator::reset()
+{
+  YTY_.setZero();
+  YTtau_.setZero();
+  tauTtau_ = 0.;
+  scale_ = 1.;
+  nrSamples_ = 0;
+}
+
+Eigen::MatrixXd IDIMAccumulator::YTY() const
+{
+  Eigen::MatrixXd res(scale_ * YTY_.selfadjointView<Eigen::Upper>());
+  return res;
+}
+
+Eigen::VectorXd IDIMAccumulator::YTtau() const
+{
+  return scale_ * YTtau_;
+}
+
+double IDIMAccumulator::tauTtau() const
+{
+  return scale_ * tauTtau_;
+}
+
+void IDIMAccumulator::sAddSample(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc, double weight)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchBodyAcc(mb, mbc);
+  checkMatchJointTorque(mb, mbc);
+
+  if(YTY_.rows() != 10 * mb.nrBodies() || tau_.size() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  addSample(mb, mbc, weight);
+}
+
+void IDIMAccumulator::sAddSample(const rbd::MultiBody & mb,
+                                 const Eigen::Ref<const Eigen::MatrixXd> & Y,
+                                 const Eigen::Ref<const Eigen::VectorXd> & tau,
+                                 double weight)
+{
+  if(YTY_.rows() != 10 * mb.nrBodies() || tau_.size() != mb.nrDof())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  if(Y.rows() != mb.nrDof() || Y.cols() != 10 * mb.nrBodies())
+  {
+    std::ostringstream str;
+    str << "Y size mismatch: expected size " << mb.nrDof() << "x" << 10 * mb.nrBodies() << " gived " << Y.rows()
+        << "x" << Y.cols();
+    throw std::domain_error(str.str());
+  }
+  checkMatchDofVector(mb, tau, "tau");
+
+  addSample(mb, Y, tau, weight);
+}
+
+void IDIMAccumulator::sMerge(const IDIMAccumulator & other)
+{
+  if(YTY_.rows() != other.YTY_.rows())
+  {
+    throw std::domain_error("IDIMAccumulator parameters number mismatch");
+  }
+
+  merge(other);
+}
+
+IDIMBaseParameters::IDIMBaseParameters(const rbd::MultiBody & mb,
+                                       const Eigen::Vector3d & gravity,
+                                       int nrSamples,
+                                       double threshold,
+                                       double zeroThreshold)
+: idim_(mb)
+{
+  using namespace Eigen;
+
+  int nrDof = mb.nrDof();
+  int nrParams = 10 * mb.nrBodies();
+  if(nrSamples <= 0)
+  {
+    nrSamples = std::max(1, (2 * nrParams + nrDof - 1) / std::max(1, nrDof));
+  }
+
+  // stack the Y matrix of random states
+  MultiBodyConfig mbc(mb);
+  mbc.zero(mb);
+  sva::MotionVecd a_0(Vector3d::Zero(), gravity);
+  MatrixXd W(nrSamples * nrDof, nrParams);
+  for(int s = 0; s < nrSamples; ++s)
+  {
+    randomState(mb, mbc);
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    forwardAcceleration(mb, mbc, a_0);
+    idim_.computeY(mb, mbc);
+    W.middleRows(s * nrDof, nrDof) = idim_.Y();
+  }
+
+  // W*P = Q*[R11 R12], the first rank permuted columns are the base columns
+  // and the others are given by W_2 = W_1*R11^{-1}*R12
+  ColPivHouseholderQR<MatrixXd> qr(W);
+  qr.setThreshold(threshold);
+  int rank = static_cast<int>(qr.rank());
+  const ColPivHouseholderQR<MatrixXd>::PermutationType::IndicesType & perm = qr.colsPermutation().indices();
+  MatrixXd beta = qr.matrixR().topLeftCorner(rank, rank).triangularView<Upper>().solve(
+      qr.matrixR().block(0, rank, rank, nrParams - rank));
+  // remove the numerical noise of the combinations
+  beta = (beta.array().abs() < zeroThreshold).select(0., beta);
+
+  // sort the base columns to keep the bodies order in Y_b
+  std::vector<int> order(static_cast<std::size_t>(rank));
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&perm](int a, int b) { return perm(a) < perm(b); });
+
+  baseIndices_.resize(static_cast<std::size_t>(rank));
+  K_ = MatrixXd::Zero(rank, nrParams);
+  for(int l = 0; l < rank; ++l)
+  {
+    int k = order[l];
+    baseIndices_[l] = perm(k);
+    K_(l, perm(k)) = 1.;
+    for(int m = 0; m < nrParams - rank; ++m)
+    {
+      K_(l, perm(rank + m)) = beta(k, m);
+    }
+  }
+
+  Yb_ = MatrixXd::Zero(nrDof, rank);
+}
+
+void IDIMBaseParameters::computeBaseY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc)
+{
+  idim_.computeCompactY(mb, mbc);
+
+  const std::vector<Eigen::MatrixXd> & compactY = idim_.compactY();
+  const std::vector<Blocks> & paths = idim_.compactPaths();
+  for(int l = 0; l < static_cast<int>(baseIndices_.size()); ++l)
+  {
+    int body = baseIndices_[l] / 10;
+    int col = baseIndices_[l] % 10;
+    for(const Block & b : paths[body])
+    {
+      Yb_.block(b.startDof, l, b.length, 1) = compactY[body].block(b.startJac, col, b.length, 1);
+    }
+  }
+}
+
+Eigen::VectorXd IDIMBaseParameters::baseParameters(const rbd::MultiBody & mb) const
+{
+  return K_ * multiBodyToInertialVector(mb);
+}
+
+void IDIMBaseParameters::sComputeBaseY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc)
+{
+  checkMatchParentToSon(mb, mbc);
+  checkMatchBodyVel(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+  checkMatchBodyAcc(mb, mbc);
+
+  if(Yb_.rows() != mb.nrDof() || K_.cols() != 10 * mb.nrBodies())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  computeBaseY(mb, mbc);
+}
+
+Eigen::VectorXd IDIMBaseParameters::sBaseParameters(const rbd::MultiBody & mb) const
+{
+  if(K_.cols() != 10 * mb.nrBodies())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  return baseParameters(mb);
+}
+
 } // namespace rbd
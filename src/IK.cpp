@@ -6,9 +6,15 @@
 #include "RBDyn/IK.h"
 
 // includes
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
 // RBDyn
-#include "RBDyn/FK.h"
-#include "RBDyn/FV.h"
+#include "RBDyn/EulerIntegration.h"
 #include "RBDyn/MultiBody.h"
 #include "RBDyn/MultiBodyConfig.h"
 
@@ -35,7 +41,7 @@ struct CwiseRoundOp
 
 InverseKinematics::InverseKinematics(const MultiBody & mb, int ef_index)
 : max_iterations_(ik::MAX_ITERATIONS), lambda_(ik::LAMBDA), threshold_(ik::THRESHOLD), almost_zero_(ik::ALMOST_ZERO),
-  ef_index_(ef_index), jac_(mb, mb.body(ef_index).name()), svd_()
+  ef_index_(ef_index), jac_(mb, mb.body(ef_index).name()), kin_(mb), svd_()
 {
 }
 
@@ -46,7 +52,9 @@ bool InverseKinematics::inverseKinematics(const MultiBody & mb,
   int iter = 0;
   bool converged = false;
   int dof = 0;
-  rbd::forwardKinematics(mb, mbc);
+  // mbc could have been modified since the last call
+  kin_.allChanged();
+  kin_.forwardKinematics(mb, mbc);
   Eigen::MatrixXd jacMat;
   Eigen::Vector6d v = Eigen::Vector6d::Ones();
   Eigen::Vector3d rotErr;
@@ -71,10 +79,10 @@ bool InverseKinematics::inverseKinematics(const MultiBody & mb,
         qv += lambda_ * res[dof];
         ++dof;
       }
+      kin_.qChanged(index);
     }
 
-    rbd::forwardKinematics(mb, mbc);
-    rbd::forwardVelocity(mb, mbc);
+    kin_.forwardKinematics(mb, mbc);
     iter++;
   }
   return converged;
@@ -92,4 +100,201 @@ bool InverseKinematics::sInverseKinematics(const MultiBody & mb,
   return inverseKinematics(mb, mbc, ef_target);
 }
 
+DampedInverseKinematics::DampedInverseKinematics(const MultiBody & mb, int ef_index)
+: max_iterations_(ik::MAX_ITERATIONS), threshold_(ik::THRESHOLD), damping_(ik::DAMPING), ef_index_(ef_index),
+  jac_(mb, mb.body(ef_index).name()), kin_(mb),
+  qMin_(Eigen::VectorXd::Constant(mb.nrParams(), -std::numeric_limits<double>::infinity())),
+  qMax_(Eigen::VectorXd::Constant(mb.nrParams(), std::numeric_limits<double>::infinity())),
+  jointConfigSave_(jac_.jointsPath().size()), parentToSonSave_(jac_.jointsPath().size()),
+  bodyPosWSave_(jac_.jointsPath().size()), dq_(jac_.dof()), iterations_(0)
+{
+  for(int i : jac_.jointsPath())
+  {
+    qSave_.emplace_back(mb.joint(i).params());
+  }
+}
+
+bool DampedInverseKinematics::inverseKinematics(const MultiBody & mb,
+                                                MultiBodyConfig & mbc,
+                                                const sva::PTransformd & ef_target)
+{
+  return solve(mb, mbc, ef_target, nullptr);
+}
+
+bool DampedInverseKinematics::inverseKinematics(const MultiBody & mb,
+                                                MultiBodyConfig & mbc,
+                                                const sva::PTransformd & ef_target,
+                                                const std::atomic<bool> & cancel)
+{
+  return solve(mb, mbc, ef_target, &cancel);
+}
+
+void DampedInverseKinematics::jointLimits(const Eigen::VectorXd & qMin, const Eigen::VectorXd & qMax)
+{
+  qMin_ = qMin;
+  qMax_ = qMax;
+}
+
+bool DampedInverseKinematics::sInverseKinematics(const MultiBody & mb,
+                                                 MultiBodyConfig & mbc,
+                                                 const sva::PTransformd & ef_target)
+{
+  checkMatchQ(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  if(qMin_.size() != mb.nrParams() || ef_index_ >= mb.nrBodies())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+
+  return inverseKinematics(mb, mbc, ef_target);
+}
+
+void DampedInverseKinematics::sJointLimits(const MultiBody & mb,
+                                           const Eigen::VectorXd & qMin,
+                                           const Eigen::VectorXd & qMax)
+{
+  checkMatchParamVector(mb, qMin, "qMin");
+  checkMatchParamVector(mb, qMax, "qMax");
+
+  jointLimits(qMin, qMax);
+}
+
+bool DampedInverseKinematics::solve(const MultiBody & mb,
+                                    MultiBodyConfig & mbc,
+                                    const sva::PTransformd & ef_target,
+                                    const std::atomic<bool> * cancel)
+{
+  // mbc could have been modified since the last call
+  kin_.allChanged();
+  kin_.forwardKinematics(mb, mbc);
+
+  double lambda = damping_;
+  double cost = computeError(mbc, ef_target, err_);
+  bool converged = std::sqrt(cost) < threshold_;
+  iterations_ = 0;
+  while(!converged && iterations_ < max_iterations_ && lambda < ik::MAX_DAMPING)
+  {
+    if(cancel != nullptr && cancel->load(std::memory_order_relaxed))
+    {
+      break;
+    }
+
+    const Eigen::MatrixXd & J = jac_.jacobian(mb, mbc);
+    A_.noalias() = J * J.transpose();
+    A_.diagonal().array() += lambda;
+    ldlt_.compute(A_);
+    y_ = ldlt_.solve(err_);
+    dq_.noalias() = J.transpose() * y_;
+
+    save(mbc);
+    step(mb, mbc);
+    double newCost = computeError(mbc, ef_target, newErr_);
+    if(newCost < cost)
+    {
+      cost = newCost;
+      err_ = newErr_;
+      lambda = std::max(lambda * 0.1, ik::MIN_DAMPING);
+      converged = std::sqrt(cost) < threshold_;
+    }
+    else
+    {
+      restore(mbc);
+      lambda *= 10.;
+    }
+    ++iterations_;
+  }
+
+  // update the subtrees of the path
+  for(int i : jac_.jointsPath())
+  {
+    kin_.qChanged(i);
+  }
+  kin_.forwardKinematics(mb, mbc);
+
+  return converged;
+}
+
+void DampedInverseKinematics::step(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  static const Eigen::Vector6d zero(Eigen::Vector6d::Zero());
+
+  int dofPos = 0;
+  for(int i : jac_.jointsPath())
+  {
+    const Joint & j = mb.joint(i);
+    std::vector<double> & qi = mbc.q[i];
+    Eigen::Map<Eigen::VectorXd> q(qi.data(), static_cast<Eigen::Index>(qi.size()));
+    eulerJointIntegration(j.type(), dq_.segment(dofPos, j.dof()), zero.head(j.dof()), 1., q);
+
+    // project on the joint limits
+    if(j.params() == j.dof())
+    {
+      int paramPos = mb.jointPosInParam(i);
+      q = q.cwiseMax(qMin_.segment(paramPos, j.params())).cwiseMin(qMax_.segment(paramPos, j.params()));
+    }
+    dofPos += j.dof();
+  }
+
+  pathForwardKinematics(mb, mbc);
+}
+
+void DampedInverseKinematics::pathForwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc) const
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & pred = mb.predecessors();
+  const std::vector<int> & succ = mb.successors();
+  const std::vector<sva::PTransformd> & Xt = mb.transforms();
+
+  for(int i : jac_.jointsPath())
+  {
+    mbc.jointConfig[i] = joints[i].pose(mbc.q[i]);
+    mbc.parentToSon[i] = mbc.jointConfig[i] * Xt[i];
+
+    if(pred[i] != -1)
+      mbc.bodyPosW[succ[i]] = mbc.parentToSon[i] * mbc.bodyPosW[pred[i]];
+    else
+      mbc.bodyPosW[succ[i]] = mbc.parentToSon[i];
+  }
+}
+
+double DampedInverseKinematics::computeError(const MultiBodyConfig & mbc,
+                                             const sva::PTransformd & ef_target,
+                                             Eigen::Vector6d & err) const
+{
+  const sva::PTransformd & X_0_ef = mbc.bodyPosW[ef_index_];
+  err << sva::rotationError(X_0_ef.rotation(), ef_target.rotation()),
+      ef_target.translation() - X_0_ef.translation();
+  return err.squaredNorm();
+}
+
+void DampedInverseKinematics::save(const MultiBodyConfig & mbc)
+{
+  const std::vector<int> & path = jac_.jointsPath();
+  for(std::size_t k = 0; k < path.size(); ++k)
+  {
+    int i = path[k];
+    std::copy(mbc.q[i].begin(), mbc.q[i].end(), qSave_[k].begin());
+    jointConfigSave_[k] = mbc.jointConfig[i];
+    parentToSonSave_[k] = mbc.parentToSon[i];
+    bodyPosWSave_[k] = mbc.bodyPosW[i];
+  }
+}
+
+void DampedInverseKinematics::restore(MultiBodyConfig & mbc) const
+{
+  const std::vector<int> & path = jac_.jointsPath();
+  for(std::size_t k = 0; k < path.size(); ++k)
+  {
+    int i = path[k];
+    std::copy(qSave_[k].begin(), qSave_[k].end(), mbc.q[i].begin());
+    mbc.jointConfig[i] = jointConfigSave_[k];
+    mbc.parentToSon[i] = parentToSonSave_[k];
+    mbc.bodyPosW[i] = bodyPosWSave_[k];
+  }
+}
+
 } // namespace rbd
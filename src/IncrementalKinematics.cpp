@@ -0,0 +1,162 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/IncrementalKinematics.h"
+
+// includes
+// std
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/Joint.h"
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace rbd
+{
+
+IncrementalKinematics::IncrementalKinematics(const MultiBody & mb)
+: q_(mb.nrJoints()), alpha_(mb.nrJoints()), qDirty_(mb.nrJoints(), true), alphaDirty_(mb.nrJoints(), true),
+  posDirty_(mb.nrBodies(), true), update_(mb.nrBodies(), false), nrUpdatedBodies_(0)
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    q_[i].resize(mb.joint(i).params());
+    alpha_[i].resize(mb.joint(i).dof());
+  }
+}
+
+void IncrementalKinematics::allChanged()
+{
+  qDirty_.assign(qDirty_.size(), true);
+  alphaDirty_.assign(alphaDirty_.size(), true);
+}
+
+void IncrementalKinematics::detectChanges(const MultiBodyConfig & mbc)
+{
+  for(std::size_t i = 0; i < qDirty_.size(); ++i)
+  {
+    if(mbc.q[i] != q_[i])
+      qDirty_[i] = true;
+    if(mbc.alpha[i] != alpha_[i])
+      alphaDirty_[i] = true;
+  }
+}
+
+void IncrementalKinematics::forwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & parent = mb.parents();
+  const std::vector<int> & succ = mb.successors();
+  const std::vector<sva::PTransformd> & Xt = mb.transforms();
+
+  nrUpdatedBodies_ = 0;
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    int b = succ[i];
+    int p = parent[b];
+    update_[b] = qDirty_[i] || (p != -1 && update_[p]);
+    if(!update_[b])
+      continue;
+
+    if(qDirty_[i])
+    {
+      mbc.jointConfig[i] = joints[i].pose(mbc.q[i]);
+      mbc.parentToSon[i] = mbc.jointConfig[i] * Xt[i];
+      mbc.motionSubspace[i] = joints[i].motionSubspace();
+      q_[i] = mbc.q[i];
+      qDirty_[i] = false;
+    }
+
+    if(p != -1)
+      mbc.bodyPosW[b] = mbc.parentToSon[i] * mbc.bodyPosW[p];
+    else
+      mbc.bodyPosW[b] = mbc.parentToSon[i];
+
+    posDirty_[b] = true;
+    ++nrUpdatedBodies_;
+  }
+}
+
+void IncrementalKinematics::forwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  const std::vector<Joint> & joints = mb.joints();
+  const std::vector<int> & parent = mb.parents();
+  const std::vector<int> & succ = mb.successors();
+
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    int b = succ[i];
+    int p = parent[b];
+    // the body velocity depends on its parent velocity and on parentToSon[i],
+    // bodyVelW also depends on the body orientation
+    update_[b] = alphaDirty_[i] || posDirty_[b] || (p != -1 && update_[p]);
+    if(!update_[b])
+      continue;
+
+    if(alphaDirty_[i])
+    {
+      mbc.jointVelocity[i] = joints[i].motion(mbc.alpha[i]);
+      alpha_[i] = mbc.alpha[i];
+      alphaDirty_[i] = false;
+    }
+
+    if(p != -1)
+      mbc.bodyVelB[b] = mbc.parentToSon[i] * mbc.bodyVelB[p] + mbc.jointVelocity[i];
+    else
+      mbc.bodyVelB[b] = mbc.jointVelocity[i];
+
+    sva::PTransformd E_0_i(mbc.bodyPosW[b].rotation());
+    mbc.bodyVelW[b] = E_0_i.invMul(mbc.bodyVelB[b]);
+
+    posDirty_[b] = false;
+  }
+}
+
+void IncrementalKinematics::checkMatchMultiBody(const MultiBody & mb) const
+{
+  if(static_cast<int>(qDirty_.size()) != mb.nrJoints())
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+}
+
+void IncrementalKinematics::sDetectChanges(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  checkMatchMultiBody(mb);
+  checkMatchQ(mb, mbc);
+  checkMatchAlpha(mb, mbc);
+
+  detectChanges(mbc);
+}
+
+void IncrementalKinematics::sForwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  checkMatchMultiBody(mb);
+  checkMatchQ(mb, mbc);
+
+  checkMatchBodyPos(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+
+  forwardKinematics(mb, mbc);
+}
+
+void IncrementalKinematics::sForwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  checkMatchMultiBody(mb);
+  checkMatchAlpha(mb, mbc);
+  checkMatchBodyPos(mb, mbc);
+  checkMatchJointConf(mb, mbc);
+  checkMatchParentToSon(mb, mbc);
+
+  checkMatchBodyVel(mb, mbc);
+  checkMatchJointVelocity(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  forwardVelocity(mb, mbc);
+}
+
+} // namespace rbd
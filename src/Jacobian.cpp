@@ -8,6 +8,7 @@
 // includes
 // std
 #include <algorithm>
+#include <sstream>
 #include <stdexcept>
 
 // RBDyn
@@ -16,10 +17,12 @@
 namespace rbd
 {
 
-Jacobian::Jacobian() {}
+Jacobian::Workspace::Workspace(const Jacobian & jac) : jac(6, jac.dof()), jacDot(6, jac.dof()) {}
+
+Jacobian::Jacobian() : dof_(0) {}
 
 Jacobian::Jacobian(const MultiBody & mb, const std::string & bodyName, const Eigen::Vector3d & point)
-: jointsPath_(), point_(point), jac_(), jacDot_()
+: jointsPath_(), point_(point), dof_(0), ws_()
 {
   int index = mb.sBodyIndexByName(bodyName);
 
@@ -32,8 +35,8 @@ Jacobian::Jacobian(const MultiBody & mb, const std::string & bodyName, const Eig
     index = mb.parent(index);
   }
 
-  jac_.resize(6, dof);
-  jacDot_.resize(6, dof);
+  dof_ = dof;
+  ws_ = Workspace(*this);
 }
 
 MultiBody Jacobian::subMultiBody(const MultiBody & mb) const
@@ -100,29 +103,57 @@ const Eigen::MatrixXd & Jacobian::jacobian(const MultiBody & mb,
                                            const MultiBodyConfig & mbc,
                                            const sva::PTransformd & X_0_p)
 {
-  return jacobian_(mb, mbc, X_0_p, jointsPath_, jac_);
+  return jacobian(mb, mbc, X_0_p, ws_);
+}
+
+const Eigen::MatrixXd & Jacobian::jacobian(const MultiBody & mb,
+                                           const MultiBodyConfig & mbc,
+                                           const sva::PTransformd & X_0_p,
+                                           Workspace & ws) const
+{
+  return jacobian_(mb, mbc, X_0_p, jointsPath_, ws.jac);
 }
 
 const Eigen::MatrixXd & Jacobian::jacobian(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return jacobian(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & Jacobian::jacobian(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
 {
   int N = jointsPath_.back();
 
   // the transformation must be read {}^0E_p {}^pT_N {}^NX_0
   Eigen::Vector3d T_0_Np((point_ * mbc.bodyPosW[N]).translation());
-  return jacobian_(mb, mbc, T_0_Np, jointsPath_, jac_);
+  return jacobian_(mb, mbc, T_0_Np, jointsPath_, ws.jac);
 }
 
 const Eigen::MatrixXd & Jacobian::bodyJacobian(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return bodyJacobian(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & Jacobian::bodyJacobian(const MultiBody & mb,
+                                               const MultiBodyConfig & mbc,
+                                               Workspace & ws) const
 {
   int N = jointsPath_.back();
 
   sva::PTransformd X_0_Np = point_ * mbc.bodyPosW[N];
-  return jacobian_(mb, mbc, X_0_Np, jointsPath_, jac_);
+  return jacobian_(mb, mbc, X_0_Np, jointsPath_, ws.jac);
 }
 
 const Eigen::MatrixXd & Jacobian::vectorJacobian(const MultiBody & mb,
                                                  const MultiBodyConfig & mbc,
                                                  const Eigen::Vector3d & vector)
+{
+  return vectorJacobian(mb, mbc, vector, ws_);
+}
+
+const Eigen::MatrixXd & Jacobian::vectorJacobian(const MultiBody & mb,
+                                                 const MultiBodyConfig & mbc,
+                                                 const Eigen::Vector3d & vector,
+                                                 Workspace & ws) const
 {
   const std::vector<Joint> & joints = mb.joints();
 
@@ -147,18 +178,26 @@ const Eigen::MatrixXd & Jacobian::vectorJacobian(const MultiBody & mb,
     //             {}^0E_i(T) (({}^{N}T_i - {}^{Nv}T_i) \times W_i)
     for(int dof = 0; dof < joints[i].dof(); ++dof)
     {
-      jac_.col(curJ + dof).tail<3>().noalias() = E_i_0 * (diff.cross(mbc.motionSubspace[i].col(dof).head<3>()));
+      ws.jac.col(curJ + dof).tail<3>().noalias() = E_i_0 * (diff.cross(mbc.motionSubspace[i].col(dof).head<3>()));
     }
 
     curJ += joints[i].dof();
   }
 
-  return jac_;
+  return ws.jac;
 }
 
 const Eigen::MatrixXd & Jacobian::vectorBodyJacobian(const MultiBody & mb,
                                                      const MultiBodyConfig & mbc,
                                                      const Eigen::Vector3d & vector)
+{
+  return vectorBodyJacobian(mb, mbc, vector, ws_);
+}
+
+const Eigen::MatrixXd & Jacobian::vectorBodyJacobian(const MultiBody & mb,
+                                                     const MultiBodyConfig & mbc,
+                                                     const Eigen::Vector3d & vector,
+                                                     Workspace & ws) const
 {
   const std::vector<Joint> & joints = mb.joints();
 
@@ -181,17 +220,22 @@ const Eigen::MatrixXd & Jacobian::vectorBodyJacobian(const MultiBody & mb,
     //             {}^NE_i(T) (({}^{N}T_i - {}^{Nv}T_i) \times W_i)
     for(int dof = 0; dof < joints[i].dof(); ++dof)
     {
-      jac_.col(curJ + dof).tail<3>().noalias() =
+      ws.jac.col(curJ + dof).tail<3>().noalias() =
           X_i_N.rotation() * (diff.cross(mbc.motionSubspace[i].col(dof).head<3>()));
     }
 
     curJ += joints[i].dof();
   }
 
-  return jac_;
+  return ws.jac;
 }
 
 const Eigen::MatrixXd & Jacobian::jacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return jacobianDot(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & Jacobian::jacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
 {
   const std::vector<Joint> & joints = mb.joints();
 
@@ -222,16 +266,23 @@ const Eigen::MatrixXd & Jacobian::jacobianDot(const MultiBody & mb, const MultiB
       // E_N_0_d = (ANG_VN)_0 x E_N_0
       // X_i_N_d = (Vi - VN)_N x X_i_N
 
-      jacDot_.col(curJ).noalias() =
+      ws.jacDot.col(curJ).noalias() =
           (E_VN.cross(E_N_0 * X_i_Np * S_ij) + E_N_0 * X_VNp_i_Np.cross(X_i_Np * S_ij)).vector();
       ++curJ;
     }
   }
 
-  return jacDot_;
+  return ws.jacDot;
 }
 
 const Eigen::MatrixXd & Jacobian::bodyJacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return bodyJacobianDot(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & Jacobian::bodyJacobianDot(const MultiBody & mb,
+                                                  const MultiBodyConfig & mbc,
+                                                  Workspace & ws) const
 {
   const std::vector<Joint> & joints = mb.joints();
 
@@ -257,12 +308,12 @@ const Eigen::MatrixXd & Jacobian::bodyJacobianDot(const MultiBody & mb, const Mu
       // JD_i = X_i_N_d*S_i
       // X_i_N_d = (Vi - VN)_N x X_i_N
 
-      jacDot_.col(curJ).noalias() = (X_VNp_i_Np.cross(X_i_Np * S_ij)).vector();
+      ws.jacDot.col(curJ).noalias() = (X_VNp_i_Np.cross(X_i_Np * S_ij)).vector();
       ++curJ;
     }
   }
 
-  return jacDot_;
+  return ws.jacDot;
 }
 
 sva::MotionVecd Jacobian::velocity(const MultiBody & /* mb */,
@@ -343,10 +394,99 @@ sva::MotionVecd Jacobian::bodyNormalAcceleration(const MultiBody & /* mb */,
   return bodyNormalAcceleration(mbc, normalAccB[jointsPath_.back()]);
 }
 
+sva::MotionVecd Jacobian::jacobianTimes(const MultiBody & mb,
+                                        const MultiBodyConfig & mbc,
+                                        const Eigen::Ref<const Eigen::VectorXd> & alpha) const
+{
+  // sum the joints velocity in world coordinate then move it at the jacobian point
+  sva::MotionVecd v_0(Eigen::Vector6d::Zero());
+  for(int i : jointsPath_)
+  {
+    int dof = mb.joint(i).dof();
+    if(dof != 0)
+    {
+      Eigen::Vector6d vj = mbc.motionSubspace[i] * alpha.segment(mb.jointPosInDof(i), dof);
+      v_0 += mbc.bodyPosW[i].invMul(sva::MotionVecd(vj));
+    }
+  }
+
+  int N = jointsPath_.back();
+  sva::PTransformd T_0_Np((point_ * mbc.bodyPosW[N]).translation());
+  return T_0_Np * v_0;
+}
+
+void Jacobian::jacobianTimesBatch(const MultiBody & mb,
+                                  const MultiBodyConfig & mbc,
+                                  const Eigen::Ref<const Eigen::MatrixXd> & alphas,
+                                  Eigen::Ref<Eigen::MatrixXd> res) const
+{
+  // the joints velocity are moved at the jacobian point before the sum
+  // to accumulate directly in res
+  int N = jointsPath_.back();
+  sva::PTransformd T_0_Np((point_ * mbc.bodyPosW[N]).translation());
+
+  res.setZero();
+  for(int i : jointsPath_)
+  {
+    int dof = mb.joint(i).dof();
+    if(dof != 0)
+    {
+      Eigen::Matrix<double, 6, Eigen::Dynamic, Eigen::ColMajor, 6, 6> S_p =
+          (T_0_Np * mbc.bodyPosW[i].inv()).matrix() * mbc.motionSubspace[i];
+      res.noalias() += S_p * alphas.middleRows(mb.jointPosInDof(i), dof);
+    }
+  }
+}
+
+void Jacobian::jacobianTransposeTimes(const MultiBody & mb,
+                                      const MultiBodyConfig & mbc,
+                                      const sva::ForceVecd & f,
+                                      Eigen::Ref<Eigen::VectorXd> tau) const
+{
+  // move the wrench at the world origin then in each joint frame
+  int N = jointsPath_.back();
+  sva::PTransformd T_0_Np((point_ * mbc.bodyPosW[N]).translation());
+  sva::ForceVecd f_0 = T_0_Np.transMul(f);
+
+  tau.setZero();
+  for(int i : jointsPath_)
+  {
+    int dof = mb.joint(i).dof();
+    if(dof != 0)
+    {
+      tau.segment(mb.jointPosInDof(i), dof).noalias() =
+          mbc.motionSubspace[i].transpose() * mbc.bodyPosW[i].dualMul(f_0).vector();
+    }
+  }
+}
+
+void Jacobian::jacobianTransposeTimesBatch(const MultiBody & mb,
+                                           const MultiBodyConfig & mbc,
+                                           const Eigen::Ref<const Eigen::MatrixXd> & wrenches,
+                                           Eigen::Ref<Eigen::MatrixXd> res) const
+{
+  // the wrenches are moved in each joint frame by a single 6x6 transform
+  // to avoid a 6 x K temporary at the world origin
+  int N = jointsPath_.back();
+  sva::PTransformd T_0_Np((point_ * mbc.bodyPosW[N]).translation());
+
+  res.setZero();
+  for(int i : jointsPath_)
+  {
+    int dof = mb.joint(i).dof();
+    if(dof != 0)
+    {
+      Eigen::Matrix<double, Eigen::Dynamic, 6, Eigen::ColMajor, 6, 6> STX =
+          mbc.motionSubspace[i].transpose() * (T_0_Np * mbc.bodyPosW[i].inv()).matrix().transpose();
+      res.middleRows(mb.jointPosInDof(i), dof).noalias() = STX * wrenches;
+    }
+  }
+}
+
 void Jacobian::translateJacobian(const Eigen::Ref<const Eigen::MatrixXd> & jac,
                                  const MultiBodyConfig & mbc,
                                  const Eigen::Vector3d & point,
-                                 Eigen::MatrixXd & res)
+                                 Eigen::MatrixXd & res) const
 {
   int N = jointsPath_.back();
   sva::PTransformd E_N_0(Eigen::Matrix3d(mbc.bodyPosW[N].rotation().transpose()));
@@ -364,7 +504,7 @@ void Jacobian::translateJacobian(const Eigen::Ref<const Eigen::MatrixXd> & jac,
 void Jacobian::translateBodyJacobian(const Eigen::Ref<const Eigen::MatrixXd> & jac,
                                      const MultiBodyConfig & /* mbc */,
                                      const Eigen::Vector3d & point,
-                                     Eigen::MatrixXd & res)
+                                     Eigen::MatrixXd & res) const
 {
   sva::PTransformd t(point);
 
@@ -595,25 +735,25 @@ const Eigen::MatrixXd & Jacobian::sBodyJacobianDot(const MultiBody & mb, const M
 void Jacobian::sTranslateJacobian(const Eigen::MatrixXd & jac,
                                   const MultiBodyConfig & mbc,
                                   const Eigen::Vector3d & point,
-                                  Eigen::MatrixXd & res)
+                                  Eigen::MatrixXd & res) const
 {
   if(jointsPath_.back() >= static_cast<int>(mbc.bodyPosW.size()))
   {
     throw std::domain_error("jointsPath mismatch MultiBodyConfig");
   }
 
-  if(jac.cols() != jac_.cols() || jac.rows() != jac_.rows())
+  if(jac.cols() != dof_ || jac.rows() != 6)
   {
     std::ostringstream str;
-    str << "jac matrix size mismatch: expected size (" << jac_.rows() << " x " << jac_.cols() << ")"
+    str << "jac matrix size mismatch: expected size (6 x " << dof_ << ")"
         << " gived (" << jac.rows() << " x " << jac.cols() << ")";
     throw std::domain_error(str.str());
   }
 
-  if(res.cols() != jac_.cols() || res.rows() != jac_.rows())
+  if(res.cols() != dof_ || res.rows() != 6)
   {
     std::ostringstream str;
-    str << "res matrix size mismatch: expected size (" << jac_.rows() << " x " << jac_.cols() << ")"
+    str << "res matrix size mismatch: expected size (6 x " << dof_ << ")"
         << " gived (" << res.rows() << " x " << res.cols() << ")";
     throw std::domain_error(str.str());
   }
@@ -629,10 +769,10 @@ void Jacobian::sFullJacobian(const MultiBody & mb, const Eigen::MatrixXd & jac,
     throw std::domain_error("jointsPath mismatch MultiBody");
   }
 
-  if(jac.cols() != jac_.cols() || jac.rows() != jac_.rows())
+  if(jac.cols() != dof_ || jac.rows() != 6)
   {
     std::ostringstream str;
-    str << "jac matrix size mismatch: expected size (" << jac_.rows() << " x " << jac_.cols() << ")"
+    str << "jac matrix size mismatch: expected size (6 x " << dof_ << ")"
         << " gived (" << jac.rows() << " x " << jac.cols() << ")";
     throw std::domain_error(str.str());
   }
@@ -649,6 +789,47 @@ void Jacobian::sFullJacobian(const MultiBody & mb, const Eigen::MatrixXd & jac,
   fullJacobian(mb, jac, res);
 }
 
+sva::MotionVecd Jacobian::sJacobianTimes(const MultiBody & mb,
+                                         const MultiBodyConfig & mbc,
+                                         const Eigen::Ref<const Eigen::VectorXd> & alpha) const
+{
+  checkMatchProduct(mb, mbc, alpha, mb.nrDof(), 1, "alpha");
+
+  return jacobianTimes(mb, mbc, alpha);
+}
+
+void Jacobian::sJacobianTimesBatch(const MultiBody & mb,
+                                   const MultiBodyConfig & mbc,
+                                   const Eigen::Ref<const Eigen::MatrixXd> & alphas,
+                                   Eigen::Ref<Eigen::MatrixXd> res) const
+{
+  checkMatchProduct(mb, mbc, alphas, mb.nrDof(), alphas.cols(), "alphas");
+  checkMatchProduct(mb, mbc, res, 6, alphas.cols(), "res");
+
+  jacobianTimesBatch(mb, mbc, alphas, res);
+}
+
+void Jacobian::sJacobianTransposeTimes(const MultiBody & mb,
+                                       const MultiBodyConfig & mbc,
+                                       const sva::ForceVecd & f,
+                                       Eigen::Ref<Eigen::VectorXd> tau) const
+{
+  checkMatchProduct(mb, mbc, tau, mb.nrDof(), 1, "tau");
+
+  jacobianTransposeTimes(mb, mbc, f, tau);
+}
+
+void Jacobian::sJacobianTransposeTimesBatch(const MultiBody & mb,
+                                            const MultiBodyConfig & mbc,
+                                            const Eigen::Ref<const Eigen::MatrixXd> & wrenches,
+                                            Eigen::Ref<Eigen::MatrixXd> res) const
+{
+  checkMatchProduct(mb, mbc, wrenches, 6, wrenches.cols(), "wrenches");
+  checkMatchProduct(mb, mbc, res, mb.nrDof(), wrenches.cols(), "res");
+
+  jacobianTransposeTimesBatch(mb, mbc, wrenches, res);
+}
+
 sva::MotionVecd Jacobian::sVelocity(const MultiBody & mb,
                                     const MultiBodyConfig & mbc,
                                     const sva::PTransformd & X_b_p) const
@@ -762,4 +943,29 @@ sva::MotionVecd Jacobian::bodyNormalAcceleration(const MultiBodyConfig & /* mbc
   return point_ * bodyNNormalAcc;
 }
 
+void Jacobian::checkMatchProduct(const MultiBody & mb,
+                                 const MultiBodyConfig & mbc,
+                                 const Eigen::Ref<const Eigen::MatrixXd> & mat,
+                                 Eigen::Index rows,
+                                 Eigen::Index cols,
+                                 const char * name) const
+{
+  checkMatchBodyPos(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  int m = *std::max_element(jointsPath_.begin(), jointsPath_.end());
+  if(m >= static_cast<int>(mb.nrJoints()))
+  {
+    throw std::domain_error("jointsPath mismatch MultiBody");
+  }
+
+  if(mat.rows() != rows || mat.cols() != cols)
+  {
+    std::ostringstream str;
+    str << name << " matrix size mismatch: expected size (" << rows << " x " << cols << ")"
+        << " gived (" << mat.rows() << " x " << mat.cols() << ")";
+    throw std::domain_error(str.str());
+  }
+}
+
 } // namespace rbd
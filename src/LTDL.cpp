@@ -0,0 +1,220 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/LTDL.h"
+
+// includes
+// std
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+
+namespace rbd
+{
+
+LTDLFactorization::LTDLFactorization(const MultiBody & mb) : LD_(mb.nrDof(), mb.nrDof()), lambda_(mb.nrDof())
+{
+  LD_.setZero();
+
+  const std::vector<int> & pred = mb.predecessors();
+
+  // last dof of each joint (-1 if the joint and all its ancestors have no dof)
+  std::vector<int> lastDof(mb.nrJoints(), -1);
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    int parentDof = pred[i] != -1 ? lastDof[pred[i]] : -1;
+    int pos = mb.jointPosInDof(i);
+    for(int dof = 0; dof < mb.joint(i).dof(); ++dof)
+    {
+      lambda_[pos + dof] = dof == 0 ? parentDof : pos + dof - 1;
+    }
+    lastDof[i] = mb.joint(i).dof() != 0 ? pos + mb.joint(i).dof() - 1 : parentDof;
+  }
+}
+
+void LTDLFactorization::compute(const Eigen::MatrixXd & H)
+{
+  LD_.triangularView<Eigen::Lower>() = H;
+
+  for(int k = static_cast<int>(lambda_.size()) - 1; k >= 0; --k)
+  {
+    int i = lambda_[k];
+    while(i != -1)
+    {
+      double a = LD_(k, i) / LD_(k, k);
+      int j = i;
+      while(j != -1)
+      {
+        LD_(i, j) -= a * LD_(k, j);
+        j = lambda_[j];
+      }
+      LD_(k, i) = a;
+      i = lambda_[i];
+    }
+  }
+}
+
+void LTDLFactorization::solveInPlace(Eigen::Ref<Eigen::MatrixXd> b) const
+{
+  // L^T y = b
+  solveLTransposeInPlace(b);
+
+  // D z = y
+  for(int i = 0; i < static_cast<int>(lambda_.size()); ++i)
+  {
+    b.row(i) /= LD_(i, i);
+  }
+
+  // L x = z
+  solveLInPlace(b);
+}
+
+void LTDLFactorization::solveLTransposeInPlace(Eigen::Ref<Eigen::MatrixXd> b) const
+{
+  for(int i = static_cast<int>(lambda_.size()) - 1; i >= 0; --i)
+  {
+    int j = lambda_[i];
+    while(j != -1)
+    {
+      b.row(j) -= LD_(i, j) * b.row(i);
+      j = lambda_[j];
+    }
+  }
+}
+
+void LTDLFactorization::solveLInPlace(Eigen::Ref<Eigen::MatrixXd> b) const
+{
+  for(int i = 0; i < static_cast<int>(lambda_.size()); ++i)
+  {
+    int j = lambda_[i];
+    while(j != -1)
+    {
+      b.row(i) -= LD_(i, j) * b.row(j);
+      j = lambda_[j];
+    }
+  }
+}
+
+void LTDLFactorization::halfSolveInPlace(const std::vector<int> & dofs, Eigen::Ref<Eigen::MatrixXd> b) const
+{
+  // L^T y = b, the ancestors of dofs[a] are found in decreasing order
+  // before a since dofs is sorted
+  for(int a = static_cast<int>(dofs.size()) - 1; a >= 0; --a)
+  {
+    int j = lambda_[dofs[a]];
+    for(int c = a - 1; j != -1; --c)
+    {
+      if(dofs[c] == j)
+      {
+        b.row(c) -= LD_(dofs[a], j) * b.row(a);
+        j = lambda_[j];
+      }
+    }
+  }
+
+  for(std::size_t a = 0; a < dofs.size(); ++a)
+  {
+    b.row(a) /= std::sqrt(LD_(dofs[a], dofs[a]));
+  }
+}
+
+void LTDLFactorization::sharedDofsProduct(const std::vector<int> & dofsI,
+                                          const Eigen::Ref<const Eigen::MatrixXd> & wI,
+                                          const std::vector<int> & dofsJ,
+                                          const Eigen::Ref<const Eigen::MatrixXd> & wJ,
+                                          Eigen::Ref<Eigen::MatrixXd> res)
+{
+  res.setZero();
+  std::size_t a = 0, b = 0;
+  while(a < dofsI.size() && b < dofsJ.size())
+  {
+    if(dofsI[a] < dofsJ[b])
+    {
+      ++a;
+    }
+    else if(dofsJ[b] < dofsI[a])
+    {
+      ++b;
+    }
+    else
+    {
+      std::size_t n = 1;
+      while(a + n < dofsI.size() && b + n < dofsJ.size() && dofsI[a + n] == dofsJ[b + n])
+      {
+        ++n;
+      }
+      res.noalias() += wI.middleRows(a, n).transpose() * wJ.middleRows(b, n);
+      a += n;
+      b += n;
+    }
+  }
+}
+
+Eigen::MatrixXd LTDLFactorization::solve(const Eigen::MatrixXd & b) const
+{
+  Eigen::MatrixXd x(b);
+  solveInPlace(x);
+  return x;
+}
+
+void LTDLFactorization::solveJacobianTranspose(const Eigen::Ref<const Eigen::MatrixXd> & jac,
+                                               Eigen::MatrixXd & res) const
+{
+  res = jac.transpose();
+  solveInPlace(res);
+}
+
+void LTDLFactorization::inverse(Eigen::MatrixXd & Hinv) const
+{
+  // H^-1 = L^-1 D^-1 L^-T, so L H^-1 = D^-1 L^-T is upper triangular with D^-1
+  // on its diagonal. Since L(i, j) is only non zero for j ancestor of i:
+  // H^-1(k, i) = -sum_j L(i, j) H^-1(k, j) for k < i
+  // H^-1(i, i) = D(i)^-1 - sum_j L(i, j) H^-1(j, i)
+  for(int i = 0; i < static_cast<int>(lambda_.size()); ++i)
+  {
+    Hinv.col(i).head(i).setZero();
+    for(int j = lambda_[i]; j != -1; j = lambda_[j])
+    {
+      Hinv.col(i).head(i) -= LD_(i, j) * Hinv.col(j).head(i);
+    }
+    Hinv.row(i).head(i) = Hinv.col(i).head(i).transpose();
+
+    Hinv(i, i) = 1. / LD_(i, i);
+    for(int j = lambda_[i]; j != -1; j = lambda_[j])
+    {
+      Hinv(i, i) -= LD_(i, j) * Hinv(j, i);
+    }
+  }
+}
+
+void LTDLFactorization::sCompute(const Eigen::MatrixXd & H)
+{
+  if(H.rows() != static_cast<int>(lambda_.size()) || H.cols() != static_cast<int>(lambda_.size()))
+  {
+    std::ostringstream str;
+    str << "H size mismatch: expected size " << lambda_.size() << "x" << lambda_.size() << " gived " << H.rows()
+        << "x" << H.cols();
+    throw std::domain_error(str.str());
+  }
+
+  compute(H);
+}
+
+Eigen::MatrixXd LTDLFactorization::sSolve(const Eigen::MatrixXd & b) const
+{
+  if(b.rows() != static_cast<int>(lambda_.size()))
+  {
+    std::ostringstream str;
+    str << "b size mismatch: expected " << lambda_.size() << " rows gived " << b.rows();
+    throw std::domain_error(str.str());
+  }
+
+  return solve(b);
+}
+
+} // namespace rbd
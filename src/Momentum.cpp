@@ -110,21 +110,29 @@ Eigen::Matrix6d jacProjectorDot(const sva::PTransformd & X_i_com,
   return Eigen::Matrix6d(X_i_com_d * I_i.matrix());
 }
 
-CentroidalMomentumMatrix::CentroidalMomentumMatrix()
-: cmMat_(), cmMatDot_(), jacVec_(), blocksVec_(), jacWork_(), bodiesWeight_()
+CentroidalMomentumMatrix::Workspace::Workspace(const MultiBody & mb, const CentroidalMomentumMatrix & cmm)
+: cmMat(6, mb.nrDof()), cmMatDot(6, mb.nrDof()), jacWork(mb.nrBodies()), jacs(mb.nrBodies()),
+  normalAcc(mb.nrBodies())
+{
+  for(int i = 0; i < static_cast<int>(cmm.jacVec_.size()); ++i)
+  {
+    jacWork[i].resize(6, cmm.jacVec_[i].dof());
+    jacs[i] = Jacobian::Workspace(cmm.jacVec_[i]);
+  }
+}
+
+CentroidalMomentumMatrix::CentroidalMomentumMatrix() : jacVec_(), blocksVec_(), bodiesWeight_(), ws_()
 {
 }
 
 CentroidalMomentumMatrix::CentroidalMomentumMatrix(const MultiBody & mb)
-: cmMat_(6, mb.nrDof()), cmMatDot_(6, mb.nrDof()), jacVec_(mb.nrBodies()), blocksVec_(mb.nrBodies()),
-  jacWork_(mb.nrBodies()), bodiesWeight_(mb.nrBodies(), 1.), normalAcc_(mb.nrBodies())
+: jacVec_(mb.nrBodies()), blocksVec_(mb.nrBodies()), bodiesWeight_(mb.nrBodies(), 1.)
 {
   init(mb);
 }
 
 CentroidalMomentumMatrix::CentroidalMomentumMatrix(const MultiBody & mb, std::vector<double> weight)
-: cmMat_(6, mb.nrDof()), cmMatDot_(6, mb.nrDof()), jacVec_(mb.nrBodies()), blocksVec_(mb.nrBodies()),
-  jacWork_(mb.nrBodies()), bodiesWeight_(std::move(weight)), normalAcc_(mb.nrBodies())
+: jacVec_(mb.nrBodies()), blocksVec_(mb.nrBodies()), bodiesWeight_(std::move(weight))
 {
   init(mb);
 
@@ -139,20 +147,28 @@ CentroidalMomentumMatrix::CentroidalMomentumMatrix(const MultiBody & mb, std::ve
 void CentroidalMomentumMatrix::computeMatrix(const MultiBody & mb,
                                              const MultiBodyConfig & mbc,
                                              const Eigen::Vector3d & com)
+{
+  computeMatrix(mb, mbc, com, ws_);
+}
+
+void CentroidalMomentumMatrix::computeMatrix(const MultiBody & mb,
+                                             const MultiBodyConfig & mbc,
+                                             const Eigen::Vector3d & com,
+                                             Workspace & ws) const
 {
   using namespace Eigen;
   const std::vector<Body> & bodies = mb.bodies();
-  cmMat_.setZero();
+  ws.cmMat.setZero();
 
   sva::PTransformd X_0_com(com);
   for(int i = 0; i < mb.nrBodies(); ++i)
   {
-    const MatrixXd & jac = jacVec_[i].bodyJacobian(mb, mbc);
+    const MatrixXd & jac = jacVec_[i].bodyJacobian(mb, mbc, ws.jacs[i]);
     sva::PTransformd X_i_com(X_0_com * (mbc.bodyPosW[i].inv()));
     Matrix6d proj = bodiesWeight_[i] * jacProjector(X_i_com, bodies[i].inertia());
 
-    jacWork_[i] = proj * jac;
-    jacVec_[i].addFullJacobian(blocksVec_[i], jacWork_[i], cmMat_);
+    ws.jacWork[i] = proj * jac;
+    jacVec_[i].addFullJacobian(blocksVec_[i], ws.jacWork[i], ws.cmMat);
   }
 }
 
@@ -160,24 +176,33 @@ void CentroidalMomentumMatrix::computeMatrixDot(const MultiBody & mb,
                                                 const MultiBodyConfig & mbc,
                                                 const Eigen::Vector3d & com,
                                                 const Eigen::Vector3d & comDot)
+{
+  computeMatrixDot(mb, mbc, com, comDot, ws_);
+}
+
+void CentroidalMomentumMatrix::computeMatrixDot(const MultiBody & mb,
+                                                const MultiBodyConfig & mbc,
+                                                const Eigen::Vector3d & com,
+                                                const Eigen::Vector3d & comDot,
+                                                Workspace & ws) const
 {
   using namespace Eigen;
   const std::vector<Body> & bodies = mb.bodies();
-  cmMatDot_.setZero();
+  ws.cmMatDot.setZero();
 
   sva::PTransformd X_0_com(com);
   sva::MotionVecd com_Vel(Vector3d::Zero(), comDot);
   for(int i = 0; i < mb.nrBodies(); ++i)
   {
-    const MatrixXd & jac = jacVec_[i].bodyJacobian(mb, mbc);
-    const MatrixXd & jacDot = jacVec_[i].bodyJacobianDot(mb, mbc);
+    const MatrixXd & jac = jacVec_[i].bodyJacobian(mb, mbc, ws.jacs[i]);
+    const MatrixXd & jacDot = jacVec_[i].bodyJacobianDot(mb, mbc, ws.jacs[i]);
 
     sva::PTransformd X_i_com(X_0_com * (mbc.bodyPosW[i].inv()));
     Matrix6d proj = bodiesWeight_[i] * jacProjector(X_i_com, bodies[i].inertia());
     Matrix6d projDot = bodiesWeight_[i] * jacProjectorDot(X_i_com, bodies[i].inertia(), mbc.bodyVelB[i], com_Vel);
 
-    jacWork_[i] = proj * jacDot + projDot * jac;
-    jacVec_[i].addFullJacobian(blocksVec_[i], jacWork_[i], cmMatDot_);
+    ws.jacWork[i] = proj * jacDot + projDot * jac;
+    jacVec_[i].addFullJacobian(blocksVec_[i], ws.jacWork[i], ws.cmMatDot);
   }
 }
 
@@ -185,39 +210,48 @@ void CentroidalMomentumMatrix::computeMatrixAndMatrixDot(const MultiBody & mb,
                                                          const MultiBodyConfig & mbc,
                                                          const Eigen::Vector3d & com,
                                                          const Eigen::Vector3d & comDot)
+{
+  computeMatrixAndMatrixDot(mb, mbc, com, comDot, ws_);
+}
+
+void CentroidalMomentumMatrix::computeMatrixAndMatrixDot(const MultiBody & mb,
+                                                         const MultiBodyConfig & mbc,
+                                                         const Eigen::Vector3d & com,
+                                                         const Eigen::Vector3d & comDot,
+                                                         Workspace & ws) const
 {
   using namespace Eigen;
   const std::vector<Body> & bodies = mb.bodies();
-  cmMat_.setZero();
-  cmMatDot_.setZero();
+  ws.cmMat.setZero();
+  ws.cmMatDot.setZero();
 
   sva::PTransformd X_0_com(com);
   sva::MotionVecd com_Vel(Vector3d::Zero(), comDot);
   for(int i = 0; i < mb.nrBodies(); ++i)
   {
-    const MatrixXd & jac = jacVec_[i].bodyJacobian(mb, mbc);
-    const MatrixXd & jacDot = jacVec_[i].bodyJacobianDot(mb, mbc);
+    const MatrixXd & jac = jacVec_[i].bodyJacobian(mb, mbc, ws.jacs[i]);
+    const MatrixXd & jacDot = jacVec_[i].bodyJacobianDot(mb, mbc, ws.jacs[i]);
 
     sva::PTransformd X_i_com(X_0_com * (mbc.bodyPosW[i].inv()));
     Matrix6d proj = bodiesWeight_[i] * jacProjector(X_i_com, bodies[i].inertia());
     Matrix6d projDot = bodiesWeight_[i] * jacProjectorDot(X_i_com, bodies[i].inertia(), mbc.bodyVelB[i], com_Vel);
 
-    jacWork_[i] = proj * jac;
-    jacVec_[i].addFullJacobian(blocksVec_[i], jacWork_[i], cmMat_);
+    ws.jacWork[i] = proj * jac;
+    jacVec_[i].addFullJacobian(blocksVec_[i], ws.jacWork[i], ws.cmMat);
 
-    jacWork_[i] = proj * jacDot + projDot * jac;
-    jacVec_[i].addFullJacobian(blocksVec_[i], jacWork_[i], cmMatDot_);
+    ws.jacWork[i] = proj * jacDot + projDot * jac;
+    jacVec_[i].addFullJacobian(blocksVec_[i], ws.jacWork[i], ws.cmMatDot);
   }
 }
 
 const Eigen::MatrixXd & CentroidalMomentumMatrix::matrix() const
 {
-  return cmMat_;
+  return ws_.cmMat;
 }
 
 const Eigen::MatrixXd & CentroidalMomentumMatrix::matrixDot() const
 {
-  return cmMatDot_;
+  return ws_.cmMatDot;
 }
 
 sva::ForceVecd CentroidalMomentumMatrix::momentum(const MultiBody & mb,
@@ -246,6 +280,15 @@ sva::ForceVecd CentroidalMomentumMatrix::normalMomentumDot(const MultiBody & mb,
                                                            const MultiBodyConfig & mbc,
                                                            const Eigen::Vector3d & com,
                                                            const Eigen::Vector3d & comDot)
+{
+  return normalMomentumDot(mb, mbc, com, comDot, ws_);
+}
+
+sva::ForceVecd CentroidalMomentumMatrix::normalMomentumDot(const MultiBody & mb,
+                                                           const MultiBodyConfig & mbc,
+                                                           const Eigen::Vector3d & com,
+                                                           const Eigen::Vector3d & comDot,
+                                                           Workspace & ws) const
 {
   using namespace Eigen;
 
@@ -259,12 +302,12 @@ sva::ForceVecd CentroidalMomentumMatrix::normalMomentumDot(const MultiBody & mb,
     const sva::MotionVecd & vb_i = mbc.bodyVelB[i];
 
     if(pred[i] != -1)
-      normalAcc_[succ[i]] = X_p_i * normalAcc_[pred[i]] + vb_i.cross(vj_i);
+      ws.normalAcc[succ[i]] = X_p_i * ws.normalAcc[pred[i]] + vb_i.cross(vj_i);
     else
-      normalAcc_[succ[i]] = vb_i.cross(vj_i);
+      ws.normalAcc[succ[i]] = vb_i.cross(vj_i);
   }
 
-  return normalMomentumDot(mb, mbc, com, comDot, normalAcc_);
+  return normalMomentumDot(mb, mbc, com, comDot, ws.normalAcc);
 }
 
 sva::ForceVecd CentroidalMomentumMatrix::normalMomentumDot(const MultiBody & mb,
@@ -384,8 +427,9 @@ void CentroidalMomentumMatrix::init(const rbd::MultiBody & mb)
   {
     jacVec_[i] = Jacobian(mb, mb.body(i).name());
     blocksVec_[i] = jacVec_[i].compactPath(mb);
-    jacWork_[i].resize(6, jacVec_[i].dof());
   }
+
+  ws_ = Workspace(mb, *this);
 }
 
 } // namespace rbd
@@ -49,6 +49,47 @@ void MultiBodyConfig::zero(const MultiBody & mb)
   }
 }
 
+FlatMultiBodyConfig::FlatMultiBodyConfig(const MultiBody & mb)
+: q(mb.nrParams()), alpha(mb.nrDof()), alphaD(mb.nrDof()), jointTorque(mb.nrDof()), paramPos_(mb.nrJoints() + 1),
+  dofPos_(mb.nrJoints() + 1)
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    paramPos_[i] = mb.jointPosInParam(i);
+    dofPos_[i] = mb.jointPosInDof(i);
+  }
+  paramPos_.back() = mb.nrParams();
+  dofPos_.back() = mb.nrDof();
+}
+
+void FlatMultiBodyConfig::zero(const MultiBody & mb)
+{
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    std::vector<double> zero = mb.joint(i).zeroParam();
+    qOf(i) = Eigen::Map<const Eigen::VectorXd>(zero.data(), static_cast<Eigen::Index>(zero.size()));
+  }
+  alpha.setZero();
+  alphaD.setZero();
+  jointTorque.setZero();
+}
+
+void FlatMultiBodyConfig::fromConfig(const MultiBodyConfig & mbc)
+{
+  paramToVector(mbc.q, q);
+  paramToVector(mbc.alpha, alpha);
+  paramToVector(mbc.alphaD, alphaD);
+  paramToVector(mbc.jointTorque, jointTorque);
+}
+
+void FlatMultiBodyConfig::toConfig(MultiBodyConfig & mbc) const
+{
+  vectorToParam(q, mbc.q);
+  vectorToParam(alpha, mbc.alpha);
+  vectorToParam(alphaD, mbc.alphaD);
+  vectorToParam(jointTorque, mbc.jointTorque);
+}
+
 std::vector<Eigen::MatrixXd> MultiBodyConfig::python_motionSubspace()
 {
   std::vector<Eigen::MatrixXd> ret(motionSubspace.size());
@@ -465,4 +506,26 @@ void checkMatchForce(const MultiBody & mb, const MultiBodyConfig & mbc)
   checkMatchBodiesVector(mb, mbc.force, "External force vector");
 }
 
+void checkMatchParamVector(const MultiBody & mb,
+                           const Eigen::Ref<const Eigen::VectorXd> & vec,
+                           const std::string & name)
+{
+  if(vec.size() != mb.nrParams())
+  {
+    std::ostringstream str;
+    str << name << " size mismatch: expected size " << mb.nrParams() << " gived " << vec.size();
+    throw std::domain_error(str.str());
+  }
+}
+
+void checkMatchDofVector(const MultiBody & mb, const Eigen::Ref<const Eigen::VectorXd> & vec, const std::string & name)
+{
+  if(vec.size() != mb.nrDof())
+  {
+    std::ostringstream str;
+    str << name << " size mismatch: expected size " << mb.nrDof() << " gived " << vec.size();
+    throw std::domain_error(str.str());
+  }
+}
+
 } // namespace rbd
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/MultiFrameJacobian.h"
+
+// includes
+// std
+#include <algorithm>
+#include <stdexcept>
+
+// RBDyn
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+
+namespace rbd
+{
+
+MultiFrameJacobian::Workspace::Workspace(const MultiFrameJacobian & mfj)
+: S_0(Eigen::MatrixXd::Zero(6, mfj.nrDof_)), jac(Eigen::MatrixXd::Zero(6 * mfj.nrFrames(), mfj.nrDof_))
+{
+}
+
+MultiFrameJacobian::MultiFrameJacobian(const MultiBody & mb,
+                                       const std::vector<std::string> & bodyNames,
+                                       const std::vector<Eigen::Vector3d> & points)
+: bodies_(), points_(), joints_(), jointsPaths_(), pathCols_(), nrDof_(mb.nrDof()), ws_()
+{
+  if(!points.empty() && points.size() != bodyNames.size())
+  {
+    throw std::domain_error("bodyNames and points size mismatch");
+  }
+
+  std::vector<bool> support(static_cast<std::size_t>(mb.nrJoints()), false);
+  for(std::size_t k = 0; k < bodyNames.size(); ++k)
+  {
+    int index = mb.sBodyIndexByName(bodyNames[k]);
+    bodies_.push_back(index);
+    points_.push_back(sva::PTransformd(points.empty() ? Eigen::Vector3d::Zero() : points[k]));
+
+    std::vector<int> path;
+    while(index != -1)
+    {
+      path.insert(path.begin(), index);
+      support[index] = true;
+      index = mb.parent(index);
+    }
+
+    // merge the contiguous dof of the path
+    std::vector<std::pair<int, int>> cols;
+    for(int i : path)
+    {
+      int pos = mb.jointPosInDof(i);
+      int dof = mb.joint(i).dof();
+      if(dof == 0)
+      {
+        continue;
+      }
+
+      if(!cols.empty() && cols.back().first + cols.back().second == pos)
+      {
+        cols.back().second += dof;
+      }
+      else
+      {
+        cols.emplace_back(pos, dof);
+      }
+    }
+
+    jointsPaths_.push_back(std::move(path));
+    pathCols_.push_back(std::move(cols));
+  }
+
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    if(support[i] && mb.joint(i).dof() != 0)
+    {
+      joints_.push_back(i);
+    }
+  }
+
+  ws_ = Workspace(*this);
+}
+
+const Eigen::MatrixXd & MultiFrameJacobian::jacobian(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return jacobian(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & MultiFrameJacobian::jacobian(const MultiBody & mb,
+                                                     const MultiBodyConfig & mbc,
+                                                     Workspace & ws) const
+{
+  computeS_0(mb, mbc, ws);
+
+  for(int k = 0; k < nrFrames(); ++k)
+  {
+    // the transformation must be read {}^0E_p {}^pT_N {}^NX_0
+    Eigen::Vector3d T_0_Np((points_[k] * mbc.bodyPosW[bodies_[k]]).translation());
+    Eigen::Matrix3d TCross(sva::vector3ToCrossMatrix(T_0_Np));
+
+    for(const std::pair<int, int> & c : pathCols_[k])
+    {
+      ws.jac.block(6 * k, c.first, 3, c.second) = ws.S_0.block(0, c.first, 3, c.second);
+      ws.jac.block(6 * k + 3, c.first, 3, c.second) = ws.S_0.block(3, c.first, 3, c.second);
+      ws.jac.block(6 * k + 3, c.first, 3, c.second).noalias() -= TCross * ws.S_0.block(0, c.first, 3, c.second);
+    }
+  }
+
+  return ws.jac;
+}
+
+const Eigen::MatrixXd & MultiFrameJacobian::bodyJacobian(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  return bodyJacobian(mb, mbc, ws_);
+}
+
+const Eigen::MatrixXd & MultiFrameJacobian::bodyJacobian(const MultiBody & mb,
+                                                         const MultiBodyConfig & mbc,
+                                                         Workspace & ws) const
+{
+  computeS_0(mb, mbc, ws);
+
+  for(int k = 0; k < nrFrames(); ++k)
+  {
+    sva::PTransformd X_0_Np = points_[k] * mbc.bodyPosW[bodies_[k]];
+    const Eigen::Matrix3d & E = X_0_Np.rotation();
+    // X_0_Np*(w, v) = (E*w, E*(v - T x w))
+    Eigen::Matrix3d ETCross(E * sva::vector3ToCrossMatrix(X_0_Np.translation()));
+
+    for(const std::pair<int, int> & c : pathCols_[k])
+    {
+      ws.jac.block(6 * k, c.first, 3, c.second).noalias() = E * ws.S_0.block(0, c.first, 3, c.second);
+      ws.jac.block(6 * k + 3, c.first, 3, c.second).noalias() = E * ws.S_0.block(3, c.first, 3, c.second);
+      ws.jac.block(6 * k + 3, c.first, 3, c.second).noalias() -= ETCross * ws.S_0.block(0, c.first, 3, c.second);
+    }
+  }
+
+  return ws.jac;
+}
+
+const Eigen::MatrixXd & MultiFrameJacobian::sJacobian(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  checkMatch(mb, mbc);
+
+  return jacobian(mb, mbc);
+}
+
+const Eigen::MatrixXd & MultiFrameJacobian::sBodyJacobian(const MultiBody & mb, const MultiBodyConfig & mbc)
+{
+  checkMatch(mb, mbc);
+
+  return bodyJacobian(mb, mbc);
+}
+
+void MultiFrameJacobian::computeS_0(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const
+{
+  for(int i : joints_)
+  {
+    int pos = mb.jointPosInDof(i);
+    const sva::PTransformd & X_0_i = mbc.bodyPosW[i];
+    for(int dof = 0; dof < mb.joint(i).dof(); ++dof)
+    {
+      ws.S_0.col(pos + dof) = X_0_i.invMul(sva::MotionVecd(mbc.motionSubspace[i].col(dof))).vector();
+    }
+  }
+}
+
+void MultiFrameJacobian::checkMatch(const MultiBody & mb, const MultiBodyConfig & mbc) const
+{
+  checkMatchBodyPos(mb, mbc);
+  checkMatchMotionSubspace(mb, mbc);
+
+  if(mb.nrDof() != nrDof_ || std::any_of(bodies_.begin(), bodies_.end(), [&mb](int b) { return b >= mb.nrBodies(); }))
+  {
+    throw std::domain_error("MultiBody mismatch");
+  }
+}
+
+} // namespace rbd
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <vector>
+
+// Eigen
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <rbdyn/config.hh>
+
+#include <SpaceVecAlg/SpaceVecAlg>
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * Articulated Body Algorithm (Featherstone).
+ * Compute the forward dynamics in O(n) without building the inertia matrix.
+ */
+class RBDYN_DLLAPI ArticulatedBodyAlgorithm
+{
+public:
+  ArticulatedBodyAlgorithm() {}
+  /// @param mb MultiBody associated with this algorithm.
+  ArticulatedBodyAlgorithm(const MultiBody & mb);
+
+  /**
+   * Compute the forward dynamics.
+   * @param mb MultiBody used has model.
+   * @param mbc Use parentToSon, motionSubspace jointVelocity, bodyVelB,
+   * bodyPosW, force, gravity and jointTorque.
+   * Fill alphaD generalized acceleration vector.
+   */
+  void forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
+
+  /// @return Articulated inertia of the subtree rooted at body i.
+  const std::vector<sva::ABInertiad> & articulatedInertia() const
+  {
+    return IA_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see forwardDynamics.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sForwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
+
+private:
+  // articulated inertia and bias force
+  std::vector<sva::ABInertiad> IA_;
+  std::vector<sva::ForceVecd> pA_;
+
+  // velocity product acceleration and body acceleration
+  std::vector<sva::MotionVecd> c_;
+  std::vector<sva::MotionVecd> a_;
+
+  // U = IA*S, D^-1 = (S^T*IA*S)^-1, u = tau - S^T*pA
+  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> U_;
+  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> UDinv_;
+  std::vector<Eigen::MatrixXd> Dinv_;
+  std::vector<Eigen::VectorXd> u_;
+  std::vector<Eigen::VectorXd> alphaD_;
+  std::vector<Eigen::LLT<Eigen::MatrixXd>> llt_;
+};
+
+} // namespace rbd
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <memory>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <rbdyn/config.hh>
+
+#include <SpaceVecAlg/SpaceVecAlg>
+
+// RBDyn
+#include "FD.h"
+#include "ID.h"
+#include "IDIM.h"
+#include "MultiBodyConfig.h"
+#include "ThreadPool.h"
+
+namespace rbd
+{
+class MultiBody;
+
+/**
+ * Evaluate the dynamics over a batch of samples (typically a trajectory)
+ * with a work-stealing thread pool.
+ * For each sample the forward kinematics, velocity (and acceleration) are
+ * computed before the requested algorithm. Each worker owns a
+ * MultiBodyConfig and the algorithms workspaces, so no allocation is done
+ * during the evaluation.
+ *
+ * The generalized vectors are packed one sample per row:
+ * q is (nrSamples x nrParams), alpha, alphaD and jointTorque are
+ * (nrSamples x nrDof). Matrix results are stacked: the result of sample s
+ * starts at row s*nrDof.
+ * No external force is applied on the bodies.
+ */
+class RBDYN_DLLAPI BatchDynamics
+{
+public:
+  /// Evaluator with a one thread pool and no model, to be assigned before use
+  /// (the safe versions throw on it).
+  BatchDynamics() : grain_(1), pool_(std::make_shared<ThreadPool>(1)) {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param nrThreads Number of threads, 0 use the hardware concurrency.
+   */
+  BatchDynamics(const MultiBody & mb, int nrThreads = 0);
+
+  /**
+   * Compute the inverse dynamics of every sample.
+   * @param mb MultiBody used has model.
+   * @param q Packed generalized position vectors (nrSamples x nrParams).
+   * @param alpha Packed generalized velocity vectors (nrSamples x nrDof).
+   * @param alphaD Packed generalized acceleration vectors (nrSamples x nrDof).
+   * @param jointTorque Packed joint torque vectors (nrSamples x nrDof), filled by the algorithm.
+   */
+  void inverseDynamics(const MultiBody & mb,
+                       const Eigen::Ref<const Eigen::MatrixXd> & q,
+                       const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                       const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                       Eigen::Ref<Eigen::MatrixXd> jointTorque);
+
+  /**
+   * Compute the forward dynamics of every sample.
+   * @param mb MultiBody used has model.
+   * @param q Packed generalized position vectors (nrSamples x nrParams).
+   * @param alpha Packed generalized velocity vectors (nrSamples x nrDof).
+   * @param jointTorque Packed joint torque vectors (nrSamples x nrDof).
+   * @param alphaD Packed generalized acceleration vectors (nrSamples x nrDof), filled by the algorithm.
+   */
+  void forwardDynamics(const MultiBody & mb,
+                       const Eigen::Ref<const Eigen::MatrixXd> & q,
+                       const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                       const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+                       Eigen::Ref<Eigen::MatrixXd> alphaD);
+
+  /**
+   * Compute the inertia matrix of every sample.
+   * @param mb MultiBody used has model.
+   * @param q Packed generalized position vectors (nrSamples x nrParams).
+   * @param H Stacked inertia matrices (nrSamples*nrDof x nrDof), filled by the algorithm.
+   */
+  void computeH(const MultiBody & mb, const Eigen::Ref<const Eigen::MatrixXd> & q, Eigen::Ref<Eigen::MatrixXd> H);
+
+  /**
+   * Compute the IDIM Y matrix of every sample (@see IDIM).
+   * @param mb MultiBody used has model.
+   * @param q Packed generalized position vectors (nrSamples x nrParams).
+   * @param alpha Packed generalized velocity vectors (nrSamples x nrDof).
+   * @param alphaD Packed generalized acceleration vectors (nrSamples x nrDof).
+   * @param Y Stacked Y matrices (nrSamples*nrDof x 10*nrBodies), filled by the algorithm.
+   */
+  void computeY(const MultiBody & mb,
+                const Eigen::Ref<const Eigen::MatrixXd> & q,
+                const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                Eigen::Ref<Eigen::MatrixXd> Y);
+
+  /// @return Number of threads used by the evaluation.
+  int nrThreads() const
+  {
+    return pool_->nrThreads();
+  }
+
+  /// @return Gravity acting on the multibody.
+  const Eigen::Vector3d & gravity() const
+  {
+    return gravity_;
+  }
+
+  /// Set the gravity acting on the multibody.
+  void gravity(const Eigen::Vector3d & g);
+
+  /// @return Number of samples processed by a worker between two steal attempts.
+  int grain() const
+  {
+    return grain_;
+  }
+
+  /// Set the number of samples processed by a worker between two steal attempts.
+  void grain(int g)
+  {
+    grain_ = g;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see inverseDynamics.
+   * @throw std::domain_error If mb don't match this evaluator or the packed matrices.
+   */
+  void sInverseDynamics(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::MatrixXd> & q,
+                        const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                        const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                        Eigen::Ref<Eigen::MatrixXd> jointTorque);
+
+  /** safe version of @see forwardDynamics.
+   * @throw std::domain_error If mb don't match this evaluator or the packed matrices.
+   */
+  void sForwardDynamics(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::MatrixXd> & q,
+                        const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                        const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+                        Eigen::Ref<Eigen::MatrixXd> alphaD);
+
+  /** safe version of @see computeH.
+   * @throw std::domain_error If mb don't match this evaluator or the packed matrices.
+   */
+  void sComputeH(const MultiBody & mb, const Eigen::Ref<const Eigen::MatrixXd> & q, Eigen::Ref<Eigen::MatrixXd> H);
+
+  /** safe version of @see computeY.
+   * @throw std::domain_error If mb don't match this evaluator or the packed matrices.
+   */
+  void sComputeY(const MultiBody & mb,
+                 const Eigen::Ref<const Eigen::MatrixXd> & q,
+                 const Eigen::Ref<const Eigen::MatrixXd> & alpha,
+                 const Eigen::Ref<const Eigen::MatrixXd> & alphaD,
+                 Eigen::Ref<Eigen::MatrixXd> Y);
+
+private:
+  /// Per thread data.
+  struct Worker
+  {
+    MultiBodyConfig mbc;
+    Eigen::VectorXd q;
+    Eigen::VectorXd alpha;
+    Eigen::VectorXd alphaD;
+    Eigen::VectorXd jointTorque;
+    InverseDynamics::Workspace idWs;
+    ForwardDynamics::Workspace fdWs;
+    IDIM idim;
+  };
+
+private:
+  void checkMatchMultiBody(const MultiBody & mb) const;
+
+private:
+  InverseDynamics id_;
+  ForwardDynamics fd_;
+  Eigen::Vector3d gravity_;
+  int grain_;
+
+  std::vector<Worker> workers_;
+  std::shared_ptr<ThreadPool> pool_;
+};
+
+} // namespace rbd
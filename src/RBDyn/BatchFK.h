@@ -0,0 +1,90 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// Eigen
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <rbdyn/config.hh>
+
+#include <SpaceVecAlg/SpaceVecAlg>
+
+namespace rbd
+{
+class MultiBody;
+
+/**
+ * Forward kinematics of a batch of configurations.
+ * Body poses are stored in a structure of arrays layout: each component of
+ * each body pose is a contiguous array over the batch, so the joint tree
+ * is traversed once and every operation is vectorized across the batch.
+ *
+ * The pose of body b in world frame uses the 12 columns starting at 12*b
+ * of bodyPosW(): column 12*b + 3*r + c holds E(r, c) and column
+ * 12*b + 9 + r holds translation(r).
+ */
+class RBDYN_DLLAPI BatchForwardKinematics
+{
+public:
+  BatchForwardKinematics() {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param batchSize Number of configurations processed by each call.
+   */
+  BatchForwardKinematics(const MultiBody & mb, int batchSize);
+
+  /**
+   * Compute the forward kinematics of every configuration.
+   * @param mb MultiBody used has model.
+   * @param q Packed generalized position vectors (batchSize x nrParams),
+   * one configuration per row.
+   */
+  void forwardKinematics(const MultiBody & mb, const Eigen::Ref<const Eigen::MatrixXd> & q);
+
+  /// @return Number of configurations processed by each call.
+  int batchSize() const
+  {
+    return static_cast<int>(bodyPosW_.rows());
+  }
+
+  /// @return Body poses in world frame of every configuration (batchSize x 12*nrBodies).
+  const Eigen::ArrayXXd & bodyPosW() const
+  {
+    return bodyPosW_;
+  }
+
+  /// @return Component (row, col) of the rotation of body in world frame for every configuration.
+  Eigen::ArrayXXd::ConstColXpr rotation(int body, int row, int col) const
+  {
+    return bodyPosW_.col(12 * body + 3 * row + col);
+  }
+
+  /// @return Component axis of the translation of body in world frame for every configuration.
+  Eigen::ArrayXXd::ConstColXpr translation(int body, int axis) const
+  {
+    return bodyPosW_.col(12 * body + 9 + axis);
+  }
+
+  /// @return Pose of body in world frame for the configuration sample.
+  sva::PTransformd bodyPosW(int body, int sample) const;
+
+  // safe version for python binding
+
+  /** safe version of @see forwardKinematics.
+   * @throw std::domain_error If mb or q don't match the batch.
+   */
+  void sForwardKinematics(const MultiBody & mb, const Eigen::Ref<const Eigen::MatrixXd> & q);
+
+private:
+  Eigen::ArrayXXd bodyPosW_;
+  // joint transformation, transformation from the parent and temporaries
+  Eigen::ArrayXXd jointConfig_;
+  Eigen::ArrayXXd parentToSon_;
+  Eigen::ArrayXXd tmp_;
+};
+
+} // namespace rbd
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <rbdyn/config.hh>
+
+#include <SpaceVecAlg/SpaceVecAlg>
+
+// RBDyn
+#include "IK.h"
+#include "MultiBodyConfig.h"
+#include "ThreadPool.h"
+
+namespace rbd
+{
+class MultiBody;
+
+/**
+ * Solve many inverse kinematics problems with random restarts on a
+ * work-stealing thread pool.
+ * A problem is an (end effector, target) pair, each one is solved from every
+ * seed with DampedInverseKinematics until one seed converge: the remaining
+ * seeds of the problem are then skipped and the running ones are cancelled.
+ * Each worker owns a MultiBodyConfig and one DampedInverseKinematics (with
+ * its jacobian) by end effector, so no allocation is done during the solve.
+ *
+ * Seeds are processed seed-major (the first seed of every problem, then the
+ * second one, ...) so the cheap problems don't wait behind the hard ones.
+ * Since the cancellation depends on the scheduling, the selected seed can
+ * change between two calls with several threads.
+ */
+class RBDYN_DLLAPI BatchInverseKinematics
+{
+public:
+  /// Inverse kinematics problem.
+  struct Problem
+  {
+    /// End effector body index (must be registered in the constructor).
+    int effector;
+    /// End effector target in world frame.
+    sva::PTransformd target;
+  };
+
+  /// Result of a problem.
+  struct Result
+  {
+    /// true if a seed has converged.
+    bool converged;
+    /// Seed of the returned solution.
+    int seed;
+    /// Norm of the end effector error of the returned solution.
+    double error;
+    /// Number of iterations of the returned solution.
+    int iterations;
+  };
+
+public:
+  BatchInverseKinematics() : grain_(1) {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param effectors End effectors body index.
+   * @param nrThreads Number of threads, 0 use the hardware concurrency.
+   */
+  BatchInverseKinematics(const MultiBody & mb, const std::vector<int> & effectors, int nrThreads = 0);
+
+  /**
+   * Solve every problem from every seed.
+   * @param mb MultiBody used has model.
+   * @param problems Problems to solve.
+   * @param seeds Packed initial generalized position vectors (nrSeeds x nrParams).
+   * @param q Packed solutions (nrProblems x nrParams), filled by the algorithm.
+   * The first converged seed is returned, if no seed has converged the
+   * configuration with the smallest error is returned.
+   * @return Result of each problem.
+   */
+  const std::vector<Result> & inverseKinematics(const MultiBody & mb,
+                                                const std::vector<Problem> & problems,
+                                                const Eigen::Ref<const Eigen::MatrixXd> & seeds,
+                                                Eigen::Ref<Eigen::MatrixXd> q);
+
+  /// Set the maximum number of iterations of a seed.
+  void maxIterations(int maxIter);
+
+  /// Set the stopping criterion on the end effector error.
+  void threshold(double threshold);
+
+  /// Set the joint limits (@see DampedInverseKinematics::jointLimits).
+  void jointLimits(const Eigen::VectorXd & qMin, const Eigen::VectorXd & qMax);
+
+  /// @return Result of each problem of the last call.
+  const std::vector<Result> & results() const
+  {
+    return results_;
+  }
+
+  /// @return Registered end effectors body index.
+  const std::vector<int> & effectors() const
+  {
+    return effectors_;
+  }
+
+  /// @return Number of threads used by the solver.
+  int nrThreads() const
+  {
+    return pool_->nrThreads();
+  }
+
+  /// @return Number of seeds processed by a worker between two steal attempts.
+  int grain() const
+  {
+    return grain_;
+  }
+
+  /// Set the number of seeds processed by a worker between two steal attempts.
+  void grain(int g)
+  {
+    grain_ = g;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see inverseKinematics.
+   * @throw std::domain_error If mb don't match this solver or the packed
+   * matrices, or if a problem effector is not registered.
+   */
+  const std::vector<Result> & sInverseKinematics(const MultiBody & mb,
+                                                 const std::vector<Problem> & problems,
+                                                 const Eigen::Ref<const Eigen::MatrixXd> & seeds,
+                                                 Eigen::Ref<Eigen::MatrixXd> q);
+
+  /** safe version of @see jointLimits.
+   * @throw std::domain_error If qMin or qMax size mismatch.
+   */
+  void sJointLimits(const MultiBody & mb, const Eigen::VectorXd & qMin, const Eigen::VectorXd & qMax);
+
+private:
+  /// Per thread data.
+  struct Worker
+  {
+    MultiBodyConfig mbc;
+    Eigen::VectorXd q;
+    /// one solver by effector (the solver holds fixed size Eigen members)
+    std::vector<DampedInverseKinematics, Eigen::aligned_allocator<DampedInverseKinematics>> iks;
+  };
+
+private:
+  void checkMatchMultiBody(const MultiBody & mb) const;
+
+private:
+  std::vector<int> effectors_;
+  /// solver index of each body (-1 if not an effector)
+  std::vector<int> ikIndex_;
+  int grain_;
+
+  // per problem
+  std::vector<Result> results_;
+  std::vector<std::atomic<bool>> solved_;
+
+  // per (seed, problem) task
+  Eigen::MatrixXd taskQ_;
+  std::vector<Result> taskResults_;
+  std::vector<char> taskRun_;
+
+  std::vector<Worker, Eigen::aligned_allocator<Worker>> workers_;
+  std::shared_ptr<ThreadPool> pool_;
+};
+
+} // namespace rbd
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <memory>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+#include "DynamicsIntegration.h"
+#include "MultiBodyConfig.h"
+#include "ThreadPool.h"
+
+namespace rbd
+{
+class MultiBody;
+
+/**
+ * Simulate many independent open-loop rollouts with a work-stealing thread
+ * pool. Each rollout starts from its own initial state and integrates the
+ * dynamics (@see DynamicsIntegrator) over a horizon with its own joint
+ * torque sequence.
+ * Each worker owns a MultiBodyConfig and a DynamicsIntegrator, so no
+ * allocation is done during the simulation.
+ *
+ * The vectors are packed one per column, so each of them is contiguous:
+ * q0 is (nrParams x nrRollouts) and alpha0 is (nrDof x nrRollouts).
+ * The joint torque of rollout r at step k is the column r*horizon + k of
+ * jointTorque (nrDof x (nrRollouts*horizon)).
+ * The state of rollout r after k steps is the column r*(horizon + 1) + k of
+ * the trajectories q (nrParams x (nrRollouts*(horizon + 1))) and alpha
+ * (nrDof x (nrRollouts*(horizon + 1))), the initial state included.
+ * No external force is applied on the bodies.
+ */
+class RBDYN_DLLAPI BatchRollout
+{
+public:
+  BatchRollout() : method_(DynamicsIntegrator::Euler), grain_(1), rolloutsPerSecond_(0.), nrParams_(0), nrDof_(0) {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param method Integration scheme, the default is ForwardDynamics followed by eulerIntegration.
+   * @param nrThreads Number of threads, 0 use the hardware concurrency.
+   */
+  BatchRollout(const MultiBody & mb, DynamicsIntegrator::Method method = DynamicsIntegrator::Euler, int nrThreads = 0);
+
+  /**
+   * Simulate every rollout.
+   * @param mb MultiBody used has model.
+   * @param q0 Packed initial generalized position vectors (nrParams x nrRollouts).
+   * @param alpha0 Packed initial generalized velocity vectors (nrDof x nrRollouts).
+   * @param jointTorque Packed joint torque sequences (nrDof x (nrRollouts*horizon)).
+   * @param step Integration step.
+   * @param q Packed generalized position trajectories (nrParams x (nrRollouts*(horizon + 1))),
+   * filled by the algorithm.
+   * @param alpha Packed generalized velocity trajectories (nrDof x (nrRollouts*(horizon + 1))),
+   * filled by the algorithm.
+   */
+  void rollout(const MultiBody & mb,
+               const Eigen::Ref<const Eigen::MatrixXd> & q0,
+               const Eigen::Ref<const Eigen::MatrixXd> & alpha0,
+               const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+               double step,
+               Eigen::Ref<Eigen::MatrixXd> q,
+               Eigen::Ref<Eigen::MatrixXd> alpha);
+
+  /// @return Rollouts simulated by second during the last call to rollout.
+  double rolloutsPerSecond() const
+  {
+    return rolloutsPerSecond_;
+  }
+
+  /// @return Integration scheme.
+  DynamicsIntegrator::Method method() const
+  {
+    return method_;
+  }
+
+  /// Set the integration scheme.
+  void method(DynamicsIntegrator::Method m);
+
+  /// @return Number of threads used by the simulation.
+  int nrThreads() const
+  {
+    return pool_->nrThreads();
+  }
+
+  /// @return Gravity acting on the multibody.
+  const Eigen::Vector3d & gravity() const
+  {
+    return gravity_;
+  }
+
+  /// Set the gravity acting on the multibody.
+  void gravity(const Eigen::Vector3d & g);
+
+  /// @return Number of rollouts simulated by a worker between two steal attempts.
+  int grain() const
+  {
+    return grain_;
+  }
+
+  /// Set the number of rollouts simulated by a worker between two steal attempts.
+  void grain(int g)
+  {
+    grain_ = g;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see rollout.
+   * @throw std::domain_error If mb don't match this simulator or the packed matrices.
+   */
+  void sRollout(const MultiBody & mb,
+                const Eigen::Ref<const Eigen::MatrixXd> & q0,
+                const Eigen::Ref<const Eigen::MatrixXd> & alpha0,
+                const Eigen::Ref<const Eigen::MatrixXd> & jointTorque,
+                double step,
+                Eigen::Ref<Eigen::MatrixXd> q,
+                Eigen::Ref<Eigen::MatrixXd> alpha);
+
+private:
+  /// Per thread data.
+  struct Worker
+  {
+    MultiBodyConfig mbc;
+    DynamicsIntegrator integrator;
+  };
+
+private:
+  void checkMatchMultiBody(const MultiBody & mb) const;
+
+private:
+  DynamicsIntegrator::Method method_;
+  Eigen::Vector3d gravity_;
+  int grain_;
+  double rolloutsPerSecond_;
+  int nrParams_;
+  int nrDof_;
+
+  std::vector<Worker> workers_;
+  std::shared_ptr<ThreadPool> pool_;
+};
+
+} // namespace rbd
@@ -108,6 +108,27 @@ private:
  */
 class RBDYN_DLLAPI CoMJacobian
 {
+public:
+  /**
+   * Computation buffers of CoMJacobian: the jacobian, its time derivative and
+   * the bodies CoM frames (@see Jacobian::Workspace).
+   */
+  struct RBDYN_DLLAPI Workspace
+  {
+    Workspace() {}
+    /// @param mb MultiBody associated with this workspace.
+    Workspace(const MultiBody & mb);
+
+    Eigen::MatrixXd jac;
+    Eigen::MatrixXd jacDot;
+
+    // jacobian, jacobianDot computation buffer
+    std::vector<sva::PTransformd> bodiesCoMWorld;
+    std::vector<sva::MotionVecd> bodiesCoMVelB;
+    // store normal acceleration of each bodies when calling normal acceleration
+    std::vector<sva::MotionVecd> normalAcc;
+  };
+
 public:
   CoMJacobian();
 
@@ -176,6 +197,18 @@ public:
                                      const MultiBodyConfig & mbc,
                                      const std::vector<sva::MotionVecd> & normalAccB) const;
 
+  /// @see jacobian(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & jacobian(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see jacobianDot(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & jacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see normalAcceleration(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store the bodies normal acceleration.
+  Eigen::Vector3d normalAcceleration(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
   // safe version for python binding
 
   /** safe version of @see updateInertialParameters.
@@ -220,22 +253,15 @@ private:
   void init(const rbd::MultiBody & mb);
 
 private:
-  Eigen::MatrixXd jac_;
-  Eigen::MatrixXd jacDot_;
-
   std::vector<double> bodiesCoeff_;
 
   /// @brief list of CoM of the bodies. Bodies with null mass have a (0,0,0) CoM
   std::vector<sva::PTransformd> bodiesCoM_;
   std::vector<std::vector<int>> jointsSubBodies_;
 
-  // jacobian, jacobianDot computation buffer
-  std::vector<sva::PTransformd> bodiesCoMWorld_;
-  std::vector<sva::MotionVecd> bodiesCoMVelB_;
-  // store normal acceleration of each bodies when calling normal acceleration
-  std::vector<sva::MotionVecd> normalAcc_;
-
   std::vector<double> weight_;
+
+  Workspace ws_;
 };
 
 // safe version for python binding
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <rbdyn/config.hh>
+
+#include <SpaceVecAlg/SpaceVecAlg>
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * MultiBody compiled into a flat sequence of joint kernels.
+ * Each joint is bound at construction to fixed size functions specialized
+ * for its type (RevX/Y/Z, Rev, PrismX/Y/Z, Prism, Spherical, Planar,
+ * Cylindrical, Free and Fixed, in both directions), so the algorithms below
+ * neither switch on the joint type nor use dynamic size motion subspaces.
+ * The generalized vectors are flat (@see FlatMultiBodyConfig).
+ */
+class RBDYN_DLLAPI CompiledMultiBody
+{
+public:
+  CompiledMultiBody() {}
+  /// @param mb MultiBody to compile.
+  CompiledMultiBody(const MultiBody & mb);
+
+  /**
+   * Compute the forward kinematics.
+   * @param q Generalized position vector (nrParams).
+   * @param mbc Fill bodyPosW, jointConfig, parentToSon and motionSubspace.
+   */
+  void forwardKinematics(const Eigen::Ref<const Eigen::VectorXd> & q, MultiBodyConfig & mbc) const;
+
+  /**
+   * Compute the forward velocity.
+   * @param alpha Generalized velocity vector (nrDof).
+   * @param mbc Use bodyPosW and parentToSon.
+   * Fill jointVelocity, bodyVelW and bodyVelB.
+   */
+  void forwardVelocity(const Eigen::Ref<const Eigen::VectorXd> & alpha, MultiBodyConfig & mbc) const;
+
+  /**
+   * Compute the forward acceleration.
+   * @param alphaD Generalized acceleration vector (nrDof).
+   * @param mbc Use jointVelocity, parentToSon and bodyVelB.
+   * Fill bodyAccB.
+   * @param A_0 initial acceleration in world coordinate.
+   */
+  void forwardAcceleration(const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                           MultiBodyConfig & mbc,
+                           const sva::MotionVecd & A_0 = sva::MotionVecd(Eigen::Vector6d::Zero())) const;
+
+  /**
+   * Compute the inverse dynamics (recursive Newton-Euler).
+   * @param alphaD Generalized acceleration vector (nrDof).
+   * @param mbc Use force, jointVelocity, bodyPosW, parentToSon, bodyVelB and gravity.
+   * Fill bodyAccB.
+   * @param jointTorque Joint torque vector (nrDof), filled by the algorithm.
+   */
+  void inverseDynamics(const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                       MultiBodyConfig & mbc,
+                       Eigen::Ref<Eigen::VectorXd> jointTorque);
+
+  /**
+   * @see inverseDynamics(alphaD, mbc, jointTorque)
+   * A const CompiledMultiBody can be shared between threads when each of
+   * them provides its own internal forces vector.
+   * @param f Internal forces (nrBodies), filled by the algorithm.
+   */
+  void inverseDynamics(const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                       MultiBodyConfig & mbc,
+                       Eigen::Ref<Eigen::VectorXd> jointTorque,
+                       std::vector<sva::ForceVecd> & f) const;
+
+  /// @return Internal forces computed by the last inverseDynamics call
+  /// without an internal forces argument.
+  const std::vector<sva::ForceVecd> & f() const
+  {
+    return f_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see forwardKinematics.
+   * @throw std::domain_error If mb don't match this model, q or mbc.
+   */
+  void sForwardKinematics(const MultiBody & mb,
+                          const Eigen::Ref<const Eigen::VectorXd> & q,
+                          MultiBodyConfig & mbc) const;
+
+  /** safe version of @see forwardVelocity.
+   * @throw std::domain_error If mb don't match this model, alpha or mbc.
+   */
+  void sForwardVelocity(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::VectorXd> & alpha,
+                        MultiBodyConfig & mbc) const;
+
+  /** safe version of @see forwardAcceleration.
+   * @throw std::domain_error If mb don't match this model, alphaD or mbc.
+   */
+  void sForwardAcceleration(const MultiBody & mb,
+                            const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                            MultiBodyConfig & mbc,
+                            const sva::MotionVecd & A_0 = sva::MotionVecd(Eigen::Vector6d::Zero())) const;
+
+  /** safe version of @see inverseDynamics.
+   * @throw std::domain_error If mb don't match this model, alphaD, mbc or jointTorque.
+   */
+  void sInverseDynamics(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                        MultiBodyConfig & mbc,
+                        Eigen::Ref<Eigen::VectorXd> jointTorque);
+
+  /** safe version of @see inverseDynamics.
+   * @throw std::domain_error If mb don't match this model, alphaD, mbc, jointTorque or f.
+   */
+  void sInverseDynamics(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                        MultiBodyConfig & mbc,
+                        Eigen::Ref<Eigen::VectorXd> jointTorque,
+                        std::vector<sva::ForceVecd> & f) const;
+
+public:
+  struct CompiledJoint;
+
+  /// @return Joint pose (jointConfig) from its generalized position.
+  typedef sva::PTransformd (*PoseKernel)(const CompiledJoint & joint, const double * q);
+  /// @return S*alpha from the joint generalized velocity (or acceleration).
+  typedef sva::MotionVecd (*MotionKernel)(const CompiledJoint & joint, const double * alpha);
+  /// Compute S^T f in tau.
+  typedef void (*TorqueKernel)(const CompiledJoint & joint, const sva::ForceVecd & f, double * tau);
+
+  /// Compiled joint data and kernels.
+  struct CompiledJoint
+  {
+    PoseKernel pose;
+    MotionKernel motion;
+    TorqueKernel torque;
+
+    /// Rev, Prism and Cylindrical axis as stored in the motion subspace.
+    Eigen::Vector3d axis;
+    /// Motion subspace, constant but copied in MultiBodyConfig for the other algorithms.
+    Eigen::Matrix<double, 6, Eigen::Dynamic> S;
+    /// Sign of the motion subspace (1 or -1).
+    double sign;
+    /// Joint direction (1 or -1).
+    double dir;
+
+    /// Predecessor body.
+    int pred;
+    /// Position in the param vector.
+    int paramPos;
+    /// Position in the dof vectors.
+    int dofPos;
+
+    /// Transformation from the predecessor body base to the joint.
+    sva::PTransformd Xt;
+    /// Successor body inertia.
+    sva::RBInertiad inertia;
+  };
+
+  /// @return Compiled joints.
+  const std::vector<CompiledJoint> & joints() const
+  {
+    return joints_;
+  }
+
+private:
+  void checkMatchMultiBody(const MultiBody & mb) const;
+
+private:
+  std::vector<CompiledJoint> joints_;
+  std::vector<sva::ForceVecd> f_;
+};
+
+} // namespace rbd
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <string>
+#include <vector>
+
+// Eigen
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+#include "FD.h"
+#include "Jacobian.h"
+#include "LTDL.h"
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * Forward dynamics with bilateral constraints (contacts, closed loops).
+ * Each constraint binds a frame of a body to a frame of another body or to
+ * a world frame, on the 6 dof or only on the frames origin (3 dof).
+ *
+ * Solve the KKT system
+ * H alphaD + C = jointTorque + J^T lambda
+ * J alphaD = gamma
+ * with J the constraints jacobian (in world frame, J_1 - J_2),
+ * lambda the constraint forces and
+ * gamma = -JDot alpha - Kd J alpha - Kp e the constraint acceleration with
+ * the Baumgarte stabilization of the constraint error e.
+ *
+ * The KKT system is solved by a Schur complement on the tree-sparse
+ * factorization H = L^T D L (@see LTDLFactorization): with W = D^-1/2 L^-T J^T,
+ * the Schur complement is G = J H^-1 J^T = W^T W.
+ * H^-1 is never formed. The rows of W of a constraint are only non zero on
+ * the dofs of its jacobians path, so L^-T J^T only follow these dofs and the
+ * block (i, j) of G only sum the dofs shared by the constraints i and j.
+ *
+ * factorize compute everything that depends on the configuration and the
+ * velocity, solve can then be called for several joint torques or
+ * constraint accelerations without factorizing again.
+ */
+class RBDYN_DLLAPI ConstrainedForwardDynamics
+{
+public:
+  /// Bilateral constraint between two frames.
+  struct Constraint
+  {
+    /// First body.
+    std::string body1;
+    /// Constraint frame in body1 coordinate.
+    sva::PTransformd X_b1_f1;
+    /// Second body, an empty name bind the first frame to the world.
+    std::string body2;
+    /// Constraint frame in body2 coordinate (or in world if body2 is empty).
+    sva::PTransformd X_b2_f2;
+    /// If true only the frames origin are bound (3 rows), otherwise 6 rows.
+    bool linear;
+  };
+
+public:
+  ConstrainedForwardDynamics() : nrRows_(0), kp_(0.), kd_(0.) {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param constraints Bilateral constraints.
+   * @throw std::out_of_range If a constraint body don't exist.
+   */
+  ConstrainedForwardDynamics(const MultiBody & mb, const std::vector<Constraint> & constraints);
+
+  /**
+   * Compute the constrained forward dynamics.
+   * @param mb MultiBody used has model.
+   * @param mbc Use parentToSon, motionSubspace jointVelocity, bodyVelB,
+   * bodyVelW, bodyPosW, force, gravity, alpha and jointTorque.
+   * Fill alphaD generalized acceleration vector.
+   */
+  void forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
+
+  /**
+   * Compute the constrained forward dynamics from flat vectors.
+   * @param mb MultiBody used has model.
+   * @param jointTorque Joint torque vector (nrDof).
+   * @param mbc Use parentToSon, motionSubspace jointVelocity, bodyVelB,
+   * bodyVelW, bodyPosW, force, gravity and alpha.
+   * @param alphaD Generalized acceleration vector (nrDof), filled by the algorithm.
+   */
+  void forwardDynamics(const MultiBody & mb,
+                       const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                       const MultiBodyConfig & mbc,
+                       Eigen::Ref<Eigen::VectorXd> alphaD);
+
+  /**
+   * Compute and factorize H, C, the constraints jacobian, the constraint
+   * acceleration and the Schur complement.
+   * @param mb MultiBody used has model.
+   * @param mbc Use parentToSon, motionSubspace jointVelocity, bodyVelB,
+   * bodyVelW, bodyPosW, force, gravity and alpha.
+   */
+  void factorize(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /**
+   * Solve the KKT system from the last factorization.
+   * @param jointTorque Joint torque vector (nrDof).
+   * @param alphaD Generalized acceleration vector (nrDof), filled by the algorithm.
+   */
+  void solve(const Eigen::Ref<const Eigen::VectorXd> & jointTorque, Eigen::Ref<Eigen::VectorXd> alphaD);
+
+  /**
+   * Solve the KKT system from the last factorization with a user constraint
+   * acceleration.
+   * @param jointTorque Joint torque vector (nrDof).
+   * @param gamma Constraint acceleration J alphaD (nrRows).
+   * @param alphaD Generalized acceleration vector (nrDof), filled by the algorithm.
+   */
+  void solve(const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+             const Eigen::Ref<const Eigen::VectorXd> & gamma,
+             Eigen::Ref<Eigen::VectorXd> alphaD);
+
+  /**
+   * Set the Baumgarte stabilization gains.
+   * @param kp Gain on the constraint error.
+   * @param kd Gain on the constraint velocity.
+   */
+  void baumgarte(double kp, double kd)
+  {
+    kp_ = kp;
+    kd_ = kd;
+  }
+
+  /// @return Baumgarte gain on the constraint error.
+  double stiffness() const
+  {
+    return kp_;
+  }
+
+  /// @return Baumgarte gain on the constraint velocity.
+  double damping() const
+  {
+    return kd_;
+  }
+
+  /// @return Constraint forces lambda of the last solve (nrRows).
+  const Eigen::VectorXd & constraintForces() const
+  {
+    return lambda_;
+  }
+
+  /// @return Constraints jacobian (nrRows x nrDof).
+  const Eigen::MatrixXd & jacobian() const
+  {
+    return J_;
+  }
+
+  /// @return Constraint error e, angular error first for the 6 rows constraints (nrRows).
+  const Eigen::VectorXd & constraintError() const
+  {
+    return error_;
+  }
+
+  /// @return Constraint velocity J alpha (nrRows).
+  const Eigen::VectorXd & constraintVelocity() const
+  {
+    return velocity_;
+  }
+
+  /// @return Constraint acceleration gamma used by solve (nrRows).
+  const Eigen::VectorXd & constraintAcceleration() const
+  {
+    return gamma_;
+  }
+
+  /// @return Schur complement J H^-1 J^T (nrRows x nrRows).
+  const Eigen::MatrixXd & schurComplement() const
+  {
+    return G_;
+  }
+
+  /// @return First row of the constraint index.
+  int rowOffset(int index) const
+  {
+    return constraints_[index].rowOffset;
+  }
+
+  /// @return Number of constraint rows.
+  int nrRows() const
+  {
+    return nrRows_;
+  }
+
+  /// @return Inertia matrix of the last factorization.
+  const Eigen::MatrixXd & H() const
+  {
+    return fd_.H();
+  }
+
+  /// @return Non linear effect vector of the last factorization.
+  const Eigen::VectorXd & C() const
+  {
+    return fd_.C();
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see forwardDynamics.
+   * @throw std::domain_error If mb don't match mbc or this algorithm.
+   */
+  void sForwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
+
+  /** safe version of @see forwardDynamics.
+   * @throw std::domain_error If mb don't match mbc, jointTorque, alphaD or this algorithm.
+   */
+  void sForwardDynamics(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                        const MultiBodyConfig & mbc,
+                        Eigen::Ref<Eigen::VectorXd> alphaD);
+
+  /** safe version of @see solve.
+   * @throw std::domain_error If jointTorque, gamma or alphaD don't match this algorithm.
+   */
+  void sSolve(const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+              const Eigen::Ref<const Eigen::VectorXd> & gamma,
+              Eigen::Ref<Eigen::VectorXd> alphaD);
+
+private:
+  /// Constraint data.
+  struct ConstraintData
+  {
+    sva::PTransformd X_b1_f1, X_b2_f2;
+    int body1, body2;
+    int rows, rowOffset;
+    /// jacobian of each body (body2 jacobian is unused for a world frame)
+    Jacobian jac1, jac2;
+    /// dofs of each jacobian path
+    std::vector<int> dofs1, dofs2;
+    /// union of dofs1 and dofs2 (increasing order), rows of J^T that can be non zero
+    std::vector<int> dofs;
+    /// D^-1/2 L^-T J^T restricted to dofs
+    Eigen::MatrixXd W;
+  };
+
+private:
+  void checkMatchMultiBody(const MultiBody & mb) const;
+
+private:
+  int nrRows_;
+  double kp_, kd_;
+  std::vector<ConstraintData> constraints_;
+
+  ForwardDynamics fd_;
+  LTDLFactorization ltdl_;
+
+  Eigen::MatrixXd J_;
+  Eigen::MatrixXd G_;
+  Eigen::LDLT<Eigen::MatrixXd> ldlt_;
+
+  Eigen::VectorXd error_, velocity_, gamma_, lambda_;
+  /// D^-1/2
+  Eigen::VectorXd dInvSqrt_;
+  Eigen::VectorXd alpha_, s_, tmpAlpha_;
+};
+
+} // namespace rbd
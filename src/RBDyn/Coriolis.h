@@ -19,10 +19,41 @@ namespace rbd
  * K. Pettersen in "A new Coriolis matrix factorization", 2012
  * NB: ForwardDynamics::C() directly computes the product of this matrix with qd.
  * This C*qd is unique, but C itself is not.
+ *
+ * The matrix is computed recursively like the inertia matrix in
+ * ForwardDynamics::computeH: with J_i the jacobian of body i in world
+ * frame, C = \sum J_i^T (I_i \dot{J}_i + B_i J_i) where B_i only depend
+ * on the body i state. The composite I_i and B_i of each subtree are
+ * accumulated in a backward sweep, then each block of C is the product of
+ * a joint motion subspace with the composite quantities of the deepest of
+ * the two joints.
  */
 class RBDYN_DLLAPI Coriolis
 {
 public:
+  /** Computation buffers of Coriolis: the coriolis matrix and the composite
+   * sweep terms, all in world frame (@see Jacobian::Workspace).
+   */
+  struct RBDYN_DLLAPI Workspace
+  {
+    Workspace() {}
+    /// @param mb MultiBody associated with this workspace.
+    Workspace(const rbd::MultiBody & mb);
+
+    Eigen::MatrixXd coriolis;
+    /// motion subspace of each joint in world frame and its time derivative (6 x nrDof)
+    Eigen::MatrixXd S, SD;
+    /// composite products of each joint: I*SD + B*S, I*S and B^T*S
+    Eigen::MatrixXd F, IS, BS;
+    /// composite inertia of each subtree in world frame
+    std::vector<sva::RBInertiad> I;
+    /// composite B = [[Bw, 0], [-[P]x, 0]] of each subtree
+    std::vector<Eigen::Matrix3d> Bw;
+    std::vector<Eigen::Vector3d> P;
+  };
+
+public:
+  Coriolis() {}
   /** Initialize the required structures
    * @param mb Multibody system
    */
@@ -30,15 +61,20 @@ public:
 
   /** Compute the matrix C of Coriolis effects.
    * @param mb Multibody system
-   * @param mbc Multibody configuration associated to mb
+   * @param mbc Multibody configuration associated to mb, use bodyPosW,
+   * motionSubspace and bodyVelB
    */
   const Eigen::MatrixXd & coriolis(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc);
 
+  /** Compute the matrix C of Coriolis effects in a caller owned workspace.
+   * @param mb Multibody system
+   * @param mbc Multibody configuration associated to mb
+   * @param ws Workspace that store the result
+   */
+  const Eigen::MatrixXd & coriolis(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc, Workspace & ws) const;
+
 private:
-  std::vector<rbd::Jacobian> jacs_;
-  std::vector<Blocks> compactPaths_;
-  Eigen::MatrixXd coriolis_;
-  Eigen::MatrixXd res_;
+  Workspace ws_;
 };
 
 } // namespace rbd
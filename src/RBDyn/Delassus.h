@@ -0,0 +1,163 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <string>
+#include <vector>
+
+// Eigen
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+#include "FD.h"
+#include "Jacobian.h"
+#include "LTDL.h"
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * Compute the Delassus operator G = J H^-1 J^T of a set of contact or task
+ * frames and the operational space inertia Lambda = G^-1.
+ * J is the stack of the frames jacobians.
+ *
+ * H^-1 is never formed: with H = L^T D L (@see LTDLFactorization),
+ * G = (D^-1/2 L^-T J^T)^T (D^-1/2 L^-T J^T).
+ * The dofs of the path between the root and a frame body are all ancestors
+ * of each other, so L^-T J_f^T only involves the dense triangular block of L
+ * on this path and the block (f, g) of G only involves the dofs common to the
+ * f and g paths.
+ */
+class RBDYN_DLLAPI Delassus
+{
+public:
+  /// Contact or task frame.
+  struct Frame
+  {
+    /// Body of the frame.
+    std::string bodyName;
+    /// Frame origin in body coordinate.
+    Eigen::Vector3d point;
+  };
+
+public:
+  Delassus() : frameRows_(6), nrRows_(0) {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param frames Contact or task frames.
+   * @param linear If true only the linear part of the frames jacobian is used
+   * (point contacts, 3 rows by frame), otherwise 6 rows by frame.
+   * @throw std::out_of_range If a frame body don't exist.
+   */
+  Delassus(const MultiBody & mb, const std::vector<Frame> & frames, bool linear = false);
+
+  /**
+   * Compute the Delassus operator.
+   * H is computed and factorized by the algorithm.
+   * @param mb MultiBody used has model.
+   * @param mbc Use parentToSon, bodyPosW and motionSubspace.
+   * @return Delassus operator (nrRows x nrRows).
+   */
+  const Eigen::MatrixXd & delassus(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /**
+   * Compute the Delassus operator from an existing factorization of H,
+   * like ForwardDynamics::factorization after forwardDynamics.
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   * @param ltdl Factorization of the inertia matrix of mbc configuration.
+   * @return Delassus operator (nrRows x nrRows).
+   */
+  const Eigen::MatrixXd & delassus(const MultiBody & mb, const MultiBodyConfig & mbc, const LTDLFactorization & ltdl);
+
+  /**
+   * Compute the operational space inertia Lambda = G^-1 from the last
+   * computed Delassus operator.
+   * G must be positive definite (non redundant frames), otherwise the
+   * result is meaningless, use sOperationalSpaceInertia to detect it.
+   * @return Operational space inertia (nrRows x nrRows).
+   */
+  const Eigen::MatrixXd & operationalSpaceInertia();
+
+  /// @return Last computed Delassus operator.
+  const Eigen::MatrixXd & matrix() const
+  {
+    return delassus_;
+  }
+
+  /// @return Frames jacobian used by the last computation.
+  const std::vector<Jacobian> & jacobians() const
+  {
+    return jacs_;
+  }
+
+  /// @return First row of the frame index in the Delassus operator.
+  int rowOffset(int index) const
+  {
+    return rowOffset_[index];
+  }
+
+  /// @return Number of rows by frame (3 or 6).
+  int frameRows() const
+  {
+    return frameRows_;
+  }
+
+  /// @return Number of rows of the Delassus operator.
+  int nrRows() const
+  {
+    return nrRows_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see delassus.
+   * @throw std::domain_error If mb don't match mbc or this algorithm.
+   */
+  const Eigen::MatrixXd & sDelassus(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /** safe version of @see delassus.
+   * @throw std::domain_error If mb don't match mbc, ltdl or this algorithm.
+   */
+  const Eigen::MatrixXd & sDelassus(const MultiBody & mb,
+                                    const MultiBodyConfig & mbc,
+                                    const LTDLFactorization & ltdl);
+
+  /** safe version of @see operationalSpaceInertia.
+   * @throw std::domain_error If the Delassus operator is not positive definite
+   * (redundant or singular frames).
+   */
+  const Eigen::MatrixXd & sOperationalSpaceInertia();
+
+private:
+  void checkMatchMultiBody(const MultiBody & mb) const;
+
+private:
+  int frameRows_;
+  int nrRows_;
+  std::vector<int> rowOffset_;
+
+  std::vector<Jacobian> jacs_;
+  /// dofs of the path of each frame (increasing order)
+  std::vector<std::vector<int>> dofs_;
+  /// D^-1/2 L^-T J^T restricted to the path of each frame
+  std::vector<Eigen::MatrixXd> W_;
+
+  ForwardDynamics fd_;
+  LTDLFactorization ltdl_;
+
+  Eigen::MatrixXd delassus_;
+  Eigen::MatrixXd lambda_;
+  Eigen::LLT<Eigen::MatrixXd> llt_;
+};
+
+} // namespace rbd
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// Eigen
+#include <Eigen/Core>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+#include "FD.h"
+#include "MultiBodyConfig.h"
+
+namespace rbd
+{
+class MultiBody;
+
+/**
+ * Integrate the multibody dynamics over a time step.
+ * The stage accelerations are computed with ForwardDynamics.
+ * The configuration is integrated in local coordinates around the initial
+ * configuration (exponential coordinates for the Spherical and Free joints
+ * rotation, FP coordinates for the Free and Planar joints translation), so
+ * quaternions stay on the unit sphere and the schemes keep their order on
+ * every joint type.
+ * The stages use internal buffers, no allocation is done by integrate.
+ *
+ * Joint torques and external forces are held constant over the step.
+ */
+class RBDYN_DLLAPI DynamicsIntegrator
+{
+public:
+  enum Method
+  {
+    /**
+     * First order, ForwardDynamics followed by eulerIntegration
+     * (constant acceleration over the step). One forward dynamics by step.
+     * eulerIntegration don't manage the reverse Spherical, Planar and Free
+     * joints, the other schemes must be used with them.
+     */
+    Euler,
+    /// First order, symplectic. One forward dynamics by step.
+    SemiImplicitEuler,
+    /**
+     * Second order Stormer-Verlet (velocity Verlet) scheme, symplectic
+     * when the forces only depend on the configuration. The velocity
+     * dependent terms of the final acceleration use an Euler prediction
+     * of the final velocity. Two forward dynamics by step.
+     */
+    StormerVerlet,
+    /// Fourth order Runge-Kutta scheme. Four forward dynamics by step.
+    RK4
+  };
+
+public:
+  DynamicsIntegrator() : method_(RK4) {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param method Integration scheme.
+   */
+  DynamicsIntegrator(const MultiBody & mb, Method method = RK4);
+
+  /**
+   * Integrate the dynamics over one step.
+   * @param mb MultiBody used has model.
+   * @param mbc Use q, alpha, jointTorque, force and gravity.
+   * Fill q and alpha with the state at the end of the step and alphaD
+   * with the acceleration at the beginning of the step.
+   * @param step Integration step.
+   */
+  void integrate(const MultiBody & mb, MultiBodyConfig & mbc, double step);
+
+  /// @return Integration scheme.
+  Method method() const
+  {
+    return method_;
+  }
+
+  /// Set the integration scheme.
+  void method(Method m)
+  {
+    method_ = m;
+  }
+
+  /// @return Forward dynamics used to compute the stage accelerations.
+  const ForwardDynamics & forwardDynamics() const
+  {
+    return fd_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see integrate.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sIntegrate(const MultiBody & mb, MultiBodyConfig & mbc, double step);
+
+private:
+  /// Compute the acceleration a at the state (q, alpha).
+  void acceleration(const MultiBody & mb,
+                    const Eigen::VectorXd & q,
+                    const Eigen::VectorXd & alpha,
+                    Eigen::VectorXd & a);
+  /**
+   * Compute the local coordinates derivative etaD at q = q0_ + eta
+   * with the velocity alpha.
+   */
+  void localVelocity(const MultiBody & mb,
+                     const Eigen::VectorXd & q,
+                     const Eigen::VectorXd & eta,
+                     const Eigen::VectorXd & alpha,
+                     Eigen::VectorXd & etaD) const;
+  /// Compute q = q0_ + eta (eta in local coordinates).
+  void retract(const MultiBody & mb, const Eigen::VectorXd & eta, Eigen::VectorXd & q) const;
+
+private:
+  ForwardDynamics fd_;
+  Method method_;
+
+  /// stage configuration
+  MultiBodyConfig mbc_;
+
+  Eigen::VectorXd jointTorque_;
+  Eigen::VectorXd q0_, alpha0_;
+  Eigen::VectorXd q_, alpha_;
+  /// stage accelerations
+  Eigen::VectorXd a1_, a2_, a3_, a4_;
+  /// local coordinates and their stage derivatives
+  Eigen::VectorXd eta_, etaD1_, etaD2_, etaD3_, etaD4_;
+};
+
+} // namespace rbd
@@ -32,6 +32,13 @@ RBDYN_DLLAPI void eulerJointIntegration(Joint::Type type,
                                         double step,
                                         std::vector<double> & q);
 
+/// @see eulerJointIntegration
+RBDYN_DLLAPI void eulerJointIntegration(Joint::Type type,
+                                        const Eigen::Ref<const Eigen::VectorXd> & alpha,
+                                        const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                        double step,
+                                        Eigen::Ref<Eigen::VectorXd> q);
+
 /**
  * Use the euler method to integrate.
  * @param mb MultiBody used has model.
@@ -40,6 +47,20 @@ RBDYN_DLLAPI void eulerJointIntegration(Joint::Type type,
  */
 RBDYN_DLLAPI void eulerIntegration(const MultiBody & mb, MultiBodyConfig & mbc, double step);
 
+/**
+ * Use the euler method to integrate flat generalized vectors.
+ * @param mb MultiBody used has model.
+ * @param q Generalized position vector (nrParams), integrated in place.
+ * @param alpha Generalized velocity vector (nrDof), integrated in place.
+ * @param alphaD Generalized acceleration vector (nrDof).
+ * @param step Integration step.
+ */
+RBDYN_DLLAPI void eulerIntegration(const MultiBody & mb,
+                                   Eigen::Ref<Eigen::VectorXd> q,
+                                   Eigen::Ref<Eigen::VectorXd> alpha,
+                                   const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                   double step);
+
 /// safe version of @see eulerIntegration.
 RBDYN_DLLAPI void sEulerIntegration(const MultiBody & mb, MultiBodyConfig & mbc, double step);
 
@@ -27,6 +27,19 @@ RBDYN_DLLAPI void forwardAcceleration(const MultiBody & mb,
                                       MultiBodyConfig & mbc,
                                       const sva::MotionVecd & A_0 = sva::MotionVecd(Eigen::Vector6d::Zero()));
 
+/**
+ * Compute the forward acceleration of a MultiBody from a flat vector.
+ * @param mb MultiBody used has model.
+ * @param alphaD Generalized acceleration vector (nrDof).
+ * @param mbc Use jointVelocity, parentToSon and bodyVelB.
+ * Fill bodyAccB.
+ * @param A_0 initial acceleration in world coordinate.
+ */
+RBDYN_DLLAPI void forwardAcceleration(const MultiBody & mb,
+                                      const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                      MultiBodyConfig & mbc,
+                                      const sva::MotionVecd & A_0 = sva::MotionVecd(Eigen::Vector6d::Zero()));
+
 /**
  * Safe version.
  * @see forwardAcceleration.
@@ -36,4 +49,14 @@ RBDYN_DLLAPI void sForwardAcceleration(const MultiBody & mb,
                                        MultiBodyConfig & mbc,
                                        const sva::MotionVecd & A_0 = sva::MotionVecd(Eigen::Vector6d::Zero()));
 
+/**
+ * Safe version.
+ * @see forwardAcceleration.
+ * @throw std::domain_error If there is a mismatch between mb, alphaD and mbc.
+ */
+RBDYN_DLLAPI void sForwardAcceleration(const MultiBody & mb,
+                                       const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                                       MultiBodyConfig & mbc,
+                                       const sva::MotionVecd & A_0 = sva::MotionVecd(Eigen::Vector6d::Zero()));
+
 } // namespace rbd
@@ -16,6 +16,9 @@
 
 #include <SpaceVecAlg/SpaceVecAlg>
 
+// RBDyn
+#include "LTDL.h"
+
 namespace rbd
 {
 class MultiBody;
@@ -26,6 +29,56 @@ struct MultiBodyConfig;
  */
 class RBDYN_DLLAPI ForwardDynamics
 {
+public:
+  /**
+   * Computation buffers of ForwardDynamics: H, C, the factorization of H and
+   * the H^-1 buffers (@see Jacobian::Workspace for the threading rule).
+   */
+  struct RBDYN_DLLAPI Workspace
+  {
+    Workspace() {}
+    /// @param mb MultiBody associated with this workspace.
+    Workspace(const MultiBody & mb);
+
+    /// Inertia matrix.
+    Eigen::MatrixXd H;
+    /// Non linear effect vector.
+    Eigen::VectorXd C;
+    /// Factorization of H.
+    LTDLFactorization ltdl;
+
+    // H computation
+    std::vector<sva::RBInertiad> I_st;
+    std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> F;
+
+    // C computation
+    std::vector<sva::MotionVecd> acc;
+    std::vector<sva::ForceVecd> f;
+
+    // H and C fused computation
+    /// Motion subspaces in world frame.
+    Eigen::Matrix<double, 6, Eigen::Dynamic> SW;
+    /// Subtree inertia times motion subspaces in world frame.
+    Eigen::Matrix<double, 6, Eigen::Dynamic> FW;
+
+    // H^-1 computation, allocated by the first computeHinv call
+    /// Inverse of the inertia matrix.
+    Eigen::MatrixXd Hinv;
+    std::vector<sva::ABInertiad> IA;
+    std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> U;
+    std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> UDinv;
+    /// Articulated forces of the unit joint torques, on the dofs of each body subtree.
+    std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> pA;
+    /// Accelerations of the unit joint torques, on the dofs after each body first dof.
+    std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> aA;
+
+    // torque computation
+    Eigen::VectorXd tmpFd;
+
+    /// Allocate the H^-1 computation buffers.
+    void resizeHinv(const MultiBody & mb);
+  };
+
 public:
   ForwardDynamics() {}
   /// @param mb MultiBody associated with this algorithm.
@@ -40,6 +93,20 @@ public:
    */
   void forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
 
+  /**
+   * Compute the forward dynamics from flat vectors.
+   * @param mb MultiBody used has model.
+   * @param jointTorque Joint torque vector (nrDof).
+   * @param mbc Use parentToSon, motionSubspace jointVelocity, bodyVelB,
+   * bodyPosW, force and gravity.
+   * @param alphaD Generalized acceleration vector (nrDof), filled by the algorithm.
+   * Can be the same vector than jointTorque.
+   */
+  void forwardDynamics(const MultiBody & mb,
+                       const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                       const MultiBodyConfig & mbc,
+                       Eigen::Ref<Eigen::VectorXd> alphaD);
+
   /**
    * Compute the inertia matrix H.
    * @param mb MultiBody used has model.
@@ -55,22 +122,91 @@ public:
    */
   void computeC(const MultiBody & mb, const MultiBodyConfig & mbc);
 
+  /**
+   * Compute the inertia matrix H and the non linear effect vector C with
+   * one forward and one backward traversal of the tree.
+   * The forward pass also expresses the motion subspaces in world frame, so
+   * the backward pass can write the blocks of H between a joint and its
+   * ancestors as soon as the joint subtree inertia is known, without
+   * transforming it to each ancestor frame. This is faster than computeH
+   * followed by computeC.
+   * @param mb MultiBody used has model.
+   * @param mbc Use parentToSon, motionSubspace jointVelocity, bodyVelB,
+   * bodyPosW, force and gravity.
+   */
+  void computeHC(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /**
+   * Compute the inverse of the inertia matrix H^-1 in O(n^2) without forming H.
+   * The articulated body algorithm is applied to the unit joint torques, the
+   * articulated forces of a body are only computed on the dofs of its
+   * subtree and only the upper triangular part is propagated by the forward
+   * pass. H() and factorization() are not updated.
+   * On shallow trees, computeH followed by LTDLFactorization::compute and
+   * LTDLFactorization::inverse (O(n^2 d) with d the depth of the tree) can
+   * be faster.
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   */
+  void computeHinv(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /// @see forwardDynamics(const MultiBody &, MultiBodyConfig &)
+  /// @param ws Workspace that store H, C and the factorization.
+  void forwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see forwardDynamics from flat vectors.
+  /// @param ws Workspace that store H, C and the factorization.
+  void forwardDynamics(const MultiBody & mb,
+                       const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                       const MultiBodyConfig & mbc,
+                       Eigen::Ref<Eigen::VectorXd> alphaD,
+                       Workspace & ws) const;
+
+  /// @see computeH(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store H.
+  void computeH(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see computeC(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store C.
+  void computeC(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see computeHC(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store H and C.
+  void computeHC(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see computeHinv(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store H^-1.
+  void computeHinv(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
   /// @return The inertia matrix H.
   const Eigen::MatrixXd & H() const
   {
-    return H_;
+    return ws_.H;
+  }
+
+  /// @return The inverse of the inertia matrix computed by computeHinv
+  /// (empty before the first call).
+  const Eigen::MatrixXd & Hinv() const
+  {
+    return ws_.Hinv;
   }
 
   /// @return The non linear effect vector (coriolis, gravity, external force).
   const Eigen::VectorXd & C() const
   {
-    return C_;
+    return ws_.C;
+  }
+
+  /// @return Factorization of H computed by forwardDynamics.
+  const LTDLFactorization & factorization() const
+  {
+    return ws_.ltdl;
   }
 
   /// @return Inertia of tho subtree rooted at body i.
   const std::vector<sva::RBInertiad> & inertiaSubTree() const
   {
-    return I_st_;
+    return ws_.I_st;
   }
 
   // safe version for python binding
@@ -80,6 +216,14 @@ public:
    */
   void sForwardDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
 
+  /** safe version of @see forwardDynamics.
+   * @throw std::domain_error If mb don't match mbc, jointTorque or alphaD.
+   */
+  void sForwardDynamics(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::VectorXd> & jointTorque,
+                        const MultiBodyConfig & mbc,
+                        Eigen::Ref<Eigen::VectorXd> alphaD);
+
   /** safe version of @see computeH.
    * @throw std::domain_error If mb don't match mbc.
    */
@@ -90,24 +234,20 @@ public:
    */
   void sComputeC(const MultiBody & mb, const MultiBodyConfig & mbc);
 
-private:
-  Eigen::MatrixXd H_;
-  Eigen::VectorXd C_;
-
-  // H computation
-  std::vector<sva::RBInertiad> I_st_;
-  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> F_;
-
-  // C computation
-  std::vector<sva::MotionVecd> acc_;
-  std::vector<sva::ForceVecd> f_;
+  /** safe version of @see computeHC.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sComputeHC(const MultiBody & mb, const MultiBodyConfig & mbc);
 
-  // torque computation
-  Eigen::VectorXd tmpFd_;
+  /** safe version of @see computeHinv.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sComputeHinv(const MultiBody & mb, const MultiBodyConfig & mbc);
 
+private:
   std::vector<int> dofPos_;
 
-  Eigen::LDLT<Eigen::MatrixXd> ldlt_;
+  Workspace ws_;
 };
 
 } // namespace rbd
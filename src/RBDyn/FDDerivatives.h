@@ -0,0 +1,89 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// Eigen
+#include <Eigen/Core>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+#include "IDDerivatives.h"
+#include "LTDL.h"
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * Analytical derivatives of the forward dynamics.
+ *
+ * Since alphaD = H^-1 (tau - C), the derivatives are
+ * dalphaD/dq = -H^-1 dtau/dq, dalphaD/dalpha = -H^-1 dtau/dalpha and
+ * dalphaD/dtau = H^-1, where dtau/dx are the inverse dynamics derivatives
+ * evaluated at the forward dynamics solution (@see InverseDynamicsDerivatives).
+ * H^-1 is applied with a factorization of H given by the caller, like
+ * ForwardDynamics::factorization() or ForwardDynamics::Workspace::ltdl.
+ * As for the inverse dynamics, q derivatives are in the joints tangent space.
+ */
+class RBDYN_DLLAPI ForwardDynamicsDerivatives
+{
+public:
+  ForwardDynamicsDerivatives() {}
+  /// @param mb MultiBody associated with this algorithm.
+  ForwardDynamicsDerivatives(const MultiBody & mb);
+
+  /**
+   * Compute the forward dynamics derivatives.
+   * @param mb MultiBody used has model.
+   * @param mbc Use alphaD computed by fd, force, jointVelocity, bodyPosW,
+   * parentToSon, bodyVelB, motionSubspace and gravity.
+   * Fill bodyAccB and overwrite jointTorque with the torque that produce alphaD.
+   * @param ltdl Factorization of the inertia matrix of mbc configuration.
+   */
+  void computeDerivatives(const MultiBody & mb, MultiBodyConfig & mbc, const LTDLFactorization & ltdl);
+
+  /// @return Derivative of alphaD with respect to q (in the tangent space).
+  const Eigen::MatrixXd & dalphaD_dq() const
+  {
+    return dalphaD_dq_;
+  }
+
+  /// @return Derivative of alphaD with respect to alpha.
+  const Eigen::MatrixXd & dalphaD_dalpha() const
+  {
+    return dalphaD_dalpha_;
+  }
+
+  /// @return Derivative of alphaD with respect to the joint torque (H^-1).
+  const Eigen::MatrixXd & dalphaD_dtau() const
+  {
+    return dalphaD_dtau_;
+  }
+
+  /// @return Inverse dynamics derivatives evaluated at the last forward dynamics solution.
+  const InverseDynamicsDerivatives & idDerivatives() const
+  {
+    return idd_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see computeDerivatives.
+   * @throw std::domain_error If mb don't match mbc or ltdl.
+   */
+  void sComputeDerivatives(const MultiBody & mb, MultiBodyConfig & mbc, const LTDLFactorization & ltdl);
+
+private:
+  InverseDynamicsDerivatives idd_;
+
+  Eigen::MatrixXd dalphaD_dq_;
+  Eigen::MatrixXd dalphaD_dalpha_;
+  Eigen::MatrixXd dalphaD_dtau_;
+};
+
+} // namespace rbd
@@ -4,6 +4,11 @@
 
 #pragma once
 
+// includes
+// Eigen
+#include <Eigen/Core>
+
+// RBDyn
 #include <rbdyn/config.hh>
 
 namespace rbd
@@ -19,6 +24,16 @@ struct MultiBodyConfig;
  */
 RBDYN_DLLAPI void forwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc);
 
+/**
+ * Compute the forward kinematic of a MultiBody from a flat vector.
+ * @param mb MultiBody used has model.
+ * @param q Generalized position vector (nrParams).
+ * @param mbc Fill bodyPosW, jointConfig, motionSubspace and parentToSon.
+ */
+RBDYN_DLLAPI void forwardKinematics(const MultiBody & mb,
+                                    const Eigen::Ref<const Eigen::VectorXd> & q,
+                                    MultiBodyConfig & mbc);
+
 /**
  * Safe version.
  * @see forwardKinematics.
@@ -26,4 +41,13 @@ RBDYN_DLLAPI void forwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc)
  */
 RBDYN_DLLAPI void sForwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc);
 
+/**
+ * Safe version.
+ * @see forwardKinematics.
+ * @throw std::domain_error If there is a mismatch between mb, q and mbc.
+ */
+RBDYN_DLLAPI void sForwardKinematics(const MultiBody & mb,
+                                     const Eigen::Ref<const Eigen::VectorXd> & q,
+                                     MultiBodyConfig & mbc);
+
 } // namespace rbd
@@ -4,6 +4,11 @@
 
 #pragma once
 
+// includes
+// Eigen
+#include <Eigen/Core>
+
+// RBDyn
 #include <rbdyn/config.hh>
 
 namespace rbd
@@ -20,6 +25,17 @@ struct MultiBodyConfig;
  */
 RBDYN_DLLAPI void forwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc);
 
+/**
+ * Compute the forward velocity of a MultiBody from a flat vector.
+ * @param mb MultiBody used has model.
+ * @param alpha Generalized velocity vector (nrDof).
+ * @param mbc Use bodyPosW, jointConfig and parentToSon.
+ * Fill jointVelocity, bodyVelW and bodyVelB.
+ */
+RBDYN_DLLAPI void forwardVelocity(const MultiBody & mb,
+                                  const Eigen::Ref<const Eigen::VectorXd> & alpha,
+                                  MultiBodyConfig & mbc);
+
 /**
  * Safe version.
  * @see forwardVelocity.
@@ -27,4 +43,13 @@ RBDYN_DLLAPI void forwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc);
  */
 RBDYN_DLLAPI void sForwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc);
 
+/**
+ * Safe version.
+ * @see forwardVelocity.
+ * @throw std::domain_error If there is a mismatch between mb, alpha and mbc.
+ */
+RBDYN_DLLAPI void sForwardVelocity(const MultiBody & mb,
+                                   const Eigen::Ref<const Eigen::VectorXd> & alpha,
+                                   MultiBodyConfig & mbc);
+
 } // namespace rbd
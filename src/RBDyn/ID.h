@@ -8,6 +8,9 @@
 // std
 #include <vector>
 
+// Eigen
+#include <Eigen/Core>
+
 // SpaceVecAlg
 #include <rbdyn/config.hh>
 
@@ -23,6 +26,21 @@ struct MultiBodyConfig;
  */
 class RBDYN_DLLAPI InverseDynamics
 {
+public:
+  /**
+   * Computation buffers of InverseDynamics: the body forces of the backward
+   * pass (@see Jacobian::Workspace for the threading rule).
+   */
+  struct RBDYN_DLLAPI Workspace
+  {
+    Workspace() {}
+    /// @param mb MultiBody associated with this workspace.
+    Workspace(const MultiBody & mb);
+
+    /// Forces transmitted from body λ(i) to body i across joint i.
+    std::vector<sva::ForceVecd> f;
+  };
+
 public:
   InverseDynamics() {}
   /// @param mb MultiBody associated with this algorithm.
@@ -36,6 +54,19 @@ public:
    * Fill bodyAccB and jointTorque.
    */
   void inverseDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
+  /**
+   * Compute the inverse dynamics from flat vectors.
+   * @param mb MultiBody used has model.
+   * @param alphaD Generalized acceleration vector (nrDof).
+   * @param mbc Use force, jointConfig, jointVelocity, bodyPosW, parentToSon,
+   * bodyVelB, motionSubspace and gravity.
+   * Fill bodyAccB.
+   * @param jointTorque Joint torque vector (nrDof), filled by the algorithm.
+   */
+  void inverseDynamics(const MultiBody & mb,
+                       const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                       MultiBodyConfig & mbc,
+                       Eigen::Ref<Eigen::VectorXd> jointTorque);
   /**
    * Compute the inverse dynamics with the inertia parameters.
    * @param mb MultiBody used has model.
@@ -44,12 +75,33 @@ public:
    */
   void inverseDynamicsNoInertia(const MultiBody & mb, MultiBodyConfig & mbc);
 
+  /// @see inverseDynamics(const MultiBody &, MultiBodyConfig &)
+  /// @param ws Workspace that store the internal forces.
+  void inverseDynamics(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const;
+  /// @see inverseDynamics from flat vectors.
+  /// @param ws Workspace that store the internal forces.
+  void inverseDynamics(const MultiBody & mb,
+                       const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                       MultiBodyConfig & mbc,
+                       Eigen::Ref<Eigen::VectorXd> jointTorque,
+                       Workspace & ws) const;
+  /// @see inverseDynamicsNoInertia(const MultiBody &, MultiBodyConfig &)
+  /// @param ws Workspace that store the internal forces.
+  void inverseDynamicsNoInertia(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const;
+
   // safe version for python binding
 
   /** safe version of @see inverseDynamics.
    * @throw std::domain_error If mb don't match mbc.
    */
   void sInverseDynamics(const MultiBody & mb, MultiBodyConfig & mbc);
+  /** safe version of @see inverseDynamics.
+   * @throw std::domain_error If mb don't match mbc, alphaD or jointTorque.
+   */
+  void sInverseDynamics(const MultiBody & mb,
+                        const Eigen::Ref<const Eigen::VectorXd> & alphaD,
+                        MultiBodyConfig & mbc,
+                        Eigen::Ref<Eigen::VectorXd> jointTorque);
   /** safe version of @see inverseDynamicsNoInertia.
    * @throw std::domain_error If mb don't match mbc.
    */
@@ -63,19 +115,46 @@ public:
   const std::vector<sva::ForceVecd> & f() const;
 
 private:
+  /**
+   * @brief Compute the acceleration and the force of a body.
+   * @param mb MultiBody used has model.
+   * @param mbc Use force, jointVelocity, bodyPosW, parentToSon and bodyVelB.
+   * Fill bodyAccB.
+   * @param i Body index.
+   * @param a_0 Acceleration of the base.
+   * @param ai_tan Tangential acceleration of joint i.
+   * @param ws Workspace that store the body force.
+   */
+  void computeBodyForce(const MultiBody & mb,
+                        MultiBodyConfig & mbc,
+                        int i,
+                        const sva::MotionVecd & a_0,
+                        const sva::MotionVecd & ai_tan,
+                        Workspace & ws) const;
+
   /**
    * @brief Compute joint torques.
    * @param mb MultiBody used has model.
    * @param mbc Use force, bodyPosW, parentToSon and motionSubspace.
    * Fill jointTorque.
+   * @param ws Workspace that store the body forces.
+   */
+  void computeJointTorques(const MultiBody & mb, MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /**
+   * @brief Compute joint torques in a flat vector.
+   * @param mb MultiBody used has model.
+   * @param mbc Use parentToSon and motionSubspace.
+   * @param jointTorque Joint torque vector (nrDof).
+   * @param ws Workspace that store the body forces.
    */
-  void computeJointTorques(const MultiBody & mb, MultiBodyConfig & mbc);
+  void computeJointTorques(const MultiBody & mb,
+                           const MultiBodyConfig & mbc,
+                           Eigen::Ref<Eigen::VectorXd> jointTorque,
+                           Workspace & ws) const;
 
 private:
-  /// @brief Internal forces.
-  /// f_ is the vector of forces transmitted from body λ(i) to body i across
-  /// joint i.
-  std::vector<sva::ForceVecd> f_;
+  Workspace ws_;
 };
 
 } // namespace rbd
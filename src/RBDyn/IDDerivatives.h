@@ -0,0 +1,136 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <utility>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <rbdyn/config.hh>
+
+#include <SpaceVecAlg/SpaceVecAlg>
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * Analytical derivatives of the inverse dynamics (recursive Newton-Euler).
+ *
+ * The derivatives with respect to q are expressed in the joints tangent
+ * space: column k is the derivative along the generalized velocity k, that
+ * is along the configuration obtained by integrating q with a unit alpha
+ * (@see eulerIntegration). This is the usual derivative for Rev, Prism and
+ * Cylindrical joints and the local angular (and linear) velocity for the
+ * quaternion parametrized Spherical and Free joints.
+ * All derivative matrices are nrDof x nrDof.
+ */
+class RBDYN_DLLAPI InverseDynamicsDerivatives
+{
+public:
+  InverseDynamicsDerivatives() {}
+  /// @param mb MultiBody associated with this algorithm.
+  InverseDynamicsDerivatives(const MultiBody & mb);
+
+  /**
+   * Compute the inverse dynamics and its derivatives in one forward and backward pass.
+   * @param mb MultiBody used has model.
+   * @param mbc Use alphaD generalized acceleration vector, force, jointVelocity,
+   * bodyPosW, parentToSon, bodyVelB, motionSubspace and gravity.
+   * Fill bodyAccB and jointTorque.
+   */
+  void computeDerivatives(const MultiBody & mb, MultiBodyConfig & mbc);
+
+  /// @return Derivative of the joint torque with respect to q (in the tangent space).
+  const Eigen::MatrixXd & dtau_dq() const
+  {
+    return dtau_dq_;
+  }
+
+  /// @return Derivative of the joint torque with respect to alpha.
+  const Eigen::MatrixXd & dtau_dalpha() const
+  {
+    return dtau_dalpha_;
+  }
+
+  /// @return Derivative of the joint torque with respect to alphaD (the inertia matrix H).
+  const Eigen::MatrixXd & dtau_dalphaD() const
+  {
+    return dtau_dalphaD_;
+  }
+
+  /**
+   * @brief Get the internal forces.
+   * @return vector of forces transmitted from body λ(i) to body i across
+   * joint i.
+   */
+  const std::vector<sva::ForceVecd> & f() const
+  {
+    return f_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see computeDerivatives.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sComputeDerivatives(const MultiBody & mb, MultiBodyConfig & mbc);
+
+private:
+  /**
+   * Compute the derivatives of the force of body i with respect to the dof
+   * columns [pos, pos + size) from the body velocity and acceleration ones.
+   */
+  void computeBodyForceDerivatives(int i,
+                                   int pos,
+                                   int size,
+                                   const Eigen::Matrix6d & I,
+                                   const Eigen::Matrix6d & dfdv,
+                                   const Eigen::Matrix6d & dfdx);
+
+  /**
+   * Fill the torque derivatives of joint i with respect to the dof columns
+   * [pos, pos + size) and propagate the body force derivatives to its parent.
+   */
+  void computeJointTorqueDerivatives(const MultiBody & mb,
+                                     const MultiBodyConfig & mbc,
+                                     int i,
+                                     const Eigen::Matrix6d & Xt,
+                                     int pos,
+                                     int size);
+
+private:
+  /// @brief Internal forces.
+  std::vector<sva::ForceVecd> f_;
+
+  // dof column ranges (position, size) of the joints supporting each body
+  // (body joint excluded) and of the joints of its subtree
+  std::vector<std::vector<std::pair<int, int>>> ancestorCols_;
+  std::vector<std::vector<std::pair<int, int>>> subtreeCols_;
+
+  // derivatives of the body velocity with respect to q and alpha
+  // (dv_dalpha_ is also the derivative of the body acceleration with respect to alphaD)
+  std::vector<Eigen::MatrixXd> dv_dq_;
+  std::vector<Eigen::MatrixXd> dv_dalpha_;
+  // derivatives of the body acceleration with respect to q and alpha
+  std::vector<Eigen::MatrixXd> da_dq_;
+  std::vector<Eigen::MatrixXd> da_dalpha_;
+  // derivatives of the internal forces with respect to q, alpha and alphaD
+  std::vector<Eigen::MatrixXd> df_dq_;
+  std::vector<Eigen::MatrixXd> df_dalpha_;
+  std::vector<Eigen::MatrixXd> df_dalphaD_;
+
+  Eigen::MatrixXd dtau_dq_;
+  Eigen::MatrixXd dtau_dalpha_;
+  Eigen::MatrixXd dtau_dalphaD_;
+};
+
+} // namespace rbd
@@ -6,6 +6,7 @@
 
 // includes
 // std
+#include <utility>
 #include <vector>
 
 // SpaceVecAlg
@@ -13,6 +14,9 @@
 
 #include <SpaceVecAlg/SpaceVecAlg>
 
+// RBDyn
+#include "Jacobian.h"
+
 namespace rbd
 {
 class MultiBody;
@@ -70,12 +74,55 @@ public:
    */
   void computeY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc);
 
+  /**
+   * Compute the compact Y matrix.
+   * The 10 columns of body i are only non zero in the rows of the joints
+   * supporting body i, so only these rows are computed and stored
+   * (like the compact path Jacobian).
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyVelB, bodyAccB, parentToSon and motionSubspace.
+   * bodyAccB must been calculated with the gravity.
+   */
+  void computeCompactY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc);
+
+  /**
+   * Compute Y*phi from the compact Y matrix.
+   * @param phi Inertial parameters vector (10*nrBodies).
+   * @param tau Result vector (nrDof), typically the joint torque.
+   */
+  void YTimes(const Eigen::Ref<const Eigen::VectorXd> & phi, Eigen::Ref<Eigen::VectorXd> tau) const;
+
+  /**
+   * Compute Y^T*r from the compact Y matrix.
+   * @param r Vector in the joint space (nrDof).
+   * @param res Result vector (10*nrBodies).
+   */
+  void YTransposeTimes(const Eigen::Ref<const Eigen::VectorXd> & r, Eigen::Ref<Eigen::VectorXd> res) const;
+
   /// Return the Y matrix.
   const Eigen::MatrixXd & Y() const
   {
     return Y_;
   }
 
+  /**
+   * Return the compact Y matrix columns of each body.
+   * The matrix of body i is (dof of the joints supporting i x 10).
+   */
+  const std::vector<Eigen::MatrixXd> & compactY() const
+  {
+    return compactY_;
+  }
+
+  /**
+   * Return the rows blocks of each body compact Y matrix.
+   * startDof is the row in Y and startJac the row in the compact matrix.
+   */
+  const std::vector<Blocks> & compactPaths() const
+  {
+    return compactPaths_;
+  }
+
   // safe version for python binding
 
   /** safe version of @see inverseDynamics.
@@ -83,8 +130,231 @@ public:
    */
   void sComputeY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc);
 
+  /** safe version of @see computeCompactY.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sComputeCompactY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc);
+
+  /** safe version of @see YTimes.
+   * @throw std::domain_error If phi or tau size mismatch.
+   */
+  void sYTimes(const Eigen::Ref<const Eigen::VectorXd> & phi, Eigen::Ref<Eigen::VectorXd> tau) const;
+
+  /** safe version of @see YTransposeTimes.
+   * @throw std::domain_error If r or res size mismatch.
+   */
+  void sYTransposeTimes(const Eigen::Ref<const Eigen::VectorXd> & r, Eigen::Ref<Eigen::VectorXd> res) const;
+
 private:
   Eigen::MatrixXd Y_;
+
+  std::vector<Eigen::MatrixXd> compactY_;
+  std::vector<Blocks> compactPaths_;
+  /// row of each joint in the compact matrix of its subtree bodies
+  std::vector<int> pathDofPos_;
+};
+
+/**
+ * Streaming accumulation of the IDIM least-squares normal equations.
+ * Each sample (Y, tau) is folded into Y^T*W*Y and Y^T*W*tau, so the
+ * identification over a long log use a constant amount of memory.
+ * A forgetting factor lambda discount the previous samples:
+ * A_k = lambda*A_{k-1} + w_k*Y_k^T*Y_k.
+ *
+ * The block-sparsity of Y is exploited: the parameters of a body only
+ * appear in the rows of its supporting joints, so the update of a joint
+ * rows only touch the parameters of its subtree.
+ */
+class RBDYN_DLLAPI IDIMAccumulator
+{
+public:
+  IDIMAccumulator() : tauTtau_(0.), scale_(1.), lambda_(1.), nrSamples_(0) {}
+  /// @param mb MultiBody associated with this algorithm.
+  IDIMAccumulator(const rbd::MultiBody & mb);
+
+  /**
+   * Compute the Y matrix of a sample and accumulate it.
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyVelB, bodyAccB, parentToSon, motionSubspace and
+   * jointTorque (measured torque).
+   * bodyAccB must been calculated with the gravity.
+   * @param weight Sample weight.
+   */
+  void addSample(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc, double weight = 1.);
+
+  /**
+   * Accumulate a sample.
+   * @param mb MultiBody used has model.
+   * @param Y Sample Y matrix (nrDof x 10*nrBodies) as computed by IDIM.
+   * @param tau Sample measured torque (nrDof).
+   * @param weight Sample weight.
+   */
+  void addSample(const rbd::MultiBody & mb,
+                 const Eigen::Ref<const Eigen::MatrixXd> & Y,
+                 const Eigen::Ref<const Eigen::VectorXd> & tau,
+                 double weight = 1.);
+
+  /**
+   * Add the sums accumulated by other, typically by another thread.
+   * Each accumulator sum is discounted by its own forgetting factor, other
+   * samples are not discounted by this accumulator samples.
+   */
+  void merge(const IDIMAccumulator & other);
+
+  /// Remove all the samples.
+  void reset();
+
+  /// @return Forgetting factor.
+  double forgettingFactor() const
+  {
+    return lambda_;
+  }
+
+  /// Set the forgetting factor (in ]0, 1], 1 don't forget any sample).
+  void forgettingFactor(double lambda)
+  {
+    lambda_ = lambda;
+  }
+
+  /// @return Number of accumulated samples.
+  int nrSamples() const
+  {
+    return nrSamples_;
+  }
+
+  /// @return Y^T*W*Y (10*nrBodies x 10*nrBodies).
+  Eigen::MatrixXd YTY() const;
+
+  /// @return Y^T*W*tau (10*nrBodies).
+  Eigen::VectorXd YTtau() const;
+
+  /// @return tau^T*W*tau.
+  double tauTtau() const;
+
+  // safe version for python binding
+
+  /** safe version of @see addSample.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sAddSample(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc, double weight = 1.);
+
+  /** safe version of @see addSample.
+   * @throw std::domain_error If mb don't match Y or tau.
+   */
+  void sAddSample(const rbd::MultiBody & mb,
+                  const Eigen::Ref<const Eigen::MatrixXd> & Y,
+                  const Eigen::Ref<const Eigen::VectorXd> & tau,
+                  double weight = 1.);
+
+  /** safe version of @see merge.
+   * @throw std::domain_error If other don't have the same parameters number.
+   */
+  void sMerge(const IDIMAccumulator & other);
+
+private:
+  IDIM idim_;
+  Eigen::VectorXd tau_;
+
+  /// Parameters column ranges (position, size) of the subtree of each joint.
+  std::vector<std::vector<std::pair<int, int>>> subtreeCols_;
+
+  // sums are stored divided by scale_ to apply the forgetting factor in O(1),
+  // only the upper triangle of YTY_ is filled
+  Eigen::MatrixXd YTY_;
+  Eigen::VectorXd YTtau_;
+  double tauTtau_;
+  double scale_;
+
+  double lambda_;
+  int nrSamples_;
+};
+
+/**
+ * Base (minimal) inertial parameters of a MultiBody.
+ * Most of the 10*nrBodies standard parameters can't be identified from the
+ * joint torques: some never act on the dynamics and others only act
+ * through linear combinations. The base parameters phi_b = K*phi are a
+ * minimal set of these combinations such that torque = Y_b*phi_b.
+ *
+ * The analysis is numerical: the Y matrices of random configurations are
+ * stacked and decomposed with a column pivoting QR. The base regressor
+ * Y_b is the subset of the Y columns selected by the QR.
+ */
+class RBDYN_DLLAPI IDIMBaseParameters
+{
+public:
+  IDIMBaseParameters() {}
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param gravity Gravity acting on the multibody, it change which
+   * parameters are identifiable.
+   * @param nrSamples Number of random configurations used by the analysis,
+   * 0 use enough samples to get at least twice more rows than parameters.
+   * @param threshold Relative threshold used to find the rank of the
+   * stacked Y matrix.
+   * @param zeroThreshold Absolute threshold under which the linear
+   * combination coefficients of the base map are set to zero, 0 keep them all.
+   * Unlike threshold it is not scaled by the Y columns norm, so it must be
+   * lowered on badly scaled regressors.
+   */
+  IDIMBaseParameters(const rbd::MultiBody & mb,
+                     const Eigen::Vector3d & gravity,
+                     int nrSamples = 0,
+                     double threshold = 1e-8,
+                     double zeroThreshold = 1e-8);
+
+  /**
+   * Compute the base regressor Y_b.
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyVelB, bodyAccB, parentToSon and motionSubspace.
+   * bodyAccB must been calculated with the gravity.
+   */
+  void computeBaseY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc);
+
+  /// @return Number of base parameters.
+  int nrBaseParameters() const
+  {
+    return static_cast<int>(baseIndices_.size());
+  }
+
+  /// @return Standard parameters index of each Y_b column (sorted).
+  const std::vector<int> & baseIndices() const
+  {
+    return baseIndices_;
+  }
+
+  /// @return Map K from the standard parameters to the base parameters (nrBase x 10*nrBodies).
+  const Eigen::MatrixXd & baseMap() const
+  {
+    return K_;
+  }
+
+  /// @return Base parameters K*phi of the MultiBody bodies inertia.
+  Eigen::VectorXd baseParameters(const rbd::MultiBody & mb) const;
+
+  /// @return The base regressor Y_b (nrDof x nrBase).
+  const Eigen::MatrixXd & baseY() const
+  {
+    return Yb_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see computeBaseY.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  void sComputeBaseY(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc);
+
+  /** safe version of @see baseParameters.
+   * @throw std::domain_error If mb don't match this analysis.
+   */
+  Eigen::VectorXd sBaseParameters(const rbd::MultiBody & mb) const;
+
+private:
+  IDIM idim_;
+  std::vector<int> baseIndices_;
+  Eigen::MatrixXd K_;
+  Eigen::MatrixXd Yb_;
 };
 
 } // namespace rbd
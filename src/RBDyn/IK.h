@@ -6,11 +6,16 @@
 
 // includes
 // std
+#include <atomic>
 #include <vector>
 
+// Eigen
+#include <Eigen/Cholesky>
+
 // SpaceVecAlg
 #include <SpaceVecAlg/SpaceVecAlg>
 
+#include "IncrementalKinematics.h"
 #include "Jacobian.h"
 
 namespace rbd
@@ -25,6 +30,9 @@ static constexpr int MAX_ITERATIONS = 50;
 static constexpr double LAMBDA = 0.9;
 static constexpr double THRESHOLD = 1e-8;
 static constexpr double ALMOST_ZERO = 1e-8;
+static constexpr double DAMPING = 1e-3;
+static constexpr double MIN_DAMPING = 1e-9;
+static constexpr double MAX_DAMPING = 1e8;
 
 } // namespace ik
 
@@ -42,7 +50,9 @@ public:
    * @param mbc Use q generalized position vector
    * @return bool if computation has converged
    * Fill q with new generalized position, update bodyPosW,
-   * jointConfig and parentToSon. All computations are done
+   * jointConfig and parentToSon. Only the subtrees moved by the
+   * joints of the end effector path are updated at each iteration.
+   * All computations are done
    * in-place : even if computation does not converge,
    * mbc will be modified.
    */
@@ -70,7 +80,122 @@ private:
   // @brief ef_index is the End Effector index used to build jacobian
   int ef_index_;
   Jacobian jac_;
+  IncrementalKinematics kin_;
   Eigen::JacobiSVD<Eigen::MatrixXd> svd_;
 };
 
+/**
+ * Levenberg-Marquardt (damped least-squares) Inverse Kinematics algorithm.
+ * Each iteration solves (J*J^T + lambda*I)*y = err with a 6x6 LDLT and
+ * applies the step J^T*y. A step that don't reduce the error is rejected and
+ * the damping lambda is increased, otherwise the damping is decreased.
+ *
+ * Only the kinematics of the end effector path is updated during the
+ * iterations, the other bodies are updated once the algorithm stops.
+ * No allocation is done by the iterations.
+ */
+class RBDYN_DLLAPI DampedInverseKinematics
+{
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /// @param mb MultiBody associated with this algorithm.
+  DampedInverseKinematics(const MultiBody & mb, int ef_index);
+
+  /**
+   * Compute the inverse kinematics.
+   * @param mb MultiBody used has model.
+   * @param mbc Use q generalized position vector
+   * @return bool if computation has converged
+   * Fill q with new generalized position, update bodyPosW,
+   * jointConfig, motionSubspace and parentToSon. All computations are done
+   * in-place : even if computation does not converge, mbc will be modified.
+   */
+  bool inverseKinematics(const MultiBody & mb, MultiBodyConfig & mbc, const sva::PTransformd & ef_target);
+
+  /**
+   * Compute the inverse kinematics until convergence or cancellation.
+   * @see inverseKinematics
+   * @param cancel Checked before each iteration, the algorithm stops
+   * (without converging) once it is true. Allow another thread to
+   * interrupt the computation.
+   */
+  bool inverseKinematics(const MultiBody & mb,
+                         MultiBodyConfig & mbc,
+                         const sva::PTransformd & ef_target,
+                         const std::atomic<bool> & cancel);
+
+  /**
+   * Set the joint limits. They are applied to the joints whose number of
+   * parameters match the number of dof (quaternions are not bounded).
+   * @param qMin Lower bounds of the generalized position vector (nrParams).
+   * @param qMax Upper bounds of the generalized position vector (nrParams).
+   */
+  void jointLimits(const Eigen::VectorXd & qMin, const Eigen::VectorXd & qMax);
+
+  /// @return Number of iterations of the last call.
+  int iterations() const
+  {
+    return iterations_;
+  }
+
+  /// @return End effector error (rotation, translation) at the end of the last call.
+  const Eigen::Vector6d & error() const
+  {
+    return err_;
+  }
+
+  /** safe version of @see inverseKinematics.
+   * @throw std::domain_error If mb doesn't match mbc.
+   */
+  bool sInverseKinematics(const MultiBody & mb, MultiBodyConfig & mbc, const sva::PTransformd & ef_target);
+
+  /** safe version of @see jointLimits.
+   * @throw std::domain_error If qMin or qMax size mismatch.
+   */
+  void sJointLimits(const MultiBody & mb, const Eigen::VectorXd & qMin, const Eigen::VectorXd & qMax);
+
+  // @brief Maximum number of iterations
+  int max_iterations_;
+  // @brief Stopping criterion
+  double threshold_;
+  // @brief Initial damping
+  double damping_;
+
+private:
+  /// Implementation of inverseKinematics, cancel can be null.
+  bool solve(const MultiBody & mb,
+             MultiBodyConfig & mbc,
+             const sva::PTransformd & ef_target,
+             const std::atomic<bool> * cancel);
+  /// Apply the step dq_ on the path joints and update their kinematics.
+  void step(const MultiBody & mb, MultiBodyConfig & mbc);
+  void pathForwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc) const;
+  double computeError(const MultiBodyConfig & mbc, const sva::PTransformd & ef_target, Eigen::Vector6d & err) const;
+  void save(const MultiBodyConfig & mbc);
+  void restore(MultiBodyConfig & mbc) const;
+
+private:
+  int ef_index_;
+  Jacobian jac_;
+  IncrementalKinematics kin_;
+
+  Eigen::VectorXd qMin_;
+  Eigen::VectorXd qMax_;
+
+  // path state saved before a step
+  std::vector<std::vector<double>> qSave_;
+  std::vector<sva::PTransformd> jointConfigSave_;
+  std::vector<sva::PTransformd> parentToSonSave_;
+  std::vector<sva::PTransformd> bodyPosWSave_;
+
+  Eigen::Matrix6d A_;
+  Eigen::LDLT<Eigen::Matrix6d> ldlt_;
+  Eigen::Vector6d err_;
+  Eigen::Vector6d newErr_;
+  Eigen::Vector6d y_;
+  Eigen::VectorXd dq_;
+  int iterations_;
+};
+
 } // namespace rbd
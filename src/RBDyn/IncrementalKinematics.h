@@ -0,0 +1,112 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <vector>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * Incremental forward kinematics and forward velocity.
+ * Keep track of the joints whose q or alpha changed since the last update
+ * and only recompute the subtrees supported by those joints.
+ * The first update of a new instance recomputes everything.
+ */
+class RBDYN_DLLAPI IncrementalKinematics
+{
+public:
+  IncrementalKinematics() : nrUpdatedBodies_(0) {}
+  /// @param mb MultiBody associated with this algorithm.
+  IncrementalKinematics(const MultiBody & mb);
+
+  /// Mark the generalized position of joint as modified.
+  void qChanged(int joint)
+  {
+    qDirty_[joint] = true;
+  }
+
+  /// Mark the generalized velocity of joint as modified.
+  void alphaChanged(int joint)
+  {
+    alphaDirty_[joint] = true;
+  }
+
+  /// Mark every joint as modified (next updates are complete).
+  void allChanged();
+
+  /**
+   * Mark the joints whose q or alpha differ from the ones used by the last updates.
+   * @param mbc Use q and alpha.
+   */
+  void detectChanges(const MultiBodyConfig & mbc);
+
+  /**
+   * Update the forward kinematics of the modified subtrees.
+   * @param mb MultiBody used has model.
+   * @param mbc Use q generalized position vector. Update bodyPosW, jointConfig, motionSubspace
+   * and parentToSon of the modified subtrees.
+   */
+  void forwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc);
+
+  /**
+   * Update the forward velocity of the modified subtrees.
+   * Subtrees moved by forwardKinematics since the last call are also updated.
+   * @param mb MultiBody used has model.
+   * @param mbc Use alpha generalized velocity vector, bodyPosW and parentToSon.
+   * Update jointVelocity, bodyVelB and bodyVelW of the modified subtrees.
+   */
+  void forwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc);
+
+  /// @return Number of bodies updated by the last forwardKinematics call.
+  int nrUpdatedBodies() const
+  {
+    return nrUpdatedBodies_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see detectChanges.
+   * @throw std::domain_error If mb don't match this algorithm or mbc.
+   */
+  void sDetectChanges(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /** safe version of @see forwardKinematics.
+   * @throw std::domain_error If mb don't match this algorithm or mbc.
+   */
+  void sForwardKinematics(const MultiBody & mb, MultiBodyConfig & mbc);
+
+  /** safe version of @see forwardVelocity.
+   * @throw std::domain_error If mb don't match this algorithm or mbc.
+   */
+  void sForwardVelocity(const MultiBody & mb, MultiBodyConfig & mbc);
+
+private:
+  void checkMatchMultiBody(const MultiBody & mb) const;
+
+private:
+  // q and alpha used by the last updates
+  std::vector<std::vector<double>> q_;
+  std::vector<std::vector<double>> alpha_;
+
+  // joints modified since the last updates
+  std::vector<bool> qDirty_;
+  std::vector<bool> alphaDirty_;
+  // bodies moved by forwardKinematics since the last forwardVelocity
+  std::vector<bool> posDirty_;
+  // bodies to update in the current traversal
+  std::vector<bool> update_;
+
+  int nrUpdatedBodies_;
+};
+
+} // namespace rbd
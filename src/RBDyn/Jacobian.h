@@ -37,6 +37,25 @@ using Blocks = std::vector<Block>;
  */
 class RBDYN_DLLAPI Jacobian
 {
+public:
+  /**
+   * Computation buffers of a Jacobian: the jacobian and its time derivative.
+   *
+   * All the algorithm classes with a Workspace follow the same rule: the
+   * methods without a Workspace argument use an internal one, the const
+   * methods taking a Workspace only write in it. So a const instance can be
+   * shared between threads as long as each of them owns its Workspace.
+   */
+  struct RBDYN_DLLAPI Workspace
+  {
+    Workspace() {}
+    /// @param jac Jacobian that will use this workspace.
+    Workspace(const Jacobian & jac);
+
+    Eigen::MatrixXd jac;
+    Eigen::MatrixXd jacDot;
+  };
+
 public:
   Jacobian();
 
@@ -114,6 +133,43 @@ public:
    */
   const Eigen::MatrixXd & bodyJacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc);
 
+  /// @see jacobian(const MultiBody &, const MultiBodyConfig &, const sva::PTransformd &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & jacobian(const MultiBody & mb,
+                                   const MultiBodyConfig & mbc,
+                                   const sva::PTransformd & X_0_p,
+                                   Workspace & ws) const;
+
+  /// @see jacobian(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & jacobian(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see bodyJacobian(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & bodyJacobian(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see vectorJacobian(const MultiBody &, const MultiBodyConfig &, const Eigen::Vector3d &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & vectorJacobian(const MultiBody & mb,
+                                         const MultiBodyConfig & mbc,
+                                         const Eigen::Vector3d & vector,
+                                         Workspace & ws) const;
+
+  /// @see vectorBodyJacobian(const MultiBody &, const MultiBodyConfig &, const Eigen::Vector3d &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & vectorBodyJacobian(const MultiBody & mb,
+                                             const MultiBodyConfig & mbc,
+                                             const Eigen::Vector3d & vector,
+                                             Workspace & ws) const;
+
+  /// @see jacobianDot(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & jacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see bodyJacobianDot(const MultiBody &, const MultiBodyConfig &)
+  /// @param ws Workspace that store the result.
+  const Eigen::MatrixXd & bodyJacobianDot(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
   /**
    * Compute the end body point velocity at the point/frame specified by X_b_p.
    * @param mb MultiBody used has model.
@@ -205,6 +261,57 @@ public:
                                          const MultiBodyConfig & mbc,
                                          const std::vector<sva::MotionVecd> & normalAccB) const;
 
+  /**
+   * Compute J·alpha for an arbitrary generalized velocity without building
+   * the jacobian (world frame at the jacobian point, like jacobian).
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   * @param alpha Generalized velocity vector (nrDof).
+   * @return Jacobian point velocity in world coordinate.
+   */
+  sva::MotionVecd jacobianTimes(const MultiBody & mb,
+                                const MultiBodyConfig & mbc,
+                                const Eigen::Ref<const Eigen::VectorXd> & alpha) const;
+
+  /**
+   * Batched version of jacobianTimes.
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   * @param alphas Generalized velocity vectors, one per column (nrDof x K).
+   * @param res J·alphas (6 x K).
+   */
+  void jacobianTimesBatch(const MultiBody & mb,
+                          const MultiBodyConfig & mbc,
+                          const Eigen::Ref<const Eigen::MatrixXd> & alphas,
+                          Eigen::Ref<Eigen::MatrixXd> res) const;
+
+  /**
+   * Compute J^T·f without building the jacobian (world frame at the
+   * jacobian point, like jacobian), typically to map a contact wrench
+   * into joint torques.
+   * Only the rows of the joints path are computed, the others are set to zero.
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   * @param f Wrench applied at the jacobian point in world coordinate.
+   * @param tau J^T·f (nrDof).
+   */
+  void jacobianTransposeTimes(const MultiBody & mb,
+                              const MultiBodyConfig & mbc,
+                              const sva::ForceVecd & f,
+                              Eigen::Ref<Eigen::VectorXd> tau) const;
+
+  /**
+   * Batched version of jacobianTransposeTimes.
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   * @param wrenches Wrenches, one per column (6 x K).
+   * @param res J^T·wrenches (nrDof x K).
+   */
+  void jacobianTransposeTimesBatch(const MultiBody & mb,
+                                   const MultiBodyConfig & mbc,
+                                   const Eigen::Ref<const Eigen::MatrixXd> & wrenches,
+                                   Eigen::Ref<Eigen::MatrixXd> res) const;
+
   /**
    * Translate a jacobian at a given position.
    * @param jac Jacobian to translate.
@@ -215,7 +322,7 @@ public:
   void translateJacobian(const Eigen::Ref<const Eigen::MatrixXd> & jac,
                          const MultiBodyConfig & mbc,
                          const Eigen::Vector3d & point,
-                         Eigen::MatrixXd & res);
+                         Eigen::MatrixXd & res) const;
 
   /**
    * Translate a jacobian at a given position in body frame.
@@ -227,7 +334,7 @@ public:
   void translateBodyJacobian(const Eigen::Ref<const Eigen::MatrixXd> & jac,
                              const MultiBodyConfig & mbc,
                              const Eigen::Vector3d & point,
-                             Eigen::MatrixXd & res);
+                             Eigen::MatrixXd & res) const;
 
   /**
    * Project the jacobian in the full robot parameters vector.
@@ -310,7 +417,7 @@ public:
   /// @return The number of degree of freedom in the joint path
   int dof() const
   {
-    return static_cast<int>(jac_.cols());
+    return dof_;
   }
 
   /// @return Static translation in the body exprimed in body coordinate.
@@ -378,7 +485,7 @@ public:
   void sTranslateJacobian(const Eigen::MatrixXd & jac,
                           const MultiBodyConfig & mbc,
                           const Eigen::Vector3d & point,
-                          Eigen::MatrixXd & res);
+                          Eigen::MatrixXd & res) const;
 
   /** safe version of @see fullJacobian.
    * @throw std::domain_error If mb don't match jointPath or res
@@ -386,6 +493,37 @@ public:
    */
   void sFullJacobian(const MultiBody & mb, const Eigen::MatrixXd & jac, Eigen::MatrixXd & res) const;
 
+  /** safe version of @see jacobianTimes.
+   * @throw std::domain_error If mb don't match mbc or alpha.
+   */
+  sva::MotionVecd sJacobianTimes(const MultiBody & mb,
+                                 const MultiBodyConfig & mbc,
+                                 const Eigen::Ref<const Eigen::VectorXd> & alpha) const;
+
+  /** safe version of @see jacobianTimesBatch.
+   * @throw std::domain_error If mb don't match mbc, alphas or res.
+   */
+  void sJacobianTimesBatch(const MultiBody & mb,
+                           const MultiBodyConfig & mbc,
+                           const Eigen::Ref<const Eigen::MatrixXd> & alphas,
+                           Eigen::Ref<Eigen::MatrixXd> res) const;
+
+  /** safe version of @see jacobianTransposeTimes.
+   * @throw std::domain_error If mb don't match mbc or tau.
+   */
+  void sJacobianTransposeTimes(const MultiBody & mb,
+                               const MultiBodyConfig & mbc,
+                               const sva::ForceVecd & f,
+                               Eigen::Ref<Eigen::VectorXd> tau) const;
+
+  /** safe version of @see jacobianTransposeTimesBatch.
+   * @throw std::domain_error If mb don't match mbc, wrenches or res.
+   */
+  void sJacobianTransposeTimesBatch(const MultiBody & mb,
+                                    const MultiBodyConfig & mbc,
+                                    const Eigen::Ref<const Eigen::MatrixXd> & wrenches,
+                                    Eigen::Ref<Eigen::MatrixXd> res) const;
+
   /** safe version of @see velocity.
    * @throw std::domain_error If mb don't match mbc.
    */
@@ -449,13 +587,19 @@ private:
                                      const sva::MotionVecd & V_b_p) const;
   sva::MotionVecd normalAcceleration(const MultiBodyConfig & mbc, const sva::MotionVecd & bodyNNormalAcc) const;
   sva::MotionVecd bodyNormalAcceleration(const MultiBodyConfig & mbc, const sva::MotionVecd & bodyNNormalAcc) const;
+  void checkMatchProduct(const MultiBody & mb,
+                         const MultiBodyConfig & mbc,
+                         const Eigen::Ref<const Eigen::MatrixXd> & mat,
+                         Eigen::Index rows,
+                         Eigen::Index cols,
+                         const char * name) const;
 
 private:
   std::vector<int> jointsPath_;
   sva::PTransformd point_;
+  int dof_;
 
-  Eigen::MatrixXd jac_;
-  Eigen::MatrixXd jacDot_;
+  Workspace ws_;
 };
 
 } // namespace rbd
@@ -26,6 +26,10 @@ namespace rbd
 template<typename T>
 Eigen::Matrix3<T> QuatToE(const std::vector<T> & q);
 
+/// @see QuatToE
+template<typename Derived>
+Eigen::Matrix3<typename Derived::Scalar> QuatToE(const Eigen::MatrixBase<Derived> & q);
+
 /**
  * Joint representation.
  * Hold joint name (used as identifier) and compute transformation, speed and motion
@@ -188,6 +192,9 @@ public:
   template<typename T>
   sva::PTransform<T> pose(const std::vector<T> & q) const;
 
+  /// @see pose
+  sva::PTransformd pose(const Eigen::Ref<const Eigen::VectorXd> & q) const;
+
   /**
    * Compute the joint velocity.
    * @param alpha vector of generalized speed variable.
@@ -195,6 +202,9 @@ public:
    */
   sva::MotionVecd motion(const std::vector<double> & alpha) const;
 
+  /// @see motion
+  sva::MotionVecd motion(const Eigen::Ref<const Eigen::VectorXd> & alpha) const;
+
   /**
    * Compute the tangential part of the acceleration S*alphaD.
    * @param alphaD vector of generalized acceleration variable.
@@ -202,6 +212,9 @@ public:
    */
   sva::MotionVecd tanAccel(const std::vector<double> & alphaD) const;
 
+  /// @see tanAccel
+  sva::MotionVecd tanAccel(const Eigen::Ref<const Eigen::VectorXd> & alphaD) const;
+
   /**
    * @return Joint configuation at zero.
    */
@@ -260,6 +273,12 @@ public:
 private:
   void constructJoint(Type t, const Eigen::Vector3d & a);
 
+  // pose, motion and tanAccel for any indexable vector type
+  template<typename T, typename Vector>
+  sva::PTransform<T> poseImpl(const Vector & q) const;
+  template<typename Vector>
+  sva::MotionVecd motionImpl(const Vector & alpha) const;
+
 private:
   Type type_;
   Eigen::Matrix<double, 6, Eigen::Dynamic> S_;
@@ -342,6 +361,17 @@ inline void Joint::makeMimic(const std::string & name, double multiplier, double
 
 template<typename T>
 inline sva::PTransform<T> Joint::pose(const std::vector<T> & q) const
+{
+  return poseImpl<T>(q);
+}
+
+inline sva::PTransformd Joint::pose(const Eigen::Ref<const Eigen::VectorXd> & q) const
+{
+  return poseImpl<double>(q);
+}
+
+template<typename T, typename Vector>
+inline sva::PTransform<T> Joint::poseImpl(const Vector & q) const
 {
   using namespace Eigen;
   using namespace sva;
@@ -385,6 +415,28 @@ inline sva::PTransform<T> Joint::pose(const std::vector<T> & q) const
 }
 
 inline sva::MotionVecd Joint::motion(const std::vector<double> & alpha) const
+{
+  return motionImpl(alpha);
+}
+
+inline sva::MotionVecd Joint::motion(const Eigen::Ref<const Eigen::VectorXd> & alpha) const
+{
+  return motionImpl(alpha);
+}
+
+inline sva::MotionVecd Joint::tanAccel(const std::vector<double> & alphaD) const
+{
+  // the tangential acceleration is linear in alphaD like the velocity in alpha
+  return motionImpl(alphaD);
+}
+
+inline sva::MotionVecd Joint::tanAccel(const Eigen::Ref<const Eigen::VectorXd> & alphaD) const
+{
+  return motionImpl(alphaD);
+}
+
+template<typename Vector>
+inline sva::MotionVecd Joint::motionImpl(const Vector & alpha) const
 {
   using namespace Eigen;
   using namespace sva;
@@ -408,31 +460,6 @@ inline sva::MotionVecd Joint::motion(const std::vector<double> & alpha) const
   }
 }
 
-inline sva::MotionVecd Joint::tanAccel(const std::vector<double> & alphaD) const
-{
-  using namespace Eigen;
-  using namespace sva;
-  switch(type_)
-  {
-    case Rev:
-      return MotionVecd((Vector6d() << S_.block<3, 1>(0, 0) * alphaD[0], Vector3d::Zero()).finished());
-    case Prism:
-      return MotionVecd((Vector6d() << Vector3d::Zero(), S_.block<3, 1>(3, 0) * alphaD[0]).finished());
-    case Spherical:
-      return MotionVecd(S_ * Vector3d(alphaD[0], alphaD[1], alphaD[2]));
-    case Planar:
-      return MotionVecd(S_ * Vector3d(alphaD[0], alphaD[1], alphaD[2]));
-    case Cylindrical:
-      return MotionVecd(S_ * Vector2d(alphaD[0], alphaD[1]));
-    case Free:
-      return MotionVecd(S_
-                        * (Vector6d() << alphaD[0], alphaD[1], alphaD[2], alphaD[3], alphaD[4], alphaD[5]).finished());
-    case Fixed:
-    default:
-      return MotionVecd(Vector6d::Zero());
-  }
-}
-
 inline std::vector<double> Joint::zeroParam() const
 {
   auto q = ZeroParam(type_);
@@ -581,8 +608,15 @@ inline void Joint::constructJoint(Type t, const Eigen::Vector3d & a)
 
 template<typename T>
 inline Eigen::Matrix3<T> QuatToE(const std::vector<T> & q)
+{
+  return QuatToE(Eigen::Map<const Eigen::Matrix<T, 4, 1>>(q.data()));
+}
+
+template<typename Derived>
+inline Eigen::Matrix3<typename Derived::Scalar> QuatToE(const Eigen::MatrixBase<Derived> & q)
 {
   using namespace Eigen;
+  using T = typename Derived::Scalar;
   T p0 = q[0];
   T p1 = q[1];
   T p2 = q[2];
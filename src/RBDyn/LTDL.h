@@ -0,0 +1,136 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+namespace rbd
+{
+class MultiBody;
+
+/**
+ * Tree-sparse factorization H = L^T D L of the inertia matrix (Featherstone).
+ * L is unit lower triangular and L(i, j) can only be non zero if the dof j
+ * is an ancestor of the dof i in the kinematic tree, so the factorization
+ * and the solve never touch the structural zeros induced by branches.
+ */
+class RBDYN_DLLAPI LTDLFactorization
+{
+public:
+  LTDLFactorization() {}
+  /// @param mb MultiBody associated with this factorization.
+  LTDLFactorization(const MultiBody & mb);
+
+  /**
+   * Factorize the inertia matrix.
+   * @param H Inertia matrix of the MultiBody (only the lower part is read).
+   */
+  void compute(const Eigen::MatrixXd & H);
+
+  /**
+   * Solve H x = b for each column of b.
+   * @param b Right-hand sides, overwritten by the solutions.
+   */
+  void solveInPlace(Eigen::Ref<Eigen::MatrixXd> b) const;
+
+  /**
+   * Solve L^T x = b for each column of b.
+   * The row i of b only modify the rows of the ancestors of the dof i.
+   * @param b Right-hand sides, overwritten by the solutions.
+   */
+  void solveLTransposeInPlace(Eigen::Ref<Eigen::MatrixXd> b) const;
+
+  /**
+   * Solve L x = b for each column of b.
+   * @param b Right-hand sides, overwritten by the solutions.
+   */
+  void solveLInPlace(Eigen::Ref<Eigen::MatrixXd> b) const;
+
+  /**
+   * Compute D^-1/2 L^-T b when b is only non zero on a set of dofs.
+   * The ancestors of each dof must also be in the set (like the union of the
+   * dofs of some paths from the root), so the result stay on these dofs and
+   * only the elements of L between them are read.
+   * With W = D^-1/2 L^-T J^T, J H^-1 J^T = W^T W (@see sharedDofsProduct).
+   * @param dofs Dofs of the rows of b (increasing order).
+   * @param b Rows of the right-hand sides on dofs, overwritten by the solutions.
+   */
+  void halfSolveInPlace(const std::vector<int> & dofs, Eigen::Ref<Eigen::MatrixXd> b) const;
+
+  /**
+   * Compute wI^T wJ for two matrices defined on a set of dofs, like two
+   * results of halfSolveInPlace. Only the rows of the dofs shared by dofsI and
+   * dofsJ are read, each run of consecutive shared rows is a dense product.
+   * @param dofsI Dofs of the rows of wI (increasing order).
+   * @param wI Left matrix (dofsI.size() x res.rows()).
+   * @param dofsJ Dofs of the rows of wJ (increasing order).
+   * @param wJ Right matrix (dofsJ.size() x res.cols()).
+   * @param res Result (must be allocated).
+   */
+  static void sharedDofsProduct(const std::vector<int> & dofsI,
+                                const Eigen::Ref<const Eigen::MatrixXd> & wI,
+                                const std::vector<int> & dofsJ,
+                                const Eigen::Ref<const Eigen::MatrixXd> & wJ,
+                                Eigen::Ref<Eigen::MatrixXd> res);
+
+  /// @return H^-1 b.
+  Eigen::MatrixXd solve(const Eigen::MatrixXd & b) const;
+
+  /**
+   * Compute H^-1 J^T.
+   * @param jac Jacobian projected on every dof (rows x nrDof).
+   * @param res Result (nrDof x rows) (must be allocated).
+   */
+  void solveJacobianTranspose(const Eigen::Ref<const Eigen::MatrixXd> & jac, Eigen::MatrixXd & res) const;
+
+  /**
+   * Compute H^-1 in O(n^2 d) with d the depth of the tree (in dof).
+   * The columns of H^-1 are computed in dof order from the columns of their
+   * ancestors dofs, so only the non zero elements of L are read.
+   * A serial chain has d = n, so it gets no asymptotic gain over a dense
+   * inverse, ForwardDynamics::computeHinv is O(n^2) for every tree.
+   * @param Hinv Inverse of H, filled with both triangular parts (nrDof x nrDof)
+   * (must be allocated).
+   */
+  void inverse(Eigen::MatrixXd & Hinv) const;
+
+  /// @return L strictly under the diagonal and D on the diagonal.
+  const Eigen::MatrixXd & matrix() const
+  {
+    return LD_;
+  }
+
+  /// @return Parent dof of each dof (-1 for the dofs without parent).
+  const std::vector<int> & lambda() const
+  {
+    return lambda_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see compute.
+   * @throw std::domain_error If H don't match the MultiBody dof.
+   */
+  void sCompute(const Eigen::MatrixXd & H);
+
+  /** safe version of @see solve.
+   * @throw std::domain_error If b don't match the MultiBody dof.
+   */
+  Eigen::MatrixXd sSolve(const Eigen::MatrixXd & b) const;
+
+private:
+  Eigen::MatrixXd LD_;
+  std::vector<int> lambda_;
+};
+
+} // namespace rbd
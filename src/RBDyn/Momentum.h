@@ -13,13 +13,13 @@
 
 #include <vector>
 
+// RBDyn
+#include "Jacobian.h"
+
 namespace rbd
 {
 class MultiBody;
 struct MultiBodyConfig;
-struct Block;
-using Blocks = std::vector<Block>;
-class Jacobian;
 
 /**
  * Compute the centroidal momentum at the CoM frame
@@ -52,6 +52,28 @@ RBDYN_DLLAPI sva::ForceVecd computeCentroidalMomentumDot(const MultiBody & mb,
  */
 class RBDYN_DLLAPI CentroidalMomentumMatrix
 {
+public:
+  /**
+   * Computation buffers of CentroidalMomentumMatrix, including one
+   * Jacobian::Workspace by body, so the same threading rule applies.
+   */
+  struct RBDYN_DLLAPI Workspace
+  {
+    Workspace() {}
+    /**
+     * @param mb MultiBody associated with this workspace.
+     * @param cmm CentroidalMomentumMatrix associated with this workspace.
+     */
+    Workspace(const MultiBody & mb, const CentroidalMomentumMatrix & cmm);
+
+    Eigen::MatrixXd cmMat;
+    Eigen::MatrixXd cmMatDot;
+
+    std::vector<Eigen::MatrixXd> jacWork;
+    std::vector<Jacobian::Workspace> jacs;
+    std::vector<sva::MotionVecd> normalAcc;
+  };
+
 public:
   CentroidalMomentumMatrix();
 
@@ -141,6 +163,37 @@ public:
                                    const Eigen::Vector3d & comDot,
                                    const std::vector<sva::MotionVecd> & normalAccB) const;
 
+  /// @see computeMatrix
+  /// @param ws Workspace that store the result in cmMat.
+  void computeMatrix(const MultiBody & mb,
+                     const MultiBodyConfig & mbc,
+                     const Eigen::Vector3d & com,
+                     Workspace & ws) const;
+
+  /// @see computeMatrixDot
+  /// @param ws Workspace that store the result in cmMatDot.
+  void computeMatrixDot(const MultiBody & mb,
+                        const MultiBodyConfig & mbc,
+                        const Eigen::Vector3d & com,
+                        const Eigen::Vector3d & comDot,
+                        Workspace & ws) const;
+
+  /// @see computeMatrixAndMatrixDot
+  /// @param ws Workspace that store the results in cmMat and cmMatDot.
+  void computeMatrixAndMatrixDot(const MultiBody & mb,
+                                 const MultiBodyConfig & mbc,
+                                 const Eigen::Vector3d & com,
+                                 const Eigen::Vector3d & comDot,
+                                 Workspace & ws) const;
+
+  /// @see normalMomentumDot
+  /// @param ws Workspace that store the bodies normal acceleration.
+  sva::ForceVecd normalMomentumDot(const MultiBody & mb,
+                                   const MultiBodyConfig & mbc,
+                                   const Eigen::Vector3d & com,
+                                   const Eigen::Vector3d & comDot,
+                                   Workspace & ws) const;
+
   // safe version for python binding
 
   /** safe version of @see computeMatrix.
@@ -190,14 +243,11 @@ private:
   void init(const rbd::MultiBody & mb);
 
 private:
-  Eigen::MatrixXd cmMat_;
-  Eigen::MatrixXd cmMatDot_;
-
   std::vector<Jacobian> jacVec_;
   std::vector<Blocks> blocksVec_;
-  std::vector<Eigen::MatrixXd> jacWork_;
   std::vector<double> bodiesWeight_;
-  std::vector<sva::MotionVecd> normalAcc_;
+
+  Workspace ws_;
 };
 
 // safe version for python binding
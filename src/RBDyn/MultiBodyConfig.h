@@ -76,6 +76,83 @@ struct RBDYN_DLLAPI MultiBodyConfig
   void python_motionSubspace(const std::vector<Eigen::MatrixXd> & v);
 };
 
+/**
+ * Generalized vectors of a MultiBody stored in contiguous buffers.
+ * Each vector is ordered like MultiBody::jointsPosInParam (q) or
+ * MultiBody::jointsPosInDof (alpha, alphaD, jointTorque) so algorithms
+ * can read and write it without conversion.
+ */
+struct RBDYN_DLLAPI FlatMultiBodyConfig
+{
+  FlatMultiBodyConfig() {}
+  FlatMultiBodyConfig(const MultiBody & mb);
+
+  /// Set the multibody at zero configuration
+  void zero(const MultiBody & mb);
+
+  /// Copy q, alpha, alphaD and jointTorque from mbc.
+  void fromConfig(const MultiBodyConfig & mbc);
+  /// Copy q, alpha, alphaD and jointTorque to mbc.
+  void toConfig(MultiBodyConfig & mbc) const;
+
+  /// @return Generalized position variable of joint.
+  Eigen::VectorXd::SegmentReturnType qOf(int joint)
+  {
+    return q.segment(paramPos_[joint], paramPos_[joint + 1] - paramPos_[joint]);
+  }
+  Eigen::VectorXd::ConstSegmentReturnType qOf(int joint) const
+  {
+    return q.segment(paramPos_[joint], paramPos_[joint + 1] - paramPos_[joint]);
+  }
+
+  /// @return Generalized speed variable of joint.
+  Eigen::VectorXd::SegmentReturnType alphaOf(int joint)
+  {
+    return alpha.segment(dofPos_[joint], dofPos_[joint + 1] - dofPos_[joint]);
+  }
+  Eigen::VectorXd::ConstSegmentReturnType alphaOf(int joint) const
+  {
+    return alpha.segment(dofPos_[joint], dofPos_[joint + 1] - dofPos_[joint]);
+  }
+
+  /// @return Generalized acceleration variable of joint.
+  Eigen::VectorXd::SegmentReturnType alphaDOf(int joint)
+  {
+    return alphaD.segment(dofPos_[joint], dofPos_[joint + 1] - dofPos_[joint]);
+  }
+  Eigen::VectorXd::ConstSegmentReturnType alphaDOf(int joint) const
+  {
+    return alphaD.segment(dofPos_[joint], dofPos_[joint + 1] - dofPos_[joint]);
+  }
+
+  /// @return Torque of joint.
+  Eigen::VectorXd::SegmentReturnType jointTorqueOf(int joint)
+  {
+    return jointTorque.segment(dofPos_[joint], dofPos_[joint + 1] - dofPos_[joint]);
+  }
+  Eigen::VectorXd::ConstSegmentReturnType jointTorqueOf(int joint) const
+  {
+    return jointTorque.segment(dofPos_[joint], dofPos_[joint + 1] - dofPos_[joint]);
+  }
+
+  /// Generalized position variable (nrParams).
+  Eigen::VectorXd q;
+
+  /// Generalized speed variable (nrDof).
+  Eigen::VectorXd alpha;
+
+  /// Generalized acceleration variable (nrDof).
+  Eigen::VectorXd alphaD;
+
+  /// Joints torque (nrDof).
+  Eigen::VectorXd jointTorque;
+
+private:
+  // position of each joint in q and in the dof vectors (nrJoints + 1 elements)
+  std::vector<int> paramPos_;
+  std::vector<int> dofPos_;
+};
+
 /**
  * Convert a MultiBodyConfig to another MultiBodyConfig of the same MultiBodyGraph.
  * This class only convert q, alpha, alphaD and force.
@@ -247,6 +324,16 @@ RBDYN_DLLAPI void checkMatchAlphaD(const MultiBody & mb, const MultiBodyConfig &
 /// @throw std::domain_error If there is a mismatch between mb and mbc.force.
 RBDYN_DLLAPI void checkMatchForce(const MultiBody & mb, const MultiBodyConfig & mbc);
 
+/// @throw std::domain_error If there is a mismatch between mb.nrParams and vec.size()
+RBDYN_DLLAPI void checkMatchParamVector(const MultiBody & mb,
+                                        const Eigen::Ref<const Eigen::VectorXd> & vec,
+                                        const std::string & name);
+
+/// @throw std::domain_error If there is a mismatch between mb.nrDof and vec.size()
+RBDYN_DLLAPI void checkMatchDofVector(const MultiBody & mb,
+                                      const Eigen::Ref<const Eigen::VectorXd> & vec,
+                                      const std::string & name);
+
 template<typename T>
 void checkMatchBodiesVector(const MultiBody & mb, const std::vector<T> & vec, const std::string & name)
 {
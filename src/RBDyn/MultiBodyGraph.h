@@ -27,7 +27,9 @@ class MultiBody;
  * Graph representation of the robot.
  * Provide a undirected graph representation of the robot that allow
  * to create a kinematic tree from any body as root.
- * The graph must be cycle free (closed loop is not supported).
+ * The graph must be cycle free (closed loop is not supported), closed loops
+ * can be simulated by adding the loop closure joints as bilateral
+ * constraints (@see ConstrainedForwardDynamics).
  */
 class RBDYN_DLLAPI MultiBodyGraph
 {
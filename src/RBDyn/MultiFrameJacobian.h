@@ -0,0 +1,151 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <string>
+#include <utility>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <rbdyn/config.hh>
+
+#include <SpaceVecAlg/SpaceVecAlg>
+
+namespace rbd
+{
+class MultiBody;
+struct MultiBodyConfig;
+
+/**
+ * Compute the jacobians of several frames (body, point) in one sweep.
+ * The motion subspace of each joint supporting at least one frame is
+ * expressed in world coordinate once, then each frame jacobian is assembled
+ * from this shared data, so common ancestors (like the torso or the pelvis)
+ * are only transformed one time.
+ *
+ * The jacobians are stacked in one (6*nrFrames x nrDof) matrix, the
+ * jacobian of frame k start at row 6*k and the columns of the joints that
+ * don't support a frame stay at zero.
+ */
+class RBDYN_DLLAPI MultiFrameJacobian
+{
+public:
+  /**
+   * Computation buffers of a MultiFrameJacobian: the world frame motion
+   * subspaces and the stacked jacobians (@see Jacobian::Workspace).
+   */
+  struct RBDYN_DLLAPI Workspace
+  {
+    Workspace() {}
+    /// @param mfj MultiFrameJacobian that will use this workspace.
+    Workspace(const MultiFrameJacobian & mfj);
+
+    /// motion subspace of each joint in world coordinate (6 x nrDof)
+    Eigen::MatrixXd S_0;
+    /// stacked jacobians (6*nrFrames x nrDof)
+    Eigen::MatrixXd jac;
+  };
+
+public:
+  MultiFrameJacobian() : nrDof_(0) {}
+
+  /**
+   * @param mb MultiBody associated with this algorithm.
+   * @param bodyNames Body of each frame.
+   * @param points Point of each frame in body coordinate,
+   * if empty the body origins are used.
+   * @throw std::out_of_range If a body don't exist.
+   * @throw std::domain_error If bodyNames and points size mismatch.
+   */
+  MultiFrameJacobian(const MultiBody & mb,
+                     const std::vector<std::string> & bodyNames,
+                     const std::vector<Eigen::Vector3d> & points = {});
+
+  /**
+   * Compute the stacked jacobians in world frame (like Jacobian::jacobian).
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   * @return Stacked jacobians of mb with mbc configuration.
+   */
+  const Eigen::MatrixXd & jacobian(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /**
+   * Compute the stacked jacobians in frames coordinate (like Jacobian::bodyJacobian).
+   * @param mb MultiBody used has model.
+   * @param mbc Use bodyPosW and motionSubspace.
+   * @return Stacked jacobians of mb with mbc configuration.
+   */
+  const Eigen::MatrixXd & bodyJacobian(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /// @see jacobian(const MultiBody &, const MultiBodyConfig &)
+  const Eigen::MatrixXd & jacobian(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @see bodyJacobian(const MultiBody &, const MultiBodyConfig &)
+  const Eigen::MatrixXd & bodyJacobian(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+
+  /// @return Number of frames.
+  int nrFrames() const
+  {
+    return static_cast<int>(bodies_.size());
+  }
+
+  /// @return Body index of each frame.
+  const std::vector<int> & bodies() const
+  {
+    return bodies_;
+  }
+
+  /// @return Point of each frame in body coordinate.
+  const std::vector<sva::PTransformd> & points() const
+  {
+    return points_;
+  }
+
+  /// @return Joints supporting at least one frame (in topological order).
+  const std::vector<int> & joints() const
+  {
+    return joints_;
+  }
+
+  /// @return Joints path of the frame k (from the root to the frame body).
+  const std::vector<int> & jointsPath(int k) const
+  {
+    return jointsPaths_[k];
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see jacobian.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  const Eigen::MatrixXd & sJacobian(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+  /** safe version of @see bodyJacobian.
+   * @throw std::domain_error If mb don't match mbc.
+   */
+  const Eigen::MatrixXd & sBodyJacobian(const MultiBody & mb, const MultiBodyConfig & mbc);
+
+private:
+  void computeS_0(const MultiBody & mb, const MultiBodyConfig & mbc, Workspace & ws) const;
+  void checkMatch(const MultiBody & mb, const MultiBodyConfig & mbc) const;
+
+private:
+  std::vector<int> bodies_;
+  std::vector<sva::PTransformd> points_;
+  std::vector<int> joints_;
+  std::vector<std::vector<int>> jointsPaths_;
+  /// dof columns (position, size) of each frame path
+  std::vector<std::vector<std::pair<int, int>>> pathCols_;
+  int nrDof_;
+
+  Workspace ws_;
+};
+
+} // namespace rbd
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+#include "Jacobian.h"
+
+namespace rbd
+{
+
+/**
+ * Stack several compact jacobians into one sparse (CSC) matrix.
+ * Only the column blocks of each jacobian compact path are stored, so a
+ * QP solver get the sparsity directly.
+ *
+ * The jacobians are registered once with addJacobian, the sparsity pattern
+ * is then built by finalize. At each control tick setJacobian only rewrite
+ * the values of the pattern (no allocation and no search).
+ */
+class RBDYN_DLLAPI SparseJacobianBuilder
+{
+public:
+  SparseJacobianBuilder() : nrDof_(0), nrRows_(0), finalized_(false) {}
+  /// @param nrDof Number of columns of the stacked matrix (MultiBody::nrDof).
+  SparseJacobianBuilder(int nrDof);
+
+  /**
+   * Register a jacobian below the previous ones.
+   * Invalidate the sparsity pattern until the next call to finalize.
+   * @param compactPath Blocks of the jacobian (@see Jacobian::compactPath).
+   * @param rows Number of rows of the jacobian.
+   * @return Index of the jacobian in the builder.
+   */
+  int addJacobian(const Blocks & compactPath, int rows = 6);
+
+  /// Build the sparsity pattern of the registered jacobians (values are set to zero).
+  void finalize();
+
+  /**
+   * Write the values of the jacobian index.
+   * @param index Jacobian index returned by addJacobian.
+   * @param jac Compact jacobian (rows x compact path dof), like Jacobian::jacobian.
+   */
+  void setJacobian(int index, const Eigen::Ref<const Eigen::MatrixXd> & jac);
+
+  /// Remove all the jacobians.
+  void clear();
+
+  /// @return Stacked sparse matrix (nrRows x nrDof).
+  const Eigen::SparseMatrix<double> & matrix() const
+  {
+    return mat_;
+  }
+
+  /// @return Number of registered jacobians.
+  int nrJacobians() const
+  {
+    return static_cast<int>(jacs_.size());
+  }
+
+  /// @return First row of the jacobian index in the stacked matrix.
+  int rowOffset(int index) const
+  {
+    return jacs_[index].rowOffset;
+  }
+
+  /// @return Number of rows of the stacked matrix.
+  int nrRows() const
+  {
+    return nrRows_;
+  }
+
+  // safe version for python binding
+
+  /** safe version of @see addJacobian.
+   * @throw std::domain_error If the blocks exceed nrDof.
+   */
+  int sAddJacobian(const Blocks & compactPath, int rows = 6);
+
+  /** safe version of @see setJacobian.
+   * @throw std::domain_error If index is not a registered jacobian, if the
+   * pattern is not finalized or if jac size mismatch.
+   */
+  void sSetJacobian(int index, const Eigen::Ref<const Eigen::MatrixXd> & jac);
+
+private:
+  struct Entry
+  {
+    Blocks blocks;
+    int rows;
+    int rowOffset;
+    int dof;
+    /// position in the values array of each compact column
+    std::vector<int> valuePos;
+  };
+
+private:
+  int nrDof_;
+  int nrRows_;
+  /// true when the sparsity pattern match the registered jacobians
+  bool finalized_;
+  std::vector<Entry> jacs_;
+  Eigen::SparseMatrix<double> mat_;
+};
+
+} // namespace rbd
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+#pragma once
+
+// includes
+// std
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// RBDyn
+#include <rbdyn/config.hh>
+
+namespace rbd
+{
+
+/**
+ * Work-stealing thread pool running parallel loops.
+ * A loop [0, size) is split into one contiguous range per worker. Each
+ * worker consumes its own range by chunks of grain indices and, once it is
+ * empty, steals the second half of the range of another worker.
+ * The calling thread is worker 0, so a pool of nrThreads workers owns
+ * nrThreads - 1 threads.
+ */
+class RBDYN_DLLAPI ThreadPool
+{
+public:
+  /// Loop body called with (worker, begin, end) for each chunk [begin, end).
+  typedef std::function<void(int, int, int)> LoopBody;
+
+public:
+  /// @param nrThreads Number of workers, 0 use the hardware concurrency.
+  ThreadPool(int nrThreads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  /// @return Number of workers (calling thread included).
+  int nrThreads() const
+  {
+    return static_cast<int>(ranges_.size());
+  }
+
+  /**
+   * Run body over [0, size) and wait for its completion.
+   * Two chunks given to the same worker are never processed concurrently,
+   * so worker can be used to index per-thread data.
+   * @param size Number of indices.
+   * @param grain Number of indices processed by a worker between two steal
+   * attempts.
+   * @param body Loop body.
+   * @throw The first exception thrown by body (remaining chunks are skipped).
+   * Concurrent calls are serialized, it must not be called from inside a loop body.
+   */
+  void parallelFor(int size, int grain, const LoopBody & body);
+
+private:
+  /// Range of indices owned by a worker.
+  struct Range
+  {
+    std::mutex mutex;
+    int begin = 0;
+    int end = 0;
+  };
+
+private:
+  void workerLoop(int worker);
+  void run(int worker);
+  bool pop(int worker, int & begin, int & end);
+  bool steal(int worker);
+
+private:
+  std::vector<std::unique_ptr<Range>> ranges_;
+  std::vector<std::thread> threads_;
+
+  // serialize the parallelFor calls
+  std::mutex runMutex_;
+  std::mutex mutex_;
+  std::condition_variable startCv_;
+  std::condition_variable doneCv_;
+  const LoopBody * body_;
+  int grain_;
+  unsigned int generation_;
+  int nrActive_;
+  bool stop_;
+
+  std::atomic<bool> failed_;
+  std::exception_ptr error_;
+};
+
+} // namespace rbd
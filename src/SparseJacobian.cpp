@@ -0,0 +1,147 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/SparseJacobian.h"
+
+// includes
+// std
+#include <sstream>
+#include <stdexcept>
+
+namespace rbd
+{
+
+SparseJacobianBuilder::SparseJacobianBuilder(int nrDof)
+: nrDof_(nrDof), nrRows_(0), finalized_(false), mat_(0, nrDof)
+{
+}
+
+int SparseJacobianBuilder::addJacobian(const Blocks & compactPath, int rows)
+{
+  Entry e;
+  e.blocks = compactPath;
+  e.rows = rows;
+  e.rowOffset = nrRows_;
+  e.dof = 0;
+  for(const Block & b : compactPath)
+  {
+    e.dof += static_cast<int>(b.length);
+  }
+
+  jacs_.push_back(std::move(e));
+  nrRows_ += rows;
+  // the pattern must be rebuilt
+  finalized_ = false;
+  mat_.resize(0, nrDof_);
+  return nrJacobians() - 1;
+}
+
+void SparseJacobianBuilder::finalize()
+{
+  Eigen::VectorXi nnz(Eigen::VectorXi::Zero(nrDof_));
+  for(const Entry & e : jacs_)
+  {
+    for(const Block & b : e.blocks)
+    {
+      nnz.segment(b.startDof, b.length).array() += e.rows;
+    }
+  }
+
+  mat_.resize(nrRows_, nrDof_);
+  mat_.reserve(nnz);
+  // jacobians are inserted by increasing rows so each column stay sorted
+  for(const Entry & e : jacs_)
+  {
+    for(const Block & b : e.blocks)
+    {
+      for(Eigen::Index c = b.startDof; c < b.startDof + b.length; ++c)
+      {
+        for(int r = 0; r < e.rows; ++r)
+        {
+          mat_.insert(e.rowOffset + r, c) = 0.;
+        }
+      }
+    }
+  }
+  mat_.makeCompressed();
+
+  // the rows of a jacobian are contiguous in each of its columns
+  std::vector<int> fill(mat_.outerIndexPtr(), mat_.outerIndexPtr() + nrDof_);
+  for(Entry & e : jacs_)
+  {
+    e.valuePos.resize(static_cast<std::size_t>(e.dof));
+    for(const Block & b : e.blocks)
+    {
+      for(Eigen::Index j = 0; j < b.length; ++j)
+      {
+        int & pos = fill[b.startDof + j];
+        e.valuePos[b.startJac + j] = pos;
+        pos += e.rows;
+      }
+    }
+  }
+  finalized_ = true;
+}
+
+void SparseJacobianBuilder::setJacobian(int index, const Eigen::Ref<const Eigen::MatrixXd> & jac)
+{
+  const Entry & e = jacs_[index];
+  double * values = mat_.valuePtr();
+  for(int c = 0; c < e.dof; ++c)
+  {
+    Eigen::VectorXd::Map(values + e.valuePos[c], e.rows) = jac.col(c);
+  }
+}
+
+void SparseJacobianBuilder::clear()
+{
+  jacs_.clear();
+  nrRows_ = 0;
+  finalized_ = false;
+  mat_.resize(0, nrDof_);
+}
+
+int SparseJacobianBuilder::sAddJacobian(const Blocks & compactPath, int rows)
+{
+  for(const Block & b : compactPath)
+  {
+    if(b.startDof < 0 || b.length < 0 || b.startDof + b.length > nrDof_)
+    {
+      std::ostringstream str;
+      str << "Block (" << b.startDof << ", " << b.length << ") exceed the number of dof " << nrDof_;
+      throw std::domain_error(str.str());
+    }
+  }
+
+  return addJacobian(compactPath, rows);
+}
+
+void SparseJacobianBuilder::sSetJacobian(int index, const Eigen::Ref<const Eigen::MatrixXd> & jac)
+{
+  if(index < 0 || index >= nrJacobians())
+  {
+    std::ostringstream str;
+    str << "Jacobian index " << index << " is not registered";
+    throw std::domain_error(str.str());
+  }
+
+  if(!finalized_)
+  {
+    throw std::domain_error("Sparsity pattern not finalized");
+  }
+
+  const Entry & e = jacs_[index];
+  if(jac.rows() != e.rows || jac.cols() != e.dof)
+  {
+    std::ostringstream str;
+    str << "jac matrix size mismatch: expected size (" << e.rows << " x " << e.dof << ")"
+        << " gived (" << jac.rows() << " x " << jac.cols() << ")";
+    throw std::domain_error(str.str());
+  }
+
+  setJacobian(index, jac);
+}
+
+} // namespace rbd
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// associated header
+#include "RBDyn/ThreadPool.h"
+
+// includes
+// std
+#include <algorithm>
+
+namespace rbd
+{
+
+ThreadPool::ThreadPool(int nrThreads)
+: body_(nullptr), grain_(1), generation_(0), nrActive_(0), stop_(false), failed_(false)
+{
+  if(nrThreads <= 0)
+  {
+    nrThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+
+  for(int i = 0; i < nrThreads; ++i)
+  {
+    ranges_.emplace_back(new Range);
+  }
+
+  for(int i = 1; i < nrThreads; ++i)
+  {
+    threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  startCv_.notify_all();
+
+  for(std::thread & t : threads_)
+  {
+    t.join();
+  }
+}
+
+void ThreadPool::parallelFor(int size, int grain, const LoopBody & body)
+{
+  if(size <= 0)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> runLock(runMutex_);
+  int nrWorkers = nrThreads();
+  // split [0, size) in nrWorkers contiguous ranges
+  for(int i = 0; i < nrWorkers; ++i)
+  {
+    ranges_[i]->begin = static_cast<int>((static_cast<long long>(size) * i) / nrWorkers);
+    ranges_[i]->end = static_cast<int>((static_cast<long long>(size) * (i + 1)) / nrWorkers);
+  }
+
+  failed_ = false;
+  error_ = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    body_ = &body;
+    grain_ = std::max(1, grain);
+    nrActive_ = nrWorkers - 1;
+    ++generation_;
+  }
+  startCv_.notify_all();
+
+  run(0);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this]() { return nrActive_ == 0; });
+    body_ = nullptr;
+  }
+
+  if(error_)
+  {
+    std::rethrow_exception(error_);
+  }
+}
+
+void ThreadPool::workerLoop(int worker)
+{
+  unsigned int generation = 0;
+  while(true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      startCv_.wait(lock, [this, generation]() { return stop_ || generation_ != generation; });
+      if(stop_)
+      {
+        return;
+      }
+      generation = generation_;
+    }
+
+    run(worker);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --nrActive_;
+      if(nrActive_ == 0)
+      {
+        doneCv_.notify_one();
+      }
+    }
+  }
+}
+
+void ThreadPool::run(int worker)
+{
+  int begin, end;
+  do
+  {
+    while(pop(worker, begin, end))
+    {
+      if(failed_)
+      {
+        continue;
+      }
+
+      try
+      {
+        (*body_)(worker, begin, end);
+      }
+      catch(...)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!failed_)
+        {
+          error_ = std::current_exception();
+          failed_ = true;
+        }
+      }
+    }
+  } while(steal(worker));
+}
+
+bool ThreadPool::pop(int worker, int & begin, int & end)
+{
+  Range & r = *ranges_[worker];
+  std::lock_guard<std::mutex> lock(r.mutex);
+  if(r.begin >= r.end)
+  {
+    return false;
+  }
+
+  begin = r.begin;
+  end = std::min(r.begin + grain_, r.end);
+  r.begin = end;
+  return true;
+}
+
+bool ThreadPool::steal(int worker)
+{
+  int nrWorkers = nrThreads();
+  for(int i = 1; i < nrWorkers; ++i)
+  {
+    Range & victim = *ranges_[(worker + i) % nrWorkers];
+    int begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      int remaining = victim.end - victim.begin;
+      if(remaining <= 0)
+      {
+        continue;
+      }
+
+      // take the second half, or everything when it is not worth splitting
+      begin = remaining > grain_ ? victim.begin + remaining / 2 : victim.begin;
+      end = victim.end;
+      victim.end = begin;
+    }
+
+    Range & own = *ranges_[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.begin = begin;
+    own.end = end;
+    return true;
+  }
+  return false;
+}
+
+} // namespace rbd
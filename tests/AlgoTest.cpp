@@ -15,13 +15,18 @@
 #include <SpaceVecAlg/SpaceVecAlg>
 
 // RBDyn
+#include "RBDyn/BatchFK.h"
+#include "RBDyn/BatchIK.h"
 #include "RBDyn/Body.h"
+#include "RBDyn/CompiledMultiBody.h"
 #include "RBDyn/EulerIntegration.h"
 #include "RBDyn/FA.h"
+#include "RBDyn/FD.h"
 #include "RBDyn/FK.h"
 #include "RBDyn/FV.h"
 #include "RBDyn/ID.h"
 #include "RBDyn/IK.h"
+#include "RBDyn/IncrementalKinematics.h"
 #include "RBDyn/Jacobian.h"
 #include "RBDyn/Joint.h"
 #include "RBDyn/MultiBody.h"
@@ -29,6 +34,7 @@
 #include "RBDyn/MultiBodyGraph.h"
 
 // arm
+#include "Tree30Dof.h"
 #include "XYZSarm.h"
 #include "XYZarm.h"
 
@@ -342,6 +348,394 @@ BOOST_AUTO_TEST_CASE(FreeFlyerTest)
   BOOST_CHECK_EQUAL_COLLECTIONS(res.begin(), res.end(), mbc.bodyVelW.begin(), mbc.bodyVelW.end());
 }
 
+BOOST_AUTO_TEST_CASE(BatchFKTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBodyGraph mbg;
+
+  double mass = 1.;
+  Matrix3d I = Matrix3d::Identity();
+  Vector3d h = Vector3d::Zero();
+
+  RBInertiad rbi(mass, h, I);
+
+  // every joint type in both directions
+  std::vector<Joint> joints = {{Joint::Rev, Vector3d(1., 2., 3.).normalized(), true, "j0"},
+                               {Joint::Prism, Vector3d(0., 1., 1.).normalized(), false, "j1"},
+                               {Joint::Spherical, false, "j2"},
+                               {Joint::Planar, false, "j3"},
+                               {Joint::Cylindrical, Vector3d(1., 0., 1.).normalized(), true, "j4"},
+                               {Joint::Free, false, "j5"},
+                               {Joint::Rev, Vector3d::UnitY(), false, "j6"},
+                               {Joint::Spherical, true, "j7"},
+                               {Joint::Planar, true, "j8"},
+                               {Joint::Fixed, true, "j9"},
+                               {Joint::Free, true, "j10"}};
+
+  mbg.addBody({rbi, "b0"});
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    mbg.addBody({rbi, "b" + std::to_string(i + 1)});
+    mbg.addJoint(joints[i]);
+  }
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    // the last joints make a branch starting from b2
+    std::string parent = i < 6 ? "b" + std::to_string(i) : (i == 6 ? "b2" : "b" + std::to_string(i));
+    mbg.linkBodies(parent, PTransformd(RotX(0.1 * i), Vector3d(0.1, 0.2 * i, -0.3)), "b" + std::to_string(i + 1),
+                   PTransformd(Vector3d(0., -0.1, 0.)), joints[i].name());
+  }
+
+  MultiBody mb = mbg.makeMultiBody("b0", false);
+  MultiBodyConfig mbc(mb);
+  mbc.zero(mb);
+
+  const int N = 17;
+  MatrixXd q = MatrixXd::Random(N, mb.nrParams());
+
+  BatchForwardKinematics bfk(mb, N);
+  bfk.sForwardKinematics(mb, q);
+
+  BOOST_CHECK_EQUAL(bfk.batchSize(), N);
+  for(int n = 0; n < N; ++n)
+  {
+    mbc.q = vectorToParam(mb, q.row(n).transpose());
+    forwardKinematics(mb, mbc);
+
+    for(int b = 0; b < mb.nrBodies(); ++b)
+    {
+      const PTransformd & X = mbc.bodyPosW[b];
+      double error = (bfk.bodyPosW(b, n).matrix() - X.matrix()).norm();
+      BOOST_CHECK_SMALL(error / (1. + X.matrix().norm()), TOL);
+      BOOST_CHECK_EQUAL(bfk.rotation(b, 1, 2)(n), bfk.bodyPosW(b, n).rotation()(1, 2));
+      BOOST_CHECK_EQUAL(bfk.translation(b, 2)(n), bfk.bodyPosW(b, n).translation()(2));
+    }
+  }
+
+  BOOST_CHECK_THROW(bfk.sForwardKinematics(mb, MatrixXd::Zero(N + 1, mb.nrParams())), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalKinematicsTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  auto checkEqual = [&mb](const MultiBodyConfig & mbc1, const MultiBodyConfig & mbc2) {
+    for(int i = 0; i < mb.nrBodies(); ++i)
+    {
+      BOOST_CHECK_SMALL((mbc1.bodyPosW[i].matrix() - mbc2.bodyPosW[i].matrix()).norm(), TOL);
+      BOOST_CHECK_SMALL((mbc1.parentToSon[i].matrix() - mbc2.parentToSon[i].matrix()).norm(), TOL);
+      BOOST_CHECK_SMALL((mbc1.bodyVelB[i] - mbc2.bodyVelB[i]).vector().norm(), TOL);
+      BOOST_CHECK_SMALL((mbc1.bodyVelW[i] - mbc2.bodyVelW[i]).vector().norm(), TOL);
+    }
+  };
+
+  VectorXd q = VectorXd::Random(mb.nrParams());
+  q.head<4>().normalize();
+  mbc.q = vectorToParam(mb, q);
+  mbc.alpha = vectorToDof(mb, VectorXd::Random(mb.nrDof()));
+
+  MultiBodyConfig mbcInc(mbc);
+  IncrementalKinematics kin(mb);
+
+  // first update is complete
+  kin.sForwardKinematics(mb, mbcInc);
+  kin.sForwardVelocity(mb, mbcInc);
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+  BOOST_CHECK_EQUAL(kin.nrUpdatedBodies(), mb.nrBodies());
+  checkEqual(mbc, mbcInc);
+
+  // nothing changed
+  kin.forwardKinematics(mb, mbcInc);
+  kin.forwardVelocity(mb, mbcInc);
+  BOOST_CHECK_EQUAL(kin.nrUpdatedBodies(), 0);
+
+  for(int test = 0; test < 10; ++test)
+  {
+    // move a random joint and change the velocity of another one
+    int qJoint = 1 + std::rand() % (mb.nrJoints() - 1);
+    int alphaJoint = 1 + std::rand() % (mb.nrJoints() - 1);
+    for(double & qi : mbc.q[qJoint])
+      qi += 0.3;
+    for(double & ai : mbc.alpha[alphaJoint])
+      ai -= 0.5;
+    mbcInc.q = mbc.q;
+    mbcInc.alpha = mbc.alpha;
+
+    if(test % 2 == 0)
+    {
+      kin.qChanged(qJoint);
+      kin.alphaChanged(alphaJoint);
+    }
+    else
+    {
+      kin.sDetectChanges(mb, mbcInc);
+    }
+
+    kin.forwardKinematics(mb, mbcInc);
+    kin.forwardVelocity(mb, mbcInc);
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+
+    // only the subtree supported by qJoint is recomputed
+    int subtree = 0;
+    for(int i = 0; i < mb.nrBodies(); ++i)
+    {
+      int b = i;
+      while(b != -1 && b != qJoint)
+        b = mb.parent(b);
+      subtree += b == qJoint ? 1 : 0;
+    }
+    BOOST_CHECK_EQUAL(kin.nrUpdatedBodies(), subtree);
+    checkEqual(mbc, mbcInc);
+  }
+
+  // complete update
+  mbcInc.zero(mb);
+  mbc.zero(mb);
+  kin.allChanged();
+  kin.forwardKinematics(mb, mbcInc);
+  kin.forwardVelocity(mb, mbcInc);
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+  BOOST_CHECK_EQUAL(kin.nrUpdatedBodies(), mb.nrBodies());
+  checkEqual(mbc, mbcInc);
+
+  BOOST_CHECK_THROW(kin.sForwardKinematics(std::get<0>(makeXYZSarm()), mbcInc), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(FlatConfigTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  FlatMultiBodyConfig fmbc(mb);
+  fmbc.zero(mb);
+  mbc.zero(mb);
+  MultiBodyConfig mbcZero(mbc);
+  fmbc.toConfig(mbcZero);
+  BOOST_CHECK(mbcZero.q == mbc.q);
+
+  for(int test = 0; test < 10; ++test)
+  {
+    fmbc.q.setRandom();
+    fmbc.qOf(0).head<4>().normalize();
+    fmbc.alpha.setRandom();
+    fmbc.alphaD.setRandom();
+    fmbc.jointTorque.setRandom();
+    fmbc.toConfig(mbc);
+
+    // per joint views
+    for(int i = 0; i < mb.nrJoints(); ++i)
+    {
+      for(int j = 0; j < mb.joint(i).params(); ++j)
+      {
+        BOOST_CHECK_EQUAL(fmbc.qOf(i)(j), mbc.q[i][j]);
+      }
+      for(int j = 0; j < mb.joint(i).dof(); ++j)
+      {
+        BOOST_CHECK_EQUAL(fmbc.alphaOf(i)(j), mbc.alpha[i][j]);
+        BOOST_CHECK_EQUAL(fmbc.alphaDOf(i)(j), mbc.alphaD[i][j]);
+        BOOST_CHECK_EQUAL(fmbc.jointTorqueOf(i)(j), mbc.jointTorque[i][j]);
+      }
+    }
+
+    MultiBodyConfig mbcFlat(mbc);
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    forwardAcceleration(mb, mbc);
+    sForwardKinematics(mb, fmbc.q, mbcFlat);
+    sForwardVelocity(mb, fmbc.alpha, mbcFlat);
+    sForwardAcceleration(mb, fmbc.alphaD, mbcFlat);
+
+    for(int i = 0; i < mb.nrBodies(); ++i)
+    {
+      BOOST_CHECK_SMALL((mbc.bodyPosW[i].matrix() - mbcFlat.bodyPosW[i].matrix()).norm(), TOL);
+      BOOST_CHECK_SMALL((mbc.bodyVelB[i] - mbcFlat.bodyVelB[i]).vector().norm(), TOL);
+      BOOST_CHECK_SMALL((mbc.bodyVelW[i] - mbcFlat.bodyVelW[i]).vector().norm(), TOL);
+      BOOST_CHECK_SMALL((mbc.bodyAccB[i] - mbcFlat.bodyAccB[i]).vector().norm(), TOL);
+    }
+
+    eulerIntegration(mb, mbc, 0.01);
+    eulerIntegration(mb, fmbc.q, fmbc.alpha, fmbc.alphaD, 0.01);
+    BOOST_CHECK_SMALL((paramToVector(mb, mbc.q) - fmbc.q).norm(), TOL);
+    BOOST_CHECK_SMALL((dofToVector(mb, mbc.alpha) - fmbc.alpha).norm(), TOL);
+
+    FlatMultiBodyConfig fmbcCopy(mb);
+    fmbcCopy.fromConfig(mbc);
+    BOOST_CHECK_SMALL((fmbcCopy.q - fmbc.q).norm(), TOL);
+    BOOST_CHECK_SMALL((fmbcCopy.jointTorque - fmbc.jointTorque).norm(), TOL);
+  }
+
+  BOOST_CHECK_THROW(sForwardKinematics(mb, fmbc.alpha, mbc), std::domain_error);
+  BOOST_CHECK_THROW(sForwardVelocity(mb, fmbc.q, mbc), std::domain_error);
+}
+
+/// @return MultiBody with every joint type, including the axis specialized
+/// ones, in both directions, with a branch, on a free base.
+rbd::MultiBody makeCompiledJointsTree()
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBodyGraph mbg;
+
+  double mass = 1.;
+  Matrix3d I = Matrix3d::Identity();
+  Vector3d h = Vector3d::Zero();
+
+  RBInertiad rbi(mass, h, I);
+
+  // every joint type in both directions
+  std::vector<Joint> joints = {{Joint::Rev, Vector3d(1., 2., 3.).normalized(), true, "j0"},
+                               {Joint::Prism, Vector3d(0., 1., 1.).normalized(), false, "j1"},
+                               {Joint::Spherical, false, "j2"},
+                               {Joint::Planar, false, "j3"},
+                               {Joint::Cylindrical, Vector3d(1., 0., 1.).normalized(), true, "j4"},
+                               {Joint::Free, false, "j5"},
+                               {Joint::Rev, Vector3d::UnitY(), false, "j6"},
+                               {Joint::Spherical, true, "j7"},
+                               {Joint::Planar, true, "j8"},
+                               {Joint::Fixed, true, "j9"},
+                               {Joint::Free, true, "j10"},
+                               {Joint::PrismX, true, "j11"},
+                               {Joint::RevZ, true, "j12"},
+                               {Joint::PrismZ, false, "j13"}};
+
+  mbg.addBody({rbi, "b0"});
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    mbg.addBody({RBInertiad(mass + 0.1 * i, Vector3d(0.1, -0.2, 0.01 * i), I), "b" + std::to_string(i + 1)});
+    mbg.addJoint(joints[i]);
+  }
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    // the last joints make a branch starting from b2
+    std::string parent = i < 6 ? "b" + std::to_string(i) : (i == 6 ? "b2" : "b" + std::to_string(i));
+    mbg.linkBodies(parent, PTransformd(RotX(0.1 * i), Vector3d(0.1, 0.2 * i, -0.3)), "b" + std::to_string(i + 1),
+                   PTransformd(Vector3d(0., -0.1, 0.)), joints[i].name());
+  }
+
+  return mbg.makeMultiBody("b0", false);
+}
+
+BOOST_AUTO_TEST_CASE(CompiledMultiBodyTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb = makeCompiledJointsTree();
+  MultiBodyConfig mbc(mb);
+  mbc.zero(mb);
+  MultiBodyConfig mbcComp(mbc);
+
+  CompiledMultiBody cmb(mb);
+  InverseDynamics id(mb);
+  FlatMultiBodyConfig fmbc(mb);
+  VectorXd torque(mb.nrDof());
+
+  auto checkEqual = [](const std::vector<PTransformd> & X1, const std::vector<PTransformd> & X2) {
+    for(std::size_t i = 0; i < X1.size(); ++i)
+    {
+      BOOST_CHECK_SMALL((X1[i].matrix() - X2[i].matrix()).norm(), TOL);
+    }
+  };
+  auto checkEqualMotion = [](const std::vector<MotionVecd> & m1, const std::vector<MotionVecd> & m2) {
+    for(std::size_t i = 0; i < m1.size(); ++i)
+    {
+      BOOST_CHECK_SMALL((m1[i] - m2[i]).vector().norm(), TOL);
+    }
+  };
+
+  for(int test = 0; test < 10; ++test)
+  {
+    fmbc.q.setRandom();
+    fmbc.alpha.setRandom();
+    fmbc.alphaD.setRandom();
+    fmbc.toConfig(mbc);
+    for(auto & f : mbc.force)
+    {
+      f = ForceVecd(Vector6d::Random());
+    }
+    mbcComp.force = mbc.force;
+
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    id.inverseDynamics(mb, mbc);
+
+    cmb.sForwardKinematics(mb, fmbc.q, mbcComp);
+    cmb.sForwardVelocity(mb, fmbc.alpha, mbcComp);
+    cmb.sInverseDynamics(mb, fmbc.alphaD, mbcComp, torque);
+
+    checkEqual(mbc.jointConfig, mbcComp.jointConfig);
+    checkEqual(mbc.parentToSon, mbcComp.parentToSon);
+    checkEqual(mbc.bodyPosW, mbcComp.bodyPosW);
+    checkEqualMotion(mbc.jointVelocity, mbcComp.jointVelocity);
+    checkEqualMotion(mbc.bodyVelB, mbcComp.bodyVelB);
+    checkEqualMotion(mbc.bodyVelW, mbcComp.bodyVelW);
+    checkEqualMotion(mbc.bodyAccB, mbcComp.bodyAccB);
+    BOOST_CHECK_SMALL((torque - dofToVector(mb, mbc.jointTorque)).norm(), TOL);
+
+    // const version with caller owned internal forces
+    const CompiledMultiBody & ccmb = cmb;
+    std::vector<ForceVecd> f(mb.nrBodies());
+    VectorXd torqueConst(mb.nrDof());
+    ccmb.sInverseDynamics(mb, fmbc.alphaD, mbcComp, torqueConst, f);
+    BOOST_CHECK_SMALL((torqueConst - torque).norm(), TOL);
+    for(int i = 0; i < mb.nrBodies(); ++i)
+    {
+      BOOST_CHECK_SMALL((f[i] - cmb.f()[i]).vector().norm(), TOL);
+    }
+
+    // forwardAcceleration with a non zero base acceleration
+    MotionVecd A_0(Vector6d::Random());
+    forwardAcceleration(mb, mbc, A_0);
+    cmb.sForwardAcceleration(mb, fmbc.alphaD, mbcComp, A_0);
+    checkEqualMotion(mbc.bodyAccB, mbcComp.bodyAccB);
+  }
+
+  // a configuration only driven by the compiled model can be used by the
+  // algorithms reading motionSubspace
+  MultiBodyConfig mbcOnly(mb);
+  mbcOnly.zero(mb);
+  cmb.sForwardKinematics(mb, fmbc.q, mbcOnly);
+  cmb.sForwardVelocity(mb, fmbc.alpha, mbcOnly);
+
+  ForwardDynamics fd(mb), fdComp(mb);
+  fd.computeH(mb, mbc);
+  fdComp.computeH(mb, mbcOnly);
+  BOOST_CHECK_SMALL((fd.H() - fdComp.H()).norm(), TOL);
+
+  Jacobian jac(mb, mb.body(mb.nrBodies() - 1).name());
+  MatrixXd J = jac.jacobian(mb, mbc);
+  MatrixXd JDot = jac.jacobianDot(mb, mbc);
+  BOOST_CHECK_SMALL((J - jac.jacobian(mb, mbcOnly)).norm(), TOL);
+  BOOST_CHECK_SMALL((JDot - jac.jacobianDot(mb, mbcOnly)).norm(), TOL);
+
+  BOOST_CHECK_THROW(cmb.sForwardKinematics(mb, fmbc.alpha, mbcComp), std::domain_error);
+  BOOST_CHECK_THROW(cmb.sForwardKinematics(std::get<0>(makeXYZSarm()), fmbc.q, mbcComp), std::domain_error);
+  std::vector<ForceVecd> fBad(mb.nrBodies() - 1);
+  BOOST_CHECK_THROW(cmb.sInverseDynamics(mb, fmbc.alphaD, mbcComp, torque, fBad), std::domain_error);
+}
+
 BOOST_AUTO_TEST_CASE(EulerTest)
 {
   using namespace std;
@@ -383,11 +777,14 @@ BOOST_AUTO_TEST_CASE(EulerTest)
   eulerJointIntegration(Joint::Free, {pi / 2., 0., 0., 0., 0., 0.}, {0., 0., 0., 0., 0., 0.}, 1., q);
   BOOST_CHECK_EQUAL_COLLECTIONS(q.begin(), q.end(), goalQ.begin(), goalQ.end());
 
-  // planar
+  // planar, the translation is integrated while rotating
   q = {0., 0., 0.};
-  goalQ = {1., 1., 1.};
+  goalQ = {1., 1. - std::cos(1.) + std::sin(1.), std::sin(1.) + std::cos(1.) - 1.};
   eulerJointIntegration(Joint::Planar, {1., 1., 1.}, {0., 0., 0.}, 1., q);
-  BOOST_CHECK_EQUAL_COLLECTIONS(q.begin(), q.end(), goalQ.begin(), goalQ.end());
+  for(std::size_t i = 0; i < q.size(); ++i)
+  {
+    BOOST_CHECK_SMALL(q[i] - goalQ[i], 1e-3);
+  }
 }
 
 /// @return norm of the finite diff motion vector minus model motion vector
@@ -663,3 +1060,160 @@ BOOST_AUTO_TEST_CASE(FailureIKTest)
   ik.max_iterations_ = 40;
   BOOST_CHECK(ik.inverseKinematics(mb, mbc, reachable_target));
 }
+
+BOOST_AUTO_TEST_CASE(DampedIKTest)
+{
+  using namespace Eigen;
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+  int ef = mb.bodyIndexByName("LARM6");
+
+  rbd::DampedInverseKinematics ik(mb, ef);
+  rbd::MultiBodyConfig mbcFK(mbc);
+
+  for(int i = 0; i < 20; ++i)
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.head<4>().normalize();
+    rbd::vectorToParam(q, mbc.q);
+    rbd::forwardKinematics(mb, mbc);
+    sva::PTransformd target(mbc.bodyPosW[ef]);
+
+    // start near the solution
+    q.tail(mb.nrParams() - 7) += 0.3 * VectorXd::Random(mb.nrParams() - 7);
+    rbd::vectorToParam(q, mbc.q);
+    BOOST_CHECK(ik.sInverseKinematics(mb, mbc, target));
+    BOOST_CHECK_LT(ik.error().norm(), ik.threshold_);
+    BOOST_CHECK_LE(ik.iterations(), ik.max_iterations_);
+
+    // every body must be up to date, not only the path ones
+    mbcFK.q = mbc.q;
+    rbd::forwardKinematics(mb, mbcFK);
+    for(int b = 0; b < mb.nrBodies(); ++b)
+    {
+      BOOST_CHECK_SMALL((mbcFK.bodyPosW[b].matrix() - mbc.bodyPosW[b].matrix()).norm(), TOL);
+    }
+    BOOST_CHECK_SMALL((mbcFK.bodyPosW[ef].matrix() - target.matrix()).norm(), 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DampedIKLimitsTest)
+{
+  using namespace Eigen;
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+
+  std::tie(mb, mbc, mbg) = makeXYZarm();
+
+  rbd::DampedInverseKinematics ik(mb, 3);
+  VectorXd qMin(VectorXd::Constant(mb.nrParams(), -0.5));
+  VectorXd qMax(VectorXd::Constant(mb.nrParams(), 0.5));
+  ik.sJointLimits(mb, qMin, qMax);
+  BOOST_CHECK_THROW(ik.sJointLimits(mb, VectorXd::Zero(mb.nrParams() + 1), qMax), std::domain_error);
+
+  // reachable inside the limits
+  Vector3d solution(0.2, -0.4, 0.3);
+  rbd::vectorToParam(solution, mbc.q);
+  rbd::forwardKinematics(mb, mbc);
+  sva::PTransformd target(mbc.bodyPosW[3]);
+  mbc.zero(mb);
+  BOOST_CHECK(ik.inverseKinematics(mb, mbc, target));
+  VectorXd q(mb.nrParams());
+  rbd::paramToVector(mbc.q, q);
+  BOOST_CHECK_SMALL((q - solution).norm(), 1e-6);
+
+  // out of the limits, the result stay inside them
+  rbd::vectorToParam(Vector3d(1., -1., 0.8), mbc.q);
+  rbd::forwardKinematics(mb, mbc);
+  target = mbc.bodyPosW[3];
+  mbc.zero(mb);
+  BOOST_CHECK(!ik.inverseKinematics(mb, mbc, target));
+  rbd::paramToVector(mbc.q, q);
+  BOOST_CHECK((q.array() >= qMin.array()).all() && (q.array() <= qMax.array()).all());
+
+  // unreachable target
+  mbc.zero(mb);
+  ik.jointLimits(VectorXd::Constant(mb.nrParams(), -10.), VectorXd::Constant(mb.nrParams(), 10.));
+  BOOST_CHECK(!ik.inverseKinematics(mb, mbc, sva::PTransformd(sva::RotX(rbd::PI / 2), Vector3d(0., 0.5, 2.5))));
+}
+
+BOOST_AUTO_TEST_CASE(BatchIKTest)
+{
+  using namespace Eigen;
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+  std::vector<int> effectors = {mb.bodyIndexByName("LARM6"), mb.bodyIndexByName("RARM6"),
+                                mb.bodyIndexByName("LLEG5")};
+
+  // two reachable targets by effector
+  std::vector<rbd::BatchInverseKinematics::Problem> problems;
+  for(int i = 0; i < 6; ++i)
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.head<4>().normalize();
+    rbd::vectorToParam(q, mbc.q);
+    rbd::forwardKinematics(mb, mbc);
+    int ef = effectors[i % 3];
+    problems.push_back({ef, mbc.bodyPosW[ef]});
+  }
+
+  const int nrSeeds = 4;
+  MatrixXd seeds(MatrixXd::Random(nrSeeds, mb.nrParams()));
+  for(int s = 0; s < nrSeeds; ++s)
+  {
+    seeds.row(s).head<4>().normalize();
+  }
+
+  rbd::MultiBodyConfig mbcFK(mbc);
+  MatrixXd q(problems.size(), mb.nrParams());
+  for(int nrThreads : {1, 3})
+  {
+    rbd::BatchInverseKinematics batch(mb, effectors, nrThreads);
+    BOOST_CHECK_EQUAL(batch.nrThreads(), nrThreads);
+
+    const std::vector<rbd::BatchInverseKinematics::Result> & res = batch.sInverseKinematics(mb, problems, seeds, q);
+    BOOST_REQUIRE_EQUAL(res.size(), problems.size());
+    for(std::size_t p = 0; p < problems.size(); ++p)
+    {
+      BOOST_CHECK(res[p].converged);
+      BOOST_CHECK(res[p].seed >= 0 && res[p].seed < nrSeeds);
+      BOOST_CHECK_LT(res[p].error, rbd::ik::THRESHOLD);
+
+      rbd::vectorToParam(q.row(p).transpose(), mbcFK.q);
+      rbd::forwardKinematics(mb, mbcFK);
+      BOOST_CHECK_SMALL((mbcFK.bodyPosW[problems[p].effector].matrix() - problems[p].target.matrix()).norm(), 1e-6);
+    }
+
+    if(nrThreads == 1)
+    {
+      // the first seed is tried first on every problem
+      for(const rbd::BatchInverseKinematics::Result & r : res)
+      {
+        BOOST_CHECK_EQUAL(r.seed, 0);
+      }
+    }
+  }
+
+  // no seed converge, the smallest error is returned
+  rbd::BatchInverseKinematics batch(mb, effectors, 2);
+  batch.maxIterations(1);
+  batch.sInverseKinematics(mb, problems, seeds, q);
+  for(const rbd::BatchInverseKinematics::Result & r : batch.results())
+  {
+    BOOST_CHECK(!r.converged);
+    BOOST_CHECK_EQUAL(r.iterations, 1);
+  }
+
+  std::vector<rbd::BatchInverseKinematics::Problem> wrongEf = {
+      {mb.bodyIndexByName("TORSO"), sva::PTransformd::Identity()}};
+  BOOST_CHECK_THROW(batch.sInverseKinematics(mb, wrongEf, seeds, q.topRows(1)), std::domain_error);
+  BOOST_CHECK_THROW(batch.sInverseKinematics(mb, problems, seeds.leftCols(3), q), std::domain_error);
+  BOOST_CHECK_THROW(batch.sInverseKinematics(mb, problems, seeds, q.topRows(2)), std::domain_error);
+}
@@ -610,3 +610,43 @@ BOOST_AUTO_TEST_CASE(CoMJacobianTest)
   jacDummyMat = comJacDummyWeight2.jacobian(mb, mbc);
   BOOST_CHECK_SMALL((jacMat - jacDummyMat).norm(), TOL);
 }
+
+BOOST_AUTO_TEST_CASE(CoMJacobianWorkspaceTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBodyGraph mbg;
+  MultiBody mb;
+  MultiBodyConfig mbc1, mbc2;
+
+  std::tie(mb, mbc1, mbg) = makeXYZSarmRandomCoM();
+  mbc2 = mbc1;
+
+  CoMJacobian comJac(mb);
+  const CoMJacobian & cComJac = comJac;
+  CoMJacobian::Workspace ws1(mb), ws2(mb);
+
+  for(MultiBodyConfig & mbc : {std::ref(mbc1), std::ref(mbc2)})
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.tail<4>().normalize();
+    vectorToParam(q, mbc.q);
+    vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alpha);
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+  }
+
+  cComJac.jacobian(mb, mbc1, ws1);
+  cComJac.jacobianDot(mb, mbc1, ws1);
+  Vector3d normalAcc1 = cComJac.normalAcceleration(mb, mbc1, ws1);
+  cComJac.jacobian(mb, mbc2, ws2);
+  cComJac.jacobianDot(mb, mbc2, ws2);
+
+  BOOST_CHECK_SMALL((ws1.jac - comJac.jacobian(mb, mbc1)).norm(), TOL);
+  BOOST_CHECK_SMALL((ws1.jacDot - comJac.jacobianDot(mb, mbc1)).norm(), TOL);
+  BOOST_CHECK_SMALL((normalAcc1 - comJac.normalAcceleration(mb, mbc1)).norm(), TOL);
+  BOOST_CHECK_SMALL((ws2.jac - comJac.jacobian(mb, mbc2)).norm(), TOL);
+  BOOST_CHECK_SMALL((ws2.jacDot - comJac.jacobianDot(mb, mbc2)).norm(), TOL);
+}
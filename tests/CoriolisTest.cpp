@@ -10,6 +10,7 @@
 #include <RBDyn/FD.h>
 #include <RBDyn/FK.h>
 #include <RBDyn/FV.h>
+#include <RBDyn/Jacobian.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -24,6 +25,39 @@ void setRandomFreeFlyer(rbd::MultiBodyConfig & mbc)
   mbc.q[0][3] = qd.z();
 }
 
+/// Reference C computed with the jacobian (and its derivative) of each body CoM.
+Eigen::MatrixXd jacobianCoriolis(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc)
+{
+  Eigen::MatrixXd coriolis(Eigen::MatrixXd::Zero(mb.nrDof(), mb.nrDof()));
+  for(int i = 0; i < mb.nrBodies(); ++i)
+  {
+    double mass = mb.body(i).inertia().mass();
+    Eigen::Vector3d com = Eigen::Vector3d::Zero();
+    if(mass > 0)
+    {
+      com = mb.body(i).inertia().momentum() / mass;
+    }
+    rbd::Jacobian jac(mb, mb.body(i).name(), com);
+    Eigen::MatrixXd J = jac.jacobian(mb, mbc);
+    Eigen::MatrixXd JD = jac.jacobianDot(mb, mbc);
+
+    Eigen::Matrix3d rot = mbc.bodyPosW[i].rotation().transpose();
+    Eigen::Matrix3d rDot = sva::vector3ToCrossMatrix(mbc.bodyVelW[i].angular()) * rot;
+    Eigen::Matrix3d inertia =
+        mb.body(i).inertia().inertia()
+        - sva::vector3ToCrossMatrix<double>(mass * com) * sva::vector3ToCrossMatrix(com).transpose();
+    Eigen::Matrix3d ir = inertia * rot.transpose();
+
+    /* C = \sum m_i J_{v_i}^T \dot{J}_{v_i}
+     *        + J_{w_i}^T R_i I_i R_i^T \dot{J}_{w_i}
+     *        + J_{w_i}^T \dot{R}_i I_i R_i^T J_{w_i} */
+    Eigen::MatrixXd res = mass * J.bottomRows<3>().transpose() * JD.bottomRows<3>()
+                          + J.topRows<3>().transpose() * (rot * ir * JD.topRows<3>() + rDot * ir * J.topRows<3>());
+    jac.expandAdd(jac.compactPath(mb), res, coriolis);
+  }
+  return coriolis;
+}
+
 BOOST_AUTO_TEST_CASE(CoriolisTest)
 {
   std::srand(133757348);
@@ -62,6 +96,7 @@ BOOST_AUTO_TEST_CASE(CoriolisTest)
     rbd::forwardVelocity(mb, mbc);
 
     Eigen::MatrixXd C = coriolis.coriolis(mb, mbc);
+    BOOST_CHECK_SMALL((C - jacobianCoriolis(mb, mbc)).norm(), TOL);
 
     fd.computeC(mb, mbc);
     Eigen::MatrixXd N = fd.C();
@@ -88,3 +123,36 @@ BOOST_AUTO_TEST_CASE(CoriolisTest)
     BOOST_CHECK_SMALL(diff.norm(), BIGTOL);
   }
 }
+
+BOOST_AUTO_TEST_CASE(CoriolisWorkspaceTest)
+{
+  std::srand(133757348);
+
+  constexpr double TOL = 1e-10;
+
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc1, mbc2;
+  rbd::MultiBodyGraph mbg;
+
+  std::tie(mb, mbc1, mbg) = makeTree30Dof(false);
+  mbc2 = mbc1;
+
+  rbd::Coriolis coriolis(mb);
+  const rbd::Coriolis & cCoriolis = coriolis;
+  rbd::Coriolis::Workspace ws1(mb), ws2(mb);
+
+  for(rbd::MultiBodyConfig & mbc : {std::ref(mbc1), std::ref(mbc2)})
+  {
+    mbc.q = rbd::vectorToParam(mb, Eigen::VectorXd::Random(mb.nrParams()));
+    setRandomFreeFlyer(mbc);
+    mbc.alpha = rbd::vectorToDof(mb, Eigen::VectorXd::Random(mb.nrDof()));
+    rbd::forwardKinematics(mb, mbc);
+    rbd::forwardVelocity(mb, mbc);
+  }
+
+  cCoriolis.coriolis(mb, mbc1, ws1);
+  cCoriolis.coriolis(mb, mbc2, ws2);
+
+  BOOST_CHECK_SMALL((ws1.coriolis - coriolis.coriolis(mb, mbc1)).norm(), TOL);
+  BOOST_CHECK_SMALL((ws2.coriolis - coriolis.coriolis(mb, mbc2)).norm(), TOL);
+}
@@ -3,15 +3,30 @@
  */
 
 // includes
+// std
+#include <thread>
+
 // benchmark
 #include "benchmark/benchmark.h"
 
 // RBDyn
+#include "RBDyn/ABA.h"
+#include "RBDyn/BatchDynamics.h"
+#include "RBDyn/BatchRollout.h"
 #include "RBDyn/CoM.h"
+#include "RBDyn/CompiledMultiBody.h"
+#include "RBDyn/ConstrainedFD.h"
 #include "RBDyn/Coriolis.h"
+#include "RBDyn/Delassus.h"
+#include "RBDyn/DynamicsIntegration.h"
 #include "RBDyn/FD.h"
+#include "RBDyn/FDDerivatives.h"
 #include "RBDyn/FK.h"
 #include "RBDyn/FV.h"
+#include "RBDyn/ID.h"
+#include "RBDyn/IDDerivatives.h"
+#include "RBDyn/IDIM.h"
+#include "RBDyn/Jacobian.h"
 #include "RBDyn/MultiBody.h"
 #include "RBDyn/MultiBodyConfig.h"
 #include "RBDyn/MultiBodyGraph.h"
@@ -55,6 +70,217 @@ static void BM_FD_computeC(benchmark::State & state)
 }
 BENCHMARK(BM_FD_computeC);
 
+static void BM_FD_computeHC(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::ForwardDynamics fd(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    fd.computeHC(mb, mbc);
+  }
+}
+BENCHMARK(BM_FD_computeHC);
+
+static void BM_FD_computeHCArms(benchmark::State & state, bool fused)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTreeArms(static_cast<int>(state.range(0)), false);
+
+  rbd::ForwardDynamics fd(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    if(fused)
+    {
+      fd.computeHC(mb, mbc);
+    }
+    else
+    {
+      fd.computeH(mb, mbc);
+      fd.computeC(mb, mbc);
+    }
+  }
+  state.counters["dof"] = mb.nrDof();
+}
+BENCHMARK_CAPTURE(BM_FD_computeHCArms, separate, false)->Arg(4)->Arg(16)->Arg(32);
+BENCHMARK_CAPTURE(BM_FD_computeHCArms, fused, true)->Arg(4)->Arg(16)->Arg(32);
+
+static void BM_FD_computeHinv(benchmark::State & state, int method, bool chain)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  if(chain)
+  {
+    std::tie(mb, mbc, mbg) = makeChain(static_cast<int>(state.range(0)));
+  }
+  else
+  {
+    std::tie(mb, mbc, mbg) = makeTreeArms(static_cast<int>(state.range(0)), false);
+  }
+
+  rbd::ForwardDynamics fd(mb);
+  rbd::LTDLFactorization ltdl(mb);
+  Eigen::LLT<Eigen::MatrixXd> llt(mb.nrDof());
+  Eigen::MatrixXd Hinv(mb.nrDof(), mb.nrDof());
+
+  rbd::forwardKinematics(mb, mbc);
+  for(auto _ : state)
+  {
+    switch(method)
+    {
+      case 0:
+        fd.computeH(mb, mbc);
+        llt.compute(fd.H());
+        Hinv.setIdentity();
+        llt.solveInPlace(Hinv);
+        break;
+      case 1:
+        fd.computeH(mb, mbc);
+        ltdl.compute(fd.H());
+        ltdl.inverse(Hinv);
+        break;
+      default:
+        fd.computeHinv(mb, mbc);
+    }
+  }
+  state.counters["dof"] = mb.nrDof();
+}
+BENCHMARK_CAPTURE(BM_FD_computeHinv, armsDense, 0, false)->Arg(1)->Arg(4)->Arg(16)->Arg(32);
+BENCHMARK_CAPTURE(BM_FD_computeHinv, armsLtdl, 1, false)->Arg(1)->Arg(4)->Arg(16)->Arg(32);
+BENCHMARK_CAPTURE(BM_FD_computeHinv, armsArticulated, 2, false)->Arg(1)->Arg(4)->Arg(16)->Arg(32);
+BENCHMARK_CAPTURE(BM_FD_computeHinv, chainDense, 0, true)->Arg(30)->Arg(100)->Arg(230);
+BENCHMARK_CAPTURE(BM_FD_computeHinv, chainLtdl, 1, true)->Arg(30)->Arg(100)->Arg(230);
+BENCHMARK_CAPTURE(BM_FD_computeHinv, chainArticulated, 2, true)->Arg(30)->Arg(100)->Arg(230);
+
+static void BM_Delassus(benchmark::State & state, bool dense)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  int nrArms = static_cast<int>(state.range(0));
+  std::tie(mb, mbc, mbg) = makeTreeArms(nrArms, false);
+
+  // one point contact at the end of each arm
+  std::vector<rbd::Delassus::Frame> frames;
+  std::vector<rbd::Jacobian> jacs;
+  for(int i = 0; i < nrArms; ++i)
+  {
+    frames.push_back({"A" + std::to_string(i) + "ARM6", Eigen::Vector3d(0., 0.1, 0.)});
+    jacs.emplace_back(mb, frames.back().bodyName, frames.back().point);
+  }
+
+  rbd::ForwardDynamics fd(mb);
+  rbd::Delassus delassus(mb, frames, true);
+  Eigen::MatrixXd fullJac(6, mb.nrDof());
+  Eigen::MatrixXd J(3 * nrArms, mb.nrDof());
+  Eigen::MatrixXd HinvJt(mb.nrDof(), 3 * nrArms);
+  Eigen::MatrixXd G(3 * nrArms, 3 * nrArms);
+  Eigen::LLT<Eigen::MatrixXd> llt(mb.nrDof());
+
+  rbd::forwardKinematics(mb, mbc);
+  for(auto _ : state)
+  {
+    if(dense)
+    {
+      for(int i = 0; i < nrArms; ++i)
+      {
+        jacs[i].fullJacobian(mb, jacs[i].jacobian(mb, mbc), fullJac);
+        J.middleRows(3 * i, 3) = fullJac.bottomRows<3>();
+      }
+      fd.computeH(mb, mbc);
+      llt.compute(fd.H());
+      HinvJt = J.transpose();
+      llt.solveInPlace(HinvJt);
+      G.noalias() = J * HinvJt;
+    }
+    else
+    {
+      delassus.delassus(mb, mbc);
+    }
+  }
+  state.counters["dof"] = mb.nrDof();
+}
+BENCHMARK_CAPTURE(BM_Delassus, dense, true)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK_CAPTURE(BM_Delassus, sparse, false)->Arg(2)->Arg(8)->Arg(32);
+
+static void BM_ConstrainedFD(benchmark::State & state, int mode)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  int nrArms = static_cast<int>(state.range(0));
+  std::tie(mb, mbc, mbg) = makeTreeArms(nrArms, false);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+
+  // the end of each arm is bound to the world
+  std::vector<rbd::ConstrainedForwardDynamics::Constraint> constraints;
+  std::vector<rbd::Jacobian> jacs;
+  for(int i = 0; i < nrArms; ++i)
+  {
+    std::string name = "A" + std::to_string(i) + "ARM6";
+    sva::PTransformd X_b_f(Eigen::Vector3d(0., 0.1, 0.));
+    constraints.push_back({name, X_b_f, "", X_b_f * mbc.bodyPosW[mb.bodyIndexByName(name)], true});
+    jacs.emplace_back(mb, name, X_b_f.translation());
+  }
+
+  int n = mb.nrDof(), m = 3 * nrArms;
+  rbd::ConstrainedForwardDynamics cfd(mb, constraints);
+  rbd::ForwardDynamics fd(mb);
+  Eigen::VectorXd tau(Eigen::VectorXd::Zero(n)), alphaD(n), alpha(n), rhs(n + m), sol(n + m);
+  Eigen::MatrixXd fullJac(6, n), K(n + m, n + m);
+  Eigen::PartialPivLU<Eigen::MatrixXd> lu(n + m);
+  rbd::paramToVector(mbc.alpha, alpha);
+
+  cfd.factorize(mb, mbc);
+  for(auto _ : state)
+  {
+    if(mode == 0)
+    {
+      // dense KKT system
+      fd.computeHC(mb, mbc);
+      K.setZero();
+      K.topLeftCorner(n, n) = fd.H();
+      rhs.head(n) = tau - fd.C();
+      for(int i = 0; i < nrArms; ++i)
+      {
+        jacs[i].fullJacobian(mb, jacs[i].jacobian(mb, mbc), fullJac);
+        K.block(n + 3 * i, 0, 3, n) = fullJac.bottomRows<3>();
+        K.block(0, n + 3 * i, n, 3) = -fullJac.bottomRows<3>().transpose();
+        jacs[i].fullJacobian(mb, jacs[i].jacobianDot(mb, mbc), fullJac);
+        rhs.segment<3>(n + 3 * i) = -fullJac.bottomRows<3>() * alpha;
+      }
+      lu.compute(K);
+      sol = lu.solve(rhs);
+    }
+    else if(mode == 1)
+    {
+      cfd.forwardDynamics(mb, tau, mbc, alphaD);
+    }
+    else
+    {
+      cfd.solve(tau, alphaD);
+    }
+  }
+  state.counters["dof"] = n;
+}
+BENCHMARK_CAPTURE(BM_ConstrainedFD, denseKKT, 0)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK_CAPTURE(BM_ConstrainedFD, schur, 1)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK_CAPTURE(BM_ConstrainedFD, cachedSolve, 2)->Arg(2)->Arg(8)->Arg(32);
+
 static void BM_Coriolis(benchmark::State & state)
 {
   rbd::MultiBody mb;
@@ -74,4 +300,367 @@ static void BM_Coriolis(benchmark::State & state)
 }
 BENCHMARK(BM_Coriolis);
 
+static void BM_FD_forwardDynamics(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::ForwardDynamics fd(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    fd.forwardDynamics(mb, mbc);
+  }
+}
+BENCHMARK(BM_FD_forwardDynamics);
+
+static void BM_ABA_forwardDynamics(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::ArticulatedBodyAlgorithm aba(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    aba.forwardDynamics(mb, mbc);
+  }
+}
+BENCHMARK(BM_ABA_forwardDynamics);
+
+static void BM_FD_forwardDynamicsArms(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTreeArms(static_cast<int>(state.range(0)), false);
+
+  rbd::ForwardDynamics fd(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    fd.forwardDynamics(mb, mbc);
+  }
+  state.counters["dof"] = mb.nrDof();
+}
+BENCHMARK(BM_FD_forwardDynamicsArms)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_ABA_forwardDynamicsArms(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTreeArms(static_cast<int>(state.range(0)), false);
+
+  rbd::ArticulatedBodyAlgorithm aba(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    aba.forwardDynamics(mb, mbc);
+  }
+  state.counters["dof"] = mb.nrDof();
+}
+BENCHMARK(BM_ABA_forwardDynamicsArms)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_ID_inverseDynamics(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::InverseDynamics id(mb);
+  rbd::FlatMultiBodyConfig fmbc(mb);
+  fmbc.fromConfig(mbc);
+  fmbc.alphaD.setRandom();
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    id.inverseDynamics(mb, fmbc.alphaD, mbc, fmbc.jointTorque);
+  }
+}
+BENCHMARK(BM_ID_inverseDynamics);
+
+static void BM_ID_inverseDynamicsCompiled(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::CompiledMultiBody cmb(mb);
+  rbd::FlatMultiBodyConfig fmbc(mb);
+  fmbc.fromConfig(mbc);
+  fmbc.alphaD.setRandom();
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    cmb.inverseDynamics(fmbc.alphaD, mbc, fmbc.jointTorque);
+  }
+}
+BENCHMARK(BM_ID_inverseDynamicsCompiled);
+
+static void BM_ID_derivatives(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::InverseDynamicsDerivatives idd(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    idd.computeDerivatives(mb, mbc);
+  }
+}
+BENCHMARK(BM_ID_derivatives);
+
+static void BM_FD_derivatives(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::ForwardDynamics fd(mb);
+  rbd::ForwardDynamicsDerivatives fdd(mb);
+
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  for(auto _ : state)
+  {
+    fd.forwardDynamics(mb, mbc);
+    fdd.computeDerivatives(mb, mbc, fd.factorization());
+  }
+}
+BENCHMARK(BM_FD_derivatives);
+
+static void BM_IDIM_denseAccumulate(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::IDIM idim(mb);
+  rbd::InverseDynamics id(mb);
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  id.inverseDynamics(mb, mbc);
+  idim.computeY(mb, mbc);
+  Eigen::VectorXd tau = rbd::dofToVector(mb, mbc.jointTorque);
+
+  Eigen::MatrixXd YTY(Eigen::MatrixXd::Zero(10 * mb.nrBodies(), 10 * mb.nrBodies()));
+  Eigen::VectorXd YTtau(Eigen::VectorXd::Zero(10 * mb.nrBodies()));
+  for(auto _ : state)
+  {
+    YTY.selfadjointView<Eigen::Upper>().rankUpdate(idim.Y().transpose());
+    YTtau.noalias() += idim.Y().transpose() * tau;
+  }
+}
+BENCHMARK(BM_IDIM_denseAccumulate);
+
+static void BM_IDIM_accumulate(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::IDIM idim(mb);
+  rbd::InverseDynamics id(mb);
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  id.inverseDynamics(mb, mbc);
+  idim.computeY(mb, mbc);
+  Eigen::VectorXd tau = rbd::dofToVector(mb, mbc.jointTorque);
+
+  rbd::IDIMAccumulator acc(mb);
+  for(auto _ : state)
+  {
+    acc.addSample(mb, idim.Y(), tau);
+  }
+}
+BENCHMARK(BM_IDIM_accumulate);
+
+static void BM_IDIM_regressor(benchmark::State & state, bool compact)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::IDIM idim(mb);
+  rbd::InverseDynamics id(mb);
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  id.inverseDynamics(mb, mbc);
+  Eigen::VectorXd r = rbd::dofToVector(mb, mbc.jointTorque);
+  Eigen::VectorXd phi = rbd::multiBodyToInertialVector(mb);
+  Eigen::VectorXd tau(mb.nrDof()), YTr(10 * mb.nrBodies());
+
+  for(auto _ : state)
+  {
+    if(compact)
+    {
+      idim.computeCompactY(mb, mbc);
+      idim.YTimes(phi, tau);
+      idim.YTransposeTimes(r, YTr);
+    }
+    else
+    {
+      idim.computeY(mb, mbc);
+      tau.noalias() = idim.Y() * phi;
+      YTr.noalias() = idim.Y().transpose() * r;
+    }
+  }
+}
+BENCHMARK_CAPTURE(BM_IDIM_regressor, dense, false);
+BENCHMARK_CAPTURE(BM_IDIM_regressor, compact, true);
+
+/// @return Kinetic plus potential energy of mbc (q and alpha).
+static double energy(const rbd::MultiBody & mb, rbd::MultiBodyConfig & mbc)
+{
+  rbd::forwardKinematics(mb, mbc);
+  rbd::ForwardDynamics fd(mb);
+  fd.computeH(mb, mbc);
+  Eigen::VectorXd alpha = rbd::dofToVector(mb, mbc.alpha);
+  double mass = 0.;
+  for(const rbd::Body & b : mb.bodies())
+  {
+    mass += b.inertia().mass();
+  }
+  return 0.5 * alpha.dot(fd.H() * alpha) + mass * mbc.gravity.dot(rbd::computeCoM(mb, mbc));
+}
+
+static void BM_DynamicsIntegrator(benchmark::State & state, rbd::DynamicsIntegrator::Method method)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  // passive motion during 1s, the energy must be conserved
+  const int nrSteps = 1000;
+  const double step = 1e-3;
+  Eigen::VectorXd q(Eigen::VectorXd::Random(mb.nrParams()));
+  q.head<4>().normalize();
+  mbc.q = rbd::vectorToParam(mb, q);
+  mbc.alpha = rbd::vectorToDof(mb, Eigen::VectorXd::Random(mb.nrDof()));
+  double e0 = energy(mb, mbc);
+
+  rbd::DynamicsIntegrator integrator(mb, method);
+  rbd::MultiBodyConfig mbcSim(mbc);
+  for(auto _ : state)
+  {
+    mbcSim.q = mbc.q;
+    mbcSim.alpha = mbc.alpha;
+    for(int i = 0; i < nrSteps; ++i)
+    {
+      integrator.integrate(mb, mbcSim, step);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * nrSteps);
+  state.counters["drift"] = std::abs(energy(mb, mbcSim) - e0) / std::abs(e0);
+}
+BENCHMARK_CAPTURE(BM_DynamicsIntegrator, semiImplicitEuler, rbd::DynamicsIntegrator::SemiImplicitEuler);
+BENCHMARK_CAPTURE(BM_DynamicsIntegrator, stormerVerlet, rbd::DynamicsIntegrator::StormerVerlet);
+BENCHMARK_CAPTURE(BM_DynamicsIntegrator, rk4, rbd::DynamicsIntegrator::RK4);
+
+/// Number of threads from 1 to the hardware concurrency.
+static void BatchThreads(benchmark::internal::Benchmark * b)
+{
+  int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  for(int t = 1; t < maxThreads; t *= 2)
+  {
+    b->Arg(t);
+  }
+  b->Arg(maxThreads);
+}
+
+static void BM_BatchDynamics(benchmark::State & state, bool computeY)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  const int nrSamples = 10000;
+  Eigen::MatrixXd q(nrSamples, mb.nrParams());
+  Eigen::MatrixXd alpha(Eigen::MatrixXd::Random(nrSamples, mb.nrDof()));
+  Eigen::MatrixXd alphaD(Eigen::MatrixXd::Random(nrSamples, mb.nrDof()));
+  for(int s = 0; s < nrSamples; ++s)
+  {
+    q.row(s) = rbd::paramToVector(mb, mbc.q).transpose();
+    q.row(s).tail(mb.nrParams() - 7).setRandom();
+  }
+  Eigen::MatrixXd res(computeY ? nrSamples * mb.nrDof() : nrSamples, computeY ? 10 * mb.nrBodies() : mb.nrDof());
+
+  rbd::BatchDynamics batch(mb, static_cast<int>(state.range(0)));
+  for(auto _ : state)
+  {
+    if(computeY)
+    {
+      batch.computeY(mb, q, alpha, alphaD, res);
+    }
+    else
+    {
+      batch.inverseDynamics(mb, q, alpha, alphaD, res);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * nrSamples);
+}
+BENCHMARK_CAPTURE(BM_BatchDynamics, inverseDynamics, false)->Apply(BatchThreads)->UseRealTime();
+BENCHMARK_CAPTURE(BM_BatchDynamics, computeY, true)->Apply(BatchThreads)->UseRealTime();
+
+static void BM_BatchRollout(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  // MPC like batch: short open-loop rollouts
+  const int nrRollouts = 256;
+  const int horizon = 20;
+  Eigen::MatrixXd q0(mb.nrParams(), nrRollouts);
+  Eigen::MatrixXd alpha0(Eigen::MatrixXd::Random(mb.nrDof(), nrRollouts));
+  Eigen::MatrixXd torque(Eigen::MatrixXd::Random(mb.nrDof(), nrRollouts * horizon));
+  for(int r = 0; r < nrRollouts; ++r)
+  {
+    q0.col(r) = rbd::paramToVector(mb, mbc.q);
+    q0.col(r).tail(mb.nrParams() - 7).setRandom();
+  }
+  Eigen::MatrixXd q(mb.nrParams(), nrRollouts * (horizon + 1));
+  Eigen::MatrixXd alpha(mb.nrDof(), nrRollouts * (horizon + 1));
+
+  rbd::BatchRollout batch(mb, rbd::DynamicsIntegrator::Euler, static_cast<int>(state.range(0)));
+  for(auto _ : state)
+  {
+    batch.rollout(mb, q0, alpha0, torque, 1e-3, q, alpha);
+  }
+  state.SetItemsProcessed(state.iterations() * nrRollouts);
+  state.counters["rollouts/s"] = batch.rolloutsPerSecond();
+}
+BENCHMARK(BM_BatchRollout)->Apply(BatchThreads)->UseRealTime();
+
 BENCHMARK_MAIN()
@@ -7,6 +7,8 @@
 
 // includes
 // std
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 
 // boost
@@ -18,17 +20,32 @@
 #include <SpaceVecAlg/SpaceVecAlg>
 
 // RBDyn
+#include "RBDyn/ABA.h"
+#include "RBDyn/BatchDynamics.h"
+#include "RBDyn/BatchRollout.h"
 #include "RBDyn/Body.h"
+#include "RBDyn/ConstrainedFD.h"
+#include "RBDyn/Delassus.h"
+#include "RBDyn/DynamicsIntegration.h"
 #include "RBDyn/FD.h"
+#include "RBDyn/FDDerivatives.h"
 #include "RBDyn/FK.h"
+#include "RBDyn/EulerIntegration.h"
+#include "RBDyn/FA.h"
 #include "RBDyn/FV.h"
 #include "RBDyn/ID.h"
+#include "RBDyn/IDDerivatives.h"
+#include "RBDyn/IDIM.h"
+#include "RBDyn/Jacobian.h"
 #include "RBDyn/Joint.h"
+#include "RBDyn/LTDL.h"
 #include "RBDyn/MultiBody.h"
 #include "RBDyn/MultiBodyConfig.h"
 #include "RBDyn/MultiBodyGraph.h"
+#include "RBDyn/ThreadPool.h"
 
 // arm
+#include "Tree30Dof.h"
 #include "XYZSarm.h"
 
 const double TOL = 0.0000001;
@@ -514,3 +531,955 @@ BOOST_AUTO_TEST_CASE(MultiBodyGraphMerge)
 
   BOOST_CHECK_SMALL(error, TOL);
 }
+
+void testABAvsFD(const rbd::MultiBody & mb, rbd::MultiBodyConfig & mbc)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  ForwardDynamics fd(mb);
+  ArticulatedBodyAlgorithm aba(mb);
+
+  VectorXd vA1(mb.nrDof()), vA2(mb.nrDof());
+
+  for(int i = 0; i < 10; ++i)
+  {
+    makeRandomConfig(mbc);
+    for(auto & f : mbc.force)
+    {
+      f = ForceVecd(Vector6d::Random());
+    }
+
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+
+    fd.forwardDynamics(mb, mbc);
+    paramToVector(mbc.alphaD, vA1);
+
+    internal::set_is_malloc_allowed(false);
+    aba.forwardDynamics(mb, mbc);
+    internal::set_is_malloc_allowed(true);
+    paramToVector(mbc.alphaD, vA2);
+
+    BOOST_CHECK_SMALL((vA1 - vA2).norm(), 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ABAvsFD)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+
+  std::tie(mb, mbc, mbg) = makeXYZSarm(true);
+  testABAvsFD(mb, mbc);
+
+  std::tie(mb, mbc, mbg) = makeXYZSarm(false);
+  testABAvsFD(mb, mbc);
+
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+  testABAvsFD(mb, mbc);
+}
+
+BOOST_AUTO_TEST_CASE(FlatConfigDynamics)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  InverseDynamics id(mb);
+  ForwardDynamics fd(mb);
+  FlatMultiBodyConfig fmbc(mb);
+  MultiBodyConfig mbcFlat(mbc);
+  VectorXd torque(mb.nrDof()), torqueFlat(mb.nrDof());
+
+  for(int i = 0; i < 10; ++i)
+  {
+    makeRandomConfig(mbc);
+    for(auto & f : mbc.force)
+    {
+      f = ForceVecd(Vector6d::Random());
+    }
+    mbcFlat.force = mbc.force;
+    fmbc.fromConfig(mbc);
+
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    id.inverseDynamics(mb, mbc);
+    paramToVector(mbc.jointTorque, torque);
+    vectorToParam(fmbc.jointTorque, mbc.jointTorque);
+    fd.forwardDynamics(mb, mbc);
+
+    internal::set_is_malloc_allowed(false);
+    forwardKinematics(mb, fmbc.q, mbcFlat);
+    forwardVelocity(mb, fmbc.alpha, mbcFlat);
+    id.inverseDynamics(mb, fmbc.alphaD, mbcFlat, torqueFlat);
+    // torque and alphaD can share the same vector
+    fd.forwardDynamics(mb, fmbc.jointTorque, mbcFlat, fmbc.jointTorque);
+    internal::set_is_malloc_allowed(true);
+
+    BOOST_CHECK_SMALL((torque - torqueFlat).norm(), TOL);
+    BOOST_CHECK_SMALL((fmbc.jointTorque - dofToVector(mb, mbc.alphaD)).norm(), 1e-8);
+  }
+
+  BOOST_CHECK_THROW(id.sInverseDynamics(mb, fmbc.q, mbcFlat, torque), std::domain_error);
+  BOOST_CHECK_THROW(fd.sForwardDynamics(mb, fmbc.q, mbcFlat, fmbc.alphaD), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(WorkspaceDynamics)
+{
+  using namespace Eigen;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc1, mbc2;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc1, mbg) = makeTree30Dof(false);
+  mbc2 = mbc1;
+
+  InverseDynamics id(mb);
+  ForwardDynamics fd(mb);
+  const InverseDynamics & cid = id;
+  const ForwardDynamics & cfd = fd;
+  InverseDynamics::Workspace idWs1(mb), idWs2(mb);
+  ForwardDynamics::Workspace fdWs1(mb), fdWs2(mb);
+
+  makeRandomConfig(mbc1);
+  makeRandomConfig(mbc2);
+  forwardKinematics(mb, mbc1);
+  forwardVelocity(mb, mbc1);
+  forwardKinematics(mb, mbc2);
+  forwardVelocity(mb, mbc2);
+
+  // reference results from the internal workspace
+  id.inverseDynamics(mb, mbc1);
+  VectorXd torque1 = dofToVector(mb, mbc1.jointTorque);
+  fd.forwardDynamics(mb, mbc1);
+  MatrixXd H1 = fd.H();
+  VectorXd C1 = fd.C();
+  VectorXd alphaD1 = dofToVector(mb, mbc1.alphaD);
+
+  // a shared const algorithm evaluated with two workspaces
+  VectorXd alphaD(dofToVector(mb, mbc1.alphaD)), torque(mb.nrDof()), res(mb.nrDof());
+  internal::set_is_malloc_allowed(false);
+  cid.inverseDynamics(mb, alphaD, mbc1, torque, idWs1);
+  cid.inverseDynamics(mb, mbc2, idWs2);
+  cfd.forwardDynamics(mb, torque1, mbc1, res, fdWs1);
+  cfd.forwardDynamics(mb, mbc2, fdWs2);
+  internal::set_is_malloc_allowed(true);
+
+  BOOST_CHECK_SMALL((torque - torque1).norm(), TOL);
+  BOOST_CHECK_SMALL((res - alphaD1).norm(), TOL);
+  BOOST_CHECK_SMALL((fdWs1.H - H1).norm(), TOL);
+  BOOST_CHECK_SMALL((fdWs1.C - C1).norm(), TOL);
+  for(int i = 0; i < mb.nrBodies(); ++i)
+  {
+    BOOST_CHECK_SMALL((idWs1.f[i] - id.f()[i]).vector().norm(), TOL);
+  }
+
+  // the second workspace holds the second configuration results
+  id.inverseDynamics(mb, mbc2);
+  fd.computeH(mb, mbc2);
+  BOOST_CHECK_SMALL((fdWs2.H - fd.H()).norm(), TOL);
+  for(int i = 0; i < mb.nrBodies(); ++i)
+  {
+    BOOST_CHECK_SMALL((idWs2.f[i] - id.f()[i]).vector().norm(), TOL);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FusedHCTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+
+  for(int arms : {0, 4})
+  {
+    std::tie(mb, mbc, mbg) = arms == 0 ? makeTree30Dof(false) : makeTreeArms(arms, false);
+
+    ForwardDynamics fd(mb);
+    ForwardDynamics::Workspace ws(mb);
+    for(int i = 0; i < 10; ++i)
+    {
+      makeRandomConfig(mbc);
+      for(auto & f : mbc.force)
+      {
+        f = ForceVecd(Vector6d::Random());
+      }
+      forwardKinematics(mb, mbc);
+      forwardVelocity(mb, mbc);
+
+      fd.computeH(mb, mbc);
+      fd.computeC(mb, mbc);
+
+      // H must not depend on the previous content of the workspace
+      ws.H.setRandom();
+      internal::set_is_malloc_allowed(false);
+      fd.computeHC(mb, mbc, ws);
+      internal::set_is_malloc_allowed(true);
+
+      BOOST_CHECK_SMALL((ws.H - fd.H()).norm(), TOL);
+      BOOST_CHECK_SMALL((ws.C - fd.C()).norm(), TOL);
+      for(int b = 0; b < mb.nrBodies(); ++b)
+      {
+        BOOST_CHECK_SMALL((ws.I_st[b].matrix() - fd.inertiaSubTree()[b].matrix()).norm(), TOL);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ThreadPoolTest)
+{
+  rbd::ThreadPool pool(3);
+  BOOST_CHECK_EQUAL(pool.nrThreads(), 3);
+
+  // every index is processed exactly once, and never concurrently by the same worker
+  std::vector<int> count(1000, 0);
+  std::vector<int> busy(pool.nrThreads(), 0);
+  std::atomic<int> overlap(0);
+  pool.parallelFor(static_cast<int>(count.size()), 7, [&](int worker, int begin, int end) {
+    if(busy[worker]++ != 0)
+    {
+      ++overlap;
+    }
+    for(int i = begin; i < end; ++i)
+    {
+      ++count[i];
+    }
+    --busy[worker];
+  });
+  BOOST_CHECK(std::all_of(count.begin(), count.end(), [](int c) { return c == 1; }));
+  BOOST_CHECK_EQUAL(overlap, 0);
+
+  BOOST_CHECK_THROW(pool.parallelFor(100, 1,
+                                     [](int, int begin, int) {
+                                       if(begin == 42)
+                                       {
+                                         throw std::runtime_error("error");
+                                       }
+                                     }),
+                    std::runtime_error);
+
+  // the pool is still usable after an exception
+  count.assign(count.size(), 0);
+  pool.parallelFor(static_cast<int>(count.size()), 1, [&](int, int begin, int end) {
+    for(int i = begin; i < end; ++i)
+    {
+      ++count[i];
+    }
+  });
+  BOOST_CHECK(std::all_of(count.begin(), count.end(), [](int c) { return c == 1; }));
+
+  // a single worker pool runs in the calling thread
+  int sum = 0;
+  rbd::ThreadPool serial(1);
+  serial.parallelFor(10, 3, [&](int, int begin, int end) {
+    for(int i = begin; i < end; ++i)
+    {
+      sum += i;
+    }
+  });
+  BOOST_CHECK_EQUAL(sum, 45);
+}
+
+BOOST_AUTO_TEST_CASE(BatchDynamicsTest)
+{
+  using namespace Eigen;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  const int nrSamples = 37;
+  MatrixXd q(nrSamples, mb.nrParams()), alpha(nrSamples, mb.nrDof()), alphaD(nrSamples, mb.nrDof());
+  for(int s = 0; s < nrSamples; ++s)
+  {
+    makeRandomConfig(mbc);
+    q.row(s) = paramToVector(mb, mbc.q).transpose();
+    alpha.row(s) = dofToVector(mb, mbc.alpha).transpose();
+    alphaD.row(s) = dofToVector(mb, mbc.alphaD).transpose();
+  }
+
+  BatchDynamics batch(mb, 3);
+  batch.grain(2);
+  batch.gravity(Vector3d(0., 0., 9.81));
+  BOOST_CHECK_EQUAL(batch.nrThreads(), 3);
+
+  MatrixXd torque(nrSamples, mb.nrDof()), alphaDRes(nrSamples, mb.nrDof());
+  MatrixXd H(nrSamples * mb.nrDof(), mb.nrDof()), Y(nrSamples * mb.nrDof(), 10 * mb.nrBodies());
+  batch.sInverseDynamics(mb, q, alpha, alphaD, torque);
+  batch.sForwardDynamics(mb, q, alpha, torque, alphaDRes);
+  batch.sComputeH(mb, q, H);
+  batch.sComputeY(mb, q, alpha, alphaD, Y);
+
+  InverseDynamics id(mb);
+  ForwardDynamics fd(mb);
+  IDIM idim(mb);
+  mbc.gravity = batch.gravity();
+  for(int s = 0; s < nrSamples; ++s)
+  {
+    vectorToParam(q.row(s).transpose(), mbc.q);
+    vectorToParam(alpha.row(s).transpose(), mbc.alpha);
+    vectorToParam(alphaD.row(s).transpose(), mbc.alphaD);
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    id.inverseDynamics(mb, mbc);
+    fd.computeH(mb, mbc);
+    idim.computeY(mb, mbc);
+
+    int rows = mb.nrDof();
+    BOOST_CHECK_SMALL((torque.row(s).transpose() - dofToVector(mb, mbc.jointTorque)).norm(), TOL);
+    BOOST_CHECK_SMALL((alphaDRes.row(s) - alphaD.row(s)).norm(), 1e-8);
+    BOOST_CHECK_SMALL((H.middleRows(s * rows, rows) - fd.H()).norm(), TOL);
+    BOOST_CHECK_SMALL((Y.middleRows(s * rows, rows) - idim.Y()).norm(), TOL);
+  }
+
+  MatrixXd badTorque(nrSamples + 1, mb.nrDof());
+  BOOST_CHECK_THROW(batch.sInverseDynamics(mb, q, alpha, alphaD, badTorque), std::domain_error);
+  std::tie(mb, mbc, mbg) = makeXYZSarm();
+  BOOST_CHECK_THROW(batch.sComputeH(mb, q, H), std::domain_error);
+
+  BatchDynamics empty;
+  BOOST_CHECK_EQUAL(empty.nrThreads(), 1);
+  BOOST_CHECK_THROW(empty.sComputeH(mb, q, H), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(BatchRolloutTest)
+{
+  using namespace Eigen;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  const int nrRollouts = 13;
+  const int horizon = 5;
+  const double step = 1e-3;
+  MatrixXd q0(mb.nrParams(), nrRollouts), alpha0(mb.nrDof(), nrRollouts);
+  MatrixXd torque(MatrixXd::Random(mb.nrDof(), nrRollouts * horizon));
+  for(int r = 0; r < nrRollouts; ++r)
+  {
+    makeRandomConfig(mbc);
+    q0.col(r) = paramToVector(mb, mbc.q);
+    alpha0.col(r) = dofToVector(mb, mbc.alpha);
+  }
+
+  BatchRollout batch(mb, DynamicsIntegrator::Euler, 3);
+  batch.gravity(Vector3d(0., 0., 9.81));
+  BOOST_CHECK_EQUAL(batch.nrThreads(), 3);
+
+  MatrixXd q(mb.nrParams(), nrRollouts * (horizon + 1)), alpha(mb.nrDof(), nrRollouts * (horizon + 1));
+  batch.sRollout(mb, q0, alpha0, torque, step, q, alpha);
+  BOOST_CHECK_GT(batch.rolloutsPerSecond(), 0.);
+
+  // serial forward dynamics and euler integration
+  ForwardDynamics fd(mb);
+  mbc.gravity = batch.gravity();
+  for(int r = 0; r < nrRollouts; ++r)
+  {
+    vectorToParam(q0.col(r), mbc.q);
+    vectorToParam(alpha0.col(r), mbc.alpha);
+    for(int k = 0; k < horizon; ++k)
+    {
+      vectorToParam(torque.col(r * horizon + k), mbc.jointTorque);
+      forwardKinematics(mb, mbc);
+      forwardVelocity(mb, mbc);
+      fd.forwardDynamics(mb, mbc);
+      eulerIntegration(mb, mbc, step);
+
+      int col = r * (horizon + 1) + k + 1;
+      BOOST_CHECK_SMALL((q.col(col) - paramToVector(mb, mbc.q)).norm(), TOL);
+      BOOST_CHECK_SMALL((alpha.col(col) - dofToVector(mb, mbc.alpha)).norm(), TOL);
+    }
+    BOOST_CHECK_EQUAL(q.col(r * (horizon + 1)), q0.col(r));
+  }
+
+  // same trajectories than a serial integrator
+  batch.method(DynamicsIntegrator::RK4);
+  batch.rollout(mb, q0, alpha0, torque, step, q, alpha);
+  DynamicsIntegrator integrator(mb, DynamicsIntegrator::RK4);
+  for(int r = 0; r < nrRollouts; ++r)
+  {
+    vectorToParam(q0.col(r), mbc.q);
+    vectorToParam(alpha0.col(r), mbc.alpha);
+    for(int k = 0; k < horizon; ++k)
+    {
+      vectorToParam(torque.col(r * horizon + k), mbc.jointTorque);
+      integrator.integrate(mb, mbc, step);
+    }
+    int col = r * (horizon + 1) + horizon;
+    BOOST_CHECK_SMALL((q.col(col) - paramToVector(mb, mbc.q)).norm(), TOL);
+    BOOST_CHECK_SMALL((alpha.col(col) - dofToVector(mb, mbc.alpha)).norm(), TOL);
+  }
+
+  MatrixXd badQ(mb.nrParams(), nrRollouts * horizon);
+  BOOST_CHECK_THROW(batch.sRollout(mb, q0, alpha0, torque, step, badQ, alpha), std::domain_error);
+  BOOST_CHECK_THROW(batch.sRollout(mb, q0, alpha0, torque.leftCols(nrRollouts * horizon - 1), step, q, alpha),
+                    std::domain_error);
+  std::tie(mb, mbc, mbg) = makeXYZSarm();
+  BOOST_CHECK_THROW(batch.sRollout(mb, q0, alpha0, torque, step, q, alpha), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(LTDLFactorizationTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  makeRandomConfig(mbc);
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+
+  ForwardDynamics fd(mb);
+  fd.computeH(mb, mbc);
+
+  LTDLFactorization ltdl(mb);
+  ltdl.compute(fd.H());
+
+  // L must keep the branch induced sparsity of H
+  const MatrixXd & LD = ltdl.matrix();
+  for(int i = 0; i < mb.nrDof(); ++i)
+  {
+    std::vector<bool> isAncestor(mb.nrDof(), false);
+    for(int j = ltdl.lambda()[i]; j != -1; j = ltdl.lambda()[j])
+    {
+      isAncestor[j] = true;
+    }
+    for(int j = 0; j < i; ++j)
+    {
+      if(!isAncestor[j])
+      {
+        BOOST_CHECK_EQUAL(fd.H()(i, j), 0.);
+        BOOST_CHECK_EQUAL(LD(i, j), 0.);
+      }
+    }
+  }
+
+  // H = L^T D L
+  MatrixXd L = LD.triangularView<UnitLower>();
+  MatrixXd H = L.transpose() * LD.diagonal().asDiagonal() * L;
+  BOOST_CHECK_SMALL((H - fd.H()).norm(), 1e-10);
+
+  // several right-hand sides
+  MatrixXd b = MatrixXd::Random(mb.nrDof(), 5);
+  MatrixXd x = ltdl.solve(b);
+  BOOST_CHECK_SMALL((fd.H() * x - b).norm(), 1e-8);
+
+  VectorXd v = VectorXd::Random(mb.nrDof());
+  VectorXd vx = v;
+  internal::set_is_malloc_allowed(false);
+  ltdl.solveInPlace(vx);
+  internal::set_is_malloc_allowed(true);
+  BOOST_CHECK_SMALL((fd.H() * vx - v).norm(), 1e-8);
+
+  // H^-1 J^T
+  MatrixXd J = MatrixXd::Random(6, mb.nrDof());
+  MatrixXd HinvJt(mb.nrDof(), 6);
+  ltdl.solveJacobianTranspose(J, HinvJt);
+  BOOST_CHECK_SMALL((fd.H().ldlt().solve(J.transpose()) - HinvJt).norm(), 1e-8);
+
+  // H^-1
+  MatrixXd Hinv(mb.nrDof(), mb.nrDof());
+  internal::set_is_malloc_allowed(false);
+  ltdl.inverse(Hinv);
+  internal::set_is_malloc_allowed(true);
+  BOOST_CHECK_SMALL((fd.H() * Hinv - MatrixXd::Identity(mb.nrDof(), mb.nrDof())).norm(), 1e-8);
+  BOOST_CHECK_SMALL((Hinv - Hinv.transpose()).norm(), 1e-12);
+
+  // D^-1/2 L^-T J^T on the dofs of one arm path and on the union of both arms paths
+  std::vector<int> leftDofs, armsDofs;
+  for(const char * body : {"LARM6", "RARM6"})
+  {
+    for(int j = mb.jointPosInDof(mb.bodyIndexByName(body)); j != -1; j = ltdl.lambda()[j])
+    {
+      armsDofs.push_back(j);
+    }
+    if(leftDofs.empty())
+    {
+      leftDofs = armsDofs;
+    }
+  }
+  std::sort(leftDofs.begin(), leftDofs.end());
+  std::sort(armsDofs.begin(), armsDofs.end());
+  armsDofs.erase(std::unique(armsDofs.begin(), armsDofs.end()), armsDofs.end());
+
+  MatrixXd JLeft = MatrixXd::Zero(3, mb.nrDof());
+  MatrixXd JArms = MatrixXd::Zero(6, mb.nrDof());
+  MatrixXd WLeft(leftDofs.size(), 3);
+  MatrixXd WArms(armsDofs.size(), 6);
+  for(std::size_t k = 0; k < leftDofs.size(); ++k)
+  {
+    JLeft.col(leftDofs[k]).setRandom();
+    WLeft.row(k) = JLeft.col(leftDofs[k]).transpose();
+  }
+  for(std::size_t k = 0; k < armsDofs.size(); ++k)
+  {
+    JArms.col(armsDofs[k]).setRandom();
+    WArms.row(k) = JArms.col(armsDofs[k]).transpose();
+  }
+  ltdl.halfSolveInPlace(leftDofs, WLeft);
+  ltdl.halfSolveInPlace(armsDofs, WArms);
+
+  MatrixXd G(6, 6);
+  LTDLFactorization::sharedDofsProduct(armsDofs, WArms, armsDofs, WArms, G);
+  BOOST_CHECK_SMALL((G - JArms * Hinv * JArms.transpose()).norm(), 1e-8);
+  MatrixXd GCross(3, 6);
+  LTDLFactorization::sharedDofsProduct(leftDofs, WLeft, armsDofs, WArms, GCross);
+  BOOST_CHECK_SMALL((GCross - JLeft * Hinv * JArms.transpose()).norm(), 1e-8);
+
+  for(int model = 0; model < 4; ++model)
+  {
+    switch(model)
+    {
+      case 0:
+        std::tie(mb, mbc, mbg) = makeXYZSarm(true);
+        break;
+      case 1:
+        std::tie(mb, mbc, mbg) = makeTreeArms(3, false);
+        break;
+      case 2:
+        std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+        break;
+      default:
+        std::tie(mb, mbc, mbg) = makeChain(40, false);
+    }
+    ForwardDynamics fdArms(mb);
+    ForwardDynamics::Workspace ws(mb);
+    makeRandomConfig(mbc);
+    forwardKinematics(mb, mbc);
+    fdArms.sComputeHinv(mb, mbc);
+    // the first call allocate the H^-1 buffers of the workspace
+    fdArms.computeHinv(mb, mbc, ws);
+    internal::set_is_malloc_allowed(false);
+    fdArms.computeHinv(mb, mbc, ws);
+    internal::set_is_malloc_allowed(true);
+    fdArms.computeH(mb, mbc);
+    BOOST_CHECK_SMALL((fdArms.Hinv() - fdArms.H().inverse()).norm(), 1e-8);
+    BOOST_CHECK_SMALL((ws.Hinv - fdArms.Hinv()).norm(), 1e-12);
+    BOOST_CHECK_SMALL((fdArms.Hinv() - fdArms.Hinv().transpose()).norm(), 1e-12);
+  }
+
+  BOOST_CHECK_THROW(ltdl.sCompute(MatrixXd::Zero(3, 3)), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(DelassusTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  std::vector<Delassus::Frame> frames = {{"LLEG5", Vector3d(0., -0.1, 0.)},
+                                         {"RLEG5", Vector3d(0., -0.1, 0.)},
+                                         {"LARM6", Vector3d(0., 0.1, 0.)},
+                                         {"RARM6", Vector3d(0.05, 0.1, 0.)},
+                                         {"RARM3", Vector3d::Zero()}};
+
+  ForwardDynamics fd(mb);
+  for(bool linear : {false, true})
+  {
+    Delassus delassus(mb, frames, linear);
+    int rows = delassus.frameRows();
+    BOOST_CHECK_EQUAL(delassus.nrRows(), rows * static_cast<int>(frames.size()));
+
+    for(int i = 0; i < 5; ++i)
+    {
+      makeRandomConfig(mbc);
+      forwardKinematics(mb, mbc);
+      forwardVelocity(mb, mbc);
+
+      // dense reference
+      MatrixXd J(delassus.nrRows(), mb.nrDof());
+      MatrixXd fullJac(6, mb.nrDof());
+      for(std::size_t f = 0; f < frames.size(); ++f)
+      {
+        Jacobian jac(mb, frames[f].bodyName, frames[f].point);
+        jac.fullJacobian(mb, jac.jacobian(mb, mbc), fullJac);
+        J.middleRows(delassus.rowOffset(static_cast<int>(f)), rows) = fullJac.bottomRows(rows);
+      }
+      fd.computeH(mb, mbc);
+      MatrixXd G = J * fd.H().llt().solve(J.transpose());
+
+      BOOST_CHECK_SMALL((delassus.delassus(mb, mbc) - G).norm(), 1e-8);
+
+      // with the factorization of forwardDynamics
+      fd.forwardDynamics(mb, mbc);
+      internal::set_is_malloc_allowed(false);
+      delassus.delassus(mb, mbc, fd.factorization());
+      internal::set_is_malloc_allowed(true);
+      BOOST_CHECK_SMALL((delassus.matrix() - G).norm(), 1e-8);
+
+      if(linear)
+      {
+        BOOST_CHECK_SMALL((delassus.sOperationalSpaceInertia() * G - MatrixXd::Identity(G.rows(), G.cols())).norm(),
+                          1e-6);
+      }
+    }
+  }
+
+  Delassus delassus(mb, frames);
+  std::tie(mb, mbc, mbg) = makeXYZSarm();
+  BOOST_CHECK_THROW(delassus.sDelassus(mb, mbc), std::domain_error);
+
+  // a frame on the fixed root body has a null jacobian and a singular G
+  forwardKinematics(mb, mbc);
+  Delassus singular(mb, {{mb.body(0).name(), Vector3d::Zero()}}, true);
+  singular.sDelassus(mb, mbc);
+  BOOST_CHECK_THROW(singular.sOperationalSpaceInertia(), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(ConstrainedFDTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  makeRandomConfig(mbc);
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+
+  // left foot fixed in world, right foot on a point contact and a closed
+  // loop between the hands
+  std::vector<ConstrainedForwardDynamics::Constraint> constraints = {
+      {"LLEG5", PTransformd(Vector3d(0., -0.1, 0.)), "", PTransformd::Identity(), false},
+      {"RLEG5", PTransformd(Vector3d(0., -0.1, 0.)), "", PTransformd::Identity(), true},
+      {"LARM6", PTransformd(Vector3d(0.1, 0.1, 0.)), "RARM6", PTransformd(Vector3d(-0.1, 0.1, 0.)), true}};
+  constraints[0].X_b2_f2 = constraints[0].X_b1_f1 * mbc.bodyPosW[mb.bodyIndexByName("LLEG5")];
+  constraints[1].X_b2_f2 = constraints[1].X_b1_f1 * mbc.bodyPosW[mb.bodyIndexByName("RLEG5")];
+
+  ConstrainedForwardDynamics cfd(mb, constraints);
+  BOOST_CHECK_EQUAL(cfd.nrRows(), 12);
+  cfd.baumgarte(10., 5.);
+
+  for(int i = 0; i < 5; ++i)
+  {
+    makeRandomConfig(mbc);
+    for(auto & f : mbc.force)
+    {
+      f = ForceVecd(Vector6d::Random());
+    }
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    VectorXd tau = VectorXd::Random(mb.nrDof());
+    vectorToParam(tau, mbc.jointTorque);
+
+    cfd.forwardDynamics(mb, mbc);
+    VectorXd alphaD = dofToVector(mb, mbc.alphaD);
+
+    // dense KKT system
+    ForwardDynamics fd(mb);
+    fd.computeH(mb, mbc);
+    fd.computeC(mb, mbc);
+    const MatrixXd & J = cfd.jacobian();
+    int n = mb.nrDof(), m = cfd.nrRows();
+    MatrixXd K = MatrixXd::Zero(n + m, n + m);
+    K.topLeftCorner(n, n) = fd.H();
+    K.topRightCorner(n, m) = -J.transpose();
+    K.bottomLeftCorner(m, n) = J;
+    VectorXd rhs(n + m);
+    rhs << tau - fd.C(), cfd.constraintAcceleration();
+    VectorXd sol = K.partialPivLu().solve(rhs);
+
+    BOOST_CHECK_SMALL((alphaD - sol.head(n)).norm(), 1e-6);
+    BOOST_CHECK_SMALL((cfd.constraintForces() - sol.tail(m)).norm(), 1e-6);
+    BOOST_CHECK_SMALL((cfd.schurComplement() - J * fd.H().llt().solve(J.transpose())).norm(), 1e-8);
+    BOOST_CHECK_SMALL((J * alphaD - cfd.constraintAcceleration()).norm(), 1e-8);
+
+    // new right-hand side with the cached factorization
+    VectorXd tau2 = VectorXd::Random(n);
+    VectorXd gamma2 = VectorXd::Random(m);
+    VectorXd alphaD2(n);
+    internal::set_is_malloc_allowed(false);
+    cfd.solve(tau2, gamma2, alphaD2);
+    internal::set_is_malloc_allowed(true);
+    BOOST_CHECK_SMALL((fd.H() * alphaD2 + fd.C() - tau2 - J.transpose() * cfd.constraintForces()).norm(), 1e-8);
+    BOOST_CHECK_SMALL((J * alphaD2 - gamma2).norm(), 1e-8);
+  }
+
+  // without stabilization J alpha is constant (check the JDot alpha term)
+  cfd.baumgarte(0., 0.);
+  const double h = 1e-7;
+  makeRandomConfig(mbc);
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+  cfd.forwardDynamics(mb, mbc);
+  VectorXd velocity = cfd.constraintVelocity();
+  eulerIntegration(mb, mbc, h);
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+  cfd.factorize(mb, mbc);
+  BOOST_CHECK_SMALL((cfd.constraintVelocity() - velocity).norm() / h, 1e-3);
+
+  VectorXd alphaD(mb.nrDof());
+  BOOST_CHECK_THROW(cfd.sSolve(VectorXd::Zero(3), cfd.constraintAcceleration(), alphaD), std::domain_error);
+  std::tie(mb, mbc, mbg) = makeXYZSarm();
+  BOOST_CHECK_THROW(cfd.sForwardDynamics(mb, mbc), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(ConstrainedFDBaumgarteTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  makeRandomConfig(mbc);
+  for(auto & a : mbc.alpha)
+  {
+    for(auto & v : a)
+    {
+      v *= 0.1;
+    }
+  }
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+
+  // the constraints targets are moved away from the initial configuration
+  std::vector<ConstrainedForwardDynamics::Constraint> constraints = {
+      {"LLEG5", PTransformd::Identity(), "", PTransformd::Identity(), false},
+      {"LARM6", PTransformd(Vector3d(0.1, 0.1, 0.)), "RARM6", PTransformd(Vector3d(-0.1, 0.1, 0.)), true}};
+  constraints[0].X_b2_f2 =
+      PTransformd(RotZ(0.05), Vector3d(0.01, 0., -0.02)) * mbc.bodyPosW[mb.bodyIndexByName("LLEG5")];
+
+  ConstrainedForwardDynamics cfd(mb, constraints);
+  cfd.baumgarte(400., 40.);
+  cfd.factorize(mb, mbc);
+  double error0 = cfd.constraintError().norm();
+
+  const double step = 1e-3;
+  for(int i = 0; i < 1000; ++i)
+  {
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    cfd.forwardDynamics(mb, mbc);
+    eulerIntegration(mb, mbc, step);
+  }
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+  cfd.factorize(mb, mbc);
+
+  BOOST_CHECK_GT(error0, 1e-2);
+  // the remaining error come from the Euler integration drift
+  BOOST_CHECK_SMALL(cfd.constraintError().norm(), 1e-2 * error0);
+  BOOST_CHECK_SMALL(cfd.constraintVelocity().norm(), 5e-2);
+}
+
+Eigen::VectorXd computeTorque(const rbd::MultiBody & mb, rbd::MultiBodyConfig & mbc)
+{
+  rbd::InverseDynamics id(mb);
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  id.inverseDynamics(mb, mbc);
+  return rbd::dofToVector(mb, mbc.jointTorque);
+}
+
+void testIDDerivatives(const rbd::MultiBody & mb, rbd::MultiBodyConfig & mbc)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  const double h = 1e-6;
+
+  makeRandomConfig(mbc);
+  for(auto & f : mbc.force)
+  {
+    f = ForceVecd(Vector6d::Random());
+  }
+
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+  InverseDynamicsDerivatives idd(mb);
+  idd.sComputeDerivatives(mb, mbc);
+
+  MultiBodyConfig mbcRef(mbc);
+  BOOST_CHECK_SMALL((dofToVector(mb, mbc.jointTorque) - computeTorque(mb, mbcRef)).norm(), TOL);
+
+  MatrixXd dtau_dq(mb.nrDof(), mb.nrDof());
+  MatrixXd dtau_dalpha(mb.nrDof(), mb.nrDof());
+  MatrixXd dtau_dalphaD(mb.nrDof(), mb.nrDof());
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    for(int j = 0; j < mb.joint(i).dof(); ++j)
+    {
+      int col = mb.jointPosInDof(i) + j;
+      std::vector<double> dir(mb.joint(i).dof(), 0.);
+      std::vector<double> zero(mb.joint(i).dof(), 0.);
+      dir[j] = 1.;
+
+      // q derivative along the joint tangent space
+      MultiBodyConfig mbcP(mbc), mbcM(mbc);
+      eulerJointIntegration(mb.joint(i).type(), dir, zero, h, mbcP.q[i]);
+      eulerJointIntegration(mb.joint(i).type(), dir, zero, -h, mbcM.q[i]);
+      dtau_dq.col(col) = (computeTorque(mb, mbcP) - computeTorque(mb, mbcM)) / (2. * h);
+
+      mbcP = mbc;
+      mbcM = mbc;
+      mbcP.alpha[i][j] += h;
+      mbcM.alpha[i][j] -= h;
+      dtau_dalpha.col(col) = (computeTorque(mb, mbcP) - computeTorque(mb, mbcM)) / (2. * h);
+
+      mbcP = mbc;
+      mbcM = mbc;
+      mbcP.alphaD[i][j] += h;
+      mbcM.alphaD[i][j] -= h;
+      dtau_dalphaD.col(col) = (computeTorque(mb, mbcP) - computeTorque(mb, mbcM)) / (2. * h);
+    }
+  }
+
+  BOOST_CHECK_SMALL((idd.dtau_dq() - dtau_dq).norm() / dtau_dq.norm(), 1e-6);
+  BOOST_CHECK_SMALL((idd.dtau_dalpha() - dtau_dalpha).norm() / dtau_dalpha.norm(), 1e-6);
+  BOOST_CHECK_SMALL((idd.dtau_dalphaD() - dtau_dalphaD).norm() / dtau_dalphaD.norm(), 1e-6);
+
+  // dtau/dalphaD is the inertia matrix
+  ForwardDynamics fd(mb);
+  fd.computeH(mb, mbc);
+  BOOST_CHECK_SMALL((idd.dtau_dalphaD() - fd.H()).norm(), TOL);
+}
+
+BOOST_AUTO_TEST_CASE(IDDerivativesTest)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+
+  std::tie(mb, mbc, mbg) = makeXYZSarm(true);
+  testIDDerivatives(mb, mbc);
+
+  std::tie(mb, mbc, mbg) = makeXYZSarm(false);
+  testIDDerivatives(mb, mbc);
+
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+  testIDDerivatives(mb, mbc);
+
+  rbd::InverseDynamicsDerivatives idd(mb);
+  std::tie(mb, mbc, mbg) = makeXYZSarm(true);
+  BOOST_CHECK_THROW(idd.sComputeDerivatives(mb, mbc), std::domain_error);
+}
+
+Eigen::VectorXd computeAlphaD(const rbd::MultiBody & mb, rbd::MultiBodyConfig & mbc)
+{
+  rbd::ForwardDynamics fd(mb);
+  rbd::forwardKinematics(mb, mbc);
+  rbd::forwardVelocity(mb, mbc);
+  fd.forwardDynamics(mb, mbc);
+  return rbd::dofToVector(mb, mbc.alphaD);
+}
+
+void testFDDerivatives(const rbd::MultiBody & mb, rbd::MultiBodyConfig & mbc)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  const double h = 1e-6;
+
+  makeRandomConfig(mbc);
+  for(auto & f : mbc.force)
+  {
+    f = ForceVecd(Vector6d::Random());
+  }
+
+  forwardKinematics(mb, mbc);
+  forwardVelocity(mb, mbc);
+  // the factorization is taken from a user workspace, fd own one is never computed
+  ForwardDynamics fd(mb);
+  ForwardDynamics::Workspace ws(mb);
+  fd.forwardDynamics(mb, mbc, ws);
+  VectorXd torque = dofToVector(mb, mbc.jointTorque);
+
+  ForwardDynamicsDerivatives fdd(mb);
+  fdd.sComputeDerivatives(mb, mbc, ws.ltdl);
+  BOOST_CHECK_SMALL((dofToVector(mb, mbc.jointTorque) - torque).norm(), 1e-8);
+
+  MatrixXd dalphaD_dq(mb.nrDof(), mb.nrDof());
+  MatrixXd dalphaD_dalpha(mb.nrDof(), mb.nrDof());
+  MatrixXd dalphaD_dtau(mb.nrDof(), mb.nrDof());
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    for(int j = 0; j < mb.joint(i).dof(); ++j)
+    {
+      int col = mb.jointPosInDof(i) + j;
+      std::vector<double> dir(mb.joint(i).dof(), 0.);
+      std::vector<double> zero(mb.joint(i).dof(), 0.);
+      dir[j] = 1.;
+
+      MultiBodyConfig mbcP(mbc), mbcM(mbc);
+      eulerJointIntegration(mb.joint(i).type(), dir, zero, h, mbcP.q[i]);
+      eulerJointIntegration(mb.joint(i).type(), dir, zero, -h, mbcM.q[i]);
+      dalphaD_dq.col(col) = (computeAlphaD(mb, mbcP) - computeAlphaD(mb, mbcM)) / (2. * h);
+
+      mbcP = mbc;
+      mbcM = mbc;
+      mbcP.alpha[i][j] += h;
+      mbcM.alpha[i][j] -= h;
+      dalphaD_dalpha.col(col) = (computeAlphaD(mb, mbcP) - computeAlphaD(mb, mbcM)) / (2. * h);
+
+      mbcP = mbc;
+      mbcM = mbc;
+      mbcP.jointTorque[i][j] += h;
+      mbcM.jointTorque[i][j] -= h;
+      dalphaD_dtau.col(col) = (computeAlphaD(mb, mbcP) - computeAlphaD(mb, mbcM)) / (2. * h);
+    }
+  }
+
+  BOOST_CHECK_SMALL((fdd.dalphaD_dq() - dalphaD_dq).norm() / dalphaD_dq.norm(), 1e-6);
+  BOOST_CHECK_SMALL((fdd.dalphaD_dalpha() - dalphaD_dalpha).norm() / dalphaD_dalpha.norm(), 1e-6);
+  BOOST_CHECK_SMALL((fdd.dalphaD_dtau() - dalphaD_dtau).norm() / dalphaD_dtau.norm(), 1e-6);
+  BOOST_CHECK_SMALL((fdd.dalphaD_dtau() * ws.H - MatrixXd::Identity(mb.nrDof(), mb.nrDof())).norm(), 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(FDDerivativesTest)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+
+  std::tie(mb, mbc, mbg) = makeXYZSarm(true);
+  testFDDerivatives(mb, mbc);
+
+  std::tie(mb, mbc, mbg) = makeXYZSarm(false);
+  testFDDerivatives(mb, mbc);
+
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+  testFDDerivatives(mb, mbc);
+
+  rbd::ForwardDynamics fd(mb);
+  rbd::ForwardDynamicsDerivatives fdd(mb);
+  std::tie(mb, mbc, mbg) = makeXYZSarm(true);
+  BOOST_CHECK_THROW(fdd.sComputeDerivatives(mb, mbc, fd.factorization()), std::domain_error);
+  rbd::ForwardDynamicsDerivatives fddArm(mb);
+  BOOST_CHECK_THROW(fddArm.sComputeDerivatives(mb, mbc, rbd::LTDLFactorization()), std::domain_error);
+}
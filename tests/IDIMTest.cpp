@@ -4,6 +4,7 @@
 
 // includes
 // std
+#include <algorithm>
 #include <iostream>
 
 // boost
@@ -128,3 +129,199 @@ BOOST_AUTO_TEST_CASE(computeY)
     BOOST_CHECK_SMALL((idTorque - idimTorque).norm(), 1e-8);
   }
 }
+
+BOOST_AUTO_TEST_CASE(computeCompactY)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  InverseDynamics id(mb);
+  IDIM idim(mb);
+
+  VectorXd inertiaVec(multiBodyToInertialVector(mb));
+  VectorXd tau(mb.nrDof()), r(mb.nrDof());
+  VectorXd YTr(10 * mb.nrBodies());
+
+  for(int i = 0; i < 50; ++i)
+  {
+    vectorToParam(VectorXd::Random(mb.nrParams()) * 4., mbc.q);
+    vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alpha);
+    vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alphaD);
+
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    // fill bodyAccB with the gravity
+    id.inverseDynamics(mb, mbc);
+
+    idim.computeY(mb, mbc);
+    idim.sComputeCompactY(mb, mbc);
+    const MatrixXd & Y = idim.Y();
+
+    // the expanded compact matrix must match the dense one
+    MatrixXd YExp(MatrixXd::Zero(mb.nrDof(), 10 * mb.nrBodies()));
+    for(int b = 0; b < mb.nrBodies(); ++b)
+    {
+      for(const rbd::Block & bl : idim.compactPaths()[b])
+      {
+        YExp.block(bl.startDof, 10 * b, bl.length, 10) = idim.compactY()[b].middleRows(bl.startJac, bl.length);
+      }
+    }
+    BOOST_CHECK_SMALL((YExp - Y).norm(), 1e-10);
+
+    idim.sYTimes(inertiaVec, tau);
+    BOOST_CHECK_SMALL((tau - dofToVector(mb, mbc.jointTorque)).norm(), 1e-8);
+
+    r.setRandom();
+    idim.sYTransposeTimes(r, YTr);
+    BOOST_CHECK_SMALL((YTr - Y.transpose() * r).norm(), 1e-10);
+  }
+
+  BOOST_CHECK_THROW(idim.sYTimes(VectorXd::Zero(10 * mb.nrBodies() + 1), tau), std::domain_error);
+  BOOST_CHECK_THROW(idim.sYTransposeTimes(VectorXd::Zero(mb.nrDof() + 1), YTr), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(IDIMAccumulatorTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  InverseDynamics id(mb);
+  IDIM idim(mb);
+  IDIMAccumulator acc(mb), acc1(mb), acc2(mb), accFast(mb);
+  acc.forgettingFactor(0.9);
+  // force several rescaling of the accumulated sums
+  accFast.forgettingFactor(0.1);
+
+  const int nrParams = 10 * mb.nrBodies();
+  MatrixXd YTY(MatrixXd::Zero(nrParams, nrParams)), YTYFull(MatrixXd::Zero(nrParams, nrParams));
+  MatrixXd YTYFast(MatrixXd::Zero(nrParams, nrParams));
+  VectorXd YTtau(VectorXd::Zero(nrParams)), YTtauFull(VectorXd::Zero(nrParams));
+  double tauTtau = 0.;
+
+  for(int i = 0; i < 150; ++i)
+  {
+    vectorToParam(VectorXd::Random(mb.nrParams()) * 4., mbc.q);
+    vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alpha);
+    vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alphaD);
+
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+    // fill bodyAccB with the gravity
+    id.inverseDynamics(mb, mbc);
+    // measured torque
+    vectorToParam(dofToVector(mb, mbc.jointTorque) + VectorXd::Random(mb.nrDof()), mbc.jointTorque);
+
+    idim.computeY(mb, mbc);
+    const MatrixXd & Y = idim.Y();
+    VectorXd tau = dofToVector(mb, mbc.jointTorque);
+    double w = 0.5 + i % 3;
+
+    YTY = 0.9 * YTY + w * Y.transpose() * Y;
+    YTtau = 0.9 * YTtau + w * Y.transpose() * tau;
+    tauTtau = 0.9 * tauTtau + w * tau.squaredNorm();
+    YTYFull += w * Y.transpose() * Y;
+    YTtauFull += w * Y.transpose() * tau;
+    YTYFast = 0.1 * YTYFast + w * Y.transpose() * Y;
+
+    acc.sAddSample(mb, mbc, w);
+    (i % 2 == 0 ? acc1 : acc2).sAddSample(mb, Y, tau, w);
+    accFast.addSample(mb, Y, tau, w);
+  }
+
+  BOOST_CHECK_EQUAL(acc.nrSamples(), 150);
+  BOOST_CHECK_SMALL((acc.YTY() - YTY).norm() / YTY.norm(), 1e-12);
+  BOOST_CHECK_SMALL((acc.YTtau() - YTtau).norm() / YTtau.norm(), 1e-12);
+  BOOST_CHECK_SMALL(std::abs(acc.tauTtau() - tauTtau) / tauTtau, 1e-12);
+  BOOST_CHECK_SMALL((accFast.YTY() - YTYFast).norm() / YTYFast.norm(), 1e-12);
+
+  acc1.sMerge(acc2);
+  BOOST_CHECK_EQUAL(acc1.nrSamples(), 150);
+  BOOST_CHECK_SMALL((acc1.YTY() - YTYFull).norm() / YTYFull.norm(), 1e-12);
+  BOOST_CHECK_SMALL((acc1.YTtau() - YTtauFull).norm() / YTtauFull.norm(), 1e-12);
+
+  acc1.reset();
+  BOOST_CHECK_EQUAL(acc1.nrSamples(), 0);
+  BOOST_CHECK_EQUAL(acc1.YTY().norm(), 0.);
+
+  BOOST_CHECK_THROW(acc.sAddSample(mb, MatrixXd::Zero(mb.nrDof(), nrParams + 1), VectorXd::Zero(mb.nrDof())),
+                    std::domain_error);
+  BOOST_CHECK_THROW(acc.sAddSample(mb, MatrixXd::Zero(mb.nrDof(), nrParams), VectorXd::Zero(mb.nrDof() + 1)),
+                    std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(IDIMBaseParametersTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  for(bool isFixed : {true, false})
+  {
+    MultiBody mb;
+    MultiBodyConfig mbc;
+    MultiBodyGraph mbg;
+    std::tie(mb, mbc, mbg) = makeTree30Dof(isFixed);
+
+    std::vector<Body> newB;
+    for(const Body & b : mb.bodies())
+    {
+      newB.push_back(Body(randomInertia(), b.name()));
+    }
+    mb = MultiBody(newB, mb.joints(), mb.predecessors(), mb.successors(), mb.parents(), mb.transforms());
+
+    InverseDynamics id(mb);
+    IDIM idim(mb);
+    IDIMBaseParameters base(mb, mbc.gravity);
+
+    const int nrParams = 10 * mb.nrBodies();
+    const int nrBase = base.nrBaseParameters();
+    BOOST_CHECK_GT(nrBase, 0);
+    BOOST_CHECK_LT(nrBase, nrParams);
+    BOOST_CHECK_EQUAL(base.baseMap().rows(), nrBase);
+    BOOST_CHECK(std::is_sorted(base.baseIndices().begin(), base.baseIndices().end()));
+
+    // the rank don't depend on the base map cleaning
+    IDIMBaseParameters rawBase(mb, mbc.gravity, 0, 1e-8, 0.);
+    BOOST_CHECK_EQUAL(rawBase.nrBaseParameters(), nrBase);
+
+    VectorXd phiB = base.sBaseParameters(mb);
+    VectorXd idTorque(mb.nrDof());
+
+    for(int i = 0; i < 20; ++i)
+    {
+      vectorToParam(VectorXd::Random(mb.nrParams()) * 4., mbc.q);
+      vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alpha);
+      vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alphaD);
+
+      forwardKinematics(mb, mbc);
+      forwardVelocity(mb, mbc);
+      id.inverseDynamics(mb, mbc);
+
+      idim.computeY(mb, mbc);
+      base.sComputeBaseY(mb, mbc);
+      const MatrixXd & Y = idim.Y();
+      const MatrixXd & Yb = base.baseY();
+
+      for(int l = 0; l < nrBase; ++l)
+      {
+        BOOST_CHECK_SMALL((Yb.col(l) - Y.col(base.baseIndices()[l])).norm(), 1e-10);
+      }
+      BOOST_CHECK_SMALL((Y - Yb * base.baseMap()).norm() / Y.norm(), 1e-8);
+
+      paramToVector(mbc.jointTorque, idTorque);
+      BOOST_CHECK_SMALL((idTorque - Yb * phiB).norm() / idTorque.norm(), 1e-8);
+    }
+  }
+}
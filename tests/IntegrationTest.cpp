@@ -17,7 +17,10 @@
 
 // RBDyn
 #include "RBDyn/Body.h"
+#include "RBDyn/CoM.h"
+#include "RBDyn/DynamicsIntegration.h"
 #include "RBDyn/EulerIntegration.h"
+#include "RBDyn/FD.h"
 #include "RBDyn/FK.h"
 #include "RBDyn/FV.h"
 #include "RBDyn/Joint.h"
@@ -25,6 +28,9 @@
 #include "RBDyn/MultiBodyConfig.h"
 #include "RBDyn/MultiBodyGraph.h"
 
+// arm
+#include "Tree30Dof.h"
+
 using namespace Eigen;
 using namespace sva;
 using namespace rbd;
@@ -187,7 +193,8 @@ BOOST_AUTO_TEST_CASE(JointIntegrationTest)
   testConstantSpeedIntegration(Joint::Prism, 1, {1}, {0.5}, {1.5});
   testConstantSpeedIntegration(Joint::Spherical, 1, {1, 0, 0, 0}, {pi / 2, 0, 0}, {c2, c2, 0, 0});
   testConstantSpeedIntegration(Joint::Spherical, 1, {c2, 0, c2, 0}, {pi / 2, 0, 0}, {0.5, 0.5, 0.5, -0.5});
-  // testConstantSpeedIntegration(Joint::Planar, 1, { 1 }, { 0.5 }, { 1.5 });
+  testConstantSpeedIntegration(Joint::Planar, 1, {1, 1, 2}, {0, 0.5, 0.25}, {1, 1.5, 2.25});
+  testConstantSpeedIntegration(Joint::Planar, 1, {0.5, 1, 1}, {pi / 2, 0, 0}, {0.5 + pi / 2, 1, -1});
   testConstantSpeedIntegration(Joint::Cylindrical, 1, {1, 2}, {0.5, 0.25}, {1.5, 2.25});
   testConstantSpeedIntegration(Joint::Free, 1, {1, 0, 0, 0, 1, 2, 3}, {pi / 2, 0, 0, 0.5, 0.25, -0.5},
                                {c2, c2, 0, 0, 1.5, 2.25, 2.5});
@@ -201,10 +208,135 @@ BOOST_AUTO_TEST_CASE(JointIntegrationTest)
   testConstantAccelerationIntegration(Joint::Prism, 1, q, v, a);
   std::tie(q, v, a) = randQVA(Joint::Spherical);
   testConstantAccelerationIntegration(Joint::Spherical, 0.01, q, v, a);
-  // std::tie(q, v, a) = randQVA(Joint::Planar);
-  // testConstantAccelerationIntegration(Joint::Planar, 1, q, v, a);
   std::tie(q, v, a) = randQVA(Joint::Cylindrical);
   testConstantAccelerationIntegration(Joint::Cylindrical, 1, q, v, a);
   std::tie(q, v, a) = randQVA(Joint::Free);
   testConstantAccelerationIntegration(Joint::Free, 0.01, q, v, a);
+  std::tie(q, v, a) = randQVA(Joint::Planar);
+  testConstantAccelerationIntegration(Joint::Planar, 0.1, q, v, a);
+}
+
+/// @return Kinetic plus potential energy of mbc (q and alpha).
+double energy(const MultiBody & mb, MultiBodyConfig & mbc)
+{
+  forwardKinematics(mb, mbc);
+  ForwardDynamics fd(mb);
+  fd.computeH(mb, mbc);
+  VectorXd alpha = dofToVector(mb, mbc.alpha);
+  double mass = 0.;
+  for(const Body & b : mb.bodies())
+  {
+    mass += b.inertia().mass();
+  }
+  // gravity is the acceleration of the base, opposed to the gravity field
+  return 0.5 * alpha.dot(fd.H() * alpha) + mass * mbc.gravity.dot(computeCoM(mb, mbc));
+}
+
+/// Integrate the configuration mbc0 during nrSteps.
+MultiBodyConfig simulate(const MultiBody & mb,
+                         const MultiBodyConfig & mbc0,
+                         DynamicsIntegrator::Method method,
+                         double step,
+                         int nrSteps)
+{
+  DynamicsIntegrator integrator(mb, method);
+  MultiBodyConfig mbc(mbc0);
+  for(int i = 0; i < nrSteps; ++i)
+  {
+    integrator.sIntegrate(mb, mbc, step);
+  }
+  return mbc;
+}
+
+BOOST_AUTO_TEST_CASE(DynamicsIntegratorOrderTest)
+{
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(true);
+
+  mbc.q = vectorToParam(mb, 0.5 * VectorXd::Random(mb.nrParams()));
+  mbc.alpha = vectorToDof(mb, VectorXd::Random(mb.nrDof()));
+  mbc.jointTorque = vectorToDof(mb, VectorXd::Random(mb.nrDof()));
+
+  const double duration = 0.08;
+  const int nrSteps = 8;
+  MultiBodyConfig ref = simulate(mb, mbc, DynamicsIntegrator::RK4, duration / (64 * nrSteps), 64 * nrSteps);
+  VectorXd qRef = paramToVector(mb, ref.q);
+
+  // halving the step divide the error by 2^order
+  std::vector<std::pair<DynamicsIntegrator::Method, double>> methods = {{DynamicsIntegrator::SemiImplicitEuler, 1.5},
+                                                                        {DynamicsIntegrator::StormerVerlet, 3.},
+                                                                        {DynamicsIntegrator::RK4, 10.}};
+  for(const auto & m : methods)
+  {
+    MultiBodyConfig mbc1 = simulate(mb, mbc, m.first, duration / nrSteps, nrSteps);
+    MultiBodyConfig mbc2 = simulate(mb, mbc, m.first, duration / (2 * nrSteps), 2 * nrSteps);
+    double err1 = (paramToVector(mb, mbc1.q) - qRef).norm();
+    double err2 = (paramToVector(mb, mbc2.q) - qRef).norm();
+    BOOST_CHECK_GT(err1 / err2, m.second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DynamicsIntegratorEnergyTest)
+{
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  VectorXd q(0.5 * VectorXd::Random(mb.nrParams()));
+  q.head<4>().normalize();
+  mbc.q = vectorToParam(mb, q);
+  mbc.alpha = vectorToDof(mb, VectorXd::Random(mb.nrDof()));
+  double e0 = energy(mb, mbc);
+
+  // no torque, the energy is conserved
+  for(DynamicsIntegrator::Method m :
+      {DynamicsIntegrator::SemiImplicitEuler, DynamicsIntegrator::StormerVerlet, DynamicsIntegrator::RK4})
+  {
+    MultiBodyConfig mbcEnd = simulate(mb, mbc, m, 1e-3, 200);
+    BOOST_CHECK_SMALL((energy(mb, mbcEnd) - e0) / std::abs(e0), m == DynamicsIntegrator::RK4 ? 1e-6 : 1e-2);
+    BOOST_CHECK_SMALL(paramToVector(mb, mbcEnd.q).head<4>().norm() - 1., 1e-12);
+  }
+
+  DynamicsIntegrator integrator(mb);
+  MultiBodyConfig mbcWrong(mbc);
+  mbcWrong.jointTorque.pop_back();
+  BOOST_CHECK_THROW(integrator.sIntegrate(mb, mbcWrong, 1e-3), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(DynamicsIntegratorReverseJointTest)
+{
+  // chain of reverse joints, the joints velocity must be mapped to the
+  // configuration derivative of the forward joint
+  MultiBodyGraph mbg;
+  RBInertiad rbi(1., Vector3d(0.1, 0.2, -0.1), Vector3d(0.3, 0.2, 0.4).asDiagonal());
+  std::vector<Joint> joints = {Joint(Joint::Free, false, "j0"),
+                               Joint(Joint::Spherical, false, "j1"),
+                               Joint(Joint::Planar, false, "j2"),
+                               Joint(Joint::RevX, false, "j3"),
+                               Joint(Joint::PrismY, false, "j4"),
+                               Joint(Joint::Cylindrical, Vector3d::UnitZ(), false, "j5")};
+  mbg.addBody(Body(rbi, "b0"));
+  for(std::size_t i = 0; i < joints.size(); ++i)
+  {
+    mbg.addBody(Body(rbi, "b" + std::to_string(i + 1)));
+    mbg.addJoint(joints[i]);
+    mbg.linkBodies("b" + std::to_string(i), PTransformd(Vector3d(0., 0.5, 0.1)), "b" + std::to_string(i + 1),
+                   PTransformd(Vector3d(0.2, -0.5, 0.)), joints[i].name());
+  }
+  MultiBody mb = mbg.makeMultiBody("b0", true);
+  MultiBodyConfig mbc(mb);
+  mbc.zero(mb);
+
+  VectorXd q(0.5 * VectorXd::Random(mb.nrParams()));
+  q.segment<4>(mb.jointPosInParam(1)).normalize();
+  q.segment<4>(mb.jointPosInParam(2)).normalize();
+  mbc.q = vectorToParam(mb, q);
+  mbc.alpha = vectorToDof(mb, VectorXd::Random(mb.nrDof()));
+  double e0 = energy(mb, mbc);
+
+  MultiBodyConfig mbcEnd = simulate(mb, mbc, DynamicsIntegrator::RK4, 1e-3, 200);
+  BOOST_CHECK_SMALL((energy(mb, mbcEnd) - e0) / std::abs(e0), 1e-6);
 }
@@ -15,6 +15,7 @@
 #include "RBDyn/MultiBody.h"
 #include "RBDyn/MultiBodyConfig.h"
 #include "RBDyn/MultiBodyGraph.h"
+#include "RBDyn/MultiFrameJacobian.h"
 
 // Arm
 #include "Tree30Dof.h"
@@ -233,4 +234,95 @@ static void BM_MomentumJacobian_jacobianDot(benchmark::State & state)
 }
 BENCHMARK(BM_MomentumJacobian_jacobianDot);
 
+static void BM_JacobianTransposeFull(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::Jacobian jac(mb, "LARM6");
+  Eigen::MatrixXd full(6, mb.nrDof());
+  Eigen::VectorXd tau(mb.nrDof());
+  Eigen::Vector6d f(Eigen::Vector6d::Random());
+
+  rbd::forwardKinematics(mb, mbc);
+
+  for(auto _ : state)
+  {
+    jac.fullJacobian(mb, jac.jacobian(mb, mbc), full);
+    tau.noalias() = full.transpose() * f;
+  }
+}
+BENCHMARK(BM_JacobianTransposeFull);
+
+static void BM_JacobianTransposeTimes(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::Jacobian jac(mb, "LARM6");
+  Eigen::VectorXd tau(mb.nrDof());
+  sva::ForceVecd f(Eigen::Vector6d::Random());
+
+  rbd::forwardKinematics(mb, mbc);
+
+  for(auto _ : state)
+  {
+    jac.jacobianTransposeTimes(mb, mbc, f, tau);
+  }
+}
+BENCHMARK(BM_JacobianTransposeTimes);
+
+static const std::vector<std::string> multiFrames = {"LARM6", "RARM6", "LLEG5", "RLEG5", "LARM3", "RARM3",
+                                                      "LLEG2", "RLEG2", "HEAD0", "TORSO"};
+
+static void BM_JacobianFrames(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  std::vector<rbd::Jacobian> jacs;
+  for(const std::string & n : multiFrames)
+  {
+    jacs.emplace_back(mb, n);
+  }
+  Eigen::MatrixXd J(Eigen::MatrixXd::Zero(6 * jacs.size(), mb.nrDof()));
+  Eigen::MatrixXd full(6, mb.nrDof());
+
+  rbd::forwardKinematics(mb, mbc);
+
+  for(auto _ : state)
+  {
+    for(std::size_t k = 0; k < jacs.size(); ++k)
+    {
+      jacs[k].fullJacobian(mb, jacs[k].jacobian(mb, mbc), full);
+      J.middleRows<6>(6 * k) = full;
+    }
+  }
+}
+BENCHMARK(BM_JacobianFrames);
+
+static void BM_MultiFrameJacobian(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::MultiFrameJacobian mfj(mb, multiFrames);
+
+  rbd::forwardKinematics(mb, mbc);
+
+  for(auto _ : state)
+  {
+    mfj.jacobian(mb, mbc);
+  }
+}
+BENCHMARK(BM_MultiFrameJacobian);
+
 BENCHMARK_MAIN()
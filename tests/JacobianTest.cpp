@@ -25,9 +25,12 @@
 #include "RBDyn/MultiBody.h"
 #include "RBDyn/MultiBodyConfig.h"
 #include "RBDyn/MultiBodyGraph.h"
+#include "RBDyn/MultiFrameJacobian.h"
+#include "RBDyn/SparseJacobian.h"
 
 // Arm
 #include "SSSarm.h"
+#include "Tree30Dof.h"
 #include "XYZSarm.h"
 
 const double TOL = 0.0000001;
@@ -389,6 +392,8 @@ Eigen::MatrixXd makeJDotFromStep(const rbd::MultiBody & mb,
 
 typedef const Eigen::MatrixXd & (rbd::Jacobian::*worldJacobian_t)(const rbd::MultiBody &, const rbd::MultiBodyConfig &);
 typedef sva::MotionVecd (rbd::Jacobian::*worldVelocity_t)(const rbd::MultiBody &, const rbd::MultiBodyConfig &) const;
+typedef const Eigen::MatrixXd & (rbd::Jacobian::*jacobianMethod_t)(const rbd::MultiBody &,
+                                                                   const rbd::MultiBodyConfig &);
 
 void testJacobianDot(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc, rbd::Jacobian & jac)
 {
@@ -400,7 +405,8 @@ void testJacobianDot(const rbd::MultiBody & mb, const rbd::MultiBodyConfig & mbc
 
   BOOST_CHECK_SMALL((JD_diff - JD).norm(), 2e-5);
 
-  MatrixXd JD_diff_b = makeJDotFromStep(mb, mbc, std::bind(&rbd::Jacobian::bodyJacobian, jac, _1, _2));
+  MatrixXd JD_diff_b =
+      makeJDotFromStep(mb, mbc, std::bind(jacobianMethod_t(&rbd::Jacobian::bodyJacobian), jac, _1, _2));
   MatrixXd JD_b = jac.bodyJacobianDot(mb, mbc);
 
   BOOST_CHECK_SMALL((JD_diff_b - JD_b).norm(), 2e-5);
@@ -758,38 +764,42 @@ BOOST_AUTO_TEST_CASE(JacobianVectorVelAccComputeTest)
               .norm(),
           TOL);
 
-      BOOST_CHECK_SMALL(testMatrixAgainstVector(mb, mbc, jac, std::bind(&Jacobian::bodyJacobian, std::ref(jac), _1, _2),
-                                                alpha, std::bind(&Jacobian::bodyVelocity, std::ref(jac), _1, _2))
-                            .norm(),
-                        TOL);
+      BOOST_CHECK_SMALL(
+          testMatrixAgainstVector(mb, mbc, jac,
+                                  std::bind(jacobianMethod_t(&Jacobian::bodyJacobian), std::ref(jac), _1, _2), alpha,
+                                  std::bind(&Jacobian::bodyVelocity, std::ref(jac), _1, _2))
+              .norm(),
+          TOL);
 
       typedef MotionVecd (Jacobian::*normalAccel_func1)(const MultiBody &, const MultiBodyConfig &) const;
       typedef MotionVecd (Jacobian::*normalAccel_func2)(const MultiBody &, const MultiBodyConfig &,
                                                         const std::vector<sva::MotionVecd> &) const;
 
-      BOOST_CHECK_SMALL(testMatrixAgainstVector(mb, mbc, jac, std::bind(&Jacobian::jacobianDot, std::ref(jac), _1, _2),
-                                                alpha,
-                                                std::bind(static_cast<normalAccel_func1>(&Jacobian::normalAcceleration),
-                                                          std::ref(jac), _1, _2))
-                            .norm(),
-                        TOL);
+      BOOST_CHECK_SMALL(
+          testMatrixAgainstVector(
+              mb, mbc, jac, std::bind(jacobianMethod_t(&Jacobian::jacobianDot), std::ref(jac), _1, _2), alpha,
+              std::bind(static_cast<normalAccel_func1>(&Jacobian::normalAcceleration), std::ref(jac), _1, _2))
+              .norm(),
+          TOL);
 
       BOOST_CHECK_SMALL(
           testMatrixAgainstVector(
-              mb, mbc, jac, std::bind(&Jacobian::bodyJacobianDot, std::ref(jac), _1, _2), alpha,
+              mb, mbc, jac, std::bind(jacobianMethod_t(&Jacobian::bodyJacobianDot), std::ref(jac), _1, _2), alpha,
               std::bind(static_cast<normalAccel_func1>(&Jacobian::bodyNormalAcceleration), std::ref(jac), _1, _2))
               .norm(),
           TOL);
 
-      BOOST_CHECK_SMALL(testMatrixAgainstVector(mb, mbc, jac, std::bind(&Jacobian::jacobianDot, std::ref(jac), _1, _2),
-                                                alpha,
-                                                std::bind(static_cast<normalAccel_func2>(&Jacobian::normalAcceleration),
-                                                          std::ref(jac), _1, _2, std::ref(mbc.bodyAccB)))
-                            .norm(),
-                        TOL);
+      BOOST_CHECK_SMALL(
+          testMatrixAgainstVector(mb, mbc, jac,
+                                  std::bind(jacobianMethod_t(&Jacobian::jacobianDot), std::ref(jac), _1, _2), alpha,
+                                  std::bind(static_cast<normalAccel_func2>(&Jacobian::normalAcceleration),
+                                            std::ref(jac), _1, _2, std::ref(mbc.bodyAccB)))
+              .norm(),
+          TOL);
 
       BOOST_CHECK_SMALL(
-          testMatrixAgainstVector(mb, mbc, jac, std::bind(&Jacobian::bodyJacobianDot, std::ref(jac), _1, _2), alpha,
+          testMatrixAgainstVector(mb, mbc, jac,
+                                  std::bind(jacobianMethod_t(&Jacobian::bodyJacobianDot), std::ref(jac), _1, _2), alpha,
                                   std::bind(static_cast<normalAccel_func2>(&Jacobian::bodyNormalAcceleration),
                                             std::ref(jac), _1, _2, std::ref(mbc.bodyAccB)))
               .norm(),
@@ -797,3 +807,216 @@ BOOST_AUTO_TEST_CASE(JacobianVectorVelAccComputeTest)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(JacobianWorkspaceTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc1, mbc2;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc1, mbg) = makeXYZSarm(false);
+  mbc2 = mbc1;
+
+  Jacobian jac(mb, "b4", Vector3d(0.1, 0.2, 0.3));
+  const Jacobian & cjac = jac;
+  Jacobian::Workspace ws1(jac), ws2(jac);
+
+  for(MultiBodyConfig & mbc : {std::ref(mbc1), std::ref(mbc2)})
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.head<4>().normalize();
+    q.segment(mb.jointPosInParam(mb.jointIndexByName("j3")), 4).normalize();
+    vectorToParam(q, mbc.q);
+    vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alpha);
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+  }
+
+  // workspaces results are independent of each other and of the internal one
+  MatrixXd J1 = cjac.jacobian(mb, mbc1, ws1);
+  MatrixXd JD1 = cjac.jacobianDot(mb, mbc1, ws1);
+  cjac.jacobian(mb, mbc2, ws2);
+  cjac.jacobianDot(mb, mbc2, ws2);
+
+  BOOST_CHECK_SMALL((J1 - jac.jacobian(mb, mbc1)).norm(), TOL);
+  BOOST_CHECK_SMALL((JD1 - jac.jacobianDot(mb, mbc1)).norm(), TOL);
+  BOOST_CHECK_SMALL((ws1.jac - J1).norm(), TOL);
+  BOOST_CHECK_SMALL((ws2.jac - jac.jacobian(mb, mbc2)).norm(), TOL);
+  BOOST_CHECK_SMALL((ws2.jacDot - jac.jacobianDot(mb, mbc2)).norm(), TOL);
+
+  BOOST_CHECK_SMALL((cjac.bodyJacobian(mb, mbc1, ws1) - jac.bodyJacobian(mb, mbc1)).norm(), TOL);
+  BOOST_CHECK_SMALL((cjac.bodyJacobianDot(mb, mbc1, ws1) - jac.bodyJacobianDot(mb, mbc1)).norm(), TOL);
+}
+
+BOOST_AUTO_TEST_CASE(MultiFrameJacobianTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  std::vector<std::string> names = {"LARM6", "RARM6", "LLEG5", "RLEG5", "HEAD0", "TORSO"};
+  std::vector<Vector3d> points;
+  std::vector<Jacobian> jacs;
+  for(const std::string & n : names)
+  {
+    points.push_back(Vector3d::Random());
+    jacs.emplace_back(mb, n, points.back());
+  }
+
+  MultiFrameJacobian mfj(mb, names, points);
+  const MultiFrameJacobian & cmfj = mfj;
+  MultiFrameJacobian::Workspace ws(mfj);
+  BOOST_CHECK_EQUAL(mfj.nrFrames(), static_cast<int>(names.size()));
+
+  MatrixXd full(6, mb.nrDof());
+  for(int i = 0; i < 10; ++i)
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.head<4>().normalize();
+    vectorToParam(q, mbc.q);
+    forwardKinematics(mb, mbc);
+
+    const MatrixXd & J = mfj.sJacobian(mb, mbc);
+    const MatrixXd & JB = cmfj.bodyJacobian(mb, mbc, ws);
+    BOOST_CHECK_EQUAL(J.rows(), 6 * mfj.nrFrames());
+    BOOST_CHECK_EQUAL(J.cols(), mb.nrDof());
+    for(std::size_t k = 0; k < jacs.size(); ++k)
+    {
+      jacs[k].fullJacobian(mb, jacs[k].jacobian(mb, mbc), full);
+      BOOST_CHECK_SMALL((J.middleRows<6>(6 * k) - full).norm(), TOL);
+      jacs[k].fullJacobian(mb, jacs[k].bodyJacobian(mb, mbc), full);
+      BOOST_CHECK_SMALL((JB.middleRows<6>(6 * k) - full).norm(), TOL);
+    }
+  }
+
+  BOOST_CHECK_THROW(MultiFrameJacobian(mb, names, {Vector3d::Zero()}), std::domain_error);
+  BOOST_CHECK_THROW(MultiFrameJacobian(mb, {"NOT_A_BODY"}), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(JacobianProductTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  Jacobian jac(mb, "LARM6", Vector3d(0.1, -0.2, 0.3));
+  MatrixXd full(6, mb.nrDof());
+  VectorXd tau(mb.nrDof());
+  MatrixXd taus(mb.nrDof(), 3), vels(6, 3);
+
+  for(int i = 0; i < 10; ++i)
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.head<4>().normalize();
+    vectorToParam(q, mbc.q);
+    vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alpha);
+    forwardKinematics(mb, mbc);
+    forwardVelocity(mb, mbc);
+
+    jac.fullJacobian(mb, jac.jacobian(mb, mbc), full);
+
+    VectorXd alpha(dofToVector(mb, mbc.alpha));
+    BOOST_CHECK_SMALL((jac.sJacobianTimes(mb, mbc, alpha).vector() - full * alpha).norm(), TOL);
+    BOOST_CHECK_SMALL((jac.jacobianTimes(mb, mbc, alpha) - jac.velocity(mb, mbc)).vector().norm(), TOL);
+
+    ForceVecd f(Vector6d::Random());
+    jac.sJacobianTransposeTimes(mb, mbc, f, tau);
+    BOOST_CHECK_SMALL((tau - full.transpose() * f.vector()).norm(), TOL);
+
+    MatrixXd alphas(MatrixXd::Random(mb.nrDof(), 3));
+    jac.sJacobianTimesBatch(mb, mbc, alphas, vels);
+    BOOST_CHECK_SMALL((vels - full * alphas).norm(), TOL);
+
+    MatrixXd wrenches(MatrixXd::Random(6, 3));
+    jac.sJacobianTransposeTimesBatch(mb, mbc, wrenches, taus);
+    BOOST_CHECK_SMALL((taus - full.transpose() * wrenches).norm(), TOL);
+  }
+
+  BOOST_CHECK_THROW(jac.sJacobianTimes(mb, mbc, VectorXd::Zero(mb.nrDof() + 1)), std::domain_error);
+  MatrixXd badTaus(mb.nrDof(), 2);
+  BOOST_CHECK_THROW(jac.sJacobianTransposeTimesBatch(mb, mbc, MatrixXd::Zero(6, 3), badTaus), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(SparseJacobianBuilderTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  std::vector<Jacobian> jacs;
+  for(const char * n : {"LARM6", "RLEG5", "HEAD0", "RARM3"})
+  {
+    jacs.emplace_back(mb, n);
+  }
+
+  SparseJacobianBuilder builder(mb.nrDof());
+  for(const Jacobian & jac : jacs)
+  {
+    builder.sAddJacobian(jac.compactPath(mb));
+  }
+  // position task only use the translation rows
+  builder.sAddJacobian(jacs[0].compactPath(mb), 3);
+  builder.finalize();
+  BOOST_CHECK_EQUAL(builder.nrRows(), 6 * 4 + 3);
+  BOOST_CHECK_EQUAL(builder.matrix().cols(), mb.nrDof());
+
+  MatrixXd full(6, mb.nrDof());
+  MatrixXd dense(builder.nrRows(), mb.nrDof());
+  for(int i = 0; i < 5; ++i)
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.head<4>().normalize();
+    vectorToParam(q, mbc.q);
+    forwardKinematics(mb, mbc);
+
+    Eigen::Index nnz = 0;
+    for(int k = 0; k < 4; ++k)
+    {
+      const MatrixXd & J = jacs[k].jacobian(mb, mbc);
+      builder.sSetJacobian(k, J);
+      jacs[k].fullJacobian(mb, J, full);
+      dense.middleRows<6>(6 * k) = full;
+      nnz += J.size();
+    }
+    const MatrixXd & J0 = jacs[0].jacobian(mb, mbc);
+    builder.setJacobian(4, J0.bottomRows<3>());
+    jacs[0].fullJacobian(mb, J0, full);
+    dense.bottomRows<3>() = full.bottomRows<3>();
+    nnz += 3 * J0.cols();
+
+    // the pattern is not rebuilt between two ticks
+    BOOST_CHECK_EQUAL(builder.matrix().nonZeros(), nnz);
+    BOOST_CHECK_SMALL((MatrixXd(builder.matrix()) - dense).norm(), TOL);
+  }
+
+  BOOST_CHECK_THROW(builder.sSetJacobian(5, full), std::domain_error);
+  BOOST_CHECK_THROW(builder.sSetJacobian(0, full), std::domain_error);
+  builder.addJacobian(jacs[1].compactPath(mb));
+  BOOST_CHECK_THROW(builder.sSetJacobian(0, jacs[0].jacobian(mb, mbc)), std::domain_error);
+  BOOST_CHECK_THROW(builder.sAddJacobian({rbd::Block(mb.nrDof() - 1, 0, 2)}), std::domain_error);
+
+  // an empty pattern is not a finalized one
+  builder.clear();
+  builder.addJacobian(jacs[0].compactPath(mb), 0);
+  BOOST_CHECK_THROW(builder.sSetJacobian(0, MatrixXd(0, jacs[0].dof())), std::domain_error);
+  builder.finalize();
+  builder.sSetJacobian(0, MatrixXd(0, jacs[0].dof()));
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2012-2019 CNRS-UM LIRMM, CNRS-AIST JRL
+ */
+
+// includes
+// benchmark
+#include "benchmark/benchmark.h"
+
+// RBDyn
+#include "RBDyn/BatchFK.h"
+#include "RBDyn/BatchIK.h"
+#include "RBDyn/CompiledMultiBody.h"
+#include "RBDyn/FK.h"
+#include "RBDyn/FV.h"
+#include "RBDyn/IK.h"
+#include "RBDyn/IncrementalKinematics.h"
+#include "RBDyn/MultiBody.h"
+#include "RBDyn/MultiBodyConfig.h"
+#include "RBDyn/MultiBodyGraph.h"
+
+// Arm
+#include "Tree30Dof.h"
+
+static Eigen::MatrixXd randomConfigs(const rbd::MultiBody & mb, int nrConfigs)
+{
+  Eigen::MatrixXd q = Eigen::MatrixXd::Random(nrConfigs, mb.nrParams());
+  // normalize the free flyer quaternion
+  for(int n = 0; n < nrConfigs; ++n)
+  {
+    q.row(n).head<4>().normalize();
+  }
+  return q;
+}
+
+static void BM_FK_loop(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  int N = static_cast<int>(state.range(0));
+  Eigen::MatrixXd q = randomConfigs(mb, N);
+
+  for(auto _ : state)
+  {
+    for(int n = 0; n < N; ++n)
+    {
+      rbd::vectorToParam(q.row(n).transpose(), mbc.q);
+      rbd::forwardKinematics(mb, mbc);
+    }
+    benchmark::DoNotOptimize(mbc.bodyPosW.back());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+BENCHMARK(BM_FK_loop)->Arg(64)->Arg(1024)->Arg(8192);
+
+static void BM_FK_batch(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  int N = static_cast<int>(state.range(0));
+  Eigen::MatrixXd q = randomConfigs(mb, N);
+
+  rbd::BatchForwardKinematics bfk(mb, N);
+
+  for(auto _ : state)
+  {
+    bfk.forwardKinematics(mb, q);
+    benchmark::DoNotOptimize(bfk.bodyPosW().data());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+BENCHMARK(BM_FK_batch)->Arg(64)->Arg(1024)->Arg(8192);
+
+static void BM_FK_leafJoint(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  // only the last joint moves between two calls
+  int joint = mb.nrJoints() - 1;
+  for(auto _ : state)
+  {
+    mbc.q[joint][0] += 1e-3;
+    rbd::forwardKinematics(mb, mbc);
+    benchmark::DoNotOptimize(mbc.bodyPosW.back());
+  }
+}
+BENCHMARK(BM_FK_leafJoint);
+
+static void BM_IncrementalFK_leafJoint(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::IncrementalKinematics kin(mb);
+  kin.forwardKinematics(mb, mbc);
+
+  int joint = mb.nrJoints() - 1;
+  for(auto _ : state)
+  {
+    mbc.q[joint][0] += 1e-3;
+    kin.qChanged(joint);
+    kin.forwardKinematics(mb, mbc);
+    benchmark::DoNotOptimize(mbc.bodyPosW.back());
+  }
+}
+BENCHMARK(BM_IncrementalFK_leafJoint);
+
+static void BM_FKFV(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::FlatMultiBodyConfig fmbc(mb);
+  fmbc.q = randomConfigs(mb, 1).row(0).transpose();
+  fmbc.alpha.setRandom();
+
+  for(auto _ : state)
+  {
+    rbd::forwardKinematics(mb, fmbc.q, mbc);
+    rbd::forwardVelocity(mb, fmbc.alpha, mbc);
+    benchmark::DoNotOptimize(mbc.bodyVelB.back());
+  }
+}
+BENCHMARK(BM_FKFV);
+
+static void BM_FKFV_compiled(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(false);
+
+  rbd::CompiledMultiBody cmb(mb);
+  rbd::FlatMultiBodyConfig fmbc(mb);
+  fmbc.q = randomConfigs(mb, 1).row(0).transpose();
+  fmbc.alpha.setRandom();
+
+  for(auto _ : state)
+  {
+    cmb.forwardKinematics(fmbc.q, mbc);
+    cmb.forwardVelocity(fmbc.alpha, mbc);
+    benchmark::DoNotOptimize(mbc.bodyVelB.back());
+  }
+}
+BENCHMARK(BM_FKFV_compiled);
+
+template<typename IK>
+static void BM_IK(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(true);
+
+  int ef = mb.bodyIndexByName("LARM6");
+  IK ik(mb, ef);
+
+  // reachable targets
+  const int nrTargets = 64;
+  Eigen::MatrixXd q = Eigen::MatrixXd::Random(nrTargets, mb.nrParams());
+  std::vector<sva::PTransformd> targets;
+  for(int n = 0; n < nrTargets; ++n)
+  {
+    rbd::forwardKinematics(mb, q.row(n).transpose(), mbc);
+    targets.push_back(mbc.bodyPosW[ef]);
+  }
+
+  int n = 0;
+  int64_t nrConverged = 0;
+  for(auto _ : state)
+  {
+    mbc.zero(mb);
+    nrConverged += ik.inverseKinematics(mb, mbc, targets[n]);
+    n = (n + 1) % nrTargets;
+  }
+  state.counters["convergence"] =
+      benchmark::Counter(static_cast<double>(nrConverged), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_TEMPLATE(BM_IK, rbd::InverseKinematics);
+BENCHMARK_TEMPLATE(BM_IK, rbd::DampedInverseKinematics);
+
+static void BM_DampedIK_iterations(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(true);
+
+  int ef = mb.bodyIndexByName("LARM6");
+  rbd::DampedInverseKinematics ik(mb, ef);
+  rbd::forwardKinematics(mb, mbc);
+  // unreachable target, a call stops after max_iterations_ iterations or once
+  // the damping reaches ik::MAX_DAMPING, so the iterations actually done are
+  // counted
+  sva::PTransformd target(Eigen::Vector3d(10., 10., 10.));
+  ik.max_iterations_ = 100;
+
+  int64_t nrIterations = 0;
+  for(auto _ : state)
+  {
+    mbc.zero(mb);
+    ik.inverseKinematics(mb, mbc, target);
+    nrIterations += ik.iterations();
+  }
+  state.counters["iterations"] = benchmark::Counter(static_cast<double>(nrIterations), benchmark::Counter::kIsRate);
+  state.counters["iterationsPerCall"] =
+      benchmark::Counter(static_cast<double>(nrIterations), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_DampedIK_iterations);
+
+static void BM_BatchIK(benchmark::State & state)
+{
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc, mbg) = makeTree30Dof(true);
+
+  std::vector<int> effectors = {mb.bodyIndexByName("LARM6"), mb.bodyIndexByName("RARM6")};
+  rbd::BatchInverseKinematics batch(mb, effectors, static_cast<int>(state.range(0)));
+
+  // reachable targets, solved from 8 random seeds
+  const int nrProblems = 64;
+  Eigen::MatrixXd q = Eigen::MatrixXd::Random(nrProblems, mb.nrParams());
+  std::vector<rbd::BatchInverseKinematics::Problem> problems;
+  for(int n = 0; n < nrProblems; ++n)
+  {
+    rbd::forwardKinematics(mb, q.row(n).transpose(), mbc);
+    int ef = effectors[n % effectors.size()];
+    problems.push_back({ef, mbc.bodyPosW[ef]});
+  }
+  Eigen::MatrixXd seeds = Eigen::MatrixXd::Random(8, mb.nrParams());
+
+  int64_t nrConverged = 0;
+  for(auto _ : state)
+  {
+    for(const rbd::BatchInverseKinematics::Result & r : batch.inverseKinematics(mb, problems, seeds, q))
+    {
+      nrConverged += r.converged;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * nrProblems);
+  state.counters["convergence"] = benchmark::Counter(static_cast<double>(nrConverged) / nrProblems,
+                                                     benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_BatchIK)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+BENCHMARK_MAIN()
@@ -215,3 +215,49 @@ BOOST_AUTO_TEST_CASE(centroidalMomentumDot)
     BOOST_CHECK_SMALL((normalMomentumDot2 - normalMomentumDotM).vector().norm(), TOL);
   }
 }
+
+BOOST_AUTO_TEST_CASE(centroidalMomentumWorkspace)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc1, mbc2;
+  rbd::MultiBodyGraph mbg;
+  std::tie(mb, mbc1, mbg) = makeXYZSarm();
+  mbc2 = mbc1;
+
+  CentroidalMomentumMatrix cmm(mb);
+  const CentroidalMomentumMatrix & ccmm = cmm;
+  CentroidalMomentumMatrix::Workspace ws1(mb, cmm), ws2(mb, cmm);
+
+  for(MultiBodyConfig & mbc : {std::ref(mbc1), std::ref(mbc2)})
+  {
+    VectorXd q(VectorXd::Random(mb.nrParams()));
+    q.segment<4>(mb.jointPosInParam(mb.jointIndexByName("j3"))).normalize();
+    rbd::vectorToParam(q, mbc.q);
+    rbd::vectorToParam(VectorXd::Random(mb.nrDof()), mbc.alpha);
+    rbd::forwardKinematics(mb, mbc);
+    rbd::forwardVelocity(mb, mbc);
+  }
+
+  Vector3d com1 = rbd::computeCoM(mb, mbc1);
+  Vector3d comVel1 = rbd::computeCoMVelocity(mb, mbc1);
+  Vector3d com2 = rbd::computeCoM(mb, mbc2);
+  Vector3d comVel2 = rbd::computeCoMVelocity(mb, mbc2);
+
+  ccmm.computeMatrixAndMatrixDot(mb, mbc1, com1, comVel1, ws1);
+  ForceVecd normalMomentumDot1 = ccmm.normalMomentumDot(mb, mbc1, com1, comVel1, ws1);
+  ccmm.computeMatrix(mb, mbc2, com2, ws2);
+  ccmm.computeMatrixDot(mb, mbc2, com2, comVel2, ws2);
+
+  cmm.computeMatrixAndMatrixDot(mb, mbc1, com1, comVel1);
+  BOOST_CHECK_SMALL((ws1.cmMat - cmm.matrix()).norm(), TOL);
+  BOOST_CHECK_SMALL((ws1.cmMatDot - cmm.matrixDot()).norm(), TOL);
+  BOOST_CHECK_SMALL((normalMomentumDot1 - cmm.normalMomentumDot(mb, mbc1, com1, comVel1)).vector().norm(), TOL);
+
+  cmm.computeMatrixAndMatrixDot(mb, mbc2, com2, comVel2);
+  BOOST_CHECK_SMALL((ws2.cmMat - cmm.matrix()).norm(), TOL);
+  BOOST_CHECK_SMALL((ws2.cmMatDot - cmm.matrixDot()).norm(), TOL);
+}
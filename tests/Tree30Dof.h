@@ -6,6 +6,7 @@
 
 // includes
 // std
+#include <string>
 #include <tuple>
 
 // RBDyn
@@ -148,3 +149,73 @@ std::tuple<rbd::MultiBody, rbd::MultiBodyConfig, rbd::MultiBodyGraph> makeTree30
 
   return std::make_tuple(mb, mbc, mbg);
 }
+
+/**
+ * @return A tree made of a base body with nrArms 7 dof arms attached
+ * side by side, used to scale the 30 dof tree up.
+ */
+std::tuple<rbd::MultiBody, rbd::MultiBodyConfig, rbd::MultiBodyGraph> makeTreeArms(int nrArms, bool isFixed = true)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBodyGraph mbg;
+
+  double mass = 1.;
+  Matrix3d I = Matrix3d::Identity();
+  Vector3d h = Vector3d::Zero();
+
+  RBInertiad rbi(mass, h, I);
+
+  mbg.addBody({rbi, "BODY0"});
+
+  for(int i = 0; i < nrArms; ++i)
+  {
+    double x = 0.1 * (i - (nrArms - 1) / 2.);
+    createArm(mbg, Vector3d(x, 0.05, 0.), "BODY0", "A" + std::to_string(i));
+  }
+
+  MultiBody mb = mbg.makeMultiBody("BODY0", isFixed);
+
+  MultiBodyConfig mbc(mb);
+  mbc.zero(mb);
+
+  return std::make_tuple(mb, mbc, mbg);
+}
+
+/**
+ * @return A serial chain of nrJoints revolute joints about X, Y and Z in
+ * turn, the worst case for the algorithms that exploit the tree sparsity.
+ */
+std::tuple<rbd::MultiBody, rbd::MultiBodyConfig, rbd::MultiBodyGraph> makeChain(int nrJoints, bool isFixed = true)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBodyGraph mbg;
+
+  double mass = 1.;
+  Matrix3d I = Matrix3d::Identity();
+  Vector3d h = Vector3d::Zero();
+
+  RBInertiad rbi(mass, h, I);
+
+  mbg.addBody({rbi, "C0"});
+  for(int i = 0; i < nrJoints; ++i)
+  {
+    std::string name = "C" + std::to_string(i + 1);
+    mbg.addBody({rbi, name});
+    mbg.addJoint({Joint::Rev, Vector3d::Unit(i % 3), true, "J" + std::to_string(i)});
+    mbg.linkBodies("C" + std::to_string(i), PTransformd(Vector3d(0., 0.1, 0.)), name, PTransformd::Identity(),
+                   "J" + std::to_string(i));
+  }
+
+  MultiBody mb = mbg.makeMultiBody("C0", isFixed);
+
+  MultiBodyConfig mbc(mb);
+  mbc.zero(mb);
+
+  return std::make_tuple(mb, mbc, mbg);
+}